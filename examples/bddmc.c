@@ -20,6 +20,7 @@ static int check_deadlocks = 0; // set to 1 to check for deadlocks on-the-fly (o
 static int merge_relations = 0; // merge relations to 1 relation
 static int print_transition_matrix = 0; // print transition relation matrix
 static int workers = 0; // autodetect
+static size_t spawn_cutoff = 0; // default spawn cutoff
 static char* model_filename = NULL; // filename of model
 
 static void
@@ -28,7 +29,8 @@ print_usage()
     printf("Usage: bddmc [-h] [-s <bfs|par|sat|chaining>] [-w <workers>]\n");
     printf("        [--strategy=<bfs|par|sat|chaining>] [--workers=<workers>]\n");
     printf("        [--count-nodes] [--count-states] [--count-table] [--deadlocks]\n");
-    printf("        [--merge-relations] [--print-matrix] [--help] [--usage] <model>\n");
+    printf("        [--merge-relations] [--spawn-cutoff=<depth>] [--print-matrix] [--help]\n");
+    printf("        [--usage] <model>\n");
 }
 
 static void
@@ -37,7 +39,8 @@ print_help()
     printf("Usage: bddmc [OPTION...] <model>\n\n");
     printf("  -s, --strategy=<bfs|par|sat|chaining>\n");
     printf("                             Strategy for reachability (default=sat)\n");
-    printf("  -w, --workers=<workers>    Number of workers (default=0: autodetect)\n");
+    printf("  -w, --workers=<workers>    Number of workers (default=0: always spawn)\n");
+    printf("      --spawn-cutoff=<depth> Spawn cutoff of operations (default=0: always spawn)\n");
     printf("      --count-nodes          Report #nodes for BDDs\n");
     printf("      --count-states         Report #states at each level\n");
     printf("      --count-table          Report table usage at each level\n");
@@ -54,6 +57,7 @@ parse_args(int argc, char **argv)
     static const struct option longopts[] = {
         {.name = "workers", .val = 'w', .has_arg = required_argument},
         {.name = "strategy", .val = 's', .has_arg = required_argument},
+        {.name = "spawn-cutoff", .val = 7, .has_arg = required_argument},
         {.name = "deadlocks", .val = 3, .has_arg = no_argument},
         {.name = "count-nodes", .val = 5, .has_arg = no_argument},
         {.name = "count-states", .val = 1, .has_arg = no_argument},
@@ -71,6 +75,9 @@ parse_args(int argc, char **argv)
             case 'w':
                 workers = atoi(optarg);
                 break;
+            case 7:
+                spawn_cutoff = strtoull(optarg, NULL, 10);
+                break;
             case 's':
                 if (strcmp(optarg, "bfs")==0) strategy = 0;
                 else if (strcmp(optarg, "par")==0) strategy = 1;
@@ -947,6 +954,7 @@ main(int argc, char **argv)
 
     sylvan_set_limits(max, 1, 6);
     sylvan_init_package();
+    sylvan_set_spawn_cutoff(spawn_cutoff);
     sylvan_init_bdd();
     sylvan_gc_hook_pregc(TASK(gc_start));
     sylvan_gc_hook_postgc(TASK(gc_end));
@@ -187,36 +187,6 @@ VOID_TASK_2(rel_load, FILE*, f, rel_t, rel)
     rel->dd = lddmc_serialize_get_reversed(dd);
 }
 
-/**
- * Compute the highest value for each variable level.
- * This method is called for the set of reachable states.
- */
-static uint64_t compute_highest_id;
-#define compute_highest(dd, arr) RUN(compute_highest, dd, arr)
-VOID_TASK_2(compute_highest, MDD, dd, uint32_t*, arr)
-{
-    if (dd == lddmc_true || dd == lddmc_false) return;
-
-    uint64_t result = 1;
-    if (cache_get3(compute_highest_id, dd, 0, 0, &result)) return;
-    cache_put3(compute_highest_id, dd, 0, 0, result);
-
-    mddnode_t n = LDD_GETNODE(dd);
-
-    SPAWN(compute_highest, mddnode_getright(n), arr);
-    CALL(compute_highest, mddnode_getdown(n), arr+1);
-    SYNC(compute_highest);
-
-    if (!mddnode_getcopy(n)) {
-        const uint32_t v = mddnode_getvalue(n);
-        while (1) {
-            const uint32_t cur = *(volatile uint32_t*)arr;
-            if (v <= cur) break;
-            if (__sync_bool_compare_and_swap(arr, cur, v)) break;
-        }
-    }
-}
-
 /**
  * Compute the highest value for the action label.
  * This method is called for each transition relation.
@@ -262,56 +232,6 @@ VOID_TASK_3(compute_highest_action, MDD, dd, MDD, meta, uint32_t*, target)
     }
 }
 
-/**
- * Compute the BDD equivalent of the LDD of a set of states.
- */
-static uint64_t bdd_from_ldd_id;
-#define bdd_from_ldd(dd, bits, firstvar) RUN(bdd_from_ldd, dd, bits, firstvar)
-TASK_3(MTBDD, bdd_from_ldd, MDD, dd, MDD, bits_dd, uint32_t, firstvar)
-{
-    /* simple for leaves */
-    if (dd == lddmc_false) return mtbdd_false;
-    if (dd == lddmc_true) return mtbdd_true;
-
-    MTBDD result;
-    /* get from cache */
-    /* note: some assumptions about the encoding... */
-    if (cache_get3(bdd_from_ldd_id, dd, bits_dd, firstvar, &result)) return result;
-
-    mddnode_t n = LDD_GETNODE(dd);
-    mddnode_t nbits = LDD_GETNODE(bits_dd);
-    int bits = (int)mddnode_getvalue(nbits);
-
-    /* spawn right, same bits_dd and firstvar */
-    mtbdd_refs_spawn(SPAWN(bdd_from_ldd, mddnode_getright(n), bits_dd, firstvar));
-
-    /* call down, with next bits_dd and firstvar */
-    MTBDD down = CALL(bdd_from_ldd, mddnode_getdown(n), mddnode_getdown(nbits), firstvar + 2*bits);
-
-    /* encode current value */
-    uint32_t val = mddnode_getvalue(n);
-    for (int i=0; i<bits; i++) {
-        /* encode with high bit first */
-        int bit = bits-i-1;
-        if (val & (1LL<<i)) down = mtbdd_makenode(firstvar + 2*bit, mtbdd_false, down);
-        else down = mtbdd_makenode(firstvar + 2*bit, down, mtbdd_false);
-    }
-
-    /* sync right */
-    mtbdd_refs_push(down);
-    MTBDD right = mtbdd_refs_sync(SYNC(bdd_from_ldd));
-
-    /* take union of current and right */
-    mtbdd_refs_push(right);
-    result = sylvan_or(down, right);
-    mtbdd_refs_pop(2);
-
-    /* put in cache */
-    cache_put3(bdd_from_ldd_id, dd, bits_dd, firstvar, result);
-
-    return result;
-}
-
 /**
  * Compute the BDD equivalent of an LDD transition relation.
  */
@@ -475,49 +395,6 @@ TASK_4(MTBDD, bdd_from_ldd_rel, MDD, dd, MDD, bits_dd, uint32_t, firstvar, MDD,
     return result;
 }
 
-/**
- * Compute the BDD equivalent of the meta variable (to a variables cube)
- */
-MTBDD
-meta_to_bdd(MDD meta, MDD bits_dd, uint32_t firstvar)
-{
-    if (meta == lddmc_false || meta == lddmc_true) return mtbdd_true;
-
-    /* meta:
-     * -1 is end
-     *  0 is skip (no variables)
-     *  1 is read (variables added by write)
-     *  2 is write
-     *  3 is only-read
-     *  4 is only-write
-     */
-
-    const mddnode_t nmeta = LDD_GETNODE(meta);
-    const uint32_t vmeta = mddnode_getvalue(nmeta);
-    if (vmeta == (uint32_t)-1) return mtbdd_true;
-    
-    if (vmeta == 1) {
-        /* return recursive result, don't go down on bits */
-        return meta_to_bdd(mddnode_getdown(nmeta), bits_dd, firstvar);
-    }
-
-    const mddnode_t nbits = LDD_GETNODE(bits_dd);
-    const int bits = (int)mddnode_getvalue(nbits);
-
-    /* compute recursive result */
-    MTBDD res = meta_to_bdd(mddnode_getdown(nmeta), mddnode_getdown(nbits), firstvar + 2*bits);
-
-    /* add our variables if meta is 2,3,4 */
-    if (vmeta != 0 && vmeta != 5) {
-        for (int i=0; i<bits; i++) {
-            res = mtbdd_makenode(firstvar + 2*(bits-i-1) + 1, mtbdd_false, res);
-            res = mtbdd_makenode(firstvar + 2*(bits-i-1), mtbdd_false, res);
-        }
-    }
-
-    return res;
-}
-
 VOID_TASK_0(gc_start)
 {
     printf("Starting garbage collection\n");
@@ -605,7 +482,7 @@ VOID_TASK_0(run)
     // Compute highest value at each level (from reachable states)
     uint32_t highest[vector_size];
     for (int i=0; i<vector_size; i++) highest[i] = 0;
-    compute_highest(states->dd, highest);
+    lddmc_highest(states->dd, highest);
 
     // Compute highest action label value (from transition relations)
     uint32_t highest_action = 0;
@@ -676,7 +553,7 @@ VOID_TASK_0(run)
     fwrite(&actionbits, sizeof(int), 1, f);
 
     // Write initial state...
-    MTBDD new_initial = bdd_from_ldd(initial->dd, bits_dd, 0);
+    MTBDD new_initial = lddmc_to_bdd(initial->dd, bits_dd, 0);
     assert((size_t)mtbdd_satcount(new_initial, totalbits) == (size_t)lddmc_satcount_cached(initial->dd));
     mtbdd_refs_push(new_initial);
     {
@@ -686,7 +563,7 @@ VOID_TASK_0(run)
     }
 
     // Custom operation that converts to BDD given number of bits for each level
-    MTBDD new_states = bdd_from_ldd(states->dd, bits_dd, 0);
+    MTBDD new_states = lddmc_to_bdd(states->dd, bits_dd, 0);
     assert((size_t)mtbdd_satcount(new_states, totalbits) == (size_t)lddmc_satcount_cached(states->dd));
     mtbdd_refs_push(new_states);
 
@@ -719,7 +596,7 @@ VOID_TASK_0(run)
 
         if (check_results) {
             // Compute new <variables> for the current transition relation
-            MTBDD new_vars = meta_to_bdd(next[i]->meta, bits_dd, 0);
+            MTBDD new_vars = lddmc_meta_to_bdd_vars(next[i]->meta, bits_dd, 0);
             mtbdd_refs_push(new_vars);
 
             // Test if the transition is correctly converted
@@ -727,7 +604,7 @@ VOID_TASK_0(run)
             mtbdd_refs_push(test);
             MDD succ = lddmc_relprod(states->dd, next[i]->dd, next[i]->meta);
             lddmc_refs_push(succ);
-            MTBDD test2 = bdd_from_ldd(succ, bits_dd, 0);
+            MTBDD test2 = lddmc_to_bdd(succ, bits_dd, 0);
             if (test != test2) Abort("Conversion error!\n");
             lddmc_refs_pop(1);
             mtbdd_refs_pop(2);
@@ -784,9 +661,7 @@ main(int argc, char **argv)
     sylvan_gc_hook_postgc(TASK(gc_end));
 
     // Obtain operation ids for the operation cache
-    compute_highest_id = cache_next_opid();
     compute_highest_action_id = cache_next_opid();
-    bdd_from_ldd_id = cache_next_opid();
     bdd_from_ldd_rel_id = cache_next_opid();
 
     RUN(run);
@@ -18,6 +18,8 @@ static int strategy = 2; // 0 = BFS, 1 = PAR, 2 = SAT, 3 = CHAINING
 static int check_deadlocks = 0; // set to 1 to check for deadlocks on-the-fly
 static int print_transition_matrix = 0; // print transition relation matrix
 static int workers = 0; // autodetect
+static size_t spawn_cutoff = 0; // default spawn cutoff
+static int file_format = SYLVAN_FILE_RAW; // format of the output file
 static char* model_filename = NULL; // filename of model
 static char* out_filename = NULL; // filename of output
 
@@ -27,7 +29,9 @@ print_usage()
     printf("Usage: lddmc [-h] [-s <bfs|par|sat|chaining>] [-w <workers>]\n");
     printf("            [--strategy=<bfs|par|sat|chaining>] [--workers=<workers>]\n");
     printf("            [--count-nodes] [--count-states] [--count-table] [--deadlocks]\n");
-    printf("            [--print-matrix] [--help] [--usage] <model> [<output-bdd>]\n");
+    printf("            [--spawn-cutoff=<depth>] [--format=<raw|compact|lz>]\n");
+    printf("            [--print-matrix] [--help] [--usage]\n");
+    printf("            <model> [<output-bdd>]\n");
 }
 
 static void
@@ -36,7 +40,10 @@ print_help()
     printf("Usage: lddmc [OPTION...] <model> [<output-bdd>]\n\n");
     printf("  -s, --strategy=<bfs|par|sat|chaining>\n");
     printf("                             Strategy for reachability (default=par)\n");
-    printf("  -w, --workers=<workers>    Number of workers (default=0: autodetect)\n");
+    printf("  -w, --workers=<workers>    Number of workers (default=0: always spawn)\n");
+    printf("      --spawn-cutoff=<depth> Spawn cutoff of operations (default=0: always spawn)\n");
+    printf("      --format=<raw|compact|lz>\n");
+    printf("                             Format of the output file (default=raw)\n");
     printf("      --count-nodes          Report #nodes for LDDs\n");
     printf("      --count-states         Report #states at each level\n");
     printf("      --count-table          Report table usage at each level\n");
@@ -52,6 +59,8 @@ parse_args(int argc, char **argv)
     static const struct option longopts[] = {
         {.name = "workers", .val = 'w', .has_arg = required_argument},
         {.name = "strategy", .val = 's', .has_arg = required_argument},
+        {.name = "spawn-cutoff", .val = 7, .has_arg = required_argument},
+        {.name = "format", .val = 8, .has_arg = required_argument},
         {.name = "deadlocks", .val = 3, .has_arg = no_argument},
         {.name = "count-nodes", .val = 5, .has_arg = no_argument},
         {.name = "count-states", .val = 1, .has_arg = no_argument},
@@ -68,6 +77,18 @@ parse_args(int argc, char **argv)
             case 'w':
                 workers = atoi(optarg);
                 break;
+            case 7:
+                spawn_cutoff = strtoull(optarg, NULL, 10);
+                break;
+            case 8:
+                if (strcmp(optarg, "raw")==0) file_format = SYLVAN_FILE_RAW;
+                else if (strcmp(optarg, "compact")==0) file_format = SYLVAN_FILE_COMPACT;
+                else if (strcmp(optarg, "lz")==0) file_format = SYLVAN_FILE_LZ;
+                else {
+                    print_usage();
+                    exit(0);
+                }
+                break;
             case 's':
                 if (strcmp(optarg, "bfs")==0) strategy = 0;
                 else if (strcmp(optarg, "par")==0) strategy = 1;
@@ -355,7 +376,10 @@ print_matrix(size_t size, MDD meta)
  */
 TASK_5(MDD, go_par, MDD, cur, MDD, visited, size_t, from, size_t, len, MDD*, deadlocks)
 {
-    if (len == 1) {
+    if (len == 1 && deadlocks == NULL) {
+        // Calculate NEW successors (not in visited)
+        return lddmc_relprod_minus(cur, next[from]->dd, next[from]->meta, visited);
+    } else if (len == 1) {
         // Calculate NEW successors (not in visited)
         MDD succ = lddmc_relprod(cur, next[from]->dd, next[from]->meta);
         lddmc_refs_push(succ);
@@ -422,6 +446,13 @@ VOID_TASK_1(par, set_t, set)
     lddmc_refs_pushptr(&visited);
     lddmc_refs_pushptr(&front);
 
+    // the relations and their metas, for lddmc_relprod_multi
+    MDD rels[next_count], metas[next_count];
+    for (int i=0; i<next_count; i++) {
+        rels[i] = next[i]->dd;
+        metas[i] = next[i]->meta;
+    }
+
     int iteration = 1;
     do {
         if (check_deadlocks) {
@@ -439,8 +470,9 @@ VOID_TASK_1(par, set_t, set)
                 check_deadlocks = 0;
             }
         } else {
-            // compute successors in parallel
-            front = CALL(go_par, front, visited, 0, next_count, NULL);
+            // compute successors of all relations in one pass over front
+            front = lddmc_relprod_multi(front, rels, metas, next_count);
+            front = lddmc_minus(front, visited);
         }
 
         // visited = visited + front
@@ -470,7 +502,10 @@ VOID_TASK_1(par, set_t, set)
  */
 TASK_5(MDD, go_bfs, MDD, cur, MDD, visited, size_t, from, size_t, len, MDD*, deadlocks)
 {
-    if (len == 1) {
+    if (len == 1 && deadlocks == NULL) {
+        // Calculate NEW successors (not in visited)
+        return lddmc_relprod_minus(cur, next[from]->dd, next[from]->meta, visited);
+    } else if (len == 1) {
         // Calculate NEW successors (not in visited)
         MDD succ = lddmc_relprod(cur, next[from]->dd, next[from]->meta);
         lddmc_refs_push(succ);
@@ -804,7 +839,9 @@ TASK_0(int, run)
     }
 
     // Now we just have states
-    INFO("Final states: %0.0f states\n", lddmc_satcount_cached(states->dd));
+    char *count = lddmc_satcount_exact_str(states->dd);
+    INFO("Final states: %s states\n", count);
+    free(count);
     if (report_nodes) {
         INFO("Final states: %zu MDD nodes\n", lddmc_nodecount(states->dd));
     }
@@ -878,6 +915,8 @@ main(int argc, char **argv)
 
     sylvan_set_limits(max, 1, 16);
     sylvan_init_package();
+    sylvan_set_spawn_cutoff(spawn_cutoff);
+    sylvan_set_file_format(file_format);
     sylvan_init_ldd();
     sylvan_gc_hook_pregc(TASK(gc_start));
     sylvan_gc_hook_postgc(TASK(gc_end));
@@ -0,0 +1,252 @@
+/**
+ * Benchmark for the iterative MTBDD solvers on generated Markov chains.
+ *
+ * The generated chain has <n> bits. In every step, a bit i is chosen uniformly at random
+ * and is then flipped from 0 to 1 with probability a_i or from 1 to 0 with probability b_i.
+ * The stationary distribution is known: bit i is 1 with probability a_i/(a_i+b_i).
+ * We compute the stationary distribution with the power method and the expected
+ * discounted reward (reward 1 per step) with the Jacobi method, and check the results.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <sylvan.h>
+
+/* Configuration */
+static int workers = 0; // autodetect number of workers by default
+static int report_iterations = 0; // report every iteration
+static int report_stats = 0; // report stats at end
+static double epsilon = 1e-10; // tolerance
+static double discount = 0.9; // discount factor for the Jacobi benchmark
+static int bits = 0; // will be set by caller
+
+/* getopt configuration */
+
+static void
+print_usage()
+{
+    printf("Usage: mcsolve [-h] [-w <workers>] [-e <epsilon>] [-d <discount>] [--workers <workers>]\n");
+    printf("            [--epsilon <epsilon>] [--discount <discount>] [--report-iterations]\n");
+    printf("            [--report-stats] [--help] [--usage] <bits>\n");
+}
+
+static void
+print_help()
+{
+    printf("Usage: mcsolve [OPTION...] <bits>\n\n");
+    printf("  -w, --workers <workers>    Number of workers (default = 0: autodetect)\n");
+    printf("  -e, --epsilon <epsilon>    Tolerance (default = 1e-10)\n");
+    printf("  -d, --discount <discount>  Discount factor (default = 0.9)\n");
+    printf("      --report-iterations    Report every iteration\n");
+    printf("      --report-stats         Report statistics at end\n");
+    printf("  -h, --help                 Give this help list\n");
+    printf("      --usage                Give a short usage message\n");
+}
+
+static void
+parse_args(int argc, char **argv)
+{
+    static const struct option longopts[] = {
+        {.name = "workers", .val = 'w', .has_arg = required_argument},
+        {.name = "epsilon", .val = 'e', .has_arg = required_argument},
+        {.name = "discount", .val = 'd', .has_arg = required_argument},
+        {.name = "report-iterations", .val = 1, .has_arg = no_argument},
+        {.name = "report-stats", .val = 2, .has_arg = no_argument},
+        {.name = "usage", .val = 99, .has_arg = no_argument},
+        {.name = "help", .val = 'h', .has_arg = no_argument},
+        {},
+    };
+    int key = 0;
+    int long_index = 0;
+    while ((key = getopt_long(argc, argv, "w:e:d:h", longopts, &long_index)) != -1) {
+        switch (key) {
+        case 'w':
+            workers = atoi(optarg);
+            break;
+        case 'e':
+            epsilon = atof(optarg);
+            break;
+        case 'd':
+            discount = atof(optarg);
+            break;
+        case 1:
+            report_iterations = 1;
+            break;
+        case 2:
+            report_stats = 1;
+            break;
+        case 99:
+            print_usage();
+            exit(0);
+        case 'h':
+            print_help();
+            exit(0);
+        }
+    }
+    if (optind >= argc) {
+        printf("missing required parameter <bits>\n");
+        exit(-1);
+    }
+    bits = atoi(argv[optind]);
+}
+
+/* Obtain current wallclock time */
+static double
+wctime()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec + 1E-6 * tv.tv_usec);
+}
+
+static double t_start;
+#define INFO(s, ...) fprintf(stdout, "[% 8.2f] " s, wctime()-t_start, ##__VA_ARGS__)
+#define Abort(...) { fprintf(stderr, __VA_ARGS__); exit(-1); }
+
+/* Probabilities of flipping bit i up (0 to 1) and down (1 to 0) */
+static double
+prob_up(int i)
+{
+    return (i%3+1)/10.0;
+}
+
+static double
+prob_down(int i)
+{
+    return ((i+1)%4+1)/10.0;
+}
+
+/* Row variables are 0, 2, 4, ..., column variables are 1, 3, 5, ... */
+
+VOID_TASK_2(report_iteration, mtbdd_solver_info*, info, MTBDD, x)
+{
+    INFO("Iteration %zu: %.6f sec, %zu nodes.\n", info->iterations, info->last_time, mtbdd_nodecount(x));
+}
+
+/**
+ * Build the transition matrix. If <transpose> is set, build the transpose instead.
+ */
+static MTBDD
+build_matrix(int transpose)
+{
+    MTBDD result = mtbdd_false, term = mtbdd_false, eq = mtbdd_true;
+    mtbdd_protect(&result);
+    mtbdd_protect(&term);
+    mtbdd_protect(&eq);
+
+    for (int i=0; i<bits; i++) {
+        // T_i(s_i, s'_i) for the chosen bit
+        double a = prob_up(i), b = prob_down(i);
+        MTBDD from0 = mtbdd_makenode(2*i+1, mtbdd_double(1.0-a), mtbdd_double(transpose ? b : a));
+        MTBDD from1 = mtbdd_makenode(2*i+1, mtbdd_double(transpose ? a : b), mtbdd_double(1.0-b));
+        term = mtbdd_makenode(2*i, from0, from1);
+        // all other bits remain the same
+        for (int j=bits-1; j>=0; j--) {
+            if (j == i) continue;
+            eq = sylvan_biimp(sylvan_ithvar(2*j), sylvan_ithvar(2*j+1));
+            term = mtbdd_times(term, eq);
+        }
+        result = mtbdd_plus(result, term);
+    }
+    result = mtbdd_times(result, mtbdd_double(1.0/bits));
+
+    mtbdd_unprotect(&result);
+    mtbdd_unprotect(&term);
+    mtbdd_unprotect(&eq);
+    return result;
+}
+
+VOID_TASK_0(run)
+{
+    uint32_t rows[bits], cols[bits];
+    for (int i=0; i<bits; i++) {
+        rows[i] = 2*i;
+        cols[i] = 2*i+1;
+    }
+
+    mtbdd_solver_info info;
+    mtbdd_solver_info_init(&info, mtbdd_set_from_array(rows, bits), mtbdd_set_from_array(cols, bits));
+    mtbdd_protect(&info.rows);
+    mtbdd_protect(&info.cols);
+    info.epsilon = epsilon;
+    if (report_iterations) info.callback = TASK(report_iteration);
+
+    MTBDD P = mtbdd_false, x = mtbdd_false, expected = mtbdd_true;
+    mtbdd_protect(&P);
+    mtbdd_protect(&x);
+    mtbdd_protect(&expected);
+
+    /* Stationary distribution with the power method */
+
+    P = build_matrix(1);
+    INFO("Transposed transition matrix has %zu nodes.\n", mtbdd_nodecount(P));
+
+    // start with the uniform distribution, probabilities are small so use the relative difference
+    x = mtbdd_double(1.0/(1ULL<<bits));
+    info.relative = 1;
+    x = mtbdd_solve_power(P, x, &info);
+    INFO("Power method: %zu iterations, %f sec (%f sec per iteration), %sconverged.\n",
+         info.iterations, info.total_time, info.total_time/info.iterations, info.converged ? "" : "not ");
+    INFO("Stationary distribution has %zu nodes.\n", mtbdd_nodecount(x));
+
+    // compare with the product form
+    expected = mtbdd_double(1.0);
+    for (int i=bits-1; i>=0; i--) {
+        double a = prob_up(i), b = prob_down(i);
+        MTBDD bit = mtbdd_makenode(2*i, mtbdd_double(b/(a+b)), mtbdd_double(a/(a+b)));
+        expected = mtbdd_times(expected, bit);
+    }
+    if (mtbdd_equal_norm_rel_d(expected, x, 1e-3) != mtbdd_true) Abort("Wrong stationary distribution!\n");
+
+    /* Expected discounted reward with the Jacobi method */
+
+    P = build_matrix(0);
+    INFO("Transition matrix has %zu nodes.\n", mtbdd_nodecount(P));
+
+    // A = I - discount * P
+    expected = mtbdd_ite(mtbdd_identity(info.rows, info.cols), mtbdd_double(1.0), mtbdd_double(0.0));
+    P = mtbdd_times(P, mtbdd_double(-discount));
+    P = mtbdd_plus(P, expected);
+    info.relative = 0;
+    x = mtbdd_solve_jacobi(P, mtbdd_double(1.0), mtbdd_double(0.0), &info);
+    INFO("Jacobi method: %zu iterations, %f sec (%f sec per iteration), %sconverged.\n",
+         info.iterations, info.total_time, info.total_time/info.iterations, info.converged ? "" : "not ");
+    if (mtbdd_equal_norm_d(x, mtbdd_double(1.0/(1.0-discount)), 1e-4) != mtbdd_true) Abort("Wrong expected reward!\n");
+
+    mtbdd_unprotect(&P);
+    mtbdd_unprotect(&x);
+    mtbdd_unprotect(&expected);
+    mtbdd_unprotect(&info.rows);
+    mtbdd_unprotect(&info.cols);
+}
+
+int
+main(int argc, char** argv)
+{
+    parse_args(argc, argv);
+    setlocale(LC_NUMERIC, "en_US.utf-8");
+    t_start = wctime();
+
+    // Init Lace
+    lace_start(workers, 1000000);
+
+    // Init Sylvan
+    sylvan_set_sizes(1LL<<20, 1LL<<26, 1LL<<18, 1LL<<24);
+    sylvan_init_package();
+    sylvan_init_mtbdd();
+
+    RUN(run);
+
+    if (report_stats) {
+        sylvan_stats_report(stdout);
+    }
+
+    sylvan_quit();
+    lace_stop();
+}
@@ -18,6 +18,7 @@
 static int report_minterms = 0; // report minterms at every major step
 static int report_minor = 0; // report minor steps
 static int report_stats = 0; // report stats at end
+static int use_zdd = 0; // use ZDD family algebra instead of BDDs
 static int workers = 0; // autodetect number of workers by default
 static size_t size = 0; // will be set by caller
 
@@ -27,7 +28,7 @@ static void
 print_usage()
 {
     printf("Usage: nqueens [-h] [-w <workers>] [--workers <workers>] [--report-minor]\n");
-    printf("            [--report-minterms] [--report-stats] [--help] [--usage] <size>\n");
+    printf("            [--report-minterms] [--report-stats] [--zdd] [--help] [--usage] <size>\n");
 }
 
 static void
@@ -38,6 +39,7 @@ print_help()
     printf("      --report-minor         Report minor steps\n");
     printf("      --report-minterms      Report #minterms at every major step\n");
     printf("      --report-stats         Report statistics at end\n");
+    printf("      --zdd                  Compute the solutions with ZDD family algebra\n");
     printf("  -h, --help                 Give this help list\n");
     printf("      --usage                Give a short usage message\n");
 }
@@ -50,6 +52,7 @@ parse_args(int argc, char **argv)
         {.name = "report-minterms", .val = 1, .has_arg = no_argument},
         {.name = "report-minor", .val = 2, .has_arg = no_argument},
         {.name = "report-stats", .val = 3, .has_arg = no_argument},
+        {.name = "zdd", .val = 4, .has_arg = no_argument},
         {.name = "usage", .val = 99, .has_arg = no_argument},
         {.name = "help", .val = 'h', .has_arg = no_argument},
         {},
@@ -70,6 +73,9 @@ parse_args(int argc, char **argv)
         case 3:
             report_stats = 1;
             break;
+        case 4:
+            use_zdd = 1;
+            break;
         case 99:
             print_usage();
             exit(0);
@@ -296,6 +302,69 @@ VOID_TASK_0(run)
     INFO("Computation time: %f sec.\n", t2-t1);
 }
 
+/**
+ * The ZDD variant: a solution is the set of squares with a queen.
+ * Rows are added one at a time by joining the partial solutions with the family of
+ * single queens on the new row, then removing the sets that contain an attacking pair.
+ */
+VOID_TASK_0(run_zdd)
+{
+    double t1 = wctime();
+
+    // Variables 0 ... (SIZE*SIZE-1)
+
+    ZDD res = zdd_true, row = zdd_false, attacks = zdd_false;
+    zdd_protect(&res);
+    zdd_protect(&row);
+    zdd_protect(&attacks);
+
+    INFO("Initialisation complete!\n");
+
+    if (report_minor) {
+        INFO("Placing queens on rows... ");
+    } else {
+        INFO("Placing queens on rows...\n");
+    }
+
+    for (size_t i=0; i<size; i++) {
+        if (report_minor) {
+            printf("%zu... ", i);
+            fflush(stdout);
+        }
+
+        // the family of single queens on row i, and of the pairs that attack a queen on row i from an earlier row
+        row = zdd_false;
+        attacks = zdd_false;
+        for (size_t j=0; j<size; j++) {
+            row = zdd_or(row, zdd_ithvar(i*size+j));
+            for (size_t k=0; k<i; k++) {
+                for (size_t l=0; l<size; l++) {
+                    if (l != j && l+i != j+k && l+k != j+i) continue;
+                    ZDD pair = zdd_makenode(k*size+l, zdd_false, zdd_ithvar(i*size+j));
+                    attacks = zdd_or(attacks, pair);
+                }
+            }
+        }
+
+        res = zdd_join(res, row);
+        res = zdd_nonsup(res, attacks);
+    }
+
+    if (report_minor) {
+        printf("\n");
+    }
+
+    double t2 = wctime();
+
+    INFO("Result: NQueens(%zu) has %.0f solutions.\n", size, zdd_pathcount(res));
+    INFO("Result ZDD has %zu nodes.\n", zdd_nodecount(&res, 1));
+    INFO("Computation time: %f sec.\n", t2-t1);
+
+    zdd_unprotect(&res);
+    zdd_unprotect(&row);
+    zdd_unprotect(&attacks);
+}
+
 int
 main(int argc, char** argv)
 {
@@ -319,12 +388,14 @@ main(int argc, char** argv)
     sylvan_init_package();
     sylvan_set_granularity(3); // granularity 3 is decent value for this small problem - 1 means "use cache for every operation"
     sylvan_init_bdd();
+    if (use_zdd) sylvan_init_zdd();
 
     // Before and after garbage collection, call gc_start and gc_end
     sylvan_gc_hook_pregc(TASK(gc_start));
     sylvan_gc_hook_postgc(TASK(gc_end));
 
-    RUN(run);
+    if (use_zdd) RUN(run_zdd);
+    else RUN(run);
 
     if (report_stats) {
         sylvan_stats_report(stdout);
@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# Reachability times of lddmc and bddmc on the models in this directory, with different spawn
+# cutoffs (see sylvan_set_spawn_cutoff) and numbers of Lace workers.
+#
+# Usage: bench-spawn-cutoff.sh <build directory> [<workers> ...]
+#
+# Prints one line per run: tool, model, strategy, workers, cutoff, time (in seconds).
+# The cutoff "always" spawns at every level, which is also the default of Sylvan (cutoff 0).
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <build directory> [<workers> ...]" >&2
+    exit 1
+fi
+
+BUILD=$1
+shift
+WORKERS=${*:-"1 2 4 8"}
+CUTOFFS=${CUTOFFS:-"always 8 16 32 64"}
+STRATEGIES=${STRATEGIES:-"par sat"}
+MODELS=$(dirname "$0")
+
+for tool in lddmc bddmc; do
+    ext=$(echo $tool | cut -c1-3)
+    for model in "$MODELS"/*.$ext; do
+        for strategy in $STRATEGIES; do
+            for w in $WORKERS; do
+                for cutoff in $CUTOFFS; do
+                    c=$cutoff
+                    [ $c = always ] && c=18446744073709551615
+                    t=$("$BUILD/examples/$tool" -w $w -s $strategy --spawn-cutoff=$c "$model" 2>&1 \
+                        | sed -n 's/.*[A-Z] Time: \([0-9.]*\).*/\1/p')
+                    echo "$tool $(basename "$model") $strategy $w $cutoff ${t:-failed}"
+                done
+            done
+        done
+    done
+done
@@ -59,7 +59,11 @@ namespace sylvan {
 #include <sylvan_mtbdd.h>
 #include <sylvan_bdd.h>
 #include <sylvan_ldd.h>
+#include <sylvan_ldd_learn.h>
 #include <sylvan_zdd.h>
+#include <sylvan_evbdd.h>
+#include <sylvan_solver.h>
+#include <sylvan_vec.h>
 
 #ifdef __cplusplus
 }
@@ -21,7 +21,9 @@
 #include <math.h>
 #include <string.h>
 
-#include <avl.h>
+#include <sylvan_codec.h>
+#include <sylvan_writer.h>
+#include <sylvan_serializer.h>
 
 static int granularity = 1; // default
 
@@ -102,8 +104,7 @@ TASK_IMPL_3(BDD, sylvan_and, BDD, a, BDD, b, BDDVAR, prev_level)
     } else if (bHigh == sylvan_true) {
         high = aHigh;
     } else {
-        bdd_refs_spawn(SPAWN(sylvan_and, aHigh, bHigh, level));
-        n=1;
+        n = SYLVAN_SPAWN_OR_DEFER(bdd, (sylvan_and, aHigh, bHigh, level));
     }
 
     if (aLow == sylvan_true) {
@@ -116,9 +117,9 @@ TASK_IMPL_3(BDD, sylvan_and, BDD, a, BDD, b, BDDVAR, prev_level)
         low = CALL(sylvan_and, aLow, bLow, level);
     }
 
-    if (n) {
+    if (n != 0) {
         bdd_refs_push(low);
-        high = bdd_refs_sync(SYNC(sylvan_and));
+        high = SYLVAN_JOIN(bdd, n, (sylvan_and, aHigh, bHigh, level));
         bdd_refs_pop(1);
     }
 
@@ -290,10 +291,7 @@ TASK_IMPL_3(BDD, sylvan_xor, BDD, a, BDD, b, BDDVAR, prev_level)
     // Recursive computation
     BDD low, high, result;
 
-    bdd_refs_spawn(SPAWN(sylvan_xor, aHigh, bHigh, level));
-    low = CALL(sylvan_xor, aLow, bLow, level);
-    bdd_refs_push(low);
-    high = bdd_refs_sync(SYNC(sylvan_xor));
+    SYLVAN_FORK(bdd, low, high, (sylvan_xor, aLow, bLow, level), (sylvan_xor, aHigh, bHigh, level));
     bdd_refs_pop(1);
 
     result = sylvan_makenode(level, low, high);
@@ -416,8 +414,7 @@ TASK_IMPL_4(BDD, sylvan_ite, BDD, a, BDD, b, BDD, c, BDDVAR, prev_level)
     } else if (aHigh == sylvan_false) {
         high = cHigh;
     } else {
-        bdd_refs_spawn(SPAWN(sylvan_ite, aHigh, bHigh, cHigh, level));
-        n=1;
+        n = SYLVAN_SPAWN_OR_DEFER(bdd, (sylvan_ite, aHigh, bHigh, cHigh, level));
     }
 
     if (aLow == sylvan_true) {
@@ -428,9 +425,9 @@ TASK_IMPL_4(BDD, sylvan_ite, BDD, a, BDD, b, BDD, c, BDDVAR, prev_level)
         low = CALL(sylvan_ite, aLow, bLow, cLow, level);
     }
 
-    if (n) {
+    if (n != 0) {
         bdd_refs_push(low);
-        high = bdd_refs_sync(SYNC(sylvan_ite));
+        high = SYLVAN_JOIN(bdd, n, (sylvan_ite, aHigh, bHigh, cHigh, level));
         bdd_refs_pop(1);
     }
 
@@ -691,10 +688,7 @@ TASK_IMPL_3(BDD, sylvan_exists, BDD, a, BDD, variables, BDDVAR, prev_level)
     } else {
         // level is not in variable set
         BDD low, high;
-        bdd_refs_spawn(SPAWN(sylvan_exists, aHigh, variables, level));
-        low = CALL(sylvan_exists, aLow, variables, level);
-        bdd_refs_push(low);
-        high = bdd_refs_sync(SYNC(sylvan_exists));
+        SYLVAN_FORK(bdd, low, high, (sylvan_exists, aLow, variables, level), (sylvan_exists, aHigh, variables, level));
         bdd_refs_pop(1);
         result = sylvan_makenode(level, low, high);
     }
@@ -906,10 +900,8 @@ TASK_IMPL_4(BDD, sylvan_and_exists, BDD, a, BDD, b, BDDSET, v, BDDVAR, prev_leve
         }
     } else {
         // level is not in variable set
-        bdd_refs_spawn(SPAWN(sylvan_and_exists, aHigh, bHigh, v, level));
-        BDD low = CALL(sylvan_and_exists, aLow, bLow, v, level);
-        bdd_refs_push(low);
-        BDD high = bdd_refs_sync(SYNC(sylvan_and_exists));
+        BDD low, high;
+        SYLVAN_FORK(bdd, low, high, (sylvan_and_exists, aLow, bLow, v, level), (sylvan_and_exists, aHigh, bHigh, v, level));
         bdd_refs_pop(1);
         result = sylvan_makenode(level, low, high);
     }
@@ -2133,189 +2125,212 @@ TASK_IMPL_4(BDD, sylvan_collect, BDD, bdd, BDDSET, vars, sylvan_collect_cb, cb,
  * SERIALIZATION
  */
 
-struct sylvan_ser {
-    BDD bdd;
-    size_t assigned;
-};
-
-// Define a AVL tree type with prefix 'sylvan_ser' holding
-// nodes of struct sylvan_ser with the following compare() function...
-AVL(sylvan_ser, struct sylvan_ser)
+static int
+bdd_ser_children(uint64_t index, uint64_t *children)
 {
-    if (left->bdd > right->bdd) return 1;
-    if (left->bdd < right->bdd) return -1;
-    return 0;
+    bddnode_t n = MTBDD_GETNODE(index);
+    children[0] = BDD_STRIPMARK(bddnode_getlow(n));
+    children[1] = BDD_STRIPMARK(bddnode_gethigh(n));
+    return 2;
 }
 
-// Define a AVL tree type with prefix 'sylvan_ser_reversed' holding
-// nodes of struct sylvan_ser with the following compare() function...
-AVL(sylvan_ser_reversed, struct sylvan_ser)
+static void
+bdd_ser_encode(sylvan_ser_t s, uint64_t index, sylvan_codec_node_t *node)
 {
-    if (left->assigned > right->assigned) return 1;
-    if (left->assigned < right->assigned) return -1;
-    return 0;
+    bddnode_t n = MTBDD_GETNODE(index);
+    node->key = bddnode_getvariable(n);
+    node->child[0] = sylvan_serializer_get(s, bddnode_getlow(n));
+    node->child[1] = sylvan_serializer_get(s, bddnode_gethigh(n));
 }
 
-// Initially, both sets are empty
-static avl_node_t *sylvan_ser_set = NULL;
-static avl_node_t *sylvan_ser_reversed_set = NULL;
+static void
+bdd_ser_to_record(const sylvan_codec_node_t *node, uint64_t *rec)
+{
+    bddnode_makenode((bddnode_t)rec, node->key, node->child[0] & ~SYLVAN_CODEC_FLAG, node->child[1]);
+}
 
-// Start counting (assigning numbers to BDDs) at 1
-static size_t sylvan_ser_counter = 1;
-static size_t sylvan_ser_done = 0;
+static int
+bdd_ser_record_children(void *ctx, const uint64_t *rec, uint64_t *children)
+{
+    bddnode_t n = (bddnode_t)rec;
+    children[0] = bddnode_getlow(n);
+    children[1] = BDD_STRIPMARK(bddnode_gethigh(n));
+    (void)ctx;
+    return 2;
+}
 
-// Given a BDD, assign unique numbers to all nodes
-static size_t
-sylvan_serialize_assign_rec(BDD bdd)
+static uint64_t
+bdd_ser_record_make(void *ctx, const uint64_t *rec, const uint64_t *arr)
 {
-    if (sylvan_isnode(bdd)) {
-        bddnode_t n = MTBDD_GETNODE(bdd);
-
-        struct sylvan_ser s, *ss;
-        s.bdd = BDD_STRIPMARK(bdd);
-        ss = sylvan_ser_search(sylvan_ser_set, &s);
-        if (ss == NULL) {
-            // assign dummy value
-            s.assigned = 0;
-            ss = sylvan_ser_put(&sylvan_ser_set, &s, NULL);
-
-            // first assign recursively
-            sylvan_serialize_assign_rec(bddnode_getlow(n));
-            sylvan_serialize_assign_rec(bddnode_gethigh(n));
-
-            // assign real value
-            ss->assigned = sylvan_ser_counter++;
-
-            // put a copy in the reversed table
-            sylvan_ser_reversed_insert(&sylvan_ser_reversed_set, ss);
-        }
+    bddnode_t n = (bddnode_t)rec;
+    BDD low = arr[bddnode_getlow(n)];
+    BDD high = bddnode_gethigh(n);
+    high = BDD_TRANSFERMARK(high, arr[BDD_STRIPMARK(high)]);
+    (void)ctx;
+    return sylvan_makenode(bddnode_getvariable(n), low, high);
+}
 
-        return ss->assigned;
-    }
+static const sylvan_ser_ops_t bdd_ser_ops = {
+    1, // 0 is the constant false
+    bdd_ser_children,
+    bdd_ser_encode,
+    bdd_ser_to_record,
+    bdd_ser_record_children,
+    bdd_ser_record_make,
+    NULL, // no leaves
+    NULL,
+};
 
-    return BDD_STRIPMARK(bdd);
+sylvan_serializer_t
+sylvan_serializer_alloc()
+{
+    return sylvan_ser_alloc(&bdd_ser_ops);
 }
 
-size_t
-sylvan_serialize_add(BDD bdd)
+void
+sylvan_serializer_free(sylvan_serializer_t s)
 {
-    return BDD_TRANSFERMARK(bdd, sylvan_serialize_assign_rec(bdd));
+    sylvan_ser_free(s);
 }
 
 void
-sylvan_serialize_reset()
+sylvan_serializer_reset(sylvan_serializer_t s)
+{
+    sylvan_ser_reset(s);
+}
+
+TASK_IMPL_2(size_t, sylvan_serializer_add, sylvan_serializer_t, s, BDD, bdd)
 {
-    sylvan_ser_free(&sylvan_ser_set);
-    sylvan_ser_free(&sylvan_ser_reversed_set);
-    sylvan_ser_counter = 1;
-    sylvan_ser_done = 0;
+    return BDD_TRANSFERMARK(bdd, CALL(sylvan_ser_add, s, BDD_STRIPMARK(bdd)));
 }
 
 size_t
-sylvan_serialize_get(BDD bdd)
+sylvan_serializer_get(sylvan_serializer_t s, BDD bdd)
 {
-    if (!sylvan_isnode(bdd)) return bdd;
-    struct sylvan_ser s, *ss;
-    s.bdd = BDD_STRIPMARK(bdd);
-    ss = sylvan_ser_search(sylvan_ser_set, &s);
-    assert(ss != NULL);
-    return BDD_TRANSFERMARK(bdd, ss->assigned);
+    return BDD_TRANSFERMARK(bdd, sylvan_ser_get(s, BDD_STRIPMARK(bdd)));
 }
 
 BDD
-sylvan_serialize_get_reversed(size_t value)
+sylvan_serializer_get_reversed(sylvan_serializer_t s, size_t value)
 {
-    if (!sylvan_isnode(value)) return value;
-    struct sylvan_ser s, *ss;
-    s.assigned = BDD_STRIPMARK(value);
-    ss = sylvan_ser_reversed_search(sylvan_ser_reversed_set, &s);
-    assert(ss != NULL);
-    return BDD_TRANSFERMARK(value, ss->bdd);
+    return BDD_TRANSFERMARK(value, sylvan_ser_get_reversed(s, BDD_STRIPMARK(value)));
 }
 
 void
-sylvan_serialize_totext(FILE *out)
+sylvan_serializer_totext(sylvan_serializer_t s, FILE *out)
 {
     fprintf(out, "[");
-    avl_iter_t *it = sylvan_ser_reversed_iter(sylvan_ser_reversed_set);
-    struct sylvan_ser *s;
-
-    while ((s=sylvan_ser_reversed_iter_next(it))) {
-        BDD bdd = s->bdd;
-        bddnode_t n = MTBDD_GETNODE(bdd);
-        fprintf(out, "(%zu,%u,%zu,%zu,%u),", s->assigned,
+    const uint64_t end = sylvan_ser_end(s);
+    for (uint64_t i=1; i<end; i++) {
+        bddnode_t n = MTBDD_GETNODE(sylvan_ser_get_reversed(s, i));
+        const size_t high = sylvan_serializer_get(s, bddnode_gethigh(n));
+        fprintf(out, "(%zu,%u,%zu,%zu,%u),", (size_t)i,
                                              bddnode_getvariable(n),
-                                             (size_t)bddnode_getlow(n),
-                                             (size_t)BDD_STRIPMARK(bddnode_gethigh(n)),
-                                             BDD_HASMARK(bddnode_gethigh(n)) ? 1 : 0);
+                                             sylvan_serializer_get(s, bddnode_getlow(n)),
+                                             (size_t)BDD_STRIPMARK(high),
+                                             BDD_HASMARK(high) ? 1 : 0);
     }
-
-    sylvan_ser_reversed_iter_free(it);
     fprintf(out, "]");
 }
 
+VOID_TASK_IMPL_2(sylvan_serializer_tofile, sylvan_serializer_t, s, FILE*, out)
+{
+    CALL(sylvan_ser_tofile, s, out);
+}
+
+TASK_IMPL_2(int, sylvan_serializer_fromfile, sylvan_serializer_t, s, FILE*, in)
+{
+    return CALL(sylvan_ser_fromfile, s, in);
+}
+
 void
-sylvan_serialize_tofile(FILE *out)
+sylvan_serializer_write_begin(sylvan_serializer_t s, FILE *out)
 {
-    size_t count = avl_count(sylvan_ser_reversed_set);
-    assert(count >= sylvan_ser_done);
-    assert(count == sylvan_ser_counter-1);
-    count -= sylvan_ser_done;
-    fwrite(&count, sizeof(size_t), 1, out);
+    sylvan_ser_write_begin(s, out);
+}
 
-    struct sylvan_ser *s;
-    avl_iter_t *it = sylvan_ser_reversed_iter(sylvan_ser_reversed_set);
+TASK_IMPL_3(size_t, sylvan_serializer_write_push, sylvan_serializer_t, s, FILE*, out, BDD, bdd)
+{
+    const size_t key = CALL(sylvan_serializer_add, s, bdd);
+    CALL(sylvan_ser_write_push, s, out, key);
+    return key;
+}
 
-    /* Skip already written entries */
-    size_t index = 0;
-    while (index < sylvan_ser_done && (s=sylvan_ser_reversed_iter_next(it))) {
-        index++;
-        assert(s->assigned == index);
-    }
+VOID_TASK_IMPL_2(sylvan_serializer_write_end, sylvan_serializer_t, s, FILE*, out)
+{
+    CALL(sylvan_ser_write_end, s, out);
+}
 
-    while ((s=sylvan_ser_reversed_iter_next(it))) {
-        index++;
-        assert(s->assigned == index);
+int
+sylvan_serializer_read_begin(sylvan_serializer_t s, FILE *in)
+{
+    return sylvan_ser_read_begin(s, in);
+}
 
-        bddnode_t n = MTBDD_GETNODE(s->bdd);
+TASK_IMPL_3(int, sylvan_serializer_read_next, sylvan_serializer_t, s, FILE*, in, BDD*, bdd)
+{
+    uint64_t key;
+    const int res = CALL(sylvan_ser_read_next, s, in, &key);
+    if (res == 1) *bdd = sylvan_serializer_get_reversed(s, key);
+    return res;
+}
 
-        struct bddnode node;
-        bddnode_makenode(&node, bddnode_getvariable(n), sylvan_serialize_get(bddnode_getlow(n)), sylvan_serialize_get(bddnode_gethigh(n)));
+/**
+ * The functions without a serializer use a global serializer.
+ */
 
-        fwrite(&node, sizeof(struct bddnode), 1, out);
-    }
+static sylvan_serializer_t sylvan_serializer_default = NULL;
 
-    sylvan_ser_done = sylvan_ser_counter-1;
-    sylvan_ser_reversed_iter_free(it);
+static sylvan_serializer_t
+sylvan_serializer_global()
+{
+    if (sylvan_serializer_default == NULL) sylvan_serializer_default = sylvan_serializer_alloc();
+    return sylvan_serializer_default;
+}
+
+size_t
+sylvan_serialize_add(BDD bdd)
+{
+    return sylvan_serializer_add(sylvan_serializer_global(), bdd);
 }
 
 void
-sylvan_serialize_fromfile(FILE *in)
+sylvan_serialize_reset()
 {
-    size_t count, i;
-    if (fread(&count, sizeof(size_t), 1, in) != 1) {
-        // TODO FIXME return error
-        printf("sylvan_serialize_fromfile: file format error, giving up\n");
-        exit(-1);
-    }
+    sylvan_serializer_reset(sylvan_serializer_global());
+}
 
-    for (i=1; i<=count; i++) {
-        struct bddnode node;
-        if (fread(&node, sizeof(struct bddnode), 1, in) != 1) {
-            // TODO FIXME return error
-            printf("sylvan_serialize_fromfile: file format error, giving up\n");
-            exit(-1);
-        }
+size_t
+sylvan_serialize_get(BDD bdd)
+{
+    return sylvan_serializer_get(sylvan_serializer_global(), bdd);
+}
 
-        BDD low = sylvan_serialize_get_reversed(bddnode_getlow(&node));
-        BDD high = sylvan_serialize_get_reversed(bddnode_gethigh(&node));
+BDD
+sylvan_serialize_get_reversed(size_t value)
+{
+    return sylvan_serializer_get_reversed(sylvan_serializer_global(), value);
+}
 
-        struct sylvan_ser s;
-        s.bdd = sylvan_makenode(bddnode_getvariable(&node), low, high);
-        s.assigned = ++sylvan_ser_done; // starts at 0 but we want 1-based...
+void
+sylvan_serialize_totext(FILE *out)
+{
+    sylvan_serializer_totext(sylvan_serializer_global(), out);
+}
 
-        sylvan_ser_insert(&sylvan_ser_set, &s);
-        sylvan_ser_reversed_insert(&sylvan_ser_reversed_set, &s);
+void
+sylvan_serialize_tofile(FILE *out)
+{
+    sylvan_serializer_tofile(sylvan_serializer_global(), out);
+}
+
+void
+sylvan_serialize_fromfile(FILE *in)
+{
+    if (sylvan_serializer_fromfile(sylvan_serializer_global(), in) != 0) {
+        // TODO FIXME return error
+        printf("sylvan_serialize_fromfile: file format error, giving up\n");
+        exit(-1);
     }
 }
 
@@ -255,19 +255,88 @@ TASK_DECL_2(double, sylvan_pathcount, BDD, BDDVAR);
 #define sylvan_pathcount(bdd) (RUN(sylvan_pathcount, bdd, 0))
 
 /**
+ * Serializers assign numbers to BDD nodes, to write BDDs to file and read them back.
+ * Nodes are numbered from 1, with children before their parents; 0 is sylvan_false, and the
+ * number of a complemented BDD is complemented. Numbers are assigned in parallel.
+ * Every serializer has its own numbering, so different serializers can be used concurrently,
+ * for instance to write different files in different threads.
+ *
  * SAVING:
- * use sylvan_serialize_add on every BDD you want to store
- * use sylvan_serialize_get to retrieve the key of every stored BDD
- * use sylvan_serialize_tofile
+ * use sylvan_serializer_add on every BDD you want to store
+ * use sylvan_serializer_get to retrieve the key of every stored BDD
+ * use sylvan_serializer_tofile (writes only the nodes added since the previous call)
  *
  * LOADING:
- * use sylvan_serialize_fromfile (implies sylvan_serialize_reset)
- * use sylvan_serialize_get_reversed for every key
+ * use sylvan_serializer_fromfile (the nodes are numbered after the nodes already in the serializer)
+ * use sylvan_serializer_get_reversed for every key
+ *
+ * STREAMING (to a pipe or socket, read without seeking):
+ * use sylvan_serializer_write_begin, then sylvan_serializer_write_push for every BDD (which writes
+ * its new nodes and its key, and flushes), then sylvan_serializer_write_end
+ * use sylvan_serializer_read_begin, then sylvan_serializer_read_next until it returns 0; the nodes
+ * are created one block at a time as they arrive, so the reader needs little memory
  *
  * MISC:
- * use sylvan_serialize_reset to free all allocated structures
- * use sylvan_serialize_totext to write a textual list of tuples of all BDDs.
+ * use sylvan_serializer_reset to forget all numbers
+ * use sylvan_serializer_totext to write a textual list of tuples of all BDDs.
  *         format: [(<key>,<level>,<key_low>,<key_high>,<complement_high>),...]
+ *
+ * Numbered nodes are not garbage collected until the serializer is reset or freed.
+ */
+typedef struct sylvan_ser *sylvan_serializer_t;
+
+sylvan_serializer_t sylvan_serializer_alloc(void);
+void sylvan_serializer_free(sylvan_serializer_t s);
+void sylvan_serializer_reset(sylvan_serializer_t s);
+
+TASK_DECL_2(size_t, sylvan_serializer_add, sylvan_serializer_t, BDD);
+#define sylvan_serializer_add(s, bdd) RUN(sylvan_serializer_add, s, bdd)
+
+size_t sylvan_serializer_get(sylvan_serializer_t s, BDD bdd);
+BDD sylvan_serializer_get_reversed(sylvan_serializer_t s, size_t value);
+void sylvan_serializer_totext(sylvan_serializer_t s, FILE *out);
+
+VOID_TASK_DECL_2(sylvan_serializer_tofile, sylvan_serializer_t, FILE*);
+#define sylvan_serializer_tofile(s, out) RUN(sylvan_serializer_tofile, s, out)
+
+/**
+ * Read a section of a file. Returns 0, or -1 if the file is invalid.
+ */
+TASK_DECL_2(int, sylvan_serializer_fromfile, sylvan_serializer_t, FILE*);
+#define sylvan_serializer_fromfile(s, in) RUN(sylvan_serializer_fromfile, s, in)
+
+/**
+ * Start a stream. Nodes that already have a number are written with the first BDD.
+ */
+void sylvan_serializer_write_begin(sylvan_serializer_t s, FILE *out);
+
+/**
+ * Add a BDD to the stream. Returns its key.
+ */
+TASK_DECL_3(size_t, sylvan_serializer_write_push, sylvan_serializer_t, FILE*, BDD);
+#define sylvan_serializer_write_push(s, out, bdd) RUN(sylvan_serializer_write_push, s, out, bdd)
+
+/**
+ * End a stream.
+ */
+VOID_TASK_DECL_2(sylvan_serializer_write_end, sylvan_serializer_t, FILE*);
+#define sylvan_serializer_write_end(s, out) RUN(sylvan_serializer_write_end, s, out)
+
+/**
+ * Forget all numbers and start reading a stream. Returns 0, or -1 if it is not a stream.
+ */
+int sylvan_serializer_read_begin(sylvan_serializer_t s, FILE *in);
+
+/**
+ * Read the next BDD of a stream into <bdd>.
+ * Returns 1, or 0 at the end of the stream, or -1 if the stream is invalid.
+ */
+TASK_DECL_3(int, sylvan_serializer_read_next, sylvan_serializer_t, FILE*, BDD*);
+#define sylvan_serializer_read_next(s, in, bdd) RUN(sylvan_serializer_read_next, s, in, bdd)
+
+/**
+ * The same functions for a global serializer.
+ * sylvan_serialize_fromfile exits the program if the file is invalid.
  */
 size_t sylvan_serialize_add(BDD bdd);
 size_t sylvan_serialize_get(BDD bdd);
@@ -280,10 +349,11 @@ void sylvan_serialize_fromfile(FILE *in);
 static void __attribute__((unused))
 sylvan_fprint(FILE *f, BDD bdd)
 {
-    sylvan_serialize_reset();
-    size_t v = sylvan_serialize_add(bdd);
+    sylvan_serializer_t s = sylvan_serializer_alloc();
+    size_t v = sylvan_serializer_add(s, bdd);
     fprintf(f, "%s%zu,", bdd&sylvan_complement?"!":"", v);
-    sylvan_serialize_totext(f);
+    sylvan_serializer_totext(s, f);
+    sylvan_serializer_free(s);
 }
 
 static void __attribute__((unused))
@@ -0,0 +1,580 @@
+/*
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <string.h>
+
+#include <sylvan_codec.h>
+
+/* Maximum number of nodes in a block */
+#define CODEC_BLOCK_NODES SYLVAN_CODEC_BLOCK_NODES
+
+/* Maximum length of an encoded node: a run header and two children */
+#define CODEC_NODE_BOUND 40
+
+/* Maximum length of a varint */
+#define CODEC_VARINT_BOUND 10
+
+/* The LZ codec finds matches of at least 4 bytes within the last 64 KB with a hash table */
+#define LZ_HASH_BITS 14
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+
+/**
+ * Varints (7 bits per byte, least significant first)
+ */
+
+static inline size_t
+codec_put(uint8_t *p, uint64_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline int
+codec_get(const uint8_t **p, const uint8_t *end, uint64_t *v)
+{
+    const uint8_t *q = *p;
+    uint64_t res = 0;
+    for (int shift=0; shift<64; shift+=7) {
+        if (q == end) return -1;
+        const uint8_t b = *q++;
+        res |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            *p = q;
+            *v = res;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int
+sylvan_codec_write_varint(FILE *out, uint64_t value)
+{
+    uint8_t buf[CODEC_VARINT_BOUND];
+    const size_t n = codec_put(buf, value);
+    return fwrite(buf, 1, n, out) == n ? 0 : -1;
+}
+
+int
+sylvan_codec_read_varint(FILE *in, uint64_t *value)
+{
+    uint64_t res = 0;
+    for (int shift=0; shift<64; shift+=7) {
+        const int b = getc(in);
+        if (b == EOF) return -1;
+        res |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            *value = res;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void
+sylvan_codec_array_get(void *ctx, uint64_t number, sylvan_codec_node_t *node)
+{
+    sylvan_codec_array_t *arr = (sylvan_codec_array_t*)ctx;
+    *node = arr->nodes[number - arr->first];
+}
+
+void
+sylvan_codec_array_put(void *ctx, uint64_t number, const sylvan_codec_node_t *node)
+{
+    sylvan_codec_array_t *arr = (sylvan_codec_array_t*)ctx;
+    arr->nodes[number - arr->first] = *node;
+}
+
+int
+sylvan_codec_write_header(FILE *out)
+{
+    const int format = sylvan_get_file_format();
+    if (format == SYLVAN_FILE_RAW) return -1;
+    fwrite(SYLVAN_CODEC_MAGIC, 1, 8, out);
+    fputc(format, out);
+    return 0;
+}
+
+int
+sylvan_codec_read_header(FILE *in, uint64_t *count)
+{
+    uint8_t buf[8];
+    if (fread(buf, 1, 8, in) != 8) return -1;
+    if (memcmp(buf, SYLVAN_CODEC_MAGIC, 8) != 0) {
+        memcpy(count, buf, 8);
+        return 0;
+    }
+    const int format = getc(in);
+    if (format != SYLVAN_FILE_COMPACT && format != SYLVAN_FILE_LZ) return -1;
+    return 1;
+}
+
+void
+sylvan_codec_write_stream_header(FILE *out)
+{
+    const int format = sylvan_get_file_format();
+    fwrite(SYLVAN_CODEC_STREAM_MAGIC, 1, 8, out);
+    fputc(format == SYLVAN_FILE_LZ ? SYLVAN_FILE_LZ : SYLVAN_FILE_COMPACT, out);
+}
+
+int
+sylvan_codec_read_stream_header(FILE *in)
+{
+    uint8_t buf[8];
+    if (fread(buf, 1, 8, in) != 8) return -1;
+    if (memcmp(buf, SYLVAN_CODEC_STREAM_MAGIC, 8) != 0) return -1;
+    const int format = getc(in);
+    if (format != SYLVAN_FILE_COMPACT && format != SYLVAN_FILE_LZ) return -1;
+    return 0;
+}
+
+/**
+ * Encoding and decoding the nodes of a block
+ */
+
+static size_t
+codec_encode(const sylvan_codec_node_t *nodes, size_t count, uint64_t first, uint64_t constants, uint8_t *dst)
+{
+    uint8_t *p = dst;
+    size_t i = 0;
+    while (i < count) {
+        size_t j = i + 1;
+        while (j < count && nodes[j].key == nodes[i].key) j++;
+        p += codec_put(p, nodes[i].key);
+        p += codec_put(p, j - i);
+        for (; i<j; i++) {
+            const uint64_t n = first + i;
+            for (int k=0; k<2; k++) {
+                const uint64_t c = nodes[i].child[k] & ~SYLVAN_CODEC_FLAG;
+                const uint64_t f = nodes[i].child[k] >> 63;
+                assert(c < constants || c < n);
+                const uint64_t v = c < constants ? c : constants + n - 1 - c;
+                p += codec_put(p, v << 1 | f);
+            }
+        }
+    }
+    return p - dst;
+}
+
+static int
+codec_decode(const uint8_t *p, size_t len, size_t count, uint64_t first, uint64_t constants, sylvan_codec_put_cb put_cb, void *ctx)
+{
+    const uint8_t *end = p + len;
+    size_t i = 0;
+    while (i < count) {
+        uint64_t key, run;
+        if (codec_get(&p, end, &key) != 0 || codec_get(&p, end, &run) != 0) return -1;
+        if (run == 0 || run > count - i) return -1;
+        for (uint64_t r=0; r<run; r++, i++) {
+            const uint64_t n = first + i;
+            sylvan_codec_node_t node;
+            node.key = key;
+            for (int k=0; k<2; k++) {
+                uint64_t v;
+                if (codec_get(&p, end, &v) != 0) return -1;
+                const uint64_t f = v & 1;
+                v >>= 1;
+                /* a child that is not a constant precedes the node */
+                if (v >= constants && v > n - 1) return -1;
+                const uint64_t c = v < constants ? v : constants + n - 1 - v;
+                node.child[k] = c | (f << 63);
+            }
+            put_cb(ctx, n, &node);
+        }
+    }
+    return p == end ? 0 : -1;
+}
+
+/**
+ * Built-in LZ codec, a byte-oriented LZ77 in the style of LZ4.
+ * A sequence is a token (4 bits literal length, 4 bits match length - 4), more length bytes
+ * if the literal length is 15, the literals, a 2-byte offset, and more length bytes if the match
+ * length is 19 or more. The last sequence only has literals.
+ */
+
+static inline uint32_t
+lz_read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t
+lz_read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint32_t
+lz_hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+static inline uint8_t*
+lz_put_length(uint8_t *op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static inline int
+lz_get_length(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+    uint8_t b;
+    do {
+        if (*ip == iend) return -1;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+size_t
+sylvan_lz_compress(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    if (len < 16) return 0;
+
+    uint32_t *table = calloc((size_t)1 << LZ_HASH_BITS, sizeof(uint32_t));
+    if (table == NULL) return 0;
+    const uint8_t *ip = src, *anchor = src;
+    const uint8_t *end = src + len, *mflimit = end - LZ_MIN_MATCH;
+    uint8_t *op = dst, *oend = dst + len;
+
+    while (ip <= mflimit) {
+        const uint32_t seq = lz_read32(ip);
+        const uint32_t h = lz_hash(seq);
+        const uint8_t *ref = src + table[h];
+        table[h] = (uint32_t)(ip - src);
+        if (ref >= ip || ip - ref > LZ_MAX_OFFSET || lz_read32(ref) != seq) {
+            /* skip ahead faster in data that does not compress */
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        const uint8_t *m = ip + LZ_MIN_MATCH, *r = ref + LZ_MIN_MATCH;
+        while (end - m >= 8 && lz_read64(m) == lz_read64(r)) {
+            m += 8;
+            r += 8;
+        }
+        while (m < end && *m == *r) {
+            m++;
+            r++;
+        }
+
+        const size_t litlen = ip - anchor, matchlen = m - ip - LZ_MIN_MATCH;
+        if ((size_t)(oend - op) < 4 + litlen + litlen/255 + matchlen/255 + 1) {
+            free(table);
+            return 0;
+        }
+        uint8_t *token = op++;
+        *token = (uint8_t)((litlen < 15 ? litlen : 15) << 4 | (matchlen < 15 ? matchlen : 15));
+        if (litlen >= 15) op = lz_put_length(op, litlen - 15);
+        memcpy(op, anchor, litlen);
+        op += litlen;
+        const size_t offset = ip - ref;
+        *op++ = (uint8_t)offset;
+        *op++ = (uint8_t)(offset >> 8);
+        if (matchlen >= 15) op = lz_put_length(op, matchlen - 15);
+        ip = anchor = m;
+    }
+    free(table);
+
+    const size_t litlen = end - anchor;
+    if ((size_t)(oend - op) <= 1 + litlen + litlen/255 + 1) return 0;
+    *op++ = (uint8_t)((litlen < 15 ? litlen : 15) << 4);
+    if (litlen >= 15) op = lz_put_length(op, litlen - 15);
+    memcpy(op, anchor, litlen);
+    op += litlen;
+    return op - dst;
+}
+
+int
+sylvan_lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t rawlen)
+{
+    const uint8_t *ip = src, *iend = src + len;
+    uint8_t *op = dst, *oend = dst + rawlen;
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+        size_t litlen = token >> 4;
+        if (litlen == 15 && lz_get_length(&ip, iend, &litlen) != 0) return -1;
+        if (litlen > (size_t)(iend - ip) || litlen > (size_t)(oend - op)) return -1;
+        memcpy(op, ip, litlen);
+        op += litlen;
+        ip += litlen;
+        if (ip == iend) break;
+
+        if (iend - ip < 2) return -1;
+        const size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return -1;
+        size_t matchlen = token & 15;
+        if (matchlen == 15 && lz_get_length(&ip, iend, &matchlen) != 0) return -1;
+        matchlen += LZ_MIN_MATCH;
+        if (matchlen > (size_t)(oend - op)) return -1;
+
+        const uint8_t *r = op - offset;
+        if (offset >= matchlen) {
+            memcpy(op, r, matchlen);
+        } else {
+            /* the match overlaps the bytes it produces */
+            for (size_t i=0; i<matchlen; i++) op[i] = r[i];
+        }
+        op += matchlen;
+    }
+
+    return op == oend ? 0 : -1;
+}
+
+/**
+ * Writing and reading blocks in parallel
+ */
+
+typedef struct codec_block
+{
+    uint64_t first;     // number of the first node
+    size_t count;       // number of nodes
+    uint8_t *data;      // written: the complete block; read: the (compressed) encoded nodes
+    size_t len;         // length of data
+    size_t rawlen;      // read: length of the encoded nodes
+    int compressed;     // read: whether data is compressed
+    int result;         // read: result of decoding
+} codec_block_t;
+
+typedef struct codec_job
+{
+    uint64_t constants;
+    int lz;
+    sylvan_codec_get_cb get_cb;
+    sylvan_codec_put_cb put_cb;
+    void *ctx;
+} codec_job_t;
+
+static void
+codec_encode_block(codec_job_t *job, codec_block_t *b)
+{
+    sylvan_codec_node_t *nodes = malloc(sizeof(sylvan_codec_node_t) * b->count);
+    uint8_t *raw = malloc(CODEC_NODE_BOUND * b->count);
+    if (nodes == NULL || raw == NULL) {
+        fprintf(stderr, "sylvan_codec_write_nodes: Unable to allocate memory!\n");
+        exit(1);
+    }
+    for (size_t i=0; i<b->count; i++) job->get_cb(job->ctx, b->first + i, nodes + i);
+
+    const size_t rawlen = codec_encode(nodes, b->count, b->first, job->constants, raw);
+    free(nodes);
+
+    uint8_t *lz = NULL;
+    size_t lzlen = 0;
+    if (job->lz) {
+        // without memory for compressing, the block is stored uncompressed
+        lz = malloc(rawlen);
+        if (lz != NULL) lzlen = sylvan_lz_compress(raw, rawlen, lz);
+    }
+
+    b->data = malloc(3 * CODEC_VARINT_BOUND + rawlen);
+    if (b->data == NULL) {
+        fprintf(stderr, "sylvan_codec_write_nodes: Unable to allocate memory!\n");
+        exit(1);
+    }
+    uint8_t *p = b->data;
+    p += codec_put(p, b->count);
+    p += codec_put(p, rawlen);
+    p += codec_put(p, lzlen);
+    if (lzlen != 0) memcpy(p, lz, lzlen);
+    else memcpy(p, raw, rawlen);
+    b->len = (p - b->data) + (lzlen != 0 ? lzlen : rawlen);
+
+    free(raw);
+    free(lz);
+}
+
+static void
+codec_decode_block(codec_job_t *job, codec_block_t *b)
+{
+    if (!b->compressed) {
+        b->result = codec_decode(b->data, b->len, b->count, b->first, job->constants, job->put_cb, job->ctx);
+        return;
+    }
+    uint8_t *raw = malloc(b->rawlen > 0 ? b->rawlen : 1);
+    if (raw == NULL) {
+        b->result = -1;
+        return;
+    }
+    b->result = sylvan_lz_decompress(b->data, b->len, raw, b->rawlen);
+    if (b->result == 0) b->result = codec_decode(raw, b->rawlen, b->count, b->first, job->constants, job->put_cb, job->ctx);
+    free(raw);
+}
+
+VOID_TASK_4(codec_blocks_par, codec_job_t*, job, codec_block_t*, blocks, size_t, count, int, encode)
+{
+    if (count > 1) {
+        SPAWN(codec_blocks_par, job, blocks, count/2, encode);
+        CALL(codec_blocks_par, job, blocks + count/2, count - count/2, encode);
+        SYNC(codec_blocks_par);
+    } else if (count == 1) {
+        if (encode) codec_encode_block(job, blocks);
+        else codec_decode_block(job, blocks);
+    }
+}
+
+/**
+ * Divide the nodes <first> ... <first>+<count>-1 from <done> on into at most <batch> blocks.
+ * Returns the number of blocks.
+ */
+static size_t
+codec_batch(codec_block_t *blocks, size_t batch, uint64_t first, size_t count, size_t done)
+{
+    size_t n = 0;
+    while (n < batch && done < count) {
+        blocks[n].first = first + done;
+        blocks[n].count = count - done < CODEC_BLOCK_NODES ? count - done : CODEC_BLOCK_NODES;
+        done += blocks[n].count;
+        n++;
+    }
+    return n;
+}
+
+VOID_TASK_IMPL_6(sylvan_codec_write_nodes, FILE*, out, uint64_t, first, size_t, count, uint64_t, constants, sylvan_codec_get_cb, get_cb, void*, ctx)
+{
+    codec_job_t job = { constants, sylvan_get_file_format() == SYLVAN_FILE_LZ, get_cb, NULL, ctx };
+    const size_t batch = lace_workers() > 1 ? lace_workers() : 1;
+    codec_block_t *blocks[2];
+    blocks[0] = malloc(sizeof(codec_block_t) * batch);
+    blocks[1] = malloc(sizeof(codec_block_t) * batch);
+    if (blocks[0] == NULL || blocks[1] == NULL) {
+        fprintf(stderr, "sylvan_codec_write_nodes: Unable to allocate memory!\n");
+        exit(1);
+    }
+
+    size_t done = 0;
+    size_t n = codec_batch(blocks[0], batch, first, count, done);
+    for (size_t i=0; i<n; i++) done += blocks[0][i].count;
+    CALL(codec_blocks_par, &job, blocks[0], n, 1);
+
+    /* Write the current blocks while the next blocks are encoded */
+    int cur = 0;
+    while (n > 0) {
+        const size_t next_n = codec_batch(blocks[1-cur], batch, first, count, done);
+        for (size_t i=0; i<next_n; i++) done += blocks[1-cur][i].count;
+        if (next_n > 0) SPAWN(codec_blocks_par, &job, blocks[1-cur], next_n, 1);
+        for (size_t i=0; i<n; i++) {
+            fwrite(blocks[cur][i].data, 1, blocks[cur][i].len, out);
+            free(blocks[cur][i].data);
+        }
+        if (next_n > 0) SYNC(codec_blocks_par);
+        n = next_n;
+        cur = 1 - cur;
+    }
+
+    free(blocks[0]);
+    free(blocks[1]);
+}
+
+/**
+ * Read at most <batch> blocks for the nodes from <done> on. Returns the number of blocks read,
+ * or -1 if the blocks are invalid or cannot be allocated.
+ */
+static int64_t
+codec_read_batch(FILE *in, codec_block_t *blocks, size_t batch, uint64_t first, size_t count, size_t *done)
+{
+    size_t n = 0;
+    while (n < batch && *done < count) {
+        codec_block_t *b = blocks + n;
+        uint64_t nodecount, rawlen, lzlen;
+        if (sylvan_codec_read_varint(in, &nodecount) != 0 ||
+            sylvan_codec_read_varint(in, &rawlen) != 0 ||
+            sylvan_codec_read_varint(in, &lzlen) != 0) break;
+        if (nodecount == 0 || nodecount > CODEC_BLOCK_NODES || nodecount > count - *done) break;
+        if (rawlen > CODEC_NODE_BOUND * nodecount || (lzlen != 0 && lzlen >= rawlen)) break;
+        b->first = first + *done;
+        b->count = nodecount;
+        b->rawlen = rawlen;
+        b->compressed = lzlen != 0;
+        b->len = lzlen != 0 ? lzlen : rawlen;
+        b->data = malloc(b->len > 0 ? b->len : 1);
+        if (b->data == NULL) break;
+        if (fread(b->data, 1, b->len, in) != b->len) {
+            free(b->data);
+            break;
+        }
+        *done += nodecount;
+        n++;
+    }
+    if (n < batch && *done < count) {
+        for (size_t i=0; i<n; i++) free(blocks[i].data);
+        return -1;
+    }
+    return (int64_t)n;
+}
+
+TASK_IMPL_6(int, sylvan_codec_read_nodes, FILE*, in, uint64_t, first, size_t, count, uint64_t, constants, sylvan_codec_put_cb, put_cb, void*, ctx)
+{
+    codec_job_t job = { constants, 0, NULL, put_cb, ctx };
+    const size_t batch = lace_workers() > 1 ? lace_workers() : 1;
+    codec_block_t *blocks[2];
+    blocks[0] = malloc(sizeof(codec_block_t) * batch);
+    blocks[1] = malloc(sizeof(codec_block_t) * batch);
+    if (blocks[0] == NULL || blocks[1] == NULL) {
+        free(blocks[0]);
+        free(blocks[1]);
+        return -1;
+    }
+
+    int result = 0;
+    size_t done = 0;
+    int64_t n = codec_read_batch(in, blocks[0], batch, first, count, &done);
+    if (n < 0) result = -1;
+
+    /* Decode the current blocks while the next blocks are read */
+    int cur = 0;
+    while (n > 0) {
+        SPAWN(codec_blocks_par, &job, blocks[cur], (size_t)n, 0);
+        const int64_t next_n = codec_read_batch(in, blocks[1-cur], batch, first, count, &done);
+        SYNC(codec_blocks_par);
+        for (int64_t i=0; i<n; i++) {
+            if (blocks[cur][i].result != 0) result = -1;
+            free(blocks[cur][i].data);
+        }
+        if (next_n < 0) result = -1;
+        if (result != 0) {
+            for (int64_t i=0; i<next_n; i++) free(blocks[1-cur][i].data);
+            break;
+        }
+        n = next_n;
+        cur = 1 - cur;
+    }
+
+    free(blocks[0]);
+    free(blocks[1]);
+    return result;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYLVAN_CODEC_H
+#define SYLVAN_CODEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Compact encoding of decision diagram nodes in files (see sylvan_set_file_format).
+ *
+ * A compact section starts with the 8 bytes of SYLVAN_CODEC_MAGIC and one byte with the format.
+ * As a (little endian) node count of a raw section, these 8 bytes would be over 2^62, so readers
+ * can tell the formats apart by the first 8 bytes.
+ *
+ * Nodes are numbered consecutively; numbers below <constants> are constants. Every node has a
+ * key (the variable or LDD value) and two children, and each child has a flag in bit 63 (such as
+ * a complement mark). The nodes are written in blocks of up to 65536 nodes. A block is:
+ *   varint: number of nodes
+ *   varint: length of the encoded nodes
+ *   varint: length of the LZ compressed nodes, or 0 if the block is stored uncompressed
+ *   the (compressed) encoded nodes
+ * and the encoded nodes are runs of nodes with the same key:
+ *   varint: key, varint: number of nodes in the run
+ *   per node, per child: varint (c << 1 | flag) for a constant c, or
+ *                        varint ((constants + n - 1 - c) << 1 | flag) for the child c of node n
+ * Children precede their parents, so the distance n - 1 - c is small when children are numbered
+ * close to their parents, as in the level by level order of the writers.
+ *
+ * A stream (written to a pipe or socket, and read without seeking) starts with the 8 bytes of
+ * SYLVAN_CODEC_STREAM_MAGIC and one byte with the format (SYLVAN_FILE_COMPACT for raw streams),
+ * followed by records that each start with a varint tag:
+ *   SYLVAN_CODEC_STREAM_NODES, varint: number of nodes, the blocks of these nodes
+ *   SYLVAN_CODEC_STREAM_ROOT, varint: number of the root, with its flag in bit 63
+ *   SYLVAN_CODEC_STREAM_LEAVES, varint: number of leaves, the leaves (MTBDD streams only: the
+ *                               16-byte node of every leaf, followed by its custom data)
+ *   SYLVAN_CODEC_STREAM_END
+ * Blocks start at multiples of SYLVAN_CODEC_BLOCK_NODES nodes in their record, so a reader can
+ * process the nodes of a record one block at a time.
+ */
+
+#define SYLVAN_CODEC_MAGIC "SylvanDD"
+#define SYLVAN_CODEC_STREAM_MAGIC "SylvanDS"
+
+#define SYLVAN_CODEC_BLOCK_NODES 65536
+
+#define SYLVAN_CODEC_STREAM_END   0
+#define SYLVAN_CODEC_STREAM_NODES 1
+#define SYLVAN_CODEC_STREAM_ROOT  2
+#define SYLVAN_CODEC_STREAM_LEAVES 3
+
+#define SYLVAN_CODEC_FLAG 0x8000000000000000ULL
+
+typedef struct sylvan_codec_node
+{
+    uint64_t key;
+    uint64_t child[2];  // number of the child, with a flag in bit 63
+} sylvan_codec_node_t;
+
+/**
+ * Store node <number> (in <first> ... <first>+<count>-1) in <node>. Called in parallel.
+ */
+typedef void (*sylvan_codec_get_cb)(void *ctx, uint64_t number, sylvan_codec_node_t *node);
+
+/**
+ * Use node <number>, decoded from file. Called in parallel.
+ */
+typedef void (*sylvan_codec_put_cb)(void *ctx, uint64_t number, const sylvan_codec_node_t *node);
+
+/**
+ * Callbacks for nodes stored in an array, where <ctx> is a sylvan_codec_array_t.
+ */
+typedef struct sylvan_codec_array
+{
+    sylvan_codec_node_t *nodes;
+    uint64_t first;     // number of nodes[0]
+} sylvan_codec_array_t;
+
+void sylvan_codec_array_get(void *ctx, uint64_t number, sylvan_codec_node_t *node);
+void sylvan_codec_array_put(void *ctx, uint64_t number, const sylvan_codec_node_t *node);
+
+/**
+ * Write the header of a compact section with the current file format to <out>.
+ * Returns 0, or -1 if the current file format is SYLVAN_FILE_RAW (nothing is written then).
+ */
+int sylvan_codec_write_header(FILE *out);
+
+/**
+ * Read the first 8 bytes of a section from <in>.
+ * Returns 1 for a compact section (and then also reads the format), 0 for a raw section (and
+ * then stores the 8 bytes, the node count of the raw section, in <count>), or -1 on error.
+ */
+int sylvan_codec_read_header(FILE *in, uint64_t *count);
+
+/**
+ * Write the header of a stream with the current file format to <out>.
+ */
+void sylvan_codec_write_stream_header(FILE *out);
+
+/**
+ * Read the header of a stream from <in>. Returns 0, or -1 if it is not a stream.
+ */
+int sylvan_codec_read_stream_header(FILE *in);
+
+/**
+ * Varints for counts and other numbers in a compact section.
+ */
+int sylvan_codec_write_varint(FILE *out, uint64_t value);
+int sylvan_codec_read_varint(FILE *in, uint64_t *value);
+
+/**
+ * Write the nodes <first> ... <first>+<count>-1, obtained from <get_cb>, as blocks to <out>.
+ * Blocks are encoded (and compressed) in parallel while earlier blocks are written.
+ */
+VOID_TASK_DECL_6(sylvan_codec_write_nodes, FILE*, uint64_t, size_t, uint64_t, sylvan_codec_get_cb, void*);
+#define sylvan_codec_write_nodes(out, first, count, constants, get_cb, ctx) RUN(sylvan_codec_write_nodes, out, first, count, constants, get_cb, ctx)
+
+/**
+ * Read the nodes <first> ... <first>+<count>-1 from the blocks in <in>, and give them to <put_cb>.
+ * Blocks are decoded in parallel. Returns 0, or -1 if the blocks are invalid or if memory
+ * cannot be allocated.
+ */
+TASK_DECL_6(int, sylvan_codec_read_nodes, FILE*, uint64_t, size_t, uint64_t, sylvan_codec_put_cb, void*);
+#define sylvan_codec_read_nodes(in, first, count, constants, put_cb, ctx) RUN(sylvan_codec_read_nodes, in, first, count, constants, put_cb, ctx)
+
+/**
+ * Compress <len> bytes at <src> with the built-in LZ codec into <dst> with room for <len> bytes.
+ * Returns the compressed length, or 0 if compressing does not save space (or memory for the
+ * hash table cannot be allocated).
+ */
+size_t sylvan_lz_compress(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * Decompress <len> bytes at <src> into exactly <rawlen> bytes at <dst>.
+ * Returns 0, or -1 if the compressed data is invalid.
+ */
+int sylvan_lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t rawlen);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
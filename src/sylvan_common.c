@@ -353,6 +353,49 @@ sylvan_set_limits(size_t memorycap, int table_ratio, int initial_ratio)
     cache_max = max_c;
 }
 
+/**
+ * Spawn cutoff, see sylvan_set_spawn_cutoff
+ */
+static size_t spawn_cutoff_req = 0;
+size_t sylvan_spawn_cutoff = SYLVAN_SPAWN_CUTOFF;
+__thread size_t sylvan_spawn_depth = 0;
+
+static void
+sylvan_update_spawn_cutoff(void)
+{
+    sylvan_spawn_cutoff = spawn_cutoff_req != 0 ? spawn_cutoff_req : SYLVAN_SPAWN_CUTOFF;
+}
+
+void
+sylvan_set_spawn_cutoff(size_t depth)
+{
+    spawn_cutoff_req = depth;
+    sylvan_update_spawn_cutoff();
+}
+
+size_t
+sylvan_get_spawn_cutoff(void)
+{
+    return sylvan_spawn_cutoff;
+}
+
+/**
+ * File format, see sylvan_set_file_format
+ */
+static int file_format = SYLVAN_FILE_RAW;
+
+void
+sylvan_set_file_format(int format)
+{
+    file_format = format;
+}
+
+int
+sylvan_get_file_format(void)
+{
+    return file_format;
+}
+
 /**
  * Initializes Sylvan.
  */
@@ -376,6 +419,8 @@ sylvan_init_package(void)
     main_hook = TASK(sylvan_gc_normal_resize);
 #endif
 
+    sylvan_update_spawn_cutoff();
+
     sylvan_stats_init();
 }
 
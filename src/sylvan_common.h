@@ -80,6 +80,40 @@ void sylvan_quit(void);
 typedef void (*quit_cb)(void);
 void sylvan_register_quit(quit_cb cb);
 
+/**
+ * Set the spawn cutoff of the recursive operations.
+ *
+ * Operations only spawn subtasks while the current worker has fewer than <depth> spawned
+ * tasks that are not yet synchronized. Below the cutoff, operations recurse sequentially,
+ * without the overhead of creating and synchronizing tasks. This avoids parallelizing many
+ * small subproblems. The cutoff adapts to the load: a task that is stolen by an idle worker
+ * starts at the depth of that worker, so its subproblems are spawned again.
+ *
+ * With depth 0 (the default), the cutoff is SYLVAN_SPAWN_CUTOFF (see sylvan_config.h), which
+ * is SIZE_MAX, i.e., always spawn subtasks, unless Sylvan is compiled with another value.
+ */
+void sylvan_set_spawn_cutoff(size_t depth);
+
+/**
+ * Get the current spawn cutoff (after resolving the default).
+ */
+size_t sylvan_get_spawn_cutoff(void);
+
+/**
+ * Binary file formats of the MTBDD and ZDD writers and the BDD and LDD serializers.
+ *
+ * With SYLVAN_FILE_RAW (the default), nodes are written as 16-byte structs. With
+ * SYLVAN_FILE_COMPACT, nodes are written in runs with the same variable (or LDD value), and each
+ * child is written as a varint with its distance to the node. With SYLVAN_FILE_LZ, every block of
+ * 65536 compact nodes is also compressed with a built-in LZ codec.
+ * The readers accept files in every format.
+ */
+#define SYLVAN_FILE_RAW     0
+#define SYLVAN_FILE_COMPACT 1
+#define SYLVAN_FILE_LZ      3
+void sylvan_set_file_format(int format);
+int sylvan_get_file_format(void);
+
 /**
  * Return number of occupied buckets in nodes table and total number of buckets.
  */
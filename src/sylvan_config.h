@@ -29,6 +29,11 @@
 #define SYLVAN_USE_MMAP 0
 #endif
 
+/* Default spawn cutoff (maximum number of spawned tasks of a worker), see sylvan_set_spawn_cutoff */
+#ifndef SYLVAN_SPAWN_CUTOFF
+#define SYLVAN_SPAWN_CUTOFF SIZE_MAX
+#endif
+
 /* Aggressive or conservative resizing strategy */
 #ifndef SYLVAN_AGGRESSIVE_RESIZE
 #define SYLVAN_AGGRESSIVE_RESIZE 1
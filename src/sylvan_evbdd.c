@@ -0,0 +1,673 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <inttypes.h>
+
+#include <sylvan_refs.h>
+
+/**
+ * Checked arithmetic on offsets (see sylvan_evbdd.h)
+ */
+
+static void __attribute__((noinline, noreturn))
+evbdd_overflow(void)
+{
+    fprintf(stderr, "EVBDD offset overflow: values of EVBDDs must fit in int64_t!\n");
+    exit(1);
+}
+
+static inline int64_t
+evbdd_add(int64_t a, int64_t b)
+{
+    int64_t res;
+    if (__builtin_add_overflow(a, b, &res)) evbdd_overflow();
+    return res;
+}
+
+static inline int64_t
+evbdd_sub(int64_t a, int64_t b)
+{
+    int64_t res;
+    if (__builtin_sub_overflow(a, b, &res)) evbdd_overflow();
+    return res;
+}
+
+/**
+ * Basic EVBDD node manipulation
+ */
+
+int64_t
+evbdd_getoffset(EVBDD dd)
+{
+    if (dd == evbdd_zero) return 0;
+    evbddnode_t n = EVBDD_GETNODE(dd);
+    return evbddnode_isoffset(n) ? evbddnode_getoffset(n) : 0;
+}
+
+EVBDD
+evbdd_getnode(EVBDD dd)
+{
+    if (dd == evbdd_zero) return evbdd_zero;
+    evbddnode_t n = EVBDD_GETNODE(dd);
+    return evbddnode_isoffset(n) ? evbddnode_gettarget(n) : dd;
+}
+
+int
+evbdd_isconst(EVBDD dd)
+{
+    return evbdd_getnode(dd) == evbdd_zero ? 1 : 0;
+}
+
+uint32_t
+evbdd_getvar(EVBDD dd)
+{
+    return evbddnode_getvariable(EVBDD_GETNODE(evbdd_getnode(dd)));
+}
+
+EVBDD
+evbdd_getlow(EVBDD dd)
+{
+    return evbdd_addconst(evbddnode_getlow(EVBDD_GETNODE(evbdd_getnode(dd))), evbdd_getoffset(dd));
+}
+
+EVBDD
+evbdd_gethigh(EVBDD dd)
+{
+    return evbdd_addconst(evbddnode_gethigh(EVBDD_GETNODE(evbdd_getnode(dd))), evbdd_getoffset(dd));
+}
+
+/**
+ * Implementation of garbage collection
+ */
+
+/**
+ * During garbage collection, recursively mark EVBDD nodes in the nodes table to keep.
+ */
+VOID_TASK_IMPL_1(evbdd_gc_mark_rec, EVBDD, dd)
+{
+    if (dd == evbdd_zero) return;
+
+    // Mark, and if returns 0, we are done
+    if (llmsset_mark(nodes, dd & 0x000000ffffffffff) != 0) {
+        evbddnode_t n = EVBDD_GETNODE(dd);
+        if (evbddnode_isoffset(n)) {
+            CALL(evbdd_gc_mark_rec, evbddnode_gettarget(n));
+        } else {
+            // Recursively mark low and high
+            SPAWN(evbdd_gc_mark_rec, evbddnode_getlow(n));
+            CALL(evbdd_gc_mark_rec, evbddnode_gethigh(n));
+            SYNC(evbdd_gc_mark_rec);
+        }
+    }
+}
+
+/**
+ * External references (we only offer reference-by-pointer, not by-value)
+ */
+
+refs_table_t evbdd_protected;
+static int evbdd_protected_created = 0;
+
+void
+evbdd_protect(EVBDD *a)
+{
+    if (!evbdd_protected_created) {
+        // In C++, sometimes evbdd_protect is called before Sylvan is initialized. Just create a table.
+        protect_create(&evbdd_protected, 4096);
+        evbdd_protected_created = 1;
+    }
+    protect_up(&evbdd_protected, (size_t)a);
+}
+
+void
+evbdd_unprotect(EVBDD *a)
+{
+    if (evbdd_protected.refs_table != NULL) protect_down(&evbdd_protected, (size_t)a);
+}
+
+size_t
+evbdd_count_protected()
+{
+    return protect_count(&evbdd_protected);
+}
+
+/**
+ * Mark all external references (during garbage collection)
+ */
+VOID_TASK_0(evbdd_gc_mark_protected)
+{
+    // iterate through refs hash table, mark all found
+    size_t count=0;
+    uint64_t *it = protect_iter(&evbdd_protected, 0, evbdd_protected.refs_size);
+    while (it != NULL) {
+        EVBDD *to_mark = (EVBDD*)protect_next(&evbdd_protected, &it, evbdd_protected.refs_size);
+        SPAWN(evbdd_gc_mark_rec, *to_mark);
+        count++;
+    }
+    while (count--) {
+        SYNC(evbdd_gc_mark_rec);
+    }
+}
+
+/**
+ * Internal references (spawn/sync, push/pop)
+ */
+SYLVAN_REFS_STACKS(evbdd, EVBDD, evbdd_gc_mark_rec)
+
+/**
+ * Initialize and quit functions
+ */
+
+static int evbdd_initialized = 0;
+
+static void
+evbdd_quit()
+{
+    if (evbdd_protected_created) {
+        protect_free(&evbdd_protected);
+        evbdd_protected_created = 0;
+    }
+
+    evbdd_initialized = 0;
+}
+
+void
+sylvan_init_evbdd()
+{
+    sylvan_init_mtbdd();
+
+    if (evbdd_initialized) return;
+    evbdd_initialized = 1;
+
+    sylvan_register_quit(evbdd_quit);
+    sylvan_gc_add_mark(TASK(evbdd_gc_mark_protected));
+    sylvan_gc_add_mark(TASK(evbdd_refs_mark));
+
+    if (!evbdd_protected_created) {
+        protect_create(&evbdd_protected, 4096);
+        evbdd_protected_created = 1;
+    }
+
+    RUN(evbdd_refs_init);
+}
+
+/**
+ * Node creation
+ */
+
+/**
+ * Look up the node <n> in the nodes table, running garbage collection if the table is full.
+ * The children <c1> and <c2> of the node are kept during garbage collection.
+ */
+static EVBDD
+evbdd_lookup(evbddnode_t n, EVBDD c1, EVBDD c2)
+{
+    int created;
+    uint64_t index = llmsset_lookup(nodes, n->a, n->b, &created);
+    if (index == 0) {
+        evbdd_refs_push(c1);
+        evbdd_refs_push(c2);
+        RUN(sylvan_gc);
+        evbdd_refs_pop(2);
+
+        index = llmsset_lookup(nodes, n->a, n->b, &created);
+        if (index == 0) {
+            fprintf(stderr, "BDD Unique table full, %zu of %zu buckets filled!\n", llmsset_count_marked(nodes), llmsset_get_size(nodes));
+            exit(1);
+        }
+    }
+
+    if (created) sylvan_stats_count(EVBDD_NODES_CREATED);
+    else sylvan_stats_count(EVBDD_NODES_REUSED);
+
+    return index;
+}
+
+/**
+ * Create the edge with offset <offset> to the internal node (or terminal) <node>.
+ */
+static EVBDD
+evbdd_edge(int64_t offset, EVBDD node)
+{
+    if (offset == 0) return node;
+    struct evbddnode n;
+    evbddnode_makeoffset(&n, offset, node);
+    return evbdd_lookup(&n, node, evbdd_zero);
+}
+
+EVBDD
+evbdd_constant(int64_t value)
+{
+    return evbdd_edge(value, evbdd_zero);
+}
+
+EVBDD
+evbdd_addconst(EVBDD dd, int64_t value)
+{
+    if (value == 0) return dd;
+    return evbdd_edge(evbdd_add(evbdd_getoffset(dd), value), evbdd_getnode(dd));
+}
+
+EVBDD
+evbdd_makenode(uint32_t var, EVBDD low, EVBDD high)
+{
+    if (low == high) return low;
+
+    // normalize: the offset of the low edge moves to the root edge
+    int64_t offset = evbdd_getoffset(low);
+    low = evbdd_getnode(low);
+    evbdd_refs_push(low);
+    high = evbdd_addconst(high, evbdd_sub(0, offset));
+    evbdd_refs_pop(1);
+
+    struct evbddnode n;
+    evbddnode_makenode(&n, var, low, high);
+    return evbdd_edge(offset, evbdd_lookup(&n, low, high));
+}
+
+EVBDD
+evbdd_ithvar(uint32_t var)
+{
+    return evbdd_makenode(var, evbdd_zero, evbdd_constant(1));
+}
+
+int64_t
+evbdd_eval(EVBDD dd, MTBDD vars, const uint8_t *values)
+{
+    int64_t result = 0;
+    for (;;) {
+        result = evbdd_add(result, evbdd_getoffset(dd));
+        dd = evbdd_getnode(dd);
+        if (dd == evbdd_zero) return result;
+        evbddnode_t n = EVBDD_GETNODE(dd);
+        uint32_t var = evbddnode_getvariable(n);
+        while (mtbdd_getvar(vars) != var) {
+            vars = mtbdd_gethigh(vars);
+            values++;
+            assert(vars != mtbdd_true);
+        }
+        dd = *values ? evbddnode_gethigh(n) : evbddnode_getlow(n);
+    }
+}
+
+/**
+ * Get the variable of an internal node or the terminal (then 0xffffffff).
+ */
+static inline uint32_t
+evbdd_nodevar(EVBDD node)
+{
+    return node == evbdd_zero ? 0xffffffff : evbddnode_getvariable(EVBDD_GETNODE(node));
+}
+
+/**
+ * Compute op(a, d + b) for edges <a> and <b>.
+ *
+ * The offsets are first moved out of the operands: plus and minus are linear, and
+ * min(oa + x, ob + y) = oa + min(x, (ob - oa) + y), likewise for max. The remaining
+ * computation only depends on the two nodes and the difference of the offsets.
+ */
+TASK_4(EVBDD, evbdd_apply_rec, EVBDD, a, EVBDD, b, int64_t, d, evbdd_op, op)
+{
+    int64_t oa = evbdd_getoffset(a), ob = evbdd_getoffset(b);
+    EVBDD na = evbdd_getnode(a), nb = evbdd_getnode(b);
+
+    int64_t base; // offset of the result
+    if (op == EVBDD_PLUS) {
+        base = evbdd_add(evbdd_add(oa, d), ob);
+        d = 0;
+    } else if (op == EVBDD_MINUS) {
+        base = evbdd_sub(evbdd_sub(oa, d), ob);
+        d = 0;
+    } else {
+        base = oa;
+        d = evbdd_sub(evbdd_add(d, ob), oa);
+    }
+
+    /* Now compute op(na, d + nb) + base; check terminal cases */
+    if (op == EVBDD_PLUS) {
+        if (na == evbdd_zero) return evbdd_addconst(nb, base);
+        if (nb == evbdd_zero) return evbdd_addconst(na, base);
+    } else if (op == EVBDD_MINUS) {
+        if (na == nb) return evbdd_constant(base);
+        if (nb == evbdd_zero) return evbdd_addconst(na, base);
+    } else if (na == nb) {
+        // min(x, d + x) = x + min(0, d)
+        if (op == EVBDD_MIN) return evbdd_addconst(na, evbdd_add(base, d < 0 ? d : 0));
+        else return evbdd_addconst(na, evbdd_add(base, d > 0 ? d : 0));
+    }
+
+    /* Commutative, so swap for the cache: op(na, d + nb) = d + op(nb, -d + na) */
+    if (op != EVBDD_MINUS && na < nb) {
+        EVBDD t = na;
+        na = nb;
+        nb = t;
+        base = evbdd_add(base, d);
+        d = evbdd_sub(0, d);
+    }
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(EVBDD_APPLY);
+
+    /* Check cache */
+    EVBDD result;
+    if (cache_get3(CACHE_EVBDD_APPLY, na, nb | ((uint64_t)op << 40), (uint64_t)d, &result)) {
+        sylvan_stats_count(EVBDD_APPLY_CACHED);
+        return evbdd_addconst(result, base);
+    }
+
+    /* Get cofactors */
+    uint32_t va = evbdd_nodevar(na), vb = evbdd_nodevar(nb);
+    uint32_t var = va < vb ? va : vb;
+    EVBDD al = na, ah = na, bl = nb, bh = nb;
+    if (va == var) {
+        evbddnode_t n = EVBDD_GETNODE(na);
+        al = evbddnode_getlow(n);
+        ah = evbddnode_gethigh(n);
+    }
+    if (vb == var) {
+        evbddnode_t n = EVBDD_GETNODE(nb);
+        bl = evbddnode_getlow(n);
+        bh = evbddnode_gethigh(n);
+    }
+
+    /* Recursive */
+    EVBDD low, high;
+    SYLVAN_FORK(evbdd, low, high, (evbdd_apply_rec, al, bl, d, op), (evbdd_apply_rec, ah, bh, d, op));
+    evbdd_refs_pop(1);
+    result = evbdd_makenode(var, low, high);
+
+    /* Store in cache */
+    if (cache_put3(CACHE_EVBDD_APPLY, na, nb | ((uint64_t)op << 40), (uint64_t)d, result)) {
+        sylvan_stats_count(EVBDD_APPLY_CACHEDPUT);
+    }
+
+    return evbdd_addconst(result, base);
+}
+
+TASK_IMPL_3(EVBDD, evbdd_apply, EVBDD, a, EVBDD, b, evbdd_op, op)
+{
+    return CALL(evbdd_apply_rec, a, b, 0, op);
+}
+
+TASK_IMPL_3(EVBDD, evbdd_abstract, EVBDD, dd, MTBDD, vars, evbdd_op, op)
+{
+    assert(op == EVBDD_MIN || op == EVBDD_MAX);
+
+    /* The offset of the root edge is not affected */
+    int64_t offset = evbdd_getoffset(dd);
+    EVBDD node = evbdd_getnode(dd);
+    if (node == evbdd_zero) return dd;
+
+    /* Skip variables in the cube that are not in the EVBDD; min(x, x) = max(x, x) = x */
+    evbddnode_t n = EVBDD_GETNODE(node);
+    uint32_t var = evbddnode_getvariable(n);
+    while (vars != mtbdd_true && mtbdd_getvar(vars) < var) vars = mtbdd_gethigh(vars);
+    if (vars == mtbdd_true) return dd;
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(EVBDD_ABSTRACT);
+
+    /* Check cache */
+    EVBDD result;
+    if (cache_get3(CACHE_EVBDD_ABSTRACT, node, vars, (uint64_t)op, &result)) {
+        sylvan_stats_count(EVBDD_ABSTRACT_CACHED);
+        return evbdd_addconst(result, offset);
+    }
+
+    /* Recursive */
+    MTBDD next = mtbdd_getvar(vars) == var ? mtbdd_gethigh(vars) : vars;
+    EVBDD low, high;
+    SYLVAN_FORK(evbdd, low, high, (evbdd_abstract, evbddnode_getlow(n), next, op), (evbdd_abstract, evbddnode_gethigh(n), next, op));
+    evbdd_refs_push(high);
+    if (next != vars) result = CALL(evbdd_apply_rec, low, high, 0, op);
+    else result = evbdd_makenode(var, low, high);
+    evbdd_refs_pop(2);
+
+    /* Store in cache */
+    if (cache_put3(CACHE_EVBDD_ABSTRACT, node, vars, (uint64_t)op, result)) {
+        sylvan_stats_count(EVBDD_ABSTRACT_CACHEDPUT);
+    }
+
+    return evbdd_addconst(result, offset);
+}
+
+/**
+ * Minimum (max=0) or maximum (max=1) value of the node <node>, without offset.
+ */
+TASK_2(int64_t, evbdd_minmax_rec, EVBDD, node, int, max)
+{
+    if (node == evbdd_zero) return 0;
+
+    /* Count operation */
+    sylvan_stats_count(EVBDD_MINMAX);
+
+    /* Check cache */
+    uint64_t result;
+    if (cache_get3(CACHE_EVBDD_MINMAX, node, (uint64_t)max, 0, &result)) {
+        sylvan_stats_count(EVBDD_MINMAX_CACHED);
+        return (int64_t)result;
+    }
+
+    evbddnode_t n = EVBDD_GETNODE(node);
+    EVBDD high = evbddnode_gethigh(n);
+    int64_t low_val, high_val;
+    SYLVAN_FORK_VALUE(low_val, high_val, (evbdd_minmax_rec, evbddnode_getlow(n), max), (evbdd_minmax_rec, evbdd_getnode(high), max));
+    high_val = evbdd_add(high_val, evbdd_getoffset(high));
+    int64_t res = max ? (low_val > high_val ? low_val : high_val) : (low_val < high_val ? low_val : high_val);
+
+    /* Store in cache */
+    if (cache_put3(CACHE_EVBDD_MINMAX, node, (uint64_t)max, 0, (uint64_t)res)) {
+        sylvan_stats_count(EVBDD_MINMAX_CACHEDPUT);
+    }
+
+    return res;
+}
+
+TASK_IMPL_1(int64_t, evbdd_minimum, EVBDD, dd)
+{
+    return evbdd_add(evbdd_getoffset(dd), CALL(evbdd_minmax_rec, evbdd_getnode(dd), 0));
+}
+
+TASK_IMPL_1(int64_t, evbdd_maximum, EVBDD, dd)
+{
+    return evbdd_add(evbdd_getoffset(dd), CALL(evbdd_minmax_rec, evbdd_getnode(dd), 1));
+}
+
+/**
+ * Conversion between MTBDDs and EVBDDs
+ */
+
+TASK_IMPL_1(EVBDD, evbdd_from_mtbdd, MTBDD, dd)
+{
+    /* Terminal cases */
+    if (dd == mtbdd_false) return evbdd_zero;
+    if (dd == mtbdd_true) return evbdd_constant(1);
+    if (mtbdd_isleaf(dd)) {
+        assert(mtbdd_gettype(dd) == 0);
+        return evbdd_constant(mtbdd_getint64(dd));
+    }
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(EVBDD_FROM_MTBDD);
+
+    /* Check cache */
+    EVBDD result;
+    if (cache_get3(CACHE_EVBDD_FROM_MTBDD, dd, 0, 0, &result)) {
+        sylvan_stats_count(EVBDD_FROM_MTBDD_CACHED);
+        return result;
+    }
+
+    /* Recursive */
+    EVBDD low, high;
+    SYLVAN_FORK(evbdd, low, high, (evbdd_from_mtbdd, mtbdd_getlow(dd)), (evbdd_from_mtbdd, mtbdd_gethigh(dd)));
+    evbdd_refs_pop(1);
+    result = evbdd_makenode(mtbdd_getvar(dd), low, high);
+
+    /* Store in cache */
+    if (cache_put3(CACHE_EVBDD_FROM_MTBDD, dd, 0, 0, result)) {
+        sylvan_stats_count(EVBDD_FROM_MTBDD_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Convert the internal node (or terminal) <node> plus <offset> to an MTBDD.
+ */
+TASK_2(MTBDD, evbdd_to_mtbdd_rec, EVBDD, node, int64_t, offset)
+{
+    /* Terminal case */
+    if (node == evbdd_zero) return mtbdd_int64(offset);
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(EVBDD_TO_MTBDD);
+
+    /* Check cache */
+    MTBDD result;
+    if (cache_get3(CACHE_EVBDD_TO_MTBDD, node, (uint64_t)offset, 0, &result)) {
+        sylvan_stats_count(EVBDD_TO_MTBDD_CACHED);
+        return result;
+    }
+
+    /* Recursive */
+    evbddnode_t n = EVBDD_GETNODE(node);
+    EVBDD high = evbddnode_gethigh(n);
+    MTBDD low_dd, high_dd;
+    SYLVAN_FORK(mtbdd, low_dd, high_dd, (evbdd_to_mtbdd_rec, evbddnode_getlow(n), offset), (evbdd_to_mtbdd_rec, evbdd_getnode(high), evbdd_add(offset, evbdd_getoffset(high))));
+    mtbdd_refs_pop(1);
+    result = mtbdd_makenode(evbddnode_getvariable(n), low_dd, high_dd);
+
+    /* Store in cache */
+    if (cache_put3(CACHE_EVBDD_TO_MTBDD, node, (uint64_t)offset, 0, result)) {
+        sylvan_stats_count(EVBDD_TO_MTBDD_CACHEDPUT);
+    }
+
+    return result;
+}
+
+TASK_IMPL_1(MTBDD, evbdd_to_mtbdd, EVBDD, dd)
+{
+    return CALL(evbdd_to_mtbdd_rec, evbdd_getnode(dd), evbdd_getoffset(dd));
+}
+
+/**
+ * Node counting and .dot export
+ */
+
+static void
+evbdd_unmark_rec(EVBDD dd)
+{
+    // Note: the terminal can be marked/unmarked, as buckets 0--1 are unused
+    evbddnode_t n = EVBDD_GETNODE(dd);
+    if (!evbddnode_getmark(n)) return;
+    evbddnode_setmark(n, 0);
+    if (dd == evbdd_zero) return;
+    if (evbddnode_isoffset(n)) {
+        evbdd_unmark_rec(evbddnode_gettarget(n));
+    } else {
+        evbdd_unmark_rec(evbddnode_getlow(n));
+        evbdd_unmark_rec(evbddnode_gethigh(n));
+    }
+}
+
+/**
+ * Mark and count all internal nodes and the terminal in the given EVBDD.
+ * Not thread-safe.
+ */
+static size_t
+evbdd_nodecount_mark(EVBDD dd)
+{
+    evbddnode_t n = EVBDD_GETNODE(dd);
+    if (evbddnode_getmark(n)) return 0;
+    evbddnode_setmark(n, 1);
+    if (dd == evbdd_zero) return 1;
+    if (evbddnode_isoffset(n)) return evbdd_nodecount_mark(evbddnode_gettarget(n));
+    return 1 + evbdd_nodecount_mark(evbddnode_getlow(n)) + evbdd_nodecount_mark(evbddnode_gethigh(n));
+}
+
+size_t
+evbdd_nodecount(const EVBDD *dds, size_t count)
+{
+    size_t result = 0, i;
+    for (i=0; i<count; i++) result += evbdd_nodecount_mark(dds[i]);
+    for (i=0; i<count; i++) evbdd_unmark_rec(dds[i]);
+    return result;
+}
+
+static void
+evbdd_fprintdot_rec(FILE *out, EVBDD node)
+{
+    evbddnode_t n = EVBDD_GETNODE(node);
+    if (evbddnode_getmark(n)) return;
+    evbddnode_setmark(n, 1);
+
+    if (node == evbdd_zero) {
+        fprintf(out, "0 [shape=box, style=filled, label=\"0\"];\n");
+        return;
+    }
+
+    EVBDD low = evbddnode_getlow(n);
+    EVBDD high = evbddnode_gethigh(n);
+    fprintf(out, "%" PRIu64 " [label=\"%" PRIu32 "\"];\n", node, evbddnode_getvariable(n));
+    evbdd_fprintdot_rec(out, low);
+    evbdd_fprintdot_rec(out, evbdd_getnode(high));
+    fprintf(out, "%" PRIu64 " -> %" PRIu64 " [style=dashed];\n", node, low);
+    fprintf(out, "%" PRIu64 " -> %" PRIu64 " [style=solid, label=\"%" PRId64 "\"];\n",
+            node, evbdd_getnode(high), evbdd_getoffset(high));
+}
+
+static void
+evbdd_unmark_nodes_rec(EVBDD node)
+{
+    evbddnode_t n = EVBDD_GETNODE(node);
+    if (!evbddnode_getmark(n)) return;
+    evbddnode_setmark(n, 0);
+    if (node == evbdd_zero) return;
+    evbdd_unmark_nodes_rec(evbddnode_getlow(n));
+    evbdd_unmark_nodes_rec(evbdd_getnode(evbddnode_gethigh(n)));
+}
+
+void
+evbdd_fprintdot(FILE *out, EVBDD dd)
+{
+    fprintf(out, "digraph \"DD\" {\n");
+    fprintf(out, "graph [dpi = 300];\n");
+    fprintf(out, "center = true;\n");
+    fprintf(out, "edge [dir = forward];\n");
+    fprintf(out, "root [style=invis];\n");
+    fprintf(out, "root -> %" PRIu64 " [style=solid, label=\"%" PRId64 "\"];\n",
+            evbdd_getnode(dd), evbdd_getoffset(dd));
+
+    evbdd_fprintdot_rec(out, evbdd_getnode(dd));
+    evbdd_unmark_nodes_rec(evbdd_getnode(dd));
+
+    fprintf(out, "}\n");
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * This is a multi-core implementation of additive edge-valued BDDs (EVBDDs).
+ *
+ * An EVBDD represents a function from Boolean variables to int64_t. Every edge carries an
+ * integer offset, and the value of a path is the sum of the offsets along the path.
+ * Nodes are normalized such that the low edge of every node has offset 0, which makes the
+ * representation canonical. Functions where every path leads to a different value, such as
+ * sums of weighted variables, have an EVBDD of linear size where the MTBDD is exponential.
+ *
+ * EVBDDs share the nodes table and the operation cache with the other decision diagrams.
+ * An edge with offset 0 is just the index of its target node; an edge with a nonzero offset
+ * is the index of an "offset node" that stores the offset and the target. There is a single
+ * terminal, the constant function 0 (evbdd_zero).
+ *
+ * Offsets are not reduced modulo 2^64: all values of EVBDDs, the differences between the
+ * values of one EVBDD, and (for min and max) the differences between the values of the two
+ * operands must fit in int64_t. Operations print an error and exit when an offset overflows;
+ * a value of an EVBDD that overflows is detected when it is computed (evbdd_eval,
+ * evbdd_minimum, evbdd_maximum, evbdd_to_mtbdd).
+ */
+
+/* Do not include this file directly. Instead, include sylvan.h */
+
+#ifndef SYLVAN_EVBDD_H
+#define SYLVAN_EVBDD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * An EVBDD is a 64-bit value. The low 40 bits are an index into the unique table.
+ */
+typedef uint64_t EVBDD;
+
+#define evbdd_zero      ((EVBDD)0)
+#define evbdd_invalid   ((EVBDD)0xffffffffffffffff)
+
+/**
+ * Operations for evbdd_apply and evbdd_abstract
+ */
+typedef enum evbdd_op {
+    EVBDD_PLUS,
+    EVBDD_MINUS,
+    EVBDD_MIN,
+    EVBDD_MAX,
+} evbdd_op;
+
+/**
+ * Initialize EVBDD functionality.
+ * This initializes internal and external referencing datastructures
+ * and registers them in the garbage collection framework.
+ */
+void sylvan_init_evbdd(void);
+
+/**
+ * Create the EVBDD of the constant function <value>.
+ */
+EVBDD evbdd_constant(int64_t value);
+
+/**
+ * Add the constant <value> to the EVBDD <dd> (only changes the offset of the root edge).
+ */
+EVBDD evbdd_addconst(EVBDD dd, int64_t value);
+
+/**
+ * Create the EVBDD "if <var> then <high> else <low>".
+ * The result is normalized: the offset of <low> moves to the root edge.
+ * This function does NOT check/enforce variable ordering!
+ */
+EVBDD evbdd_makenode(uint32_t var, EVBDD low, EVBDD high);
+
+/**
+ * Obtain the EVBDD of the function that is 1 if <var> is true and 0 otherwise.
+ */
+EVBDD evbdd_ithvar(uint32_t var);
+
+/**
+ * Returns 1 if the EVBDD is a constant function, or 0 otherwise.
+ */
+int evbdd_isconst(EVBDD dd);
+
+/**
+ * Get the offset on the root edge of <dd>; for constant functions, this is the value.
+ */
+int64_t evbdd_getoffset(EVBDD dd);
+
+/**
+ * Get the root node of <dd>, i.e., <dd> without the offset on the root edge.
+ */
+EVBDD evbdd_getnode(EVBDD dd);
+
+/**
+ * Given a non-constant EVBDD <dd>, obtain the variable of the root node.
+ */
+uint32_t evbdd_getvar(EVBDD dd);
+
+/**
+ * Given a non-constant EVBDD <dd>, obtain the cofactors (including the offset of <dd>).
+ */
+EVBDD evbdd_getlow(EVBDD dd);
+EVBDD evbdd_gethigh(EVBDD dd);
+
+/**
+ * Evaluate <dd> for the assignment <values> (0 or 1) to the variables in the cube <vars>.
+ * The variables of <dd> must all be in <vars>.
+ */
+int64_t evbdd_eval(EVBDD dd, MTBDD vars, const uint8_t *values);
+
+/**
+ * Apply the binary operation <op> (EVBDD_PLUS, EVBDD_MINUS, EVBDD_MIN or EVBDD_MAX) to <a> and <b>.
+ * Offsets are factored out before the operation cache is consulted, so for example
+ * a + b and (a + 1) + (b + 2) share cache entries.
+ */
+TASK_DECL_3(EVBDD, evbdd_apply, EVBDD, EVBDD, evbdd_op);
+#define evbdd_apply(a, b, op) RUN(evbdd_apply, a, b, op)
+#define evbdd_plus(a, b) evbdd_apply(a, b, EVBDD_PLUS)
+#define evbdd_minus(a, b) evbdd_apply(a, b, EVBDD_MINUS)
+#define evbdd_min(a, b) evbdd_apply(a, b, EVBDD_MIN)
+#define evbdd_max(a, b) evbdd_apply(a, b, EVBDD_MAX)
+
+/**
+ * Abstract the variables in the cube <vars> from <dd>, by taking the minimum (EVBDD_MIN)
+ * or the maximum (EVBDD_MAX) of the cofactors.
+ */
+TASK_DECL_3(EVBDD, evbdd_abstract, EVBDD, MTBDD, evbdd_op);
+#define evbdd_abstract(dd, vars, op) RUN(evbdd_abstract, dd, vars, op)
+#define evbdd_abstract_min(dd, vars) evbdd_abstract(dd, vars, EVBDD_MIN)
+#define evbdd_abstract_max(dd, vars) evbdd_abstract(dd, vars, EVBDD_MAX)
+
+/**
+ * Compute the minimum/maximum value of <dd> over all assignments.
+ */
+TASK_DECL_1(int64_t, evbdd_minimum, EVBDD);
+#define evbdd_minimum(dd) RUN(evbdd_minimum, dd)
+TASK_DECL_1(int64_t, evbdd_maximum, EVBDD);
+#define evbdd_maximum(dd) RUN(evbdd_maximum, dd)
+
+/**
+ * Convert an MTBDD with Integer leaves to an EVBDD.
+ * The Boolean leaves are interpreted as 0 (mtbdd_false) and 1 (mtbdd_true).
+ */
+TASK_DECL_1(EVBDD, evbdd_from_mtbdd, MTBDD);
+#define evbdd_from_mtbdd(dd) RUN(evbdd_from_mtbdd, dd)
+
+/**
+ * Convert an EVBDD to an MTBDD with Integer leaves.
+ */
+TASK_DECL_1(MTBDD, evbdd_to_mtbdd, EVBDD);
+#define evbdd_to_mtbdd(dd) RUN(evbdd_to_mtbdd, dd)
+
+/**
+ * Count the number of internal nodes plus the terminal in EVBDDs (offset nodes are not counted).
+ * Not thread-safe.
+ */
+size_t evbdd_nodecount(const EVBDD *dds, size_t count);
+
+static inline size_t
+evbdd_nodecount_one(const EVBDD dd)
+{
+    return evbdd_nodecount(&dd, 1);
+}
+
+/**
+ * Write a .dot representation of a given EVBDD; edges are labeled with their offsets.
+ */
+void evbdd_fprintdot(FILE *out, EVBDD dd);
+#define evbdd_printdot(dd) evbdd_fprintdot(stdout, dd)
+
+/**
+ * Garbage collection
+ * Sylvan supplies two default methods to handle references to nodes, but the user
+ * is encouraged to implement custom handling. Simply add a handler using sylvan_gc_add_mark
+ * and let the handler call evbdd_gc_mark_rec for every EVBDD that should be saved
+ * during garbage collection.
+ */
+
+/**
+ * Call evbdd_gc_mark_rec for every evbdd you want to keep in your custom mark functions.
+ */
+VOID_TASK_DECL_1(evbdd_gc_mark_rec, EVBDD);
+#define evbdd_gc_mark_rec(dd) RUN(evbdd_gc_mark_rec, dd)
+
+/**
+ * Default external referencing. During garbage collection, EVBDDs marked with evbdd_protect
+ * will be kept. Call evbdd_unprotect to undo this.
+ */
+void evbdd_protect(EVBDD* ptr);
+void evbdd_unprotect(EVBDD* ptr);
+size_t evbdd_count_protected(void);
+
+/**
+ * Infrastructure for internal references.
+ * Every thread has its own reference stacks. There are three stacks: pointer, values, tasks stack.
+ * The pointers stack stores pointers to EVBDD variables, manipulated with pushptr and popptr.
+ * The values stack stores EVBDDs, manipulated with push and pop.
+ * The tasks stack stores Lace tasks (that return EVBDDs), manipulated with spawn and sync.
+ */
+
+/**
+ * Push an EVBDD variable to the pointer reference stack.
+ * During garbage collection the variable will be inspected and the contents will be marked.
+ */
+void evbdd_refs_pushptr(EVBDD *ptr);
+
+/**
+ * Pop the last <amount> EVBDD variables from the pointer reference stack.
+ */
+void evbdd_refs_popptr(size_t amount);
+
+/**
+ * Push an EVBDD to the values reference stack.
+ * During garbage collection the references EVBDD will be marked.
+ */
+EVBDD evbdd_refs_push(EVBDD dd);
+
+/**
+ * Pop the last <amount> EVBDDs from the values reference stack.
+ */
+void evbdd_refs_pop(long amount);
+
+/**
+ * Push a Task that returns an EVBDD to the tasks reference stack.
+ * Usage: evbdd_refs_spawn(SPAWN(function, ...));
+ */
+void evbdd_refs_spawn(Task *t);
+
+/**
+ * Pop a Task from the task reference stack.
+ * Usage: EVBDD result = evbdd_refs_sync(SYNC(function));
+ */
+EVBDD evbdd_refs_sync(EVBDD dd);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
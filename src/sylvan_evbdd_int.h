@@ -0,0 +1,153 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Do not include this file directly. Instead, include sylvan_int.h */
+
+/**
+ * Internals for edge-valued BDDs
+ *
+ * Internal nodes (same layout as MTBDD nodes, without complement edges):
+ * 127        1 unused          set to 0
+ * 126..125   2 offset node     set to 0
+ * 124        1 mark            used for node marking
+ * 123..104  20 unused          set to 0
+ * 103..64   40 high edge       index of the high edge (an internal node, an offset node or 0)
+ *  63..40   24 variable        variable of this node
+ *  39..0    40 low edge        index of the low edge (an internal node or 0, never an offset node)
+ *
+ * Offset nodes (an edge with a nonzero offset to an internal node or to the terminal):
+ * 127        1 unused          set to 0
+ * 126..125   2 offset node     set to 1 (both)
+ * 124        1 mark            used for node marking
+ * 123..104  20 unused          set to 0
+ * 103..64   40 target          index of the internal node, or 0 for the terminal
+ *  63..0    64 offset          the offset (int64_t)
+ *
+ * Bits 126 and 125 are never both set in MTBDD and ZDD nodes, so offset nodes do not
+ * coincide with leaves of other decision diagrams in the shared nodes table.
+ */
+
+#ifndef SYLVAN_EVBDD_INT_H
+#define SYLVAN_EVBDD_INT_H
+
+/**
+ * EVBDD node structure
+ */
+typedef struct __attribute__((packed)) evbddnode {
+    uint64_t a, b;
+} * evbddnode_t; // 16 bytes
+
+static inline evbddnode_t
+EVBDD_GETNODE(EVBDD dd)
+{
+    return (evbddnode_t)llmsset_index_to_ptr(nodes, dd & 0x000000ffffffffff);
+}
+
+/**
+ * Whether a node is an offset node
+ */
+static inline int __attribute__((unused))
+evbddnode_isoffset(evbddnode_t n)
+{
+    return (n->a & 0x6000000000000000) == 0x6000000000000000 ? 1 : 0;
+}
+
+/**
+ * For offset nodes, get the offset
+ */
+static inline int64_t __attribute__((unused))
+evbddnode_getoffset(evbddnode_t n)
+{
+    return (int64_t)n->b;
+}
+
+/**
+ * For offset nodes, get the target (internal node or 0)
+ */
+static inline EVBDD __attribute__((unused))
+evbddnode_gettarget(evbddnode_t n)
+{
+    return n->a & 0x000000ffffffffff;
+}
+
+/**
+ * For internal nodes, get the low edge (an internal node or 0)
+ */
+static inline EVBDD __attribute__((unused))
+evbddnode_getlow(evbddnode_t n)
+{
+    return n->b & 0x000000ffffffffff;
+}
+
+/**
+ * For internal nodes, get the high edge (possibly an offset node)
+ */
+static inline EVBDD __attribute__((unused))
+evbddnode_gethigh(evbddnode_t n)
+{
+    return n->a & 0x000000ffffffffff;
+}
+
+/**
+ * For internal nodes, get the variable
+ */
+static inline uint32_t __attribute__((unused))
+evbddnode_getvariable(evbddnode_t n)
+{
+    return (uint32_t)(n->b >> 40);
+}
+
+/**
+ * Get whether the node is currently marked
+ */
+static inline int __attribute__((unused))
+evbddnode_getmark(evbddnode_t n)
+{
+    return n->a & 0x1000000000000000 ? 1 : 0;
+}
+
+/**
+ * Set or reset the mark on the node
+ */
+static inline void __attribute__((unused))
+evbddnode_setmark(evbddnode_t n, int mark)
+{
+    if (mark) n->a |= 0x1000000000000000;
+    else n->a &= 0xefffffffffffffff;
+}
+
+/**
+ * Initialize a evbddnode_t struct as an internal node
+ */
+static inline void __attribute__((unused))
+evbddnode_makenode(evbddnode_t n, uint32_t var, EVBDD low, EVBDD high)
+{
+    n->a = high;
+    n->b = ((uint64_t)var)<<40 | low;
+}
+
+/**
+ * Initialize a evbddnode_t struct as an offset node
+ */
+static inline void __attribute__((unused))
+evbddnode_makeoffset(evbddnode_t n, int64_t offset, EVBDD target)
+{
+    n->a = 0x6000000000000000 | target;
+    n->b = (uint64_t)offset;
+}
+
+#endif
@@ -23,6 +23,108 @@
 
 static uint32_t gmp_type;
 
+/**
+ * Small rationals are stored inline in the leaf value instead of as a pointer to a mpq_t:
+ * bit 0 is set, bits 1..31 hold the denominator and bits 32..63 hold the (signed) numerator.
+ * Pointers to mpq_t objects are aligned, so bit 0 is never set for them.
+ * A value is stored inline iff it fits, so every rational has a unique representation.
+ */
+#define GMP_INLINE_DEN_MAX 0x7fffffffULL
+
+static inline int
+gmp_is_inline(uint64_t val)
+{
+    return val & 1;
+}
+
+static inline int32_t
+gmp_inline_num(uint64_t val)
+{
+    return (int32_t)(uint32_t)(val >> 32);
+}
+
+static inline uint32_t
+gmp_inline_den(uint64_t val)
+{
+    return (uint32_t)(val & 0xffffffff) >> 1;
+}
+
+static inline uint64_t
+gmp_inline(int64_t num, uint64_t den)
+{
+    return ((uint64_t)(uint32_t)(int32_t)num << 32) | (den << 1) | 1;
+}
+
+static inline int
+gmp_fits_inline(int64_t num, uint64_t den)
+{
+    return num >= INT32_MIN && num <= INT32_MAX && den >= 1 && den <= GMP_INLINE_DEN_MAX;
+}
+
+/**
+ * Obtain the mpq_t of a leaf value; for inline values, <tmp> is set and returned.
+ */
+static inline mpq_ptr
+gmp_get_mpq(uint64_t val, mpq_ptr tmp)
+{
+    if (!gmp_is_inline(val)) return (mpq_ptr)(size_t)val;
+    mpq_set_si(tmp, gmp_inline_num(val), gmp_inline_den(val));
+    return tmp;
+}
+
+static inline uint64_t
+gmp_gcd64(uint64_t a, uint64_t b)
+{
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * Create a leaf for num/den (with den > 0), used by the fast paths of the operations.
+ * The fraction does not need to be canonical.
+ */
+static MTBDD
+gmp_leaf_from_frac(int64_t num, uint64_t den)
+{
+    uint64_t g = gmp_gcd64(num < 0 ? -(uint64_t)num : (uint64_t)num, den);
+    if (g > 1) {
+        num /= (int64_t)g;
+        den /= g;
+    }
+    if (gmp_fits_inline(num, den)) return mtbdd_makeleaf(gmp_type, gmp_inline(num, den));
+
+    mpq_t mres;
+    mpq_init(mres);
+    mpq_set_si(mres, num, den);
+    MTBDD res = mtbdd_makeleaf(gmp_type, (size_t)mres);
+    mpq_clear(mres);
+    return res;
+}
+
+/**
+ * Compare the values of two leaves
+ */
+static int
+gmp_cmp(uint64_t a, uint64_t b)
+{
+    if (gmp_is_inline(a) && gmp_is_inline(b)) {
+        int64_t l = (int64_t)gmp_inline_num(a) * gmp_inline_den(b);
+        int64_t r = (int64_t)gmp_inline_num(b) * gmp_inline_den(a);
+        return l < r ? -1 : (l > r ? 1 : 0);
+    }
+    mpq_t ta, tb;
+    mpq_init(ta);
+    mpq_init(tb);
+    int cmp = mpq_cmp(gmp_get_mpq(a, ta), gmp_get_mpq(b, tb));
+    mpq_clear(ta);
+    mpq_clear(tb);
+    return cmp;
+}
+
 /**
  * helper function for hash
  */
@@ -37,6 +139,9 @@ rotl64(uint64_t x, int8_t r)
 static uint64_t
 gmp_hash(const uint64_t v, const uint64_t seed)
 {
+    /* Inline values are canonical */
+    if (gmp_is_inline(v)) return sylvan_tabhash16(v, 0, seed);
+
     /* Hash the mpq in pointer v 
      * A simpler way would be to hash the result of mpq_get_d.
      * We just hash on the contents of the memory */
@@ -71,6 +176,7 @@ gmp_equals(const uint64_t left, const uint64_t right)
 {
     /* This function is called by the unique table when comparing a new
        leaf with an existing leaf */
+    if (gmp_is_inline(left) || gmp_is_inline(right)) return left == right ? 1 : 0;
     mpq_ptr x = (mpq_ptr)(size_t)left;
     mpq_ptr y = (mpq_ptr)(size_t)right;
 
@@ -83,7 +189,8 @@ gmp_create(uint64_t *val)
 {
     /* This function is called by the unique table when a leaf does not yet exist.
        We make a copy, which will be stored in the hash table. */
-    mpq_ptr x = (mpq_ptr)malloc(sizeof(__mpq_struct));
+    if (gmp_is_inline(*val)) return;
+    mpq_ptr x = (mpq_ptr)sylvan_mt_arena_alloc(gmp_type);
     mpq_init(x);
     mpq_set(x, *(mpq_ptr*)val);
     *(mpq_ptr*)val = x;
@@ -94,24 +201,30 @@ gmp_destroy(uint64_t val)
 {
     /* This function is called by the unique table
        when a leaf is removed during garbage collection. */
+    if (gmp_is_inline(val)) return;
     mpq_clear((mpq_ptr)val);
-    free((void*)val);
+    sylvan_mt_arena_free(gmp_type, (void*)val);
 }
 
 static char*
 gmp_to_str(int comp, uint64_t val, char *buf, size_t buflen)
 {
-    mpq_ptr op = (mpq_ptr)val;
+    mpq_t tmp;
+    mpq_init(tmp);
+    mpq_ptr op = gmp_get_mpq(val, tmp);
     size_t minsize = mpz_sizeinbase(mpq_numref(op), 10) + mpz_sizeinbase (mpq_denref(op), 10) + 3;
-    if (buflen >= minsize) return mpq_get_str(buf, 10, op);
-    else return mpq_get_str(NULL, 10, op);
+    char *res = mpq_get_str(buflen >= minsize ? buf : NULL, 10, op);
+    mpq_clear(tmp);
+    return res;
     (void)comp;
 }
 
 static int
 gmp_write_binary(FILE* out, uint64_t val)
 {
-    mpq_ptr op = (mpq_ptr)val;
+    mpq_t tmp;
+    mpq_init(tmp);
+    mpq_ptr op = gmp_get_mpq(val, tmp);
 
     mpz_t i;
     mpz_init(i);
@@ -120,6 +233,7 @@ gmp_write_binary(FILE* out, uint64_t val)
     mpq_get_den(i, op);
     if (mpz_out_raw(out, i) == 0) return -1;
     mpz_clear(i);
+    mpq_clear(tmp);
 
     return 0;
 }
@@ -138,6 +252,14 @@ gmp_read_binary(FILE* in, uint64_t *val)
     mpq_set_den(mres, i);
     mpz_clear(i);
 
+    if (mpz_fits_sint_p(mpq_numref(mres)) && mpz_cmp_ui(mpq_denref(mres), GMP_INLINE_DEN_MAX) <= 0) {
+        // small values are stored inline
+        *val = gmp_inline(mpz_get_si(mpq_numref(mres)), mpz_get_ui(mpq_denref(mres)));
+        mpq_clear(mres);
+        free(mres);
+        return 0;
+    }
+
     *(mpq_ptr*)val = mres;
 
     return 0;
@@ -158,6 +280,7 @@ gmp_init()
     sylvan_mt_set_to_str(gmp_type, gmp_to_str);
     sylvan_mt_set_write_binary(gmp_type, gmp_write_binary);
     sylvan_mt_set_read_binary(gmp_type, gmp_read_binary);
+    sylvan_mt_set_arena(gmp_type, sizeof(__mpq_struct));
 }
 
 /**
@@ -167,9 +290,21 @@ MTBDD
 mtbdd_gmp(mpq_t val)
 {
     mpq_canonicalize(val);
+    if (mpz_fits_sint_p(mpq_numref(val)) && mpz_cmp_ui(mpq_denref(val), GMP_INLINE_DEN_MAX) <= 0) {
+        return mtbdd_makeleaf(gmp_type, gmp_inline(mpz_get_si(mpq_numref(val)), mpz_get_ui(mpq_denref(val))));
+    }
     return mtbdd_makeleaf(gmp_type, (size_t)val);
 }
 
+void
+gmp_get_value(MTBDD leaf, mpq_t dst)
+{
+    assert(mtbdd_isleaf(leaf) && mtbdd_gettype(leaf) == gmp_type);
+    uint64_t val = mtbdd_getvalue(leaf);
+    if (gmp_is_inline(val)) mpq_set_si(dst, gmp_inline_num(val), gmp_inline_den(val));
+    else mpq_set(dst, (mpq_ptr)(size_t)val);
+}
+
 /**
  * Operation "plus" for two mpq MTBDDs
  * Interpret partial function as "0"
@@ -186,14 +321,24 @@ TASK_IMPL_2(MTBDD, gmp_op_plus, MTBDD*, pa, MTBDD*, pb)
     if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) {
         assert(mtbdd_gettype(a) == gmp_type && mtbdd_gettype(b) == gmp_type);
 
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        mpq_ptr mb = (mpq_ptr)mtbdd_getvalue(b);
+        uint64_t va = mtbdd_getvalue(a);
+        uint64_t vb = mtbdd_getvalue(b);
 
-        mpq_t mres;
+        if (gmp_is_inline(va) && gmp_is_inline(vb)) {
+            // fast path without libgmp, the intermediate values fit in 64 bits
+            int64_t num = (int64_t)gmp_inline_num(va) * gmp_inline_den(vb) + (int64_t)gmp_inline_num(vb) * gmp_inline_den(va);
+            return gmp_leaf_from_frac(num, (uint64_t)gmp_inline_den(va) * gmp_inline_den(vb));
+        }
+
+        mpq_t ta, tb, mres;
+        mpq_init(ta);
+        mpq_init(tb);
         mpq_init(mres);
-        mpq_add(mres, ma, mb);
+        mpq_add(mres, gmp_get_mpq(va, ta), gmp_get_mpq(vb, tb));
         MTBDD res = mtbdd_gmp(mres);
         mpq_clear(mres);
+        mpq_clear(ta);
+        mpq_clear(tb);
         return res;
     }
 
@@ -222,14 +367,24 @@ TASK_IMPL_2(MTBDD, gmp_op_minus, MTBDD*, pa, MTBDD*, pb)
     if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) {
         assert(mtbdd_gettype(a) == gmp_type && mtbdd_gettype(b) == gmp_type);
 
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        mpq_ptr mb = (mpq_ptr)mtbdd_getvalue(b);
+        uint64_t va = mtbdd_getvalue(a);
+        uint64_t vb = mtbdd_getvalue(b);
 
-        mpq_t mres;
+        if (gmp_is_inline(va) && gmp_is_inline(vb)) {
+            // fast path without libgmp, the intermediate values fit in 64 bits
+            int64_t num = (int64_t)gmp_inline_num(va) * gmp_inline_den(vb) - (int64_t)gmp_inline_num(vb) * gmp_inline_den(va);
+            return gmp_leaf_from_frac(num, (uint64_t)gmp_inline_den(va) * gmp_inline_den(vb));
+        }
+
+        mpq_t ta, tb, mres;
+        mpq_init(ta);
+        mpq_init(tb);
         mpq_init(mres);
-        mpq_sub(mres, ma, mb);
+        mpq_sub(mres, gmp_get_mpq(va, ta), gmp_get_mpq(vb, tb));
         MTBDD res = mtbdd_gmp(mres);
         mpq_clear(mres);
+        mpq_clear(ta);
+        mpq_clear(tb);
         return res;
     }
 
@@ -256,15 +411,24 @@ TASK_IMPL_2(MTBDD, gmp_op_times, MTBDD*, pa, MTBDD*, pb)
     if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) {
         assert(mtbdd_gettype(a) == gmp_type && mtbdd_gettype(b) == gmp_type);
 
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        mpq_ptr mb = (mpq_ptr)mtbdd_getvalue(b);
+        uint64_t va = mtbdd_getvalue(a);
+        uint64_t vb = mtbdd_getvalue(b);
 
-        // compute result
-        mpq_t mres;
+        if (gmp_is_inline(va) && gmp_is_inline(vb)) {
+            // fast path without libgmp, the intermediate values fit in 64 bits
+            int64_t num = (int64_t)gmp_inline_num(va) * gmp_inline_num(vb);
+            return gmp_leaf_from_frac(num, (uint64_t)gmp_inline_den(va) * gmp_inline_den(vb));
+        }
+
+        mpq_t ta, tb, mres;
+        mpq_init(ta);
+        mpq_init(tb);
         mpq_init(mres);
-        mpq_mul(mres, ma, mb);
+        mpq_mul(mres, gmp_get_mpq(va, ta), gmp_get_mpq(vb, tb));
         MTBDD res = mtbdd_gmp(mres);
         mpq_clear(mres);
+        mpq_clear(ta);
+        mpq_clear(tb);
         return res;
     }
 
@@ -292,15 +456,30 @@ TASK_IMPL_2(MTBDD, gmp_op_divide, MTBDD*, pa, MTBDD*, pb)
     if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) {
         assert(mtbdd_gettype(a) == gmp_type && mtbdd_gettype(b) == gmp_type);
 
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        mpq_ptr mb = (mpq_ptr)mtbdd_getvalue(b);
+        uint64_t va = mtbdd_getvalue(a);
+        uint64_t vb = mtbdd_getvalue(b);
+
+        if (gmp_is_inline(va) && gmp_is_inline(vb) && gmp_inline_num(vb) != 0) {
+            // fast path without libgmp, the intermediate values fit in 64 bits
+            int64_t num = (int64_t)gmp_inline_num(va) * gmp_inline_den(vb);
+            int64_t den = (int64_t)gmp_inline_den(va) * gmp_inline_num(vb);
+            if (den < 0) {
+                num = -num;
+                den = -den;
+            }
+            return gmp_leaf_from_frac(num, (uint64_t)den);
+        }
 
         // compute result
-        mpq_t mres;
+        mpq_t ta, tb, mres;
+        mpq_init(ta);
+        mpq_init(tb);
         mpq_init(mres);
-        mpq_div(mres, ma, mb);
+        mpq_div(mres, gmp_get_mpq(va, ta), gmp_get_mpq(vb, tb));
         MTBDD res = mtbdd_gmp(mres);
         mpq_clear(mres);
+        mpq_clear(ta);
+        mpq_clear(tb);
         return res;
     }
 
@@ -325,9 +504,7 @@ TASK_IMPL_2(MTBDD, gmp_op_min, MTBDD*, pa, MTBDD*, pb)
     if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) {
         assert(mtbdd_gettype(a) == gmp_type && mtbdd_gettype(b) == gmp_type);
 
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        mpq_ptr mb = (mpq_ptr)mtbdd_getvalue(b);
-        int cmp = mpq_cmp(ma, mb);
+        int cmp = gmp_cmp(mtbdd_getvalue(a), mtbdd_getvalue(b));
         return cmp < 0 ? a : b;
     }
 
@@ -358,9 +535,7 @@ TASK_IMPL_2(MTBDD, gmp_op_max, MTBDD*, pa, MTBDD*, pb)
     if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) {
         assert(mtbdd_gettype(a) == gmp_type && mtbdd_gettype(b) == gmp_type);
 
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        mpq_ptr mb = (mpq_ptr)mtbdd_getvalue(b);
-        int cmp = mpq_cmp(ma, mb);
+        int cmp = gmp_cmp(mtbdd_getvalue(a), mtbdd_getvalue(b));
         return cmp > 0 ? a : b;
     }
 
@@ -385,11 +560,12 @@ TASK_IMPL_2(MTBDD, gmp_op_neg, MTBDD, dd, size_t, p)
     if (mtbdd_isleaf(dd)) {
         assert(mtbdd_gettype(dd) == gmp_type);
 
-        mpq_ptr m = (mpq_ptr)mtbdd_getvalue(dd);
+        uint64_t v = mtbdd_getvalue(dd);
+        if (gmp_is_inline(v)) return gmp_leaf_from_frac(-(int64_t)gmp_inline_num(v), gmp_inline_den(v));
 
         mpq_t mres;
         mpq_init(mres);
-        mpq_neg(mres, m);
+        mpq_neg(mres, (mpq_ptr)(size_t)v);
         MTBDD res = mtbdd_gmp(mres);
         mpq_clear(mres);
         return res;
@@ -411,11 +587,12 @@ TASK_IMPL_2(MTBDD, gmp_op_abs, MTBDD, dd, size_t, p)
     if (mtbdd_isleaf(dd)) {
         assert(mtbdd_gettype(dd) == gmp_type);
 
-        mpq_ptr m = (mpq_ptr)mtbdd_getvalue(dd);
+        uint64_t v = mtbdd_getvalue(dd);
+        if (gmp_is_inline(v)) return gmp_leaf_from_frac(gmp_inline_num(v) < 0 ? -(int64_t)gmp_inline_num(v) : gmp_inline_num(v), gmp_inline_den(v));
 
         mpq_t mres;
         mpq_init(mres);
-        mpq_abs(mres, m);
+        mpq_abs(mres, (mpq_ptr)(size_t)v);
         MTBDD res = mtbdd_gmp(mres);
         mpq_clear(mres);
         return res;
@@ -494,8 +671,11 @@ TASK_2(MTBDD, gmp_op_threshold_d, MTBDD, a, size_t, svalue)
         assert(mtbdd_gettype(a) == gmp_type);
 
         double value = *(double*)&svalue;
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        return mpq_get_d(ma) >= value ? mtbdd_true : mtbdd_false;
+        mpq_t tmp;
+        mpq_init(tmp);
+        double d = mpq_get_d(gmp_get_mpq(mtbdd_getvalue(a), tmp));
+        mpq_clear(tmp);
+        return d >= value ? mtbdd_true : mtbdd_false;
     }
 
     return mtbdd_invalid;
@@ -514,8 +694,11 @@ TASK_2(MTBDD, gmp_op_strict_threshold_d, MTBDD, a, size_t, svalue)
         assert(mtbdd_gettype(a) == gmp_type);
 
         double value = *(double*)&svalue;
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        return mpq_get_d(ma) > value ? mtbdd_true : mtbdd_false;
+        mpq_t tmp;
+        mpq_init(tmp);
+        double d = mpq_get_d(gmp_get_mpq(mtbdd_getvalue(a), tmp));
+        mpq_clear(tmp);
+        return d > value ? mtbdd_true : mtbdd_false;
     }
 
     return mtbdd_invalid;
@@ -546,9 +729,7 @@ TASK_IMPL_2(MTBDD, gmp_op_threshold, MTBDD*, pa, MTBDD*, pb)
     if (mtbdd_isleaf(a)) {
         assert(mtbdd_gettype(a) == gmp_type);
 
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        mpq_ptr mb = (mpq_ptr)mtbdd_getvalue(b);
-        int cmp = mpq_cmp(ma, mb);
+        int cmp = gmp_cmp(mtbdd_getvalue(a), mtbdd_getvalue(b));
         return cmp >= 0 ? mtbdd_true : mtbdd_false;
     }
 
@@ -570,9 +751,7 @@ TASK_IMPL_2(MTBDD, gmp_op_strict_threshold, MTBDD*, pa, MTBDD*, pb)
     if (mtbdd_isleaf(a)) {
         assert(mtbdd_gettype(a) == gmp_type);
 
-        mpq_ptr ma = (mpq_ptr)mtbdd_getvalue(a);
-        mpq_ptr mb = (mpq_ptr)mtbdd_getvalue(b);
-        int cmp = mpq_cmp(ma, mb);
+        int cmp = gmp_cmp(mtbdd_getvalue(a), mtbdd_getvalue(b));
         return cmp > 0 ? mtbdd_true : mtbdd_false;
     }
 
@@ -36,10 +36,17 @@ extern "C" {
 void gmp_init(void);
 
 /**
- * Create MPQ leaf
+ * Create MPQ leaf.
+ * Small rationals (32-bit numerator, 31-bit denominator) are stored inline in the leaf,
+ * so mtbdd_getvalue of a MPQ leaf is not necessarily a pointer to a mpq_t.
  */
 MTBDD mtbdd_gmp(mpq_t val);
 
+/**
+ * Obtain the value of a MPQ leaf; <dst> must be initialized.
+ */
+void gmp_get_value(MTBDD leaf, mpq_t dst);
+
 /**
  * Operation "plus" for two mpq MTBDDs
  */
@@ -158,6 +165,16 @@ TASK_DECL_3(MTBDD, gmp_and_abstract_plus, MTBDD, MTBDD, MTBDD);
 TASK_DECL_3(MTBDD, gmp_and_abstract_max, MTBDD, MTBDD, MTBDD);
 #define gmp_and_abstract_max(a, b, vars) RUN(gmp_and_abstract_max, a, b, vars)
 
+/**
+ * Multiply matrix <M> and vector <x> (see mtbdd_matvec_op)
+ */
+#define gmp_matvec(M, x, rows, cols) mtbdd_matvec_op(M, x, rows, cols, TASK(gmp_op_times), TASK(gmp_abstract_op_plus))
+
+/**
+ * Multiply matrices <A> and <B>, summing over <vars> (see mtbdd_matmul_op)
+ */
+#define gmp_matmul(A, B, vars) mtbdd_matmul_op(A, B, vars, TASK(gmp_op_times), TASK(gmp_abstract_op_plus))
+
 /**
  * Convert to a Boolean MTBDD, translate terminals >= value to 1 and to 0 otherwise;
  * Parameter <dd> is the MTBDD to convert; parameter <value> is an GMP mpq leaf
@@ -46,6 +46,65 @@ extern "C" {
  */
 extern llmsset_t nodes;
 
+/**
+ * Spawn cutoff (see sylvan_set_spawn_cutoff).
+ *
+ * sylvan_spawn_depth is the number of tasks that the current thread has spawned and not yet
+ * synchronized. Lace has no public query for the depth of its deque, so Sylvan counts the tasks
+ * itself: every task spawned with SYLVAN_SPAWN is synchronized with SYLVAN_SYNC by the same task,
+ * on the same thread. A stolen task starts at the depth of the thief.
+ *
+ * SYLVAN_SPAWN_OK() decides inside a Lace task whether to spawn the next subtask,
+ * or to recurse sequentially instead.
+ */
+extern size_t sylvan_spawn_cutoff;
+extern __thread size_t sylvan_spawn_depth;
+#define SYLVAN_SPAWN_OK() (sylvan_spawn_depth < sylvan_spawn_cutoff)
+#define SYLVAN_SPAWN(task) (sylvan_spawn_depth++, SPAWN task)
+#define SYLVAN_SYNC(f) (sylvan_spawn_depth--, SYNC(f))
+
+/**
+ * Tasks are given as (function, arguments...); <refs> is the prefix of the refs functions of
+ * the results (bdd, mtbdd, lddmc, zdd or evbdd).
+ *
+ * SYLVAN_SPAWN_OR_DEFER(refs, task) spawns <task> if SYLVAN_SPAWN_OK(), and returns 1 if it was
+ * spawned, or 2 if it was deferred. SYLVAN_JOIN(refs, n, task) then obtains its result, by
+ * syncing the spawned task or by calling the deferred task.
+ *
+ * SYLVAN_FORK(refs, first, second, firsttask, secondtask) computes <first> and <second>, with
+ * <secondtask> in parallel if SYLVAN_SPAWN_OK(). The result <first> is pushed on the refs stack
+ * while <second> is computed, and the caller pops it. SYLVAN_FORK_VALUE does the same for tasks
+ * that do not return decision diagrams, and SYLVAN_FORK_VOID for tasks without a result.
+ */
+#define SYLVAN_TASK_NAME(f, ...) f
+#define SYLVAN_SPAWN_OR_DEFER(refs, task) (SYLVAN_SPAWN_OK() ? (refs##_refs_spawn(SYLVAN_SPAWN(task)), 1) : 2)
+#define SYLVAN_JOIN(refs, n, task) ((n) == 1 ? refs##_refs_sync(SYLVAN_SYNC(SYLVAN_TASK_NAME task)) : CALL task)
+#define SYLVAN_FORK(refs, first, second, firsttask, secondtask) do {                                 \
+    const int _fork = SYLVAN_SPAWN_OR_DEFER(refs, secondtask);                                        \
+    first = refs##_refs_push(CALL firsttask);                                                         \
+    second = SYLVAN_JOIN(refs, _fork, secondtask);                                                    \
+} while (0)
+#define SYLVAN_FORK_VALUE(first, second, firsttask, secondtask) do {                                \
+    if (SYLVAN_SPAWN_OK()) {                                                                          \
+        SYLVAN_SPAWN(secondtask);                                                                     \
+        first = CALL firsttask;                                                                       \
+        second = SYLVAN_SYNC(SYLVAN_TASK_NAME secondtask);                                            \
+    } else {                                                                                          \
+        first = CALL firsttask;                                                                       \
+        second = CALL secondtask;                                                                     \
+    }                                                                                                 \
+} while (0)
+#define SYLVAN_FORK_VOID(firsttask, secondtask) do {                                                 \
+    if (SYLVAN_SPAWN_OK()) {                                                                          \
+        SYLVAN_SPAWN(secondtask);                                                                     \
+        CALL firsttask;                                                                               \
+        SYLVAN_SYNC(SYLVAN_TASK_NAME secondtask);                                                     \
+    } else {                                                                                          \
+        CALL firsttask;                                                                               \
+        CALL secondtask;                                                                              \
+    }                                                                                                 \
+} while (0)
+
 /**
  * Macros for all operation identifiers for the operation cache
  */
@@ -82,6 +141,15 @@ static const uint64_t CACHE_MDD_RELPREV             = (27LL<<40);
 static const uint64_t CACHE_MDD_SATCOUNT            = (28LL<<40);
 static const uint64_t CACHE_MDD_SATCOUNTL1          = (29LL<<40);
 static const uint64_t CACHE_MDD_SATCOUNTL2          = (30LL<<40);
+static const uint64_t CACHE_MDD_LEARN_SAT           = (31LL<<40);
+static const uint64_t CACHE_MDD_HIGHEST             = (32LL<<40);
+static const uint64_t CACHE_MDD_TO_BDD              = (33LL<<40);
+static const uint64_t CACHE_MDD_REL_TO_BDD          = (34LL<<40);
+static const uint64_t CACHE_MDD_FROM_BDD            = (35LL<<40);
+static const uint64_t CACHE_MDD_REL_FROM_BDD        = (36LL<<40);
+static const uint64_t CACHE_MDD_RELPROD_MINUS       = (37LL<<40);
+static const uint64_t CACHE_MDD_RELPROD_MULTI       = (38LL<<40);
+static const uint64_t CACHE_MDD_SATCOUNT_LOG2       = (39LL<<40);
 
 // MTBDD operations
 static const uint64_t CACHE_MTBDD_APPLY             = (40LL<<40);
@@ -101,6 +169,13 @@ static const uint64_t CACHE_MTBDD_LESS              = (53LL<<40);
 static const uint64_t CACHE_MTBDD_GEQ               = (54LL<<40);
 static const uint64_t CACHE_MTBDD_GREATER           = (55LL<<40);
 static const uint64_t CACHE_MTBDD_EVAL_COMPOSE      = (56LL<<40);
+static const uint64_t CACHE_MTBDD_MATVEC            = (57LL<<40);
+static const uint64_t CACHE_MTBDD_MATVEC_PLUS       = (58LL<<40);
+static const uint64_t CACHE_MTBDD_ABSTRACT_MULTI    = (59LL<<40);
+static const uint64_t CACHE_MTBDD_AND_ABSTRACT_MULTI = (60LL<<40);
+static const uint64_t CACHE_MTBDD_BOUND             = (61LL<<40);
+static const uint64_t CACHE_MTBDD_TOPK              = (62LL<<40);
+static const uint64_t CACHE_MTBDD_RANGE_COUNT       = (63LL<<40);
 
 // ZDD operations
 static const uint64_t CACHE_ZDD_FROM_MTBDD          = (80LL<<40);
@@ -117,14 +192,39 @@ static const uint64_t CACHE_ZDD_EXISTS              = (90LL<<40);
 static const uint64_t CACHE_ZDD_PROJECT             = (91LL<<40);
 static const uint64_t CACHE_ZDD_ISOP                = (92LL<<40);
 static const uint64_t CACHE_ZDD_COVER_TO_BDD        = (93LL<<40);
+static const uint64_t CACHE_ZDD_XOR                 = (94LL<<40);
+static const uint64_t CACHE_ZDD_EQUIV               = (95LL<<40);
+static const uint64_t CACHE_ZDD_IMP                 = (96LL<<40);
+static const uint64_t CACHE_ZDD_FORALL              = (97LL<<40);
+static const uint64_t CACHE_ZDD_AND_EXISTS          = (98LL<<40);
+static const uint64_t CACHE_ZDD_AND_PROJECT         = (99LL<<40);
+static const uint64_t CACHE_ZDD_COMPOSE             = (100LL<<40);
+static const uint64_t CACHE_ZDD_MUX                 = (101LL<<40);
+static const uint64_t CACHE_ZDD_ISVALID             = (102LL<<40);
+static const uint64_t CACHE_ZDD_JOIN                = (103LL<<40);
+static const uint64_t CACHE_ZDD_MEET                = (104LL<<40);
+static const uint64_t CACHE_ZDD_DELTA               = (105LL<<40);
+static const uint64_t CACHE_ZDD_QUOTIENT            = (106LL<<40);
+static const uint64_t CACHE_ZDD_NONSUP              = (107LL<<40);
+static const uint64_t CACHE_ZDD_NONSUB              = (108LL<<40);
+static const uint64_t CACHE_ZDD_MINMAX              = (109LL<<40);
+
+// EVBDD operations
+static const uint64_t CACHE_EVBDD_APPLY             = (110LL<<40);
+static const uint64_t CACHE_EVBDD_ABSTRACT          = (111LL<<40);
+static const uint64_t CACHE_EVBDD_MINMAX            = (112LL<<40);
+static const uint64_t CACHE_EVBDD_FROM_MTBDD        = (113LL<<40);
+static const uint64_t CACHE_EVBDD_TO_MTBDD          = (114LL<<40);
 
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
 
+#include <sylvan_refs_int.h>
 #include <sylvan_mtbdd_int.h>
 #include <sylvan_ldd_int.h>
 #include <sylvan_zdd_int.h>
+#include <sylvan_evbdd_int.h>
 
 #ifdef __cplusplus
 } /* namespace */
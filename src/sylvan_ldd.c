@@ -16,12 +16,15 @@
  */
 
 #include <sylvan_int.h>
+#include <sylvan_align.h>
 
 #include <inttypes.h>
 #include <math.h>
 #include <string.h>
 
-#include <avl.h>
+#include <sylvan_codec.h>
+#include <sylvan_writer.h>
+#include <sylvan_serializer.h>
 #include <sylvan_refs.h>
 #include <sha2.h>
 
@@ -316,7 +319,233 @@ lddmc_refs_sync(MDD result)
     return result;
 }
 
-VOID_TASK_DECL_0(lddmc_gc_mark_serialize);
+VOID_TASK_DECL_0(lddmc_exact_gc);
+static void lddmc_exact_free(void);
+
+/**
+ * Indexes of wide levels.
+ * Finding a value in a level walks the chain of right edges, one dependent memory access per node.
+ * When a search walks more than lddmc_index_threshold nodes, the chain from the start of the search
+ * is indexed: its values and nodes are copied to sorted arrays, and further searches from the same
+ * node use binary search. The nodes are not changed, so LDDs remain canonical.
+ * Operations recurse on the right edge after a search, so later searches start in the middle of an
+ * indexed chain. Every worker remembers its last LDDMC_INDEX_RECENT indexes, and a search that
+ * starts at a node of one of these chains uses that index from the position of the node, instead
+ * of indexing the rest of the chain again.
+ * Indexes are stored in a fixed-size table and are discarded before garbage collection,
+ * since the indices of nodes are reused afterwards.
+ */
+typedef struct lddmc_index {
+    MDD head;
+    size_t count;
+    uint32_t *values;
+    MDD nodes[];
+} *lddmc_index_t;
+
+#define LDDMC_INDEX_TABLE_BITS 12
+#define LDDMC_INDEX_TABLE_SIZE (1 << LDDMC_INDEX_TABLE_BITS)
+#define LDDMC_INDEX_PROBES 8
+#define LDDMC_INDEX_RECENT 4
+
+static size_t lddmc_index_threshold = 32;
+static _Atomic(lddmc_index_t) *lddmc_index_table = NULL;
+static lddmc_index_t *lddmc_index_recent = NULL; // LDDMC_INDEX_RECENT per worker
+static size_t lddmc_index_workers = 0;
+
+void
+lddmc_set_index_threshold(size_t threshold)
+{
+    lddmc_index_threshold = threshold;
+}
+
+size_t
+lddmc_get_index_threshold(void)
+{
+    return lddmc_index_threshold;
+}
+
+static void
+lddmc_index_init(void)
+{
+    if (lddmc_index_table != NULL) return;
+    lddmc_index_table = (_Atomic(lddmc_index_t)*)calloc(LDDMC_INDEX_TABLE_SIZE, sizeof(_Atomic(lddmc_index_t)));
+    if (lddmc_index_table == NULL) {
+        fprintf(stderr, "lddmc_index_init: Unable to allocate memory!\n");
+        exit(1);
+    }
+    lddmc_index_workers = lace_workers();
+    lddmc_index_recent = (lddmc_index_t*)calloc(lddmc_index_workers * LDDMC_INDEX_RECENT, sizeof(lddmc_index_t));
+    if (lddmc_index_recent == NULL) {
+        fprintf(stderr, "lddmc_index_init: Unable to allocate memory!\n");
+        exit(1);
+    }
+}
+
+/* Free all indexes; only called when no worker is searching (garbage collection or quit) */
+static void
+lddmc_index_free_all(void)
+{
+    if (lddmc_index_table == NULL) return;
+    for (size_t i=0; i<LDDMC_INDEX_TABLE_SIZE; i++) {
+        lddmc_index_t idx = atomic_load_explicit(&lddmc_index_table[i], memory_order_relaxed);
+        if (idx != NULL) {
+            free(idx);
+            atomic_store_explicit(&lddmc_index_table[i], NULL, memory_order_relaxed);
+        }
+    }
+    memset(lddmc_index_recent, 0, lddmc_index_workers * LDDMC_INDEX_RECENT * sizeof(lddmc_index_t));
+}
+
+static void
+lddmc_index_free(void)
+{
+    lddmc_index_free_all();
+    free(lddmc_index_table);
+    lddmc_index_table = NULL;
+    free(lddmc_index_recent);
+    lddmc_index_recent = NULL;
+    lddmc_index_workers = 0;
+}
+
+VOID_TASK_0(lddmc_index_clear)
+{
+    lddmc_index_free_all();
+}
+
+static inline size_t
+lddmc_index_hash(MDD head)
+{
+    return (size_t)((head * 0x9E3779B97F4A7C15ULL) >> (64 - LDDMC_INDEX_TABLE_BITS));
+}
+
+/* Get the index of the chain starting at <head>, or NULL */
+static lddmc_index_t
+lddmc_index_get(MDD head)
+{
+    const size_t hash = lddmc_index_hash(head);
+    for (size_t i=0; i<LDDMC_INDEX_PROBES; i++) {
+        lddmc_index_t idx = atomic_load_explicit(&lddmc_index_table[(hash+i) & (LDDMC_INDEX_TABLE_SIZE-1)], memory_order_acquire);
+        if (idx == NULL) return NULL;
+        if (idx->head == head) return idx;
+    }
+    return NULL;
+}
+
+/* Create the index of the chain starting at <head> (without copy nodes), or NULL if the table is full */
+static lddmc_index_t
+lddmc_index_create(MDD head)
+{
+    size_t count = 0;
+    for (MDD m = head; m != lddmc_false; m = mddnode_getright(LDD_GETNODE(m))) count++;
+
+    lddmc_index_t idx = (lddmc_index_t)malloc(sizeof(struct lddmc_index) + count * (sizeof(MDD) + sizeof(uint32_t)));
+    if (idx == NULL) return NULL;
+    idx->head = head;
+    idx->count = count;
+    idx->values = (uint32_t*)(idx->nodes + count);
+    MDD m = head;
+    for (size_t i=0; i<count; i++) {
+        mddnode_t n = LDD_GETNODE(m);
+        idx->nodes[i] = m;
+        idx->values[i] = mddnode_getvalue(n);
+        m = mddnode_getright(n);
+    }
+
+    const size_t hash = lddmc_index_hash(head);
+    for (size_t i=0; i<LDDMC_INDEX_PROBES; i++) {
+        _Atomic(lddmc_index_t) *slot = &lddmc_index_table[(hash+i) & (LDDMC_INDEX_TABLE_SIZE-1)];
+        lddmc_index_t cur = NULL;
+        if (atomic_compare_exchange_strong(slot, &cur, idx)) {
+            sylvan_stats_count(LDD_INDEX_CREATED);
+            return idx;
+        }
+        if (cur->head == head) {
+            // another worker was faster
+            free(idx);
+            return cur;
+        }
+    }
+
+    free(idx);
+    return NULL;
+}
+
+/* Get the first position at or after <pos> with a value >= <value> */
+static inline size_t
+lddmc_index_search(lddmc_index_t idx, size_t pos, uint32_t value)
+{
+    size_t end = idx->count;
+    while (pos < end) {
+        size_t mid = pos + (end - pos) / 2;
+        if (idx->values[mid] < value) pos = mid + 1;
+        else end = mid;
+    }
+    return pos;
+}
+
+/* Remember <idx> as a recent index of the current worker */
+static void
+lddmc_index_remember(lddmc_index_t idx)
+{
+    lddmc_index_t *recent = lddmc_index_recent + lace_get_worker()->worker * LDDMC_INDEX_RECENT;
+    if (recent[0] == idx) return;
+    for (size_t i=LDDMC_INDEX_RECENT-1; i>0; i--) recent[i] = recent[i-1];
+    recent[0] = idx;
+}
+
+/**
+ * Get an index of a chain that contains <mdd>, with the position of <mdd> in <pos>, or NULL.
+ * Looks for an index of the chain starting at <mdd> and in the recent indexes of the worker.
+ */
+static lddmc_index_t
+lddmc_index_lookup(MDD mdd, size_t *pos)
+{
+    lddmc_index_t idx = lddmc_index_get(mdd);
+    if (idx != NULL) {
+        *pos = 0;
+        lddmc_index_remember(idx);
+        return idx;
+    }
+    const uint32_t value = mddnode_getvalue(LDD_GETNODE(mdd));
+    lddmc_index_t *recent = lddmc_index_recent + lace_get_worker()->worker * LDDMC_INDEX_RECENT;
+    for (size_t i=0; i<LDDMC_INDEX_RECENT && recent[i] != NULL; i++) {
+        size_t p = lddmc_index_search(recent[i], 0, value);
+        if (p < recent[i]->count && recent[i]->nodes[p] == mdd) {
+            *pos = p;
+            return recent[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Get the first node in the chain of right edges from <mdd> (without copy nodes) with a value >= <value>,
+ * or lddmc_false. If the search is long and <use_index> is set, search (and create) the index of <mdd>.
+ */
+static inline MDD
+lddmc_seek(MDD mdd, uint32_t value, int use_index)
+{
+    if (mdd == lddmc_false) return lddmc_false;
+    // early exit when value is beyond the last value of the chain
+    uint32_t last = mddnode_getlast(LDD_GETNODE(mdd));
+    if (value > last && last != LDD_LAST_MAX) return lddmc_false;
+    MDD m = mdd;
+    for (size_t steps=0; m != lddmc_false; steps++) {
+        mddnode_t n = LDD_GETNODE(m);
+        if (mddnode_getvalue(n) >= value) return m;
+        if (use_index && steps == lddmc_index_threshold && steps != 0) {
+            size_t start = 0;
+            lddmc_index_t idx = lddmc_index_lookup(mdd, &start);
+            if (idx == NULL && (idx = lddmc_index_create(mdd)) != NULL) lddmc_index_remember(idx);
+            if (idx != NULL) {
+                size_t pos = lddmc_index_search(idx, start + steps, value);
+                return pos < idx->count ? idx->nodes[pos] : lddmc_false;
+            }
+        }
+        m = mddnode_getright(n);
+    }
+    return lddmc_false;
+}
 
 /**
  * Initialize and quit functions
@@ -326,6 +555,8 @@ static void
 lddmc_quit()
 {
     refs_free(&lddmc_refs);
+    lddmc_index_free();
+    lddmc_exact_free();
 }
 
 void
@@ -334,9 +565,12 @@ sylvan_init_ldd()
     sylvan_register_quit(lddmc_quit);
     sylvan_gc_add_mark(TASK(lddmc_gc_mark_external_refs));
     sylvan_gc_add_mark(TASK(lddmc_gc_mark_protected));
-    sylvan_gc_add_mark(TASK(lddmc_gc_mark_serialize));
+    sylvan_gc_hook_pregc(TASK(lddmc_index_clear));
+    sylvan_gc_hook_pregc(TASK(lddmc_exact_gc));
+    sylvan_init_serializer();
 
     refs_create(&lddmc_refs, 1024);
+    lddmc_index_init();
     if (!lddmc_protected_created) {
         protect_create(&lddmc_protected, 4096);
         lddmc_protected_created = 1;
@@ -360,6 +594,7 @@ lddmc_makenode(uint32_t value, MDD ifeq, MDD ifneq)
 
     struct mddnode n;
     mddnode_make(&n, value, ifneq, ifeq);
+    mddnode_setlast(&n, ifneq == lddmc_false ? value : mddnode_getlast(LDD_GETNODE(ifneq)));
 
     int created;
     uint64_t index = llmsset_lookup(nodes, n.a, n.b, &created);
@@ -387,6 +622,7 @@ lddmc_make_copynode(MDD ifeq, MDD ifneq)
 {
     struct mddnode n;
     mddnode_makecopy(&n, ifneq, ifeq);
+    if (ifneq != lddmc_false) mddnode_setlast(&n, mddnode_getlast(LDD_GETNODE(ifneq)));
 
     int created;
     uint64_t index = llmsset_lookup(nodes, n.a, n.b, &created);
@@ -443,16 +679,16 @@ lddmc_getright(MDD mdd)
 MDD
 lddmc_follow(MDD mdd, uint32_t value)
 {
-    for (;;) {
-        if (mdd <= lddmc_true) return mdd;
-        const mddnode_t n = LDD_GETNODE(mdd);
-        if (!mddnode_getcopy(n)) {
-            const uint32_t v = mddnode_getvalue(n);
-            if (v == value) return mddnode_getdown(n);
-            if (v > value) return lddmc_false;
-        }
+    if (mdd <= lddmc_true) return mdd;
+    mddnode_t n = LDD_GETNODE(mdd);
+    if (mddnode_getcopy(n)) {
         mdd = mddnode_getright(n);
+        if (mdd == lddmc_false) return lddmc_false;
     }
+    mdd = lddmc_seek(mdd, value, 1);
+    if (mdd == lddmc_false) return lddmc_false;
+    n = LDD_GETNODE(mdd);
+    return mddnode_getvalue(n) == value ? mddnode_getdown(n) : lddmc_false;
 }
 
 int
@@ -484,17 +720,21 @@ match_ldds(MDD *one, MDD *two)
     if (m1 == lddmc_false || m2 == lddmc_false) return 0;
     mddnode_t n1 = LDD_GETNODE(m1), n2 = LDD_GETNODE(m2);
     uint32_t v1 = mddnode_getvalue(n1), v2 = mddnode_getvalue(n2);
+    // only the given nodes are indexed, as operations search them repeatedly for different values
+    int index1 = 1, index2 = 1;
     while (v1 != v2) {
         if (v1 < v2) {
-            m1 = mddnode_getright(n1);
+            m1 = lddmc_seek(m1, v2, index1);
             if (m1 == lddmc_false) return 0;
             n1 = LDD_GETNODE(m1);
             v1 = mddnode_getvalue(n1);
+            index1 = 0;
         } else if (v1 > v2) {
-            m2 = mddnode_getright(n2);
+            m2 = lddmc_seek(m2, v1, index2);
             if (m2 == lddmc_false) return 0;
             n2 = LDD_GETNODE(m2);
             v2 = mddnode_getvalue(n2);
+            index2 = 0;
         }
     }
     *one = m1;
@@ -536,10 +776,8 @@ TASK_IMPL_2(MDD, lddmc_union, MDD, a, MDD, b)
 
     /* Perform recursive calculation */
     if (na_copy && nb_copy) {
-        lddmc_refs_spawn(SPAWN(lddmc_union, mddnode_getdown(na), mddnode_getdown(nb)));
-        MDD right = CALL(lddmc_union, mddnode_getright(na), mddnode_getright(nb));
-        lddmc_refs_push(right);
-        MDD down = lddmc_refs_sync(SYNC(lddmc_union));
+        MDD right, down;
+        SYLVAN_FORK(lddmc, right, down, (lddmc_union, mddnode_getright(na), mddnode_getright(nb)), (lddmc_union, mddnode_getdown(na), mddnode_getdown(nb)));
         lddmc_refs_pop(1);
         result = lddmc_make_copynode(down, right);
     } else if (na_copy) {
@@ -549,13 +787,35 @@ TASK_IMPL_2(MDD, lddmc_union, MDD, a, MDD, b)
         MDD right = CALL(lddmc_union, a, mddnode_getright(nb));
         result = lddmc_make_copynode(mddnode_getdown(nb), right);
     } else if (na_value < nb_value) {
-        MDD right = CALL(lddmc_union, mddnode_getright(na), b);
-        result = lddmc_makenode(na_value, mddnode_getdown(na), right);
+        size_t start = 0;
+        lddmc_index_t idx = lddmc_index_threshold ? lddmc_index_lookup(a, &start) : NULL;
+        size_t end = idx != NULL ? lddmc_index_search(idx, start + 1, nb_value) : 0;
+        if (end > start + 1) {
+            /* Fast path: the first <pos> nodes of indexed <a> come before <b>, copy them at once */
+            /* (the index is freed if garbage collection happens, so the nodes are copied first) */
+            const size_t pos = end - start;
+            MDD *prefix = (MDD*)malloc(sizeof(MDD) * pos);
+            if (prefix == NULL) {
+                fprintf(stderr, "lddmc_union: Unable to allocate memory!\n");
+                exit(1);
+            }
+            memcpy(prefix, idx->nodes + start, sizeof(MDD) * pos);
+            MDD right = CALL(lddmc_union, end < idx->count ? idx->nodes[end] : lddmc_false, b);
+            for (size_t i=pos; i>0; i--) {
+                mddnode_t n = LDD_GETNODE(prefix[i-1]);
+                lddmc_refs_push(right);
+                right = lddmc_makenode(mddnode_getvalue(n), mddnode_getdown(n), right);
+                lddmc_refs_pop(1);
+            }
+            free(prefix);
+            result = right;
+        } else {
+            MDD right = CALL(lddmc_union, mddnode_getright(na), b);
+            result = lddmc_makenode(na_value, mddnode_getdown(na), right);
+        }
     } else if (na_value == nb_value) {
-        lddmc_refs_spawn(SPAWN(lddmc_union, mddnode_getdown(na), mddnode_getdown(nb)));
-        MDD right = CALL(lddmc_union, mddnode_getright(na), mddnode_getright(nb));
-        lddmc_refs_push(right);
-        MDD down = lddmc_refs_sync(SYNC(lddmc_union));
+        MDD right, down;
+        SYLVAN_FORK(lddmc, right, down, (lddmc_union, mddnode_getright(na), mddnode_getright(nb)), (lddmc_union, mddnode_getdown(na), mddnode_getdown(nb)));
         lddmc_refs_pop(1);
         result = lddmc_makenode(na_value, down, right);
     } else /* na_value > nb_value */ {
@@ -601,10 +861,8 @@ TASK_IMPL_2(MDD, lddmc_minus, MDD, a, MDD, b)
         MDD right = CALL(lddmc_minus, mddnode_getright(na), b);
         result = lddmc_makenode(na_value, mddnode_getdown(na), right);
     } else if (na_value == nb_value) {
-        lddmc_refs_spawn(SPAWN(lddmc_minus, mddnode_getright(na), mddnode_getright(nb)));
-        MDD down = CALL(lddmc_minus, mddnode_getdown(na), mddnode_getdown(nb));
-        lddmc_refs_push(down);
-        MDD right = lddmc_refs_sync(SYNC(lddmc_minus));
+        MDD down, right;
+        SYLVAN_FORK(lddmc, down, right, (lddmc_minus, mddnode_getdown(na), mddnode_getdown(nb)), (lddmc_minus, mddnode_getright(na), mddnode_getright(nb)));
         lddmc_refs_pop(1);
         result = lddmc_makenode(na_value, down, right);
     } else /* na_value > nb_value */ {
@@ -727,10 +985,8 @@ TASK_IMPL_2(MDD, lddmc_intersect, MDD, a, MDD, b)
     }
 
     /* Perform recursive calculation */
-    lddmc_refs_spawn(SPAWN(lddmc_intersect, mddnode_getright(na), mddnode_getright(nb)));
-    MDD down = CALL(lddmc_intersect, mddnode_getdown(na), mddnode_getdown(nb));
-    lddmc_refs_push(down);
-    MDD right = lddmc_refs_sync(SYNC(lddmc_intersect));
+    MDD down, right;
+    SYLVAN_FORK(lddmc, down, right, (lddmc_intersect, mddnode_getdown(na), mddnode_getdown(nb)), (lddmc_intersect, mddnode_getright(na), mddnode_getright(nb)));
     lddmc_refs_pop(1);
     result = lddmc_makenode(na_value, down, right);
 
@@ -841,10 +1097,8 @@ TASK_IMPL_3(MDD, lddmc_relprod, MDD, set, MDD, rel, MDD, meta)
 
     /* Recursive operations */
     if (m_val == 0) { // not in rel
-        lddmc_refs_spawn(SPAWN(lddmc_relprod, mddnode_getright(n_set), rel, meta));
-        MDD down = CALL(lddmc_relprod, mddnode_getdown(n_set), rel, mddnode_getdown(n_meta));
-        lddmc_refs_push(down);
-        MDD right = lddmc_refs_sync(SYNC(lddmc_relprod));
+        MDD down, right;
+        SYLVAN_FORK(lddmc, down, right, (lddmc_relprod, mddnode_getdown(n_set), rel, mddnode_getdown(n_meta)), (lddmc_relprod, mddnode_getright(n_set), rel, meta));
         lddmc_refs_pop(1);
         result = lddmc_makenode(mddnode_getvalue(n_set), down, right);
     } else if (m_val == 5) { // action label
@@ -925,10 +1179,8 @@ TASK_IMPL_3(MDD, lddmc_relprod, MDD, set, MDD, rel, MDD, meta)
             lddmc_refs_pop(2);
         } else {
             // only-read, without copy
-            lddmc_refs_spawn(SPAWN(lddmc_relprod, mddnode_getright(n_set), mddnode_getright(n_rel), meta));
-            MDD down = CALL(lddmc_relprod, mddnode_getdown(n_set), mddnode_getdown(n_rel), mddnode_getdown(n_meta));
-            lddmc_refs_push(down);
-            MDD right = lddmc_refs_sync(SYNC(lddmc_relprod));
+            MDD down, right;
+            SYLVAN_FORK(lddmc, down, right, (lddmc_relprod, mddnode_getdown(n_set), mddnode_getdown(n_rel), mddnode_getdown(n_meta)), (lddmc_relprod, mddnode_getright(n_set), mddnode_getright(n_rel), meta));
             lddmc_refs_pop(1);
             result = lddmc_makenode(mddnode_getvalue(n_set), down, right);
         }
@@ -1069,10 +1321,8 @@ TASK_IMPL_4(MDD, lddmc_relprod_union, MDD, set, MDD, rel, MDD, meta, MDD, un)
             result = lddmc_makenode(mddnode_getvalue(n_set), down, right);
         } else /* set_value == un_value */ {
             assert(set_value == un_value);
-            lddmc_refs_spawn(SPAWN(lddmc_relprod_union, mddnode_getright(n_set), rel, meta, mddnode_getright(n_un)));
-            MDD down = CALL(lddmc_relprod_union, mddnode_getdown(n_set), rel, mddnode_getdown(n_meta), mddnode_getdown(n_un));
-            lddmc_refs_push(down);
-            MDD right = lddmc_refs_sync(SYNC(lddmc_relprod_union));
+            MDD down, right;
+            SYLVAN_FORK(lddmc, down, right, (lddmc_relprod_union, mddnode_getdown(n_set), rel, mddnode_getdown(n_meta), mddnode_getdown(n_un)), (lddmc_relprod_union, mddnode_getright(n_set), rel, meta, mddnode_getright(n_un)));
             lddmc_refs_pop(1);
             if (right == mddnode_getright(n_un) && down == mddnode_getdown(n_un)) result = un;
             else result = lddmc_makenode(mddnode_getvalue(n_set), down, right);
@@ -1201,18 +1451,14 @@ TASK_IMPL_4(MDD, lddmc_relprod_union, MDD, set, MDD, rel, MDD, meta, MDD, un)
 
             // we already checked un_value < set_value
             if (un_value > set_value) {
-                lddmc_refs_spawn(SPAWN(lddmc_relprod_union, mddnode_getright(n_set), mddnode_getright(n_rel), meta, un));
-                MDD down = CALL(lddmc_relprod, mddnode_getdown(n_set), mddnode_getdown(n_rel), mddnode_getdown(n_meta));
-                lddmc_refs_push(down);
-                MDD right = lddmc_refs_sync(SYNC(lddmc_relprod_union));
+                MDD down, right;
+                SYLVAN_FORK(lddmc, down, right, (lddmc_relprod, mddnode_getdown(n_set), mddnode_getdown(n_rel), mddnode_getdown(n_meta)), (lddmc_relprod_union, mddnode_getright(n_set), mddnode_getright(n_rel), meta, un));
                 lddmc_refs_pop(1);
                 result = lddmc_makenode(set_value, down, right);
             } else /* un_value == set_value */ {
                 assert(un_value == set_value);
-                lddmc_refs_spawn(SPAWN(lddmc_relprod_union, mddnode_getright(n_set), mddnode_getright(n_rel), meta, mddnode_getright(n_un)));
-                MDD down = CALL(lddmc_relprod_union, mddnode_getdown(n_set), mddnode_getdown(n_rel), mddnode_getdown(n_meta), mddnode_getdown(n_un));
-                lddmc_refs_push(down);
-                MDD right = lddmc_refs_sync(SYNC(lddmc_relprod_union));
+                MDD down, right;
+                SYLVAN_FORK(lddmc, down, right, (lddmc_relprod_union, mddnode_getdown(n_set), mddnode_getdown(n_rel), mddnode_getdown(n_meta), mddnode_getdown(n_un)), (lddmc_relprod_union, mddnode_getright(n_set), mddnode_getright(n_rel), meta, mddnode_getright(n_un)));
                 lddmc_refs_pop(1);
                 result = lddmc_makenode(set_value, down, right);
             }
@@ -1292,6 +1538,191 @@ TASK_IMPL_4(MDD, lddmc_relprod_union, MDD, set, MDD, rel, MDD, meta, MDD, un)
     return result;
 }
 
+// meta: -1 (end; rest not in rel), 0 (not in rel), 1 (read), 2 (write), 3 (only-read), 4 (only-write), 5 (action label)
+TASK_IMPL_4(MDD, lddmc_relprod_minus, MDD, set, MDD, rel, MDD, meta, MDD, avoid)
+{
+    if (set == lddmc_false) return lddmc_false;
+    if (rel == lddmc_false) return lddmc_false;
+    if (avoid == lddmc_false) return CALL(lddmc_relprod, set, rel, meta);
+    if (meta == lddmc_true) return CALL(lddmc_minus, set, avoid);
+
+    mddnode_t n_meta = LDD_GETNODE(meta);
+    uint32_t m_val = mddnode_getvalue(n_meta);
+    if (m_val == (uint32_t)-1) return CALL(lddmc_minus, set, avoid);
+
+    // check depths (this triggers on logic error)
+    if (m_val != 0 && m_val != 5) assert(set != lddmc_true && rel != lddmc_true && avoid != lddmc_true);
+
+    /* Skip nodes if possible */
+    if (!mddnode_getcopy(LDD_GETNODE(rel))) {
+        // if we "read" or "only-read", then match LDDs set and rel
+        if (m_val == 1 || m_val == 3) {
+            if (!match_ldds(&set, &rel)) return lddmc_false;
+        }
+    }
+
+    /**
+     * Only levels where the result has the values of <set> (not in rel, or only-read) prune <avoid>.
+     * From the first level that writes, the successors of <set> do not depend on <avoid>, and the
+     * relprod below is shared between all prefixes in the operation cache, so compute it first.
+     */
+    if (m_val != 0 && (m_val != 3 || mddnode_getcopy(LDD_GETNODE(rel)))) {
+        MDD succ = CALL(lddmc_relprod, set, rel, meta);
+        lddmc_refs_push(succ);
+        MDD result = CALL(lddmc_minus, succ, avoid);
+        lddmc_refs_pop(1);
+        return result;
+    }
+
+    /* Test gc */
+    sylvan_gc_test();
+
+    sylvan_stats_count(LDD_RELPROD_MINUS);
+
+    /* Access cache */
+    MDD result;
+    MDD _set=set, _rel=rel;
+    if (cache_get4(CACHE_MDD_RELPROD_MINUS, set, rel, meta, avoid, &result)) {
+        sylvan_stats_count(LDD_RELPROD_MINUS_CACHED);
+        return result;
+    }
+
+    mddnode_t n_set = LDD_GETNODE(set);
+    mddnode_t n_rel = LDD_GETNODE(rel);
+
+    // the value of the result is the value of <set>, so skip smaller values of <avoid>
+    uint32_t set_value = mddnode_getvalue(n_set);
+    MDD av = avoid;
+    while (av != lddmc_false && lddmc_getvalue(av) < set_value) av = lddmc_getright(av);
+    MDD av_down = (av != lddmc_false && lddmc_getvalue(av) == set_value) ? lddmc_getdown(av) : lddmc_false;
+    MDD rel_down = m_val == 0 ? rel : mddnode_getdown(n_rel);
+    MDD rel_right = m_val == 0 ? rel : mddnode_getright(n_rel);
+
+    MDD down, right;
+    SYLVAN_FORK(lddmc, down, right, (lddmc_relprod_minus, mddnode_getdown(n_set), rel_down, mddnode_getdown(n_meta), av_down), (lddmc_relprod_minus, mddnode_getright(n_set), rel_right, meta, av));
+    lddmc_refs_pop(1);
+    result = lddmc_makenode(set_value, down, right);
+
+    /* Write to cache */
+    if (cache_put4(CACHE_MDD_RELPROD_MINUS, _set, _rel, meta, avoid, result)) sylvan_stats_count(LDD_RELPROD_MINUS_CACHEDPUT);
+
+    return result;
+}
+
+/**
+ * Context of lddmc_relprod_multi: the relations sorted by the first level in their meta.
+ * Every call has its own id, which is part of the cache key.
+ */
+typedef struct lddmc_relprod_multi_ctx {
+    size_t n;
+    const MDD *rels;
+    const MDD *topmetas;
+    const uint32_t *firstvars;
+    uint64_t id;
+} lddmc_relprod_multi_ctx_t;
+
+static _Atomic(uint64_t) lddmc_relprod_multi_next_id = 1;
+
+TASK_DECL_4(MDD, lddmc_relprod_multi_rec, const lddmc_relprod_multi_ctx_t*, MDD, size_t, uint32_t);
+
+/**
+ * Walk the level of <set> (at <depth>) and apply the relations from <idx> below it
+ */
+TASK_4(MDD, lddmc_relprod_multi_level, const lddmc_relprod_multi_ctx_t*, ctx, MDD, set, size_t, idx, uint32_t, depth)
+{
+    if (set == lddmc_false) return lddmc_false;
+
+    mddnode_t n_set = LDD_GETNODE(set);
+    MDD down, right;
+    SYLVAN_FORK(lddmc, down, right, (lddmc_relprod_multi_rec, ctx, mddnode_getdown(n_set), idx, depth+1), (lddmc_relprod_multi_level, ctx, mddnode_getright(n_set), idx, depth));
+    lddmc_refs_pop(1);
+    return lddmc_makenode(mddnode_getvalue(n_set), down, right);
+}
+
+/**
+ * Apply the relations from <idx> (which start at <depth> or deeper) to <set> (at <depth>)
+ */
+TASK_IMPL_4(MDD, lddmc_relprod_multi_rec, const lddmc_relprod_multi_ctx_t*, ctx, MDD, set, size_t, idx, uint32_t, depth)
+{
+    if (set == lddmc_false) return lddmc_false;
+    if (idx == ctx->n) return lddmc_false;
+
+    /* Test gc */
+    sylvan_gc_test();
+
+    sylvan_stats_count(LDD_RELPROD_MULTI);
+
+    /* Access cache */
+    MDD result;
+    if (cache_get4(CACHE_MDD_RELPROD_MULTI, set, idx, depth, ctx->id, &result)) {
+        sylvan_stats_count(LDD_RELPROD_MULTI_CACHED);
+        return result;
+    }
+
+    /* Dispatch the relations that start at this level on the whole level */
+    size_t end = idx;
+    while (end < ctx->n && ctx->firstvars[end] == depth) {
+        lddmc_refs_spawn(SPAWN(lddmc_relprod, set, ctx->rels[end], ctx->topmetas[end]));
+        end++;
+    }
+
+    /* Go down for the other relations */
+    result = end < ctx->n ? CALL(lddmc_relprod_multi_level, ctx, set, end, depth) : lddmc_false;
+
+    /* Union the results as they are synced */
+    while (end-- > idx) {
+        lddmc_refs_push(result);
+        MDD result2 = lddmc_refs_sync(SYNC(lddmc_relprod));
+        lddmc_refs_push(result2);
+        result = CALL(lddmc_union, result, result2);
+        lddmc_refs_pop(2);
+    }
+
+    /* Write to cache */
+    if (cache_put4(CACHE_MDD_RELPROD_MULTI, set, idx, depth, ctx->id, result)) sylvan_stats_count(LDD_RELPROD_MULTI_CACHEDPUT);
+
+    return result;
+}
+
+TASK_IMPL_4(MDD, lddmc_relprod_multi, MDD, set, const MDD*, rels, const MDD*, metas, size_t, n)
+{
+    /* Sort the relations by their first level (insertion sort, stable) and strip the leading 0s */
+    MDD *sorted_rels = (MDD*)malloc(sizeof(MDD[2*n+1]));
+    MDD *topmetas = sorted_rels + n;
+    uint32_t *firstvars = (uint32_t*)malloc(sizeof(uint32_t[n+1]));
+    if (sorted_rels == NULL || firstvars == NULL) {
+        fprintf(stderr, "lddmc_relprod_multi: Unable to allocate memory!\n");
+        exit(1);
+    }
+    size_t count = 0;
+    for (size_t i=0; i<n; i++) {
+        if (rels[i] == lddmc_false) continue;
+        MDD meta = metas[i];
+        uint32_t firstvar = 0;
+        while (meta != lddmc_true && lddmc_getvalue(meta) == 0) {
+            meta = lddmc_getdown(meta);
+            firstvar++;
+        }
+        size_t j = count++;
+        while (j > 0 && firstvars[j-1] > firstvar) {
+            sorted_rels[j] = sorted_rels[j-1];
+            topmetas[j] = topmetas[j-1];
+            firstvars[j] = firstvars[j-1];
+            j--;
+        }
+        sorted_rels[j] = rels[i];
+        topmetas[j] = meta;
+        firstvars[j] = firstvar;
+    }
+
+    lddmc_relprod_multi_ctx_t ctx = { count, sorted_rels, topmetas, firstvars, atomic_fetch_add(&lddmc_relprod_multi_next_id, 1) };
+    MDD result = CALL(lddmc_relprod_multi_rec, &ctx, set, 0, 0);
+
+    free(sorted_rels);
+    free(firstvars);
+    return result;
+}
+
 TASK_5(MDD, lddmc_relprev_help, uint32_t, val, MDD, set, MDD, rel, MDD, proj, MDD, uni)
 {
     return lddmc_makenode(val, CALL(lddmc_relprev, set, rel, proj, uni), lddmc_false);
@@ -1871,6 +2302,111 @@ lddmc_member_cube_copy(MDD a, uint32_t* values, int* copy, size_t count)
     }
 }
 
+TASK_DECL_4(MDD, lddmc_from_sorted_rec, const uint32_t*, size_t, size_t, size_t);
+
+/**
+ * The groups of vectors with the same value at position <depth> (for lddmc_from_sorted_array).
+ * The vectors of group g are <starts>[g]..<starts>[g+1]; the down edge of group g is stored in <downs>[g].
+ */
+typedef struct lddmc_sorted_groups {
+    const uint32_t *vectors;
+    const size_t *starts;
+    MDD *downs;
+    size_t length;
+    size_t depth;
+} lddmc_sorted_groups_t;
+
+/**
+ * Build the down edges of the groups <g0>..<g1>.
+ */
+VOID_TASK_3(lddmc_from_sorted_groups, const lddmc_sorted_groups_t*, groups, size_t, g0, size_t, g1)
+{
+    while (g1 - g0 > 1) {
+        size_t mid = g0 + (g1 - g0) / 2;
+        if (SYLVAN_SPAWN_OK()) {
+            SYLVAN_SPAWN((lddmc_from_sorted_groups, groups, mid, g1));
+            CALL(lddmc_from_sorted_groups, groups, g0, mid);
+            SYLVAN_SYNC(lddmc_from_sorted_groups);
+            return;
+        }
+        CALL(lddmc_from_sorted_groups, groups, mid, g1);
+        g1 = mid;
+    }
+    const size_t first = groups->starts[g0], count = groups->starts[g0+1] - first;
+    groups->downs[g0] = CALL(lddmc_from_sorted_rec, groups->vectors + first * groups->length, count, groups->length, groups->depth+1);
+}
+
+/**
+ * Build the LDD of <count> (at least 1) sorted vectors from value <depth> onwards.
+ */
+TASK_IMPL_4(MDD, lddmc_from_sorted_rec, const uint32_t*, vectors, size_t, count, size_t, length, size_t, depth)
+{
+    if (depth == length) return lddmc_true;
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count the groups of vectors with the same value */
+    size_t ngroups = 1;
+    for (size_t i=1; i<count; i++) {
+        uint32_t prev = vectors[(i-1)*length+depth], cur = vectors[i*length+depth];
+        assert(prev <= cur); // the vectors must be sorted
+        if (prev != cur) ngroups++;
+    }
+
+    if (ngroups == 1) {
+        MDD down = CALL(lddmc_from_sorted_rec, vectors, count, length, depth+1);
+        lddmc_refs_push(down);
+        MDD result = lddmc_makenode(vectors[depth], down, lddmc_false);
+        lddmc_refs_pop(1);
+        return result;
+    }
+
+    /* Find the first vector of each group and build the down edges of the groups in parallel */
+    size_t *starts = (size_t*)malloc(sizeof(size_t) * (ngroups + 1) + sizeof(MDD) * ngroups);
+    if (starts == NULL) {
+        fprintf(stderr, "lddmc_from_sorted_array: Unable to allocate memory!\n");
+        exit(1);
+    }
+    MDD *downs = (MDD*)(starts + ngroups + 1);
+    starts[0] = 0;
+    for (size_t i=1, g=1; i<count; i++) {
+        if (vectors[(i-1)*length+depth] != vectors[i*length+depth]) starts[g++] = i;
+    }
+    starts[ngroups] = count;
+    for (size_t g=0; g<ngroups; g++) {
+        downs[g] = lddmc_false;
+        lddmc_refs_pushptr(&downs[g]);
+    }
+    lddmc_sorted_groups_t groups = { vectors, starts, downs, length, depth };
+    CALL(lddmc_from_sorted_groups, &groups, 0, ngroups);
+
+    /* Link the groups from right to left */
+    MDD result = lddmc_false;
+    lddmc_refs_pushptr(&result);
+    for (size_t g=ngroups; g>0; g--) {
+        result = lddmc_makenode(vectors[starts[g-1]*length+depth], downs[g-1], result);
+    }
+    lddmc_refs_popptr(ngroups + 1);
+    free(starts);
+    return result;
+}
+
+TASK_IMPL_3(MDD, lddmc_from_sorted_array, const uint32_t*, vectors, size_t, count, size_t, length)
+{
+    if (count == 0) return lddmc_false;
+    return CALL(lddmc_from_sorted_rec, vectors, count, length, 0);
+}
+
+TASK_IMPL_4(MDD, lddmc_union_sorted_array, MDD, a, const uint32_t*, vectors, size_t, count, size_t, length)
+{
+    MDD b = CALL(lddmc_from_sorted_array, vectors, count, length);
+    lddmc_refs_push(b);
+    MDD result = CALL(lddmc_union, a, b);
+    lddmc_refs_pop(1);
+    return result;
+}
+
 MDD
 lddmc_cube(uint32_t* values, size_t count)
 {
@@ -2028,39 +2564,354 @@ TASK_IMPL_1(long double, lddmc_satcount, MDD, mdd)
     return hack.d;
 }
 
-TASK_IMPL_5(MDD, lddmc_collect, MDD, mdd, lddmc_collect_cb, cb, void*, context, uint32_t*, values, size_t, count)
-{
-    if (mdd == lddmc_false) return lddmc_false;
-    if (mdd == lddmc_true) {
-        return WRAP(cb, values, count, context);
-    }
+/**
+ * Exact satcount.
+ * Counts are stored per node in a memo table indexed by the node index. A count below 2^63 is
+ * stored inline as (count << 1) | 1, larger counts point to a bignum in the arena of a worker.
+ * Every entry is tagged with the generation in which it was computed. A new generation starts
+ * when a count is started after garbage collection, since the indices of dead nodes are reused.
+ * Nodes of a running count are never dead, so a count that spans garbage collection may keep
+ * using its own generation. The arenas and the memo table are only freed when no count is running.
+ * The memo table has the size of the node table. If the node table has grown when a count starts
+ * while other counts are running, a larger memo table replaces it and the old one is retired
+ * (running counts simply miss their earlier entries) until no count is running.
+ */
+typedef struct lddmc_exact_entry {
+    _Atomic(uint64_t) gen;
+    _Atomic(uint64_t) value;
+} *lddmc_exact_entry_t;
 
-    mddnode_t n = LDD_GETNODE(mdd);
+typedef struct lddmc_exact_memo {
+    struct lddmc_exact_memo *retired; // older memo tables, freed when no count is running
+    size_t size;
+    struct lddmc_exact_entry entries[];
+} *lddmc_exact_memo_t;
 
-    lddmc_refs_spawn(SPAWN(lddmc_collect, mddnode_getright(n), cb, context, values, count));
+typedef struct lddmc_bignum {
+    uint64_t size; // number of limbs, least significant first
+    uint64_t limbs[];
+} *lddmc_bignum_t;
 
-    uint32_t newvalues[count+1];
-    if (count > 0) memcpy(newvalues, values, sizeof(uint32_t)*count);
-    newvalues[count] = mddnode_getvalue(n);
-    MDD down = CALL(lddmc_collect, mddnode_getdown(n), cb, context, newvalues, count+1);
+typedef struct lddmc_exact_chunk {
+    struct lddmc_exact_chunk *next;
+    size_t used, size; // in limbs
+    uint64_t data[];
+} *lddmc_exact_chunk_t;
 
-    if (down == lddmc_false) {
-        MDD result = lddmc_refs_sync(SYNC(lddmc_collect));
-        return result;
-    }
+#define LDDMC_EXACT_CHUNK_LIMBS 65536
 
-    lddmc_refs_push(down);
-    MDD right = lddmc_refs_sync(SYNC(lddmc_collect));
+static _Atomic(lddmc_exact_memo_t) lddmc_exact_memo = NULL;
+static lddmc_exact_chunk_t *lddmc_exact_chunks = NULL;
+static size_t lddmc_exact_workers = 0;
+static uint64_t lddmc_exact_gen = 0;
+static uint64_t lddmc_exact_gen_epoch = 0;
+static size_t lddmc_exact_users = 0;
+static atomic_flag lddmc_exact_lock = ATOMIC_FLAG_INIT;
+static _Atomic(uint64_t) lddmc_exact_epoch = 1; // incremented before garbage collection
 
-    if (right == lddmc_false) {
-        lddmc_refs_pop(1);
-        return down;
-    } else {
-        lddmc_refs_push(right);
-        MDD result = CALL(lddmc_union, down, right);
-        lddmc_refs_pop(2);
-        return result;
-    }
+VOID_TASK_IMPL_0(lddmc_exact_gc)
+{
+    atomic_fetch_add(&lddmc_exact_epoch, 1);
+}
+
+/* Allocate an empty memo table of <size> entries */
+static lddmc_exact_memo_t
+lddmc_exact_memo_alloc(size_t size)
+{
+    lddmc_exact_memo_t memo = (lddmc_exact_memo_t)alloc_aligned(sizeof(struct lddmc_exact_memo) + size * sizeof(struct lddmc_exact_entry));
+    if (memo == NULL) {
+        fprintf(stderr, "lddmc_satcount_exact: Unable to allocate memory!\n");
+        exit(1);
+    }
+    memo->retired = NULL;
+    memo->size = size;
+    return memo;
+}
+
+/* Free the arenas and the memo tables; only called when no count is running */
+static void
+lddmc_exact_free(void)
+{
+    for (size_t i=0; i<lddmc_exact_workers; i++) {
+        lddmc_exact_chunk_t c = lddmc_exact_chunks[i];
+        while (c != NULL) {
+            lddmc_exact_chunk_t next = c->next;
+            free(c);
+            c = next;
+        }
+    }
+    free(lddmc_exact_chunks);
+    lddmc_exact_chunks = NULL;
+    lddmc_exact_workers = 0;
+    lddmc_exact_memo_t memo = atomic_load_explicit(&lddmc_exact_memo, memory_order_relaxed);
+    while (memo != NULL) {
+        lddmc_exact_memo_t next = memo->retired;
+        free_aligned(memo, sizeof(struct lddmc_exact_memo) + memo->size * sizeof(struct lddmc_exact_entry));
+        memo = next;
+    }
+    atomic_store_explicit(&lddmc_exact_memo, NULL, memory_order_relaxed);
+}
+
+/* Start a count and return the generation to use */
+static uint64_t
+lddmc_exact_enter(void)
+{
+    while (atomic_flag_test_and_set_explicit(&lddmc_exact_lock, memory_order_acquire)) {}
+    const uint64_t epoch = atomic_load(&lddmc_exact_epoch);
+    const size_t size = llmsset_get_size(nodes);
+    lddmc_exact_memo_t memo = atomic_load_explicit(&lddmc_exact_memo, memory_order_relaxed);
+    if (memo == NULL || epoch != lddmc_exact_gen_epoch || memo->size != size) {
+        if (lddmc_exact_users == 0) {
+            lddmc_exact_free();
+            memo = lddmc_exact_memo_alloc(size);
+            lddmc_exact_workers = lace_workers();
+            lddmc_exact_chunks = (lddmc_exact_chunk_t*)calloc(lddmc_exact_workers, sizeof(lddmc_exact_chunk_t));
+            if (lddmc_exact_chunks == NULL) {
+                fprintf(stderr, "lddmc_satcount_exact: Unable to allocate memory!\n");
+                exit(1);
+            }
+            atomic_store_explicit(&lddmc_exact_memo, memo, memory_order_release);
+        } else if (memo->size != size) {
+            /* the node table has grown, running counts switch to the new memo table */
+            lddmc_exact_memo_t bigger = lddmc_exact_memo_alloc(size);
+            bigger->retired = memo;
+            atomic_store_explicit(&lddmc_exact_memo, bigger, memory_order_release);
+        }
+        lddmc_exact_gen++;
+        lddmc_exact_gen_epoch = epoch;
+    }
+    lddmc_exact_users++;
+    const uint64_t gen = lddmc_exact_gen;
+    atomic_flag_clear_explicit(&lddmc_exact_lock, memory_order_release);
+    return gen;
+}
+
+static void
+lddmc_exact_leave(void)
+{
+    while (atomic_flag_test_and_set_explicit(&lddmc_exact_lock, memory_order_acquire)) {}
+    lddmc_exact_users--;
+    atomic_flag_clear_explicit(&lddmc_exact_lock, memory_order_release);
+}
+
+/* Allocate a bignum of <size> limbs in the arena of the current worker */
+static lddmc_bignum_t
+lddmc_bignum_alloc(size_t size)
+{
+    lddmc_exact_chunk_t *head = &lddmc_exact_chunks[lace_get_worker()->worker];
+    lddmc_exact_chunk_t c = *head;
+    if (c == NULL || c->used + size + 1 > c->size) {
+        size_t limbs = size + 1 > LDDMC_EXACT_CHUNK_LIMBS ? size + 1 : LDDMC_EXACT_CHUNK_LIMBS;
+        c = (lddmc_exact_chunk_t)malloc(sizeof(struct lddmc_exact_chunk) + limbs * sizeof(uint64_t));
+        if (c == NULL) {
+            fprintf(stderr, "lddmc_satcount_exact: Unable to allocate memory!\n");
+            exit(1);
+        }
+        c->next = *head;
+        c->used = 0;
+        c->size = limbs;
+        *head = c;
+    }
+    lddmc_bignum_t b = (lddmc_bignum_t)(c->data + c->used);
+    c->used += size + 1;
+    b->size = size;
+    return b;
+}
+
+/* Get the limbs of a count; <buf> holds an inline count */
+static inline const uint64_t*
+lddmc_exact_limbs(uint64_t value, uint64_t *buf, size_t *size)
+{
+    if (value & 1) {
+        *buf = value >> 1;
+        *size = 1;
+        return buf;
+    } else {
+        lddmc_bignum_t b = (lddmc_bignum_t)(uintptr_t)value;
+        *size = b->size;
+        return b->limbs;
+    }
+}
+
+static uint64_t
+lddmc_exact_add(uint64_t a, uint64_t b)
+{
+    if ((a & 1) && (b & 1)) {
+        uint64_t sum = (a >> 1) + (b >> 1); // no overflow, both are below 2^63
+        if (sum < (1ULL << 63)) return (sum << 1) | 1;
+    }
+    uint64_t buf_a, buf_b;
+    size_t size_a, size_b;
+    const uint64_t *la = lddmc_exact_limbs(a, &buf_a, &size_a);
+    const uint64_t *lb = lddmc_exact_limbs(b, &buf_b, &size_b);
+    if (size_a < size_b) {
+        const uint64_t *t = la; la = lb; lb = t;
+        size_t s = size_a; size_a = size_b; size_b = s;
+    }
+    lddmc_bignum_t r = lddmc_bignum_alloc(size_a + 1);
+    uint64_t carry = 0;
+    for (size_t i=0; i<size_a; i++) {
+        uint64_t x = la[i], y = i < size_b ? lb[i] : 0;
+        uint64_t s = x + y;
+        uint64_t c = s < x;
+        s += carry;
+        c |= s < carry;
+        r->limbs[i] = s;
+        carry = c;
+    }
+    r->limbs[size_a] = carry;
+    if (carry == 0) r->size = size_a;
+    return (uint64_t)(uintptr_t)r;
+}
+
+TASK_2(uint64_t, lddmc_satcount_exact_rec, MDD, mdd, uint64_t, gen)
+{
+    if (mdd == lddmc_false) return 1; // 0
+    if (mdd == lddmc_true) return 3; // 1
+
+    /* Perhaps execute garbage collection */
+    sylvan_gc_test();
+
+    sylvan_stats_count(LDD_SATCOUNT_EXACT);
+
+    lddmc_exact_memo_t memo = atomic_load_explicit(&lddmc_exact_memo, memory_order_acquire);
+    lddmc_exact_entry_t e = mdd < memo->size ? &memo->entries[mdd] : NULL;
+    if (e != NULL && atomic_load_explicit(&e->gen, memory_order_acquire) == gen) {
+        sylvan_stats_count(LDD_SATCOUNT_EXACT_CACHED);
+        return atomic_load_explicit(&e->value, memory_order_relaxed);
+    }
+
+    mddnode_t n = LDD_GETNODE(mdd);
+
+    SPAWN(lddmc_satcount_exact_rec, mddnode_getdown(n), gen);
+    uint64_t right = CALL(lddmc_satcount_exact_rec, mddnode_getright(n), gen);
+    uint64_t result = lddmc_exact_add(SYNC(lddmc_satcount_exact_rec), right);
+
+    if (e != NULL) {
+        atomic_store_explicit(&e->value, result, memory_order_relaxed);
+        atomic_store_explicit(&e->gen, gen, memory_order_release);
+        sylvan_stats_count(LDD_SATCOUNT_EXACT_CACHEDPUT);
+    }
+
+    return result;
+}
+
+size_t
+lddmc_satcount_exact(MDD mdd, uint64_t *limbs, size_t n)
+{
+    const uint64_t gen = lddmc_exact_enter();
+    uint64_t value = RUN(lddmc_satcount_exact_rec, mdd, gen);
+    uint64_t buf;
+    size_t size;
+    const uint64_t *l = lddmc_exact_limbs(value, &buf, &size);
+    for (size_t i=0; i<n; i++) limbs[i] = i < size ? l[i] : 0;
+    lddmc_exact_leave();
+    return size;
+}
+
+char*
+lddmc_satcount_exact_str(MDD mdd)
+{
+    size_t size = lddmc_satcount_exact(mdd, NULL, 0);
+    uint64_t *limbs = (uint64_t*)malloc(sizeof(uint64_t) * (size > 0 ? size : 1));
+    char *str = (char*)malloc(20*size+1);
+    if (limbs == NULL || str == NULL) {
+        fprintf(stderr, "lddmc_satcount_exact_str: Unable to allocate memory!\n");
+        exit(1);
+    }
+    lddmc_satcount_exact(mdd, limbs, size);
+
+    // repeatedly divide by 10^9 (32 bits at a time), which gives 9 digits (at most 20 digits per limb)
+    char *end = str + 20*size, *p = end;
+    *p = 0;
+    while (size > 0) {
+        uint64_t rem = 0;
+        for (size_t i=size; i-->0;) {
+            uint64_t hi = (rem << 32) | (limbs[i] >> 32);
+            uint64_t lo = ((hi % 1000000000) << 32) | (limbs[i] & 0xffffffff);
+            limbs[i] = ((hi / 1000000000) << 32) | (lo / 1000000000);
+            rem = lo % 1000000000;
+        }
+        while (size > 0 && limbs[size-1] == 0) size--;
+        uint64_t digits = rem;
+        for (int i=0; i<9 && (size > 0 || digits != 0); i++) {
+            *--p = '0' + (digits % 10);
+            digits /= 10;
+        }
+    }
+    if (p == end) *--p = '0';
+    memmove(str, p, end - p + 1);
+    free(limbs);
+    return str;
+}
+
+TASK_IMPL_1(double, lddmc_satcount_log2, MDD, mdd)
+{
+    if (mdd == lddmc_false) return -INFINITY;
+    if (mdd == lddmc_true) return 0.0;
+
+    /* Perhaps execute garbage collection */
+    sylvan_gc_test();
+
+    union {
+        double d;
+        uint64_t s;
+    } hack;
+
+    sylvan_stats_count(LDD_SATCOUNT_LOG2);
+
+    if (cache_get3(CACHE_MDD_SATCOUNT_LOG2, mdd, 0, 0, &hack.s)) {
+        sylvan_stats_count(LDD_SATCOUNT_LOG2_CACHED);
+        return hack.d;
+    }
+
+    mddnode_t n = LDD_GETNODE(mdd);
+
+    SPAWN(lddmc_satcount_log2, mddnode_getdown(n));
+    double right = CALL(lddmc_satcount_log2, mddnode_getright(n));
+    double down = SYNC(lddmc_satcount_log2);
+    // log2(2^a + 2^b) = max + log2(1 + 2^(min-max))
+    double hi = down > right ? down : right, lo = down > right ? right : down;
+    hack.d = lo == -INFINITY ? hi : hi + log2(1.0 + exp2(lo - hi));
+
+    if (cache_put3(CACHE_MDD_SATCOUNT_LOG2, mdd, 0, 0, hack.s)) sylvan_stats_count(LDD_SATCOUNT_LOG2_CACHEDPUT);
+
+    return hack.d;
+}
+
+TASK_IMPL_5(MDD, lddmc_collect, MDD, mdd, lddmc_collect_cb, cb, void*, context, uint32_t*, values, size_t, count)
+{
+    if (mdd == lddmc_false) return lddmc_false;
+    if (mdd == lddmc_true) {
+        return WRAP(cb, values, count, context);
+    }
+
+    mddnode_t n = LDD_GETNODE(mdd);
+
+    lddmc_refs_spawn(SPAWN(lddmc_collect, mddnode_getright(n), cb, context, values, count));
+
+    uint32_t newvalues[count+1];
+    if (count > 0) memcpy(newvalues, values, sizeof(uint32_t)*count);
+    newvalues[count] = mddnode_getvalue(n);
+    MDD down = CALL(lddmc_collect, mddnode_getdown(n), cb, context, newvalues, count+1);
+
+    if (down == lddmc_false) {
+        MDD result = lddmc_refs_sync(SYNC(lddmc_collect));
+        return result;
+    }
+
+    lddmc_refs_push(down);
+    MDD right = lddmc_refs_sync(SYNC(lddmc_collect));
+
+    if (right == lddmc_false) {
+        lddmc_refs_pop(1);
+        return down;
+    } else {
+        lddmc_refs_push(right);
+        MDD result = CALL(lddmc_union, down, right);
+        lddmc_refs_pop(2);
+        return result;
+    }
 }
 
 VOID_TASK_5(_lddmc_sat_all_nopar, MDD, mdd, lddmc_enum_cb, cb, void*, context, uint32_t*, values, size_t, count)
@@ -2232,6 +3083,374 @@ TASK_IMPL_4(MDD, lddmc_compose, MDD, mdd, lddmc_compose_cb, cb, void*, context,
     }
 }
 
+/**
+ * Conversion between LDDs and BDDs
+ */
+
+/**
+ * Atomically raise *ptr to <value>
+ */
+static inline void
+lddmc_raise_highest(uint32_t *ptr, uint32_t value)
+{
+    _Atomic(uint32_t) *a = (_Atomic(uint32_t)*)ptr;
+    uint32_t cur = atomic_load_explicit(a, memory_order_relaxed);
+    while (value > cur) {
+        if (atomic_compare_exchange_weak(a, &cur, value)) break;
+    }
+}
+
+/**
+ * Every call of lddmc_highest and lddmc_rel_highest gets its own id, which is part of the
+ * cache key, so nodes are visited once per call (the cache only records visited nodes).
+ */
+static _Atomic(uint64_t) lddmc_highest_next_id = 1;
+
+VOID_TASK_3(lddmc_highest_rec, MDD, mdd, uint32_t*, highest, uint64_t, id)
+{
+    if (mdd == lddmc_true || mdd == lddmc_false) return;
+
+    uint64_t result = 1;
+    if (cache_get3(CACHE_MDD_HIGHEST, mdd, id, 0, &result)) return;
+    cache_put3(CACHE_MDD_HIGHEST, mdd, id, 0, result);
+
+    mddnode_t n = LDD_GETNODE(mdd);
+    SPAWN(lddmc_highest_rec, mddnode_getright(n), highest, id);
+    CALL(lddmc_highest_rec, mddnode_getdown(n), highest+1, id);
+    SYNC(lddmc_highest_rec);
+
+    if (!mddnode_getcopy(n)) lddmc_raise_highest(highest, mddnode_getvalue(n));
+}
+
+VOID_TASK_IMPL_2(lddmc_highest, MDD, mdd, uint32_t*, highest)
+{
+    CALL(lddmc_highest_rec, mdd, highest, atomic_fetch_add(&lddmc_highest_next_id, 1));
+}
+
+VOID_TASK_4(lddmc_rel_highest_rec, MDD, rel, MDD, meta, uint32_t*, highest, uint64_t, id)
+{
+    if (rel == lddmc_true || rel == lddmc_false) return;
+
+    /* Skip levels that are not in the relation */
+    uint32_t vmeta = lddmc_getvalue(meta);
+    while (vmeta == 0) {
+        meta = lddmc_getdown(meta);
+        highest++;
+        vmeta = lddmc_getvalue(meta);
+    }
+    if (vmeta == 5 || vmeta == (uint32_t)-1) return;
+
+    uint64_t result = 1;
+    if (cache_get4(CACHE_MDD_HIGHEST, rel, meta, id, 0, &result)) return;
+    cache_put4(CACHE_MDD_HIGHEST, rel, meta, id, 0, result);
+
+    /* The read level of a read+write pair shares the integer variable with the write level */
+    mddnode_t n = LDD_GETNODE(rel);
+    SPAWN(lddmc_rel_highest_rec, mddnode_getright(n), meta, highest, id);
+    CALL(lddmc_rel_highest_rec, mddnode_getdown(n), lddmc_getdown(meta), vmeta == 1 ? highest : highest+1, id);
+    SYNC(lddmc_rel_highest_rec);
+
+    if (!mddnode_getcopy(n)) lddmc_raise_highest(highest, mddnode_getvalue(n));
+}
+
+VOID_TASK_IMPL_3(lddmc_rel_highest, MDD, rel, MDD, meta, uint32_t*, highest)
+{
+    CALL(lddmc_rel_highest_rec, rel, meta, highest, atomic_fetch_add(&lddmc_highest_next_id, 1));
+}
+
+MDD
+lddmc_bits_from_highest(const uint32_t *highest, size_t count)
+{
+    MDD bits = lddmc_true;
+    for (size_t i=0; i<count; i++) {
+        uint32_t h = highest[count-i-1];
+        uint32_t b = 1;
+        while (h >>= 1) b++;
+        bits = lddmc_makenode(b, bits, lddmc_false);
+    }
+    return bits;
+}
+
+/**
+ * Encode <value> on <bits> BDD variables (highest bit first) from <var> with stride 2, above <dd>
+ */
+static MTBDD
+lddmc_encode_value(MTBDD dd, uint32_t value, uint32_t bits, uint32_t var)
+{
+    for (uint32_t i=0; i<bits; i++) {
+        const uint32_t v = var + 2*(bits-i-1);
+        if (value & (1LL<<i)) dd = mtbdd_makenode(v, mtbdd_false, dd);
+        else dd = mtbdd_makenode(v, dd, mtbdd_false);
+    }
+    return dd;
+}
+
+TASK_IMPL_3(MTBDD, lddmc_to_bdd, MDD, mdd, MDD, bits_dd, uint32_t, firstvar)
+{
+    if (mdd == lddmc_false) return mtbdd_false;
+    if (mdd == lddmc_true) return mtbdd_true;
+
+    sylvan_gc_test();
+
+    sylvan_stats_count(LDD_TO_BDD);
+
+    MTBDD result;
+    if (cache_get3(CACHE_MDD_TO_BDD, mdd, bits_dd, firstvar, &result)) {
+        sylvan_stats_count(LDD_TO_BDD_CACHED);
+        return result;
+    }
+
+    mddnode_t n = LDD_GETNODE(mdd);
+    const uint32_t bits = lddmc_getvalue(bits_dd);
+
+    mtbdd_refs_spawn(SPAWN(lddmc_to_bdd, mddnode_getright(n), bits_dd, firstvar));
+    MTBDD down = CALL(lddmc_to_bdd, mddnode_getdown(n), lddmc_getdown(bits_dd), firstvar + 2*bits);
+    down = lddmc_encode_value(down, mddnode_getvalue(n), bits, firstvar);
+    mtbdd_refs_push(down);
+    MTBDD right = mtbdd_refs_sync(SYNC(lddmc_to_bdd));
+    mtbdd_refs_push(right);
+    result = sylvan_not(CALL(sylvan_and, sylvan_not(down), sylvan_not(right), 0));
+    mtbdd_refs_pop(2);
+
+    if (cache_put3(CACHE_MDD_TO_BDD, mdd, bits_dd, firstvar, result)) sylvan_stats_count(LDD_TO_BDD_CACHEDPUT);
+    return result;
+}
+
+TASK_IMPL_4(MTBDD, lddmc_rel_to_bdd, MDD, rel, MDD, bits_dd, MDD, meta, uint32_t, firstvar)
+{
+    if (rel == lddmc_false) return mtbdd_false;
+    if (rel == lddmc_true) return mtbdd_true;
+
+    /* Skip levels that are not in the relation */
+    uint32_t vmeta = lddmc_getvalue(meta);
+    while (vmeta == 0) {
+        firstvar += 2*lddmc_getvalue(bits_dd);
+        bits_dd = lddmc_getdown(bits_dd);
+        meta = lddmc_getdown(meta);
+        vmeta = lddmc_getvalue(meta);
+    }
+    /* Abstract action labels */
+    if (vmeta == 5 || vmeta == (uint32_t)-1) return mtbdd_true;
+
+    sylvan_gc_test();
+
+    sylvan_stats_count(LDD_REL_TO_BDD);
+
+    MTBDD result;
+    if (cache_get4(CACHE_MDD_REL_TO_BDD, rel, bits_dd, meta, firstvar, &result)) {
+        sylvan_stats_count(LDD_REL_TO_BDD_CACHED);
+        return result;
+    }
+
+    const mddnode_t n = LDD_GETNODE(rel);
+    const uint32_t bits = lddmc_getvalue(bits_dd);
+    const uint32_t value = mddnode_getvalue(n);
+
+    mtbdd_refs_spawn(SPAWN(lddmc_rel_to_bdd, mddnode_getright(n), bits_dd, meta, firstvar));
+
+    MTBDD down;
+    if (vmeta == 1) {
+        /* read level: the write level below encodes the same integer variable */
+        assert(!mddnode_getcopy(n));
+        down = CALL(lddmc_rel_to_bdd, mddnode_getdown(n), bits_dd, lddmc_getdown(meta), firstvar);
+        mtbdd_refs_push(down);
+        MTBDD read = lddmc_encode_value(mtbdd_true, value, bits, firstvar);
+        mtbdd_refs_push(read);
+        down = CALL(sylvan_and, read, down, 0);
+        mtbdd_refs_pop(2);
+    } else {
+        down = CALL(lddmc_rel_to_bdd, mddnode_getdown(n), lddmc_getdown(bits_dd), lddmc_getdown(meta), firstvar + 2*bits);
+        if (vmeta == 3) {
+            /* only-read: the primed variables keep the value */
+            assert(!mddnode_getcopy(n));
+            for (uint32_t i=0; i<bits; i++) {
+                const uint32_t v = firstvar + 2*(bits-i-1);
+                down = lddmc_encode_value(down, (value >> i) & 1, 1, v+1);
+                down = lddmc_encode_value(down, (value >> i) & 1, 1, v);
+            }
+        } else if (mddnode_getcopy(n)) {
+            /* write level with a copy node: primed = unprimed */
+            assert(vmeta == 2 || vmeta == 4);
+            for (uint32_t i=0; i<bits; i++) {
+                const uint32_t v = firstvar + 2*(bits-i-1);
+                MTBDD low = mtbdd_makenode(v+1, down, mtbdd_false);
+                mtbdd_refs_push(low);
+                MTBDD high = mtbdd_makenode(v+1, mtbdd_false, down);
+                mtbdd_refs_pop(1);
+                down = mtbdd_makenode(v, low, high);
+            }
+        } else {
+            /* write or only-write level */
+            assert(vmeta == 2 || vmeta == 4);
+            down = lddmc_encode_value(down, value, bits, firstvar+1);
+        }
+    }
+
+    mtbdd_refs_push(down);
+    MTBDD right = mtbdd_refs_sync(SYNC(lddmc_rel_to_bdd));
+    mtbdd_refs_push(right);
+    result = sylvan_not(CALL(sylvan_and, sylvan_not(down), sylvan_not(right), 0));
+    mtbdd_refs_pop(2);
+
+    if (cache_put4(CACHE_MDD_REL_TO_BDD, rel, bits_dd, meta, firstvar, result)) sylvan_stats_count(LDD_REL_TO_BDD_CACHEDPUT);
+    return result;
+}
+
+MTBDD
+lddmc_meta_to_bdd_vars(MDD meta, MDD bits_dd, uint32_t firstvar)
+{
+    if (meta == lddmc_false || meta == lddmc_true) return mtbdd_true;
+
+    const uint32_t vmeta = lddmc_getvalue(meta);
+    if (vmeta == 5 || vmeta == (uint32_t)-1) return mtbdd_true;
+    /* the variables of a read level are added by the write level below */
+    if (vmeta == 1) return lddmc_meta_to_bdd_vars(lddmc_getdown(meta), bits_dd, firstvar);
+
+    const uint32_t bits = lddmc_getvalue(bits_dd);
+    MTBDD res = lddmc_meta_to_bdd_vars(lddmc_getdown(meta), lddmc_getdown(bits_dd), firstvar + 2*bits);
+    if (vmeta != 0) {
+        for (uint32_t i=0; i<2*bits; i++) res = mtbdd_makenode(firstvar + 2*bits-i-1, mtbdd_false, res);
+    }
+    return res;
+}
+
+/**
+ * Get the cofactors of <dd> for BDD variable <var>
+ */
+static inline void
+lddmc_bdd_cofactors(MTBDD dd, uint32_t var, MTBDD *low, MTBDD *high)
+{
+    if (!mtbdd_isleaf(dd) && mtbdd_getvar(dd) == var) {
+        *low = mtbdd_getlow(dd);
+        *high = mtbdd_gethigh(dd);
+    } else {
+        *low = *high = dd;
+    }
+}
+
+/**
+ * Decode the value of the integer variable that starts at <firstvar> from bit <j> on,
+ * where <value> holds the bits before j, and convert the rest of <dd> below it.
+ */
+TASK_5(MDD, lddmc_from_bdd_value, MTBDD, dd, MDD, bits_dd, uint32_t, firstvar, uint32_t, j, uint32_t, value)
+{
+    if (dd == mtbdd_false) return lddmc_false;
+
+    const uint32_t bits = lddmc_getvalue(bits_dd);
+    if (j == bits) {
+        MDD down = CALL(lddmc_from_bdd, dd, lddmc_getdown(bits_dd), firstvar + 2*bits);
+        if (down == lddmc_false) return lddmc_false;
+        return lddmc_makenode(value, down, lddmc_false);
+    }
+
+    MTBDD low, high;
+    lddmc_bdd_cofactors(dd, firstvar + 2*j, &low, &high);
+    const uint32_t bit = 1 << (bits-j-1);
+
+    lddmc_refs_spawn(SPAWN(lddmc_from_bdd_value, high, bits_dd, firstvar, j+1, value | bit));
+    MDD left = lddmc_refs_push(CALL(lddmc_from_bdd_value, low, bits_dd, firstvar, j+1, value));
+    MDD right = lddmc_refs_push(lddmc_refs_sync(SYNC(lddmc_from_bdd_value)));
+    MDD result = CALL(lddmc_union, left, right);
+    lddmc_refs_pop(2);
+    return result;
+}
+
+TASK_IMPL_3(MDD, lddmc_from_bdd, MTBDD, dd, MDD, bits_dd, uint32_t, firstvar)
+{
+    if (dd == mtbdd_false) return lddmc_false;
+    if (bits_dd == lddmc_true) return lddmc_true;
+
+    sylvan_gc_test();
+
+    sylvan_stats_count(LDD_FROM_BDD);
+
+    MDD result;
+    if (cache_get3(CACHE_MDD_FROM_BDD, dd, bits_dd, firstvar, &result)) {
+        sylvan_stats_count(LDD_FROM_BDD_CACHED);
+        return result;
+    }
+
+    result = CALL(lddmc_from_bdd_value, dd, bits_dd, firstvar, 0, 0);
+
+    if (cache_put3(CACHE_MDD_FROM_BDD, dd, bits_dd, firstvar, result)) sylvan_stats_count(LDD_FROM_BDD_CACHEDPUT);
+    return result;
+}
+
+/**
+ * Decode the integer variable that starts at <firstvar> for the relation level(s) of <meta>,
+ * from the interleaved BDD variable firstvar+pos on. The read value is in the high 32 bits
+ * of <values> and the written value in the low 32 bits.
+ */
+TASK_6(MDD, lddmc_rel_from_bdd_value, MTBDD, dd, MDD, bits_dd, MDD, meta, uint32_t, firstvar, uint32_t, pos, uint64_t, values)
+{
+    if (dd == mtbdd_false) return lddmc_false;
+
+    const uint32_t bits = lddmc_getvalue(bits_dd);
+    const uint32_t vmeta = lddmc_getvalue(meta);
+
+    if (pos == 2*bits) {
+        MDD next_meta = lddmc_getdown(meta);
+        if (vmeta == 1) next_meta = lddmc_getdown(next_meta);
+        MDD down = CALL(lddmc_rel_from_bdd, dd, lddmc_getdown(bits_dd), next_meta, firstvar + 2*bits);
+        if (down == lddmc_false || vmeta == 0) return down;
+        const uint32_t read = (uint32_t)(values >> 32), write = (uint32_t)values;
+        if (vmeta == 3) return lddmc_makenode(read, down, lddmc_false);
+        if (vmeta == 4) return lddmc_makenode(write, down, lddmc_false);
+        down = lddmc_refs_push(lddmc_makenode(write, down, lddmc_false));
+        MDD result = lddmc_makenode(read, down, lddmc_false);
+        lddmc_refs_pop(1);
+        return result;
+    }
+
+    MTBDD low, high;
+    lddmc_bdd_cofactors(dd, firstvar + pos, &low, &high);
+    const int primed = pos & 1;
+    const uint64_t bit = 1ULL << (bits-pos/2-1);
+
+    if (vmeta == 3 && primed) {
+        /* only-read: the primed variable equals the unprimed variable */
+        MTBDD next = (values >> 32) & bit ? high : low;
+        return CALL(lddmc_rel_from_bdd_value, next, bits_dd, meta, firstvar, pos+1, values);
+    }
+
+    uint64_t high_values = values;
+    if (vmeta == 0 || (vmeta == 4 && !primed)) {
+        /* abstract the variable */
+        if (low == high) return CALL(lddmc_rel_from_bdd_value, low, bits_dd, meta, firstvar, pos+1, values);
+    } else {
+        high_values |= primed ? bit : bit << 32;
+    }
+
+    lddmc_refs_spawn(SPAWN(lddmc_rel_from_bdd_value, high, bits_dd, meta, firstvar, pos+1, high_values));
+    MDD left = lddmc_refs_push(CALL(lddmc_rel_from_bdd_value, low, bits_dd, meta, firstvar, pos+1, values));
+    MDD right = lddmc_refs_push(lddmc_refs_sync(SYNC(lddmc_rel_from_bdd_value)));
+    MDD result = CALL(lddmc_union, left, right);
+    lddmc_refs_pop(2);
+    return result;
+}
+
+TASK_IMPL_4(MDD, lddmc_rel_from_bdd, MTBDD, dd, MDD, bits_dd, MDD, meta, uint32_t, firstvar)
+{
+    if (dd == mtbdd_false) return lddmc_false;
+    if (meta == lddmc_true || lddmc_getvalue(meta) == (uint32_t)-1) return lddmc_true;
+    assert(lddmc_getvalue(meta) <= 4 && lddmc_getvalue(meta) != 2);
+
+    sylvan_gc_test();
+
+    sylvan_stats_count(LDD_REL_FROM_BDD);
+
+    MDD result;
+    if (cache_get4(CACHE_MDD_REL_FROM_BDD, dd, bits_dd, meta, firstvar, &result)) {
+        sylvan_stats_count(LDD_REL_FROM_BDD_CACHED);
+        return result;
+    }
+
+    result = CALL(lddmc_rel_from_bdd_value, dd, bits_dd, meta, firstvar, 0, 0);
+
+    if (cache_put4(CACHE_MDD_REL_FROM_BDD, dd, bits_dd, meta, firstvar, result)) sylvan_stats_count(LDD_REL_FROM_BDD_CACHEDPUT);
+    return result;
+}
+
 VOID_TASK_IMPL_4(lddmc_visit_seq, MDD, mdd, lddmc_visit_callbacks_t*, cbs, size_t, ctx_size, void*, context)
 {
     if (WRAP(cbs->lddmc_visit_pre, mdd, context) == 0) return;
@@ -2405,10 +3624,11 @@ lddmc_printdot(MDD mdd)
 void
 lddmc_fprint(FILE *f, MDD mdd)
 {
-    lddmc_serialize_reset();
-    size_t v = lddmc_serialize_add(mdd);
+    lddmc_serializer_t s = lddmc_serializer_alloc();
+    size_t v = lddmc_serializer_add(s, mdd);
     fprintf(f, "%zu,", v);
-    lddmc_serialize_totext(f);
+    lddmc_serializer_totext(s, f);
+    lddmc_serializer_free(s);
 }
 
 void
@@ -2421,208 +3641,216 @@ lddmc_print(MDD mdd)
  * SERIALIZATION
  */
 
-struct lddmc_ser {
-    MDD mdd;
-    size_t assigned;
-};
-
-// Define a AVL tree type with prefix 'lddmc_ser' holding
-// nodes of struct lddmc_ser with the following compare() function...
-AVL(lddmc_ser, struct lddmc_ser)
+static int
+lddmc_ser_children(uint64_t index, uint64_t *children)
 {
-    if (left->mdd > right->mdd) return 1;
-    if (left->mdd < right->mdd) return -1;
-    return 0;
+    mddnode_t n = LDD_GETNODE(index);
+    children[0] = mddnode_getdown(n);
+    children[1] = mddnode_getright(n);
+    return 2;
 }
 
-// Define a AVL tree type with prefix 'lddmc_ser_reversed' holding
-// nodes of struct lddmc_ser with the following compare() function...
-AVL(lddmc_ser_reversed, struct lddmc_ser)
+/* copy nodes have no value, and a flag on the right child */
+static void
+lddmc_ser_encode(sylvan_ser_t s, uint64_t index, sylvan_codec_node_t *node)
 {
-    if (left->assigned > right->assigned) return 1;
-    if (left->assigned < right->assigned) return -1;
-    return 0;
+    mddnode_t n = LDD_GETNODE(index);
+    node->key = mddnode_getcopy(n) ? 0 : mddnode_getvalue(n);
+    node->child[0] = sylvan_ser_get(s, mddnode_getdown(n));
+    node->child[1] = sylvan_ser_get(s, mddnode_getright(n));
+    if (mddnode_getcopy(n)) node->child[1] |= SYLVAN_CODEC_FLAG;
 }
 
-// Initially, both sets are empty
-static avl_node_t *lddmc_ser_set = NULL;
-static avl_node_t *lddmc_ser_reversed_set = NULL;
-
-// Start counting (assigning numbers to MDDs) at 2
-static size_t lddmc_ser_counter = 2;
-static size_t lddmc_ser_done = 0;
-
-// Given a MDD, assign unique numbers to all nodes
-static size_t
-lddmc_serialize_assign_rec(MDD mdd)
+static void
+lddmc_ser_to_record(const sylvan_codec_node_t *node, uint64_t *rec)
 {
-    if (mdd <= lddmc_true) return mdd;
-
-    mddnode_t n = LDD_GETNODE(mdd);
-
-    struct lddmc_ser s, *ss;
-    s.mdd = mdd;
-    ss = lddmc_ser_search(lddmc_ser_set, &s);
-    if (ss == NULL) {
-        // assign dummy value
-        s.assigned = 0;
-        ss = lddmc_ser_put(&lddmc_ser_set, &s, NULL);
+    const uint64_t right = node->child[1] & ~SYLVAN_CODEC_FLAG;
+    if (node->child[1] & SYLVAN_CODEC_FLAG) mddnode_makecopy((mddnode_t)rec, right, node->child[0]);
+    else mddnode_make((mddnode_t)rec, (uint32_t)node->key, right, node->child[0]);
+}
 
-        // first assign recursively
-        lddmc_serialize_assign_rec(mddnode_getright(n));
-        lddmc_serialize_assign_rec(mddnode_getdown(n));
+static int
+lddmc_ser_record_children(void *ctx, const uint64_t *rec, uint64_t *children)
+{
+    mddnode_t n = (mddnode_t)rec;
+    children[0] = mddnode_getdown(n);
+    children[1] = mddnode_getright(n);
+    (void)ctx;
+    return 2;
+}
 
-        // assign real value
-        ss->assigned = lddmc_ser_counter++;
+static uint64_t
+lddmc_ser_record_make(void *ctx, const uint64_t *rec, const uint64_t *arr)
+{
+    mddnode_t n = (mddnode_t)rec;
+    MDD down = arr[mddnode_getdown(n)];
+    MDD right = arr[mddnode_getright(n)];
+    (void)ctx;
+    if (mddnode_getcopy(n)) return lddmc_make_copynode(down, right);
+    else return lddmc_makenode(mddnode_getvalue(n), down, right);
+}
 
-        // put a copy in the reversed table
-        lddmc_ser_reversed_insert(&lddmc_ser_reversed_set, ss);
-    }
+static const sylvan_ser_ops_t lddmc_ser_ops = {
+    2, // 0 and 1 are lddmc_false and lddmc_true
+    lddmc_ser_children,
+    lddmc_ser_encode,
+    lddmc_ser_to_record,
+    lddmc_ser_record_children,
+    lddmc_ser_record_make,
+    NULL, // no leaves
+    NULL,
+};
 
-    return ss->assigned;
+lddmc_serializer_t
+lddmc_serializer_alloc()
+{
+    return sylvan_ser_alloc(&lddmc_ser_ops);
 }
 
-size_t
-lddmc_serialize_add(MDD mdd)
+void
+lddmc_serializer_free(lddmc_serializer_t s)
 {
-    return lddmc_serialize_assign_rec(mdd);
+    sylvan_ser_free(s);
 }
 
 void
-lddmc_serialize_reset()
+lddmc_serializer_reset(lddmc_serializer_t s)
 {
-    lddmc_ser_free(&lddmc_ser_set);
-    lddmc_ser_free(&lddmc_ser_reversed_set);
-    lddmc_ser_counter = 2;
-    lddmc_ser_done = 0;
+    sylvan_ser_reset(s);
+}
+
+TASK_IMPL_2(size_t, lddmc_serializer_add, lddmc_serializer_t, s, MDD, mdd)
+{
+    return CALL(sylvan_ser_add, s, mdd);
 }
 
 size_t
-lddmc_serialize_get(MDD mdd)
+lddmc_serializer_get(lddmc_serializer_t s, MDD mdd)
 {
-    if (mdd <= lddmc_true) return mdd;
-    struct lddmc_ser s, *ss;
-    s.mdd = mdd;
-    ss = lddmc_ser_search(lddmc_ser_set, &s);
-    assert(ss != NULL);
-    return ss->assigned;
+    return sylvan_ser_get(s, mdd);
 }
 
 MDD
-lddmc_serialize_get_reversed(size_t value)
+lddmc_serializer_get_reversed(lddmc_serializer_t s, size_t value)
 {
-    if ((MDD)value <= lddmc_true) return (MDD)value;
-    struct lddmc_ser s, *ss;
-    s.assigned = value;
-    ss = lddmc_ser_reversed_search(lddmc_ser_reversed_set, &s);
-    assert(ss != NULL);
-    return ss->mdd;
+    return sylvan_ser_get_reversed(s, value);
 }
 
 void
-lddmc_serialize_totext(FILE *out)
+lddmc_serializer_totext(lddmc_serializer_t s, FILE *out)
 {
-    avl_iter_t *it = lddmc_ser_reversed_iter(lddmc_ser_reversed_set);
-    struct lddmc_ser *s;
-
     fprintf(out, "[");
-    while ((s=lddmc_ser_reversed_iter_next(it))) {
-        MDD mdd = s->mdd;
-        mddnode_t n = LDD_GETNODE(mdd);
-        fprintf(out, "(%zu,v=%u,d=%zu,r=%zu),", s->assigned,
+    const uint64_t end = sylvan_ser_end(s);
+    for (uint64_t i=2; i<end; i++) {
+        mddnode_t n = LDD_GETNODE(sylvan_ser_get_reversed(s, i));
+        fprintf(out, "(%zu,v=%u,d=%zu,r=%zu),", (size_t)i,
                                                 mddnode_getvalue(n),
-                                                lddmc_serialize_get(mddnode_getdown(n)),
-                                                lddmc_serialize_get(mddnode_getright(n)));
+                                                lddmc_serializer_get(s, mddnode_getdown(n)),
+                                                lddmc_serializer_get(s, mddnode_getright(n)));
     }
     fprintf(out, "]");
+}
 
-    lddmc_ser_reversed_iter_free(it);
+VOID_TASK_IMPL_2(lddmc_serializer_tofile, lddmc_serializer_t, s, FILE*, out)
+{
+    CALL(sylvan_ser_tofile, s, out);
+}
+
+TASK_IMPL_2(int, lddmc_serializer_fromfile, lddmc_serializer_t, s, FILE*, in)
+{
+    return CALL(sylvan_ser_fromfile, s, in);
 }
 
 void
-lddmc_serialize_tofile(FILE *out)
+lddmc_serializer_write_begin(lddmc_serializer_t s, FILE *out)
 {
-    size_t count = avl_count(lddmc_ser_reversed_set);
-    assert(count >= lddmc_ser_done);
-    assert(count == lddmc_ser_counter-2);
-    count -= lddmc_ser_done;
-    fwrite(&count, sizeof(size_t), 1, out);
+    sylvan_ser_write_begin(s, out);
+}
 
-    struct lddmc_ser *s;
-    avl_iter_t *it = lddmc_ser_reversed_iter(lddmc_ser_reversed_set);
+TASK_IMPL_3(size_t, lddmc_serializer_write_push, lddmc_serializer_t, s, FILE*, out, MDD, mdd)
+{
+    const size_t key = CALL(sylvan_ser_add, s, mdd);
+    CALL(sylvan_ser_write_push, s, out, key);
+    return key;
+}
 
-    /* Skip already written entries */
-    size_t index = 0;
-    while (index < lddmc_ser_done && (s=lddmc_ser_reversed_iter_next(it))) {
-        assert(s->assigned == index+2);
-        index++;
-    }
+VOID_TASK_IMPL_2(lddmc_serializer_write_end, lddmc_serializer_t, s, FILE*, out)
+{
+    CALL(sylvan_ser_write_end, s, out);
+}
 
-    while ((s=lddmc_ser_reversed_iter_next(it))) {
-        assert(s->assigned == index+2);
-        index++;
+int
+lddmc_serializer_read_begin(lddmc_serializer_t s, FILE *in)
+{
+    return sylvan_ser_read_begin(s, in);
+}
 
-        mddnode_t n = LDD_GETNODE(s->mdd);
+TASK_IMPL_3(int, lddmc_serializer_read_next, lddmc_serializer_t, s, FILE*, in, MDD*, mdd)
+{
+    uint64_t key;
+    const int res = CALL(sylvan_ser_read_next, s, in, &key);
+    if (res != 1) return res;
+    if (key & SYLVAN_CODEC_FLAG) return -1; // LDDs have no complement marks
+    *mdd = sylvan_ser_get_reversed(s, key);
+    return 1;
+}
 
-        struct mddnode node;
-        uint64_t right = lddmc_serialize_get(mddnode_getright(n));
-        uint64_t down = lddmc_serialize_get(mddnode_getdown(n));
-        if (mddnode_getcopy(n)) mddnode_makecopy(&node, right, down);
-        else mddnode_make(&node, mddnode_getvalue(n), right, down);
+/**
+ * The functions without a serializer use a global serializer.
+ */
 
-        assert(right <= index);
-        assert(down <= index);
+static lddmc_serializer_t lddmc_serializer_default = NULL;
 
-        fwrite(&node, sizeof(struct mddnode), 1, out);
-    }
+static lddmc_serializer_t
+lddmc_serializer_global()
+{
+    if (lddmc_serializer_default == NULL) lddmc_serializer_default = lddmc_serializer_alloc();
+    return lddmc_serializer_default;
+}
 
-    lddmc_ser_done = lddmc_ser_counter-2;
-    lddmc_ser_reversed_iter_free(it);
+size_t
+lddmc_serialize_add(MDD mdd)
+{
+    return lddmc_serializer_add(lddmc_serializer_global(), mdd);
 }
 
 void
-lddmc_serialize_fromfile(FILE *in)
+lddmc_serialize_reset()
 {
-    size_t count, i;
-    if (fread(&count, sizeof(size_t), 1, in) != 1) {
-        // TODO FIXME return error
-        printf("sylvan_serialize_fromfile: file format error, giving up\n");
-        exit(-1);
-    }
-
-    for (i=1; i<=count; i++) {
-        struct mddnode node;
-        if (fread(&node, sizeof(struct mddnode), 1, in) != 1) {
-            // TODO FIXME return error
-            printf("sylvan_serialize_fromfile: file format error, giving up\n");
-            exit(-1);
-        }
-
-        assert(mddnode_getright(&node) <= lddmc_ser_done+1);
-        assert(mddnode_getdown(&node) <= lddmc_ser_done+1);
+    lddmc_serializer_reset(lddmc_serializer_global());
+}
 
-        MDD right = lddmc_serialize_get_reversed(mddnode_getright(&node));
-        MDD down = lddmc_serialize_get_reversed(mddnode_getdown(&node));
+size_t
+lddmc_serialize_get(MDD mdd)
+{
+    return lddmc_serializer_get(lddmc_serializer_global(), mdd);
+}
 
-        struct lddmc_ser s;
-        if (mddnode_getcopy(&node)) s.mdd = lddmc_make_copynode(down, right);
-        else s.mdd = lddmc_makenode(mddnode_getvalue(&node), down, right);
-        s.assigned = lddmc_ser_done+2; // starts at 0 but we want 2-based...
-        lddmc_ser_done++;
+MDD
+lddmc_serialize_get_reversed(size_t value)
+{
+    return lddmc_serializer_get_reversed(lddmc_serializer_global(), value);
+}
 
-        lddmc_ser_insert(&lddmc_ser_set, &s);
-        lddmc_ser_reversed_insert(&lddmc_ser_reversed_set, &s);
-    }
+void
+lddmc_serialize_totext(FILE *out)
+{
+    lddmc_serializer_totext(lddmc_serializer_global(), out);
 }
 
-VOID_TASK_IMPL_0(lddmc_gc_mark_serialize)
+void
+lddmc_serialize_tofile(FILE *out)
 {
-    struct lddmc_ser *s;
-    avl_iter_t *it = lddmc_ser_iter(lddmc_ser_set);
+    lddmc_serializer_tofile(lddmc_serializer_global(), out);
+}
 
-    /* Iterate through nodes in serialization */
-    while ((s=lddmc_ser_iter_next(it))) {
-        CALL(lddmc_gc_mark_rec, s->mdd);
+void
+lddmc_serialize_fromfile(FILE *in)
+{
+    if (lddmc_serializer_fromfile(lddmc_serializer_global(), in) != 0) {
+        // TODO FIXME return error
+        printf("sylvan_serialize_fromfile: file format error, giving up\n");
+        exit(-1);
     }
 }
 
@@ -40,6 +40,15 @@ MDD lddmc_getdown(MDD mdd);
 MDD lddmc_getright(MDD mdd);
 MDD lddmc_follow(MDD mdd, uint32_t value);
 
+/**
+ * Wide levels are indexed: when a search for a value in a level (lddmc_follow, and matching values
+ * in operations such as lddmc_relprod and lddmc_intersect) walks more than <threshold> nodes,
+ * the values of the level are indexed, and later searches from the same node use binary search.
+ * The index does not change the LDD nodes. The default threshold is 32; 0 disables indexing.
+ */
+void lddmc_set_index_threshold(size_t threshold);
+size_t lddmc_get_index_threshold(void);
+
 /**
  * Copy nodes in relations.
  * A copy node represents 'read x, then write x' for every x.
@@ -125,12 +134,43 @@ MDD lddmc_union_cube_copy(MDD a, uint32_t* values, int* copy, size_t count);
 int lddmc_member_cube_copy(MDD a, uint32_t* values, int* copy, size_t count);
 MDD lddmc_cube_copy(uint32_t* values, int* copy, size_t count);
 
+/**
+ * Build the LDD of <count> vectors of <length> values, stored consecutively in <vectors> and sorted
+ * lexicographically (duplicates are allowed). The LDD is built bottom-up in one pass, creating every
+ * node once; the vectors are split by value and the parts are built in parallel.
+ * This is much faster than calling lddmc_union_cube for every vector.
+ */
+TASK_DECL_3(MDD, lddmc_from_sorted_array, const uint32_t*, size_t, size_t);
+#define lddmc_from_sorted_array(vectors, count, length) RUN(lddmc_from_sorted_array, vectors, count, length)
+
+/**
+ * Add the <count> sorted vectors in <vectors> (see lddmc_from_sorted_array) to <a>.
+ */
+TASK_DECL_4(MDD, lddmc_union_sorted_array, MDD, const uint32_t*, size_t, size_t);
+#define lddmc_union_sorted_array(a, vectors, count, length) RUN(lddmc_union_sorted_array, a, vectors, count, length)
+
 TASK_DECL_3(MDD, lddmc_relprod, MDD, MDD, MDD);
 #define lddmc_relprod(a, b, proj) RUN(lddmc_relprod, a, b, proj)
 
 TASK_DECL_4(MDD, lddmc_relprod_union, MDD, MDD, MDD, MDD);
 #define lddmc_relprod_union(a, b, meta, un) RUN(lddmc_relprod_union, a, b, meta, un)
 
+/**
+ * Compute the successors of <a> according to rel[meta] that are not in <avoid>,
+ * i.e., lddmc_minus(lddmc_relprod(a, rel, meta), avoid). The levels above the first written
+ * variable are pruned with <avoid> during the recursion, so avoided prefixes are never computed.
+ */
+TASK_DECL_4(MDD, lddmc_relprod_minus, MDD, MDD, MDD, MDD);
+#define lddmc_relprod_minus(a, rel, meta, avoid) RUN(lddmc_relprod_minus, a, rel, meta, avoid)
+
+/**
+ * Compute the union of the successors of <a> according to the <n> relations rels[i][metas[i]].
+ * The state LDD is walked once: every relation is applied at the first level in its meta, to all
+ * states below the current prefix, and the results are unioned as the recursion unwinds.
+ */
+TASK_DECL_4(MDD, lddmc_relprod_multi, MDD, const MDD*, const MDD*, size_t);
+#define lddmc_relprod_multi(a, rels, metas, n) RUN(lddmc_relprod_multi, a, rels, metas, n)
+
 /**
  * Calculate all predecessors to a in uni according to rel[proj]
  * <proj> follows the same semantics as relprod
@@ -178,6 +218,28 @@ TASK_DECL_1(lddmc_satcount_double_t, lddmc_satcount_cached, MDD);
 TASK_DECL_1(long double, lddmc_satcount, MDD);
 #define lddmc_satcount(mdd) RUN(lddmc_satcount, mdd)
 
+/**
+ * Calculate the exact number of satisfying variable assignments, in parallel.
+ * Writes the count to <limbs> as <n> 64-bit limbs, least significant first (for example for
+ * mpz_import), and returns the number of limbs of the count, which may be larger than <n>.
+ * Counts of nodes are memoized until the next garbage collection, so counting related LDDs
+ * (such as the levels of a BFS) is cheap.
+ */
+size_t lddmc_satcount_exact(MDD mdd, uint64_t *limbs, size_t n);
+
+/**
+ * Calculate the exact number of satisfying variable assignments as a decimal string.
+ * The string is allocated with malloc, and the caller must free it with free.
+ */
+char *lddmc_satcount_exact_str(MDD mdd);
+
+/**
+ * Estimate the binary logarithm of the number of satisfying variable assignments
+ * (-INFINITY for lddmc_false). Unlike lddmc_satcount_cached, this does not overflow.
+ */
+TASK_DECL_1(double, lddmc_satcount_log2, MDD);
+#define lddmc_satcount_log2(mdd) RUN(lddmc_satcount_log2, mdd)
+
 /**
  * A callback for enumerating functions like sat_all_par, collect and match
  * Example:
@@ -238,21 +300,153 @@ TASK_DECL_4(MDD, lddmc_compose, MDD, lddmc_compose_cb, void*, int);
 #define lddmc_compose(mdd, cb, context, depth) RUN(lddmc_compose, mdd, cb, context, depth)
 
 /**
+ * Conversion between LDDs and BDDs.
+ *
+ * Every integer variable i of the LDD is encoded by bits[i] Boolean variables, with the highest
+ * bit first. The bit widths are given as an LDD cube <bits> (one value per integer variable).
+ * The BDD variables of the sets and the relations are interleaved: bit b of the integer variable
+ * that starts at BDD variable <var> is variable var+2*b, and its primed copy is var+2*b+1.
+ * The next integer variable starts at var+2*bits[i].
+ *
+ * Relations follow the <meta> of lddmc_relprod: 0 (not in rel), 1 and 2 (read+write),
+ * 3 (only-read), 4 (only-write), 5 (action label), -1 (end).
+ * Copy nodes on write levels are encoded as primed = unprimed. Action labels are abstracted.
+ * Apply the converted relation with sylvan_relnext and the variables of lddmc_meta_to_bdd_vars.
+ */
+
+/**
+ * For every level of <mdd>, raise highest[level] to the highest value on that level.
+ * lddmc_rel_highest does the same for a relation, where highest[i] is for integer variable i.
+ * Copy nodes and action labels are ignored. The levels are visited in parallel.
+ */
+VOID_TASK_DECL_2(lddmc_highest, MDD, uint32_t*);
+#define lddmc_highest(mdd, highest) RUN(lddmc_highest, mdd, highest)
+VOID_TASK_DECL_3(lddmc_rel_highest, MDD, MDD, uint32_t*);
+#define lddmc_rel_highest(rel, meta, highest) RUN(lddmc_rel_highest, rel, meta, highest)
+
+/**
+ * Create the LDD cube of bit widths that encode the values up to highest[i] for <count>
+ * integer variables (at least 1 bit per variable).
+ */
+MDD lddmc_bits_from_highest(const uint32_t *highest, size_t count);
+
+/**
+ * Convert the set <mdd> to a BDD, starting at BDD variable <firstvar>.
+ */
+TASK_DECL_3(MTBDD, lddmc_to_bdd, MDD, MDD, uint32_t);
+#define lddmc_to_bdd(mdd, bits, firstvar) RUN(lddmc_to_bdd, mdd, bits, firstvar)
+
+/**
+ * Convert the relation <rel> with meta <meta> to a BDD, starting at BDD variable <firstvar>.
+ */
+TASK_DECL_4(MTBDD, lddmc_rel_to_bdd, MDD, MDD, MDD, uint32_t);
+#define lddmc_rel_to_bdd(rel, bits, meta, firstvar) RUN(lddmc_rel_to_bdd, rel, bits, meta, firstvar)
+
+/**
+ * Get the BDD variables (unprimed and primed) of the integer variables in <meta> that
+ * are read or written, as a cube for sylvan_relnext.
+ */
+MTBDD lddmc_meta_to_bdd_vars(MDD meta, MDD bits, uint32_t firstvar);
+
+/**
+ * Convert the BDD <dd> of a set to an LDD.
+ * The BDD may only depend on the unprimed variables of the encoding.
+ */
+TASK_DECL_3(MDD, lddmc_from_bdd, MTBDD, MDD, uint32_t);
+#define lddmc_from_bdd(dd, bits, firstvar) RUN(lddmc_from_bdd, dd, bits, firstvar)
+
+/**
+ * Convert the BDD <dd> of a relation to an LDD with meta <meta>.
+ * The BDD may only depend on variables of the integer variables in <meta> that are read or
+ * written; for only-written variables, the unprimed variables are abstracted.
+ * The result has no copy nodes, and <meta> may not have action labels.
+ */
+TASK_DECL_4(MDD, lddmc_rel_from_bdd, MTBDD, MDD, MDD, uint32_t);
+#define lddmc_rel_from_bdd(dd, bits, meta, firstvar) RUN(lddmc_rel_from_bdd, dd, bits, meta, firstvar)
+
+/**
+ * Serializers assign numbers to LDD nodes, to write LDDs to file and read them back.
+ * Nodes are numbered from 2, with children before their parents; 0 and 1 are lddmc_false and
+ * lddmc_true. Numbers are assigned in parallel. Every serializer has its own numbering, so
+ * different serializers can be used concurrently.
+ *
  * SAVING:
- * use lddmc_serialize_add on every MDD you want to store
- * use lddmc_serialize_get to retrieve the key of every stored MDD
- * use lddmc_serialize_tofile
+ * use lddmc_serializer_add on every MDD you want to store
+ * use lddmc_serializer_get to retrieve the key of every stored MDD
+ * use lddmc_serializer_tofile (writes only the nodes added since the previous call)
  *
  * LOADING:
- * use lddmc_serialize_fromfile (implies lddmc_serialize_reset)
- * use lddmc_serialize_get_reversed for every key
+ * use lddmc_serializer_fromfile (the nodes are numbered after the nodes already in the serializer)
+ * use lddmc_serializer_get_reversed for every key
+ *
+ * STREAMING (to a pipe or socket, read without seeking):
+ * use lddmc_serializer_write_begin, then lddmc_serializer_write_push for every MDD (which writes
+ * its new nodes and its key, and flushes), then lddmc_serializer_write_end
+ * use lddmc_serializer_read_begin, then lddmc_serializer_read_next until it returns 0; the nodes
+ * are created one block at a time as they arrive, so the reader needs little memory
  *
  * MISC:
- * use lddmc_serialize_reset to free all allocated structures
- * use lddmc_serialize_totext to write a textual list of tuples of all MDDs.
- *         format: [(<key>,<level>,<key_low>,<key_high>,<complement_high>),...]
+ * use lddmc_serializer_reset to forget all numbers
+ * use lddmc_serializer_totext to write a textual list of tuples of all MDDs.
+ *         format: [(<key>,v=<value>,d=<key_down>,r=<key_right>),...]
  *
- * for the old lddmc_print functions, use lddmc_serialize_totext
+ * Numbered nodes are not garbage collected until the serializer is reset or freed.
+ * For the old lddmc_print functions, use lddmc_serializer_totext.
+ */
+typedef struct sylvan_ser *lddmc_serializer_t;
+
+lddmc_serializer_t lddmc_serializer_alloc(void);
+void lddmc_serializer_free(lddmc_serializer_t s);
+void lddmc_serializer_reset(lddmc_serializer_t s);
+
+TASK_DECL_2(size_t, lddmc_serializer_add, lddmc_serializer_t, MDD);
+#define lddmc_serializer_add(s, mdd) RUN(lddmc_serializer_add, s, mdd)
+
+size_t lddmc_serializer_get(lddmc_serializer_t s, MDD mdd);
+MDD lddmc_serializer_get_reversed(lddmc_serializer_t s, size_t value);
+void lddmc_serializer_totext(lddmc_serializer_t s, FILE *out);
+
+VOID_TASK_DECL_2(lddmc_serializer_tofile, lddmc_serializer_t, FILE*);
+#define lddmc_serializer_tofile(s, out) RUN(lddmc_serializer_tofile, s, out)
+
+/**
+ * Read a section of a file. Returns 0, or -1 if the file is invalid.
+ */
+TASK_DECL_2(int, lddmc_serializer_fromfile, lddmc_serializer_t, FILE*);
+#define lddmc_serializer_fromfile(s, in) RUN(lddmc_serializer_fromfile, s, in)
+
+/**
+ * Start a stream. Nodes that already have a number are written with the first MDD.
+ */
+void lddmc_serializer_write_begin(lddmc_serializer_t s, FILE *out);
+
+/**
+ * Add an MDD to the stream. Returns its key.
+ */
+TASK_DECL_3(size_t, lddmc_serializer_write_push, lddmc_serializer_t, FILE*, MDD);
+#define lddmc_serializer_write_push(s, out, mdd) RUN(lddmc_serializer_write_push, s, out, mdd)
+
+/**
+ * End a stream.
+ */
+VOID_TASK_DECL_2(lddmc_serializer_write_end, lddmc_serializer_t, FILE*);
+#define lddmc_serializer_write_end(s, out) RUN(lddmc_serializer_write_end, s, out)
+
+/**
+ * Forget all numbers and start reading a stream. Returns 0, or -1 if it is not a stream.
+ */
+int lddmc_serializer_read_begin(lddmc_serializer_t s, FILE *in);
+
+/**
+ * Read the next MDD of a stream into <mdd>.
+ * Returns 1, or 0 at the end of the stream, or -1 if the stream is invalid.
+ */
+TASK_DECL_3(int, lddmc_serializer_read_next, lddmc_serializer_t, FILE*, MDD*);
+#define lddmc_serializer_read_next(s, in, mdd) RUN(lddmc_serializer_read_next, s, in, mdd)
+
+/**
+ * The same functions for a global serializer.
+ * lddmc_serialize_fromfile exits the program if the file is invalid.
  */
 size_t lddmc_serialize_add(MDD mdd);
 size_t lddmc_serialize_get(MDD mdd);
@@ -27,13 +27,21 @@
 /**
  * LDD node structure
  *
- * RmRR RRRR RRRR VVVV | VVVV DcDD DDDD DDDD (little endian - in memory)
- * VVVV RRRR RRRR RRRm | DDDD DDDD DDDc VVVV (big endian)
+ * RmRR RRRR RRRL VVVV | VVVV DcDD DDDD DDDL (little endian - in memory)
+ * VVVV LRRR RRRR RRRm | LDDD DDDD DDDc VVVV (big endian)
+ *
+ * Node indices have at most 42 bits (see llmsset), which leaves 5 bits at the top of R and D.
+ * These 10 bits (L) hold the last value of the chain starting at this node, or LDD_LAST_MAX if
+ * that value is LDD_LAST_MAX or higher. For the small value domains of most models, this lets
+ * searches exit early when a value is beyond the end of a chain. The field is a function of the
+ * value and the right node, so nodes remain canonical.
  */
 typedef struct __attribute__((packed)) mddnode {
     uint64_t a, b;
 } * mddnode_t; // 16 bytes
 
+#define LDD_LAST_MAX 0x3ff
+
 static inline mddnode_t
 LDD_GETNODE(MDD mdd)
 {
@@ -61,13 +69,19 @@ mddnode_getcopy(mddnode_t n)
 static inline uint64_t __attribute__((unused))
 mddnode_getright(mddnode_t n)
 {
-    return (n->a & 0x0000ffffffffffff) >> 1;
+    return (n->a & 0x000007fffffffffe) >> 1;
 }
 
 static inline uint64_t __attribute__((unused))
 mddnode_getdown(mddnode_t n)
 {
-    return n->b >> 17;
+    return (n->b >> 17) & 0x000003ffffffffff;
+}
+
+static inline uint32_t __attribute__((unused))
+mddnode_getlast(mddnode_t n)
+{
+    return ((n->a >> 43) & 0x1f) | ((n->b >> 54) & 0x3e0);
 }
 
 static inline void __attribute__((unused))
@@ -85,13 +99,21 @@ mddnode_setmark(mddnode_t n, uint8_t mark)
 static inline void __attribute__((unused))
 mddnode_setright(mddnode_t n, uint64_t right)
 {
-    n->a = (n->a & 0xffff000000000001) | (right << 1);
+    n->a = (n->a & 0xfffff80000000001) | (right << 1);
 }
 
 static inline void __attribute__((unused))
 mddnode_setdown(mddnode_t n, uint64_t down)
 {
-    n->b = (n->b & 0x000000000001ffff) | (down << 17);
+    n->b = (n->b & 0xf80000000001ffff) | (down << 17);
+}
+
+static inline void __attribute__((unused))
+mddnode_setlast(mddnode_t n, uint32_t last)
+{
+    if (last > LDD_LAST_MAX) last = LDD_LAST_MAX;
+    n->a = (n->a & 0xffff07ffffffffff) | ((uint64_t)(last & 0x1f) << 43);
+    n->b = (n->b & 0x07ffffffffffffff) | ((uint64_t)(last >> 5) << 59);
 }
 
 static inline void __attribute__((unused))
@@ -0,0 +1,435 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <string.h>
+
+/**
+ * A transition group of a learner.
+ * The relation of the group has one level for every variable that is only read or only
+ * written, and two levels (read, then write) for every variable that is read and written.
+ * Every level of a transition comes from the short vector given to the callback or from
+ * the vector reported with lddmc_learn_add, as recorded in <levels>.
+ */
+typedef struct lddmc_learn_group
+{
+    MDD rel;            // learned relation (from firstvar)
+    MDD learned;        // projected states of which the transitions are in rel
+    MDD meta;           // meta of rel for lddmc_relprod on full states
+    MDD topmeta;        // meta of rel for states from firstvar
+    MDD proj;           // read projection for full states
+    MDD topproj;        // read projection for states from firstvar
+    uint32_t firstvar;  // first variable read or written by the group
+    size_t r_k, w_k;
+    size_t length;      // number of levels of rel
+    uint32_t *levels;   // src index, or dst index with the top bit set
+} lddmc_learn_group_t;
+
+struct lddmc_learner
+{
+    size_t nvars;
+    size_t ngroups;
+    lddmc_learn_cb cb;
+    void *context;
+    uint64_t id;        // distinguishes learners in the operation cache
+    lddmc_learn_group_t *groups;
+    int *order;         // groups sorted by firstvar
+};
+
+/**
+ * Per-worker buffer of learned transitions
+ */
+typedef struct lddmc_learn_buf
+{
+    uint32_t *data;
+    size_t count, size;
+} lddmc_learn_buf_t;
+
+/**
+ * One call of lddmc_learn for one group, shared by all workers
+ */
+typedef struct lddmc_learn_call
+{
+    lddmc_learner_t learner;
+    int group;
+    lddmc_learn_buf_t *bufs;
+} lddmc_learn_call_t;
+
+/**
+ * Argument of lddmc_learn_add, on the stack of the worker running the callback
+ */
+struct lddmc_learn_ctx
+{
+    lddmc_learn_call_t *call;
+    const uint32_t *src;
+};
+
+static _Atomic(uint64_t) lddmc_learner_next_id = 1;
+
+lddmc_learner_t
+lddmc_learner_create(size_t nvars, size_t ngroups, lddmc_learn_cb cb, void *context)
+{
+    lddmc_learner_t learner = (lddmc_learner_t)malloc(sizeof(struct lddmc_learner));
+    if (learner == NULL) {
+        fprintf(stderr, "lddmc_learner_create: Unable to allocate memory!\n");
+        exit(1);
+    }
+    learner->nvars = nvars;
+    learner->ngroups = ngroups;
+    learner->cb = cb;
+    learner->context = context;
+    learner->id = atomic_fetch_add(&lddmc_learner_next_id, 1);
+    learner->groups = (lddmc_learn_group_t*)calloc(ngroups, sizeof(lddmc_learn_group_t));
+    learner->order = (int*)malloc(sizeof(int) * ngroups);
+    if (ngroups > 0 && (learner->groups == NULL || learner->order == NULL)) {
+        fprintf(stderr, "lddmc_learner_create: Unable to allocate memory!\n");
+        exit(1);
+    }
+    for (size_t i=0; i<ngroups; i++) {
+        lddmc_learn_group_t *g = &learner->groups[i];
+        g->rel = lddmc_false;
+        g->learned = lddmc_false;
+        g->meta = lddmc_false;
+        g->topmeta = lddmc_false;
+        g->proj = lddmc_false;
+        g->topproj = lddmc_false;
+        g->firstvar = (uint32_t)nvars;
+        lddmc_protect(&g->rel);
+        lddmc_protect(&g->learned);
+        lddmc_protect(&g->meta);
+        lddmc_protect(&g->topmeta);
+        lddmc_protect(&g->proj);
+        lddmc_protect(&g->topproj);
+        learner->order[i] = (int)i;
+    }
+    return learner;
+}
+
+void
+lddmc_learner_free(lddmc_learner_t learner)
+{
+    for (size_t i=0; i<learner->ngroups; i++) {
+        lddmc_learn_group_t *g = &learner->groups[i];
+        lddmc_unprotect(&g->rel);
+        lddmc_unprotect(&g->learned);
+        lddmc_unprotect(&g->meta);
+        lddmc_unprotect(&g->topmeta);
+        lddmc_unprotect(&g->proj);
+        lddmc_unprotect(&g->topproj);
+        free(g->levels);
+    }
+    free(learner->groups);
+    free(learner->order);
+    free(learner);
+}
+
+void
+lddmc_learner_set_group(lddmc_learner_t learner, int group, size_t r_k, const int *r_proj, size_t w_k, const int *w_proj)
+{
+    assert(group >= 0 && (size_t)group < learner->ngroups);
+    assert(r_k + w_k > 0);
+    lddmc_learn_group_t *g = &learner->groups[group];
+    g->r_k = r_k;
+    g->w_k = w_k;
+
+    const size_t nvars = learner->nvars;
+    int meta[2*nvars+1], proj[nvars+1];
+    size_t meta_len = 0, proj_len = 0, length = 0;
+    uint32_t *levels = (uint32_t*)realloc(g->levels, sizeof(uint32_t) * (r_k + w_k));
+    if (levels == NULL) {
+        fprintf(stderr, "lddmc_learner_set_group: Unable to allocate memory!\n");
+        exit(1);
+    }
+
+    /* Walk over the variables, merging the read and write projections */
+    size_t r_i = 0, w_i = 0;
+    uint32_t firstvar = (uint32_t)nvars;
+    for (size_t v=0; v<nvars && (r_i < r_k || w_i < w_k); v++) {
+        const int is_read = r_i < r_k && r_proj[r_i] == (int)v;
+        const int is_write = w_i < w_k && w_proj[w_i] == (int)v;
+        if (!is_read && !is_write) {
+            meta[meta_len++] = 0;
+        } else {
+            if (firstvar == nvars) firstvar = (uint32_t)v;
+            if (is_read && is_write) {
+                meta[meta_len++] = 1;
+                meta[meta_len++] = 2;
+                levels[length++] = (uint32_t)r_i;
+                levels[length++] = (uint32_t)w_i | 0x80000000;
+            } else if (is_read) {
+                meta[meta_len++] = 3;
+                levels[length++] = (uint32_t)r_i;
+            } else {
+                meta[meta_len++] = 4;
+                levels[length++] = (uint32_t)w_i | 0x80000000;
+            }
+        }
+        if (r_i < r_k) proj[proj_len++] = is_read ? 1 : 0;
+        if (is_read) r_i++;
+        if (is_write) w_i++;
+    }
+    assert(r_i == r_k && w_i == w_k); // projections must be sorted and within nvars
+    meta[meta_len++] = -1;
+    proj[proj_len++] = -2;
+
+    g->firstvar = firstvar;
+    g->length = length;
+    g->levels = levels;
+    g->meta = lddmc_cube((uint32_t*)meta, meta_len);
+    g->topmeta = lddmc_cube((uint32_t*)meta + firstvar, meta_len - firstvar);
+    g->proj = lddmc_cube((uint32_t*)proj, proj_len);
+    g->topproj = proj_len > firstvar ? lddmc_cube((uint32_t*)proj + firstvar, proj_len - firstvar) : lddmc_cube((uint32_t*)proj + proj_len - 1, 1);
+    g->rel = lddmc_false;
+    g->learned = lddmc_false;
+
+    /* Keep the groups sorted by firstvar for saturation (insertion sort, stable) */
+    size_t n = learner->ngroups;
+    for (size_t i=1; i<n; i++) {
+        int k = learner->order[i];
+        size_t j = i;
+        while (j > 0 && learner->groups[learner->order[j-1]].firstvar > learner->groups[k].firstvar) {
+            learner->order[j] = learner->order[j-1];
+            j--;
+        }
+        learner->order[j] = k;
+    }
+}
+
+MDD
+lddmc_learner_relation(lddmc_learner_t learner, int group)
+{
+    return atomic_load((_Atomic(MDD)*)&learner->groups[group].rel);
+}
+
+MDD
+lddmc_learner_meta(lddmc_learner_t learner, int group)
+{
+    return learner->groups[group].meta;
+}
+
+void
+lddmc_learn_add(lddmc_learn_ctx_t ctx, const uint32_t *dst)
+{
+    lddmc_learn_call_t *call = ctx->call;
+    lddmc_learn_group_t *g = &call->learner->groups[call->group];
+    lddmc_learn_buf_t *buf = &call->bufs[lace_get_worker()->worker];
+
+    if (buf->count + g->length > buf->size) {
+        buf->size = buf->size == 0 ? 64 * g->length : 2 * buf->size;
+        buf->data = (uint32_t*)realloc(buf->data, sizeof(uint32_t) * buf->size);
+        if (buf->data == NULL) {
+            fprintf(stderr, "lddmc_learn_add: Unable to allocate memory!\n");
+            exit(1);
+        }
+    }
+    uint32_t *vec = buf->data + buf->count;
+    for (size_t i=0; i<g->length; i++) {
+        const uint32_t l = g->levels[i];
+        vec[i] = (l & 0x80000000) ? dst[l & 0x7fffffff] : ctx->src[l];
+    }
+    buf->count += g->length;
+}
+
+/**
+ * Callback for lddmc_sat_all_par: call the next-state function for one short vector
+ */
+VOID_TASK_3(lddmc_learn_enum_cb, uint32_t*, values, size_t, count, void*, context)
+{
+    lddmc_learn_call_t *call = (lddmc_learn_call_t*)context;
+    struct lddmc_learn_ctx ctx = { call, values };
+    call->learner->cb(&ctx, call->group, values, call->learner->context);
+    (void)count;
+}
+
+/**
+ * Sort <count> vectors of <length> values lexicographically (merge sort, <tmp> has the same size)
+ */
+static void
+lddmc_learn_sort(uint32_t *vecs, uint32_t *tmp, size_t count, size_t length)
+{
+    if (count < 2) return;
+    const size_t mid = count / 2;
+    lddmc_learn_sort(vecs, tmp, mid, length);
+    lddmc_learn_sort(vecs + mid*length, tmp, count - mid, length);
+    size_t i = 0, j = mid, k = 0;
+    while (i < mid && j < count) {
+        const uint32_t *a = vecs + i*length, *b = vecs + j*length;
+        size_t l = 0;
+        while (l < length && a[l] == b[l]) l++;
+        if (l == length || a[l] <= b[l]) {
+            memcpy(tmp + k*length, a, sizeof(uint32_t) * length);
+            i++;
+        } else {
+            memcpy(tmp + k*length, b, sizeof(uint32_t) * length);
+            j++;
+        }
+        k++;
+    }
+    if (i < mid) memcpy(tmp + k*length, vecs + i*length, sizeof(uint32_t) * length * (mid - i));
+    else memcpy(tmp + k*length, vecs + j*length, sizeof(uint32_t) * length * (count - j));
+    memcpy(vecs, tmp, sizeof(uint32_t) * length * count);
+}
+
+/**
+ * Add <dd> to the MDD in <ptr>, which other workers may update at the same time
+ */
+TASK_2(MDD, lddmc_learn_union_into, MDD*, ptr, MDD, dd)
+{
+    MDD old = atomic_load((_Atomic(MDD)*)ptr);
+    lddmc_refs_pushptr(&old);
+    for (;;) {
+        MDD result = CALL(lddmc_union, old, dd);
+        if (atomic_compare_exchange_strong((_Atomic(MDD)*)ptr, &old, result)) {
+            lddmc_refs_popptr(1);
+            return result;
+        }
+    }
+}
+
+/**
+ * Learn the transitions of group <group> for the states <states>, projected with <proj>
+ */
+TASK_4(MDD, lddmc_learn_proj, lddmc_learner_t, learner, int, group, MDD, states, MDD, proj)
+{
+    lddmc_learn_group_t *g = &learner->groups[group];
+
+    MDD todo = CALL(lddmc_project_minus, states, proj, atomic_load((_Atomic(MDD)*)&g->learned));
+    if (todo == lddmc_false) return lddmc_learner_relation(learner, group);
+    lddmc_refs_pushptr(&todo);
+
+    /* Run the callbacks in parallel, every worker fills its own buffer */
+    const size_t workers = lace_workers();
+    lddmc_learn_call_t call;
+    call.learner = learner;
+    call.group = group;
+    call.bufs = (lddmc_learn_buf_t*)calloc(workers, sizeof(lddmc_learn_buf_t));
+    if (call.bufs == NULL) {
+        fprintf(stderr, "lddmc_learn: Unable to allocate memory!\n");
+        exit(1);
+    }
+    CALL(lddmc_sat_all_par, todo, TASK(lddmc_learn_enum_cb), &call, NULL, 0);
+
+    /* Concatenate and sort the learned transitions */
+    size_t total = 0;
+    for (size_t i=0; i<workers; i++) total += call.bufs[i].count;
+    MDD rel = lddmc_learner_relation(learner, group);
+    if (total > 0) {
+        const size_t count = total / g->length;
+        uint32_t *vecs = (uint32_t*)malloc(sizeof(uint32_t) * total);
+        uint32_t *tmp = (uint32_t*)malloc(sizeof(uint32_t) * total);
+        if (vecs == NULL || tmp == NULL) {
+            fprintf(stderr, "lddmc_learn: Unable to allocate memory!\n");
+            exit(1);
+        }
+        size_t k = 0;
+        for (size_t i=0; i<workers; i++) {
+            if (call.bufs[i].count == 0) continue;
+            memcpy(vecs + k, call.bufs[i].data, sizeof(uint32_t) * call.bufs[i].count);
+            k += call.bufs[i].count;
+        }
+        lddmc_learn_sort(vecs, tmp, count, g->length);
+        free(tmp);
+        MDD added = CALL(lddmc_from_sorted_array, vecs, count, g->length);
+        free(vecs);
+        lddmc_refs_pushptr(&added);
+        rel = CALL(lddmc_learn_union_into, &g->rel, added);
+        lddmc_refs_popptr(1);
+    }
+    for (size_t i=0; i<workers; i++) free(call.bufs[i].data);
+    free(call.bufs);
+
+    /* Only mark the projections as learned after their transitions are in the relation */
+    CALL(lddmc_learn_union_into, &g->learned, todo);
+    lddmc_refs_popptr(1);
+
+    sylvan_stats_count(LDD_LEARN);
+    return rel;
+}
+
+TASK_IMPL_3(MDD, lddmc_learn, lddmc_learner_t, learner, int, group, MDD, states)
+{
+    return CALL(lddmc_learn_proj, learner, group, states, learner->groups[group].proj);
+}
+
+/**
+ * Saturation: apply the groups in learner->order starting at <idx> to <set>,
+ * where <set> contains the values of the variables from <depth>
+ */
+TASK_4(MDD, lddmc_learn_sat, lddmc_learner_t, learner, MDD, set, size_t, idx, uint32_t, depth)
+{
+    /* Terminal cases */
+    if (set == lddmc_false) return lddmc_false;
+    if (idx == learner->ngroups) return set;
+
+    sylvan_gc_test();
+
+    sylvan_stats_count(LDD_LEARN_SAT);
+
+    /* Consult the cache */
+    MDD result;
+    const MDD _set = set;
+    if (cache_get3(CACHE_MDD_LEARN_SAT, _set, idx, learner->id, &result)) {
+        sylvan_stats_count(LDD_LEARN_SAT_CACHED);
+        return result;
+    }
+    lddmc_refs_pushptr(&_set);
+
+    const uint32_t var = learner->groups[learner->order[idx]].firstvar;
+    assert(depth <= var);
+    if (depth == var) {
+        /* Count the groups starting here */
+        size_t n = 1;
+        while (idx + n < learner->ngroups && learner->groups[learner->order[idx+n]].firstvar == var) n++;
+        /* Until fixpoint: saturate deeper, then learn and apply every group on this level once */
+        MDD prev = lddmc_false;
+        lddmc_refs_pushptr(&set);
+        lddmc_refs_pushptr(&prev);
+        while (prev != set) {
+            prev = set;
+            set = CALL(lddmc_learn_sat, learner, set, idx + n, depth);
+            for (size_t i=0; i<n; i++) {
+                const int group = learner->order[idx+i];
+                lddmc_learn_group_t *g = &learner->groups[group];
+                MDD rel = CALL(lddmc_learn_proj, learner, group, set, g->topproj);
+                set = CALL(lddmc_relprod_union, set, rel, g->topmeta, set);
+            }
+        }
+        lddmc_refs_popptr(2);
+        result = set;
+    } else {
+        /* Recursive computation */
+        lddmc_refs_spawn(SPAWN(lddmc_learn_sat, learner, lddmc_getright(set), idx, depth));
+        MDD down = lddmc_refs_push(CALL(lddmc_learn_sat, learner, lddmc_getdown(set), idx, depth+1));
+        MDD right = lddmc_refs_sync(SYNC(lddmc_learn_sat));
+        lddmc_refs_pop(1);
+        result = lddmc_makenode(lddmc_getvalue(set), down, right);
+    }
+
+    /**
+     * The result stays valid when the relations grow: it is a fixpoint of which all projections
+     * are learned, so transitions learned later start outside of it.
+     */
+    if (cache_put3(CACHE_MDD_LEARN_SAT, _set, idx, learner->id, result)) sylvan_stats_count(LDD_LEARN_SAT_CACHEDPUT);
+    lddmc_refs_popptr(1);
+    return result;
+}
+
+TASK_IMPL_2(MDD, lddmc_learn_reachable, lddmc_learner_t, learner, MDD, states)
+{
+    return CALL(lddmc_learn_sat, learner, states, 0, 0);
+}
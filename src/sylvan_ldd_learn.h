@@ -0,0 +1,100 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Learning saturation for LDDs.
+ *
+ * In the on-the-fly workflow of LTSmin, the transition relation of every group is not known
+ * in advance. It is learned from the states that are found: the states are projected on the
+ * variables read by the group, and for every new short vector a next-state function reports
+ * the successors, which are added to the relation of the group.
+ *
+ * A learner runs the next-state callbacks in parallel on the Lace workers. Every worker appends
+ * the learned transitions to its own buffer; afterwards the buffers are sorted and added to the
+ * relation with one lddmc_union_sorted_array. Reachability by saturation learns the relations
+ * of the groups incrementally, whenever a group is applied to a set of states.
+ */
+
+/* Do not include this file directly. Instead, include sylvan.h */
+
+#ifndef SYLVAN_LDD_LEARN_H
+#define SYLVAN_LDD_LEARN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct lddmc_learner *lddmc_learner_t;
+typedef struct lddmc_learn_ctx *lddmc_learn_ctx_t;
+
+/**
+ * Next-state callback of a learner.
+ * <src> holds the values of the variables read by <group> (in the order of its read projection).
+ * The callback reports every successor with lddmc_learn_add, and may run concurrently on all
+ * Lace workers. The same short vector may be offered more than once when it is found by two
+ * workers at the same time.
+ */
+typedef void (*lddmc_learn_cb)(lddmc_learn_ctx_t ctx, int group, const uint32_t *src, void *context);
+
+/**
+ * Report a successor of the short vector given to the callback.
+ * <dst> holds the values of the variables written by the group (in the order of its write projection).
+ */
+void lddmc_learn_add(lddmc_learn_ctx_t ctx, const uint32_t *dst);
+
+/**
+ * Create a learner for states of <nvars> variables with <ngroups> transition groups.
+ * Every group must be defined with lddmc_learner_set_group before it is used.
+ */
+lddmc_learner_t lddmc_learner_create(size_t nvars, size_t ngroups, lddmc_learn_cb cb, void *context);
+
+/**
+ * Free the learner and release its relations.
+ */
+void lddmc_learner_free(lddmc_learner_t learner);
+
+/**
+ * Define <group> by the <r_k> variables in <r_proj> that it reads and the <w_k> variables
+ * in <w_proj> that it writes. Both projections are sorted, and at least one is not empty.
+ */
+void lddmc_learner_set_group(lddmc_learner_t learner, int group, size_t r_k, const int *r_proj, size_t w_k, const int *w_proj);
+
+/**
+ * Get the relation learned so far for <group>, and its meta (see lddmc_relprod)
+ * for applying the relation to full states.
+ */
+MDD lddmc_learner_relation(lddmc_learner_t learner, int group);
+MDD lddmc_learner_meta(lddmc_learner_t learner, int group);
+
+/**
+ * Learn the transitions of <group> from the states in <states> that are not learned yet,
+ * and return the relation of the group.
+ */
+TASK_DECL_3(MDD, lddmc_learn, lddmc_learner_t, int, MDD);
+#define lddmc_learn(learner, group, states) RUN(lddmc_learn, learner, group, states)
+
+/**
+ * Compute all states reachable from <states> by saturation, learning the relations on the way.
+ */
+TASK_DECL_2(MDD, lddmc_learn_reachable, lddmc_learner_t, MDD);
+#define lddmc_learn_reachable(learner, states) RUN(lddmc_learn_reachable, learner, states)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
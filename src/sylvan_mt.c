@@ -17,13 +17,57 @@
 
 #include <sylvan_int.h> // for llmsset*, nodes, sylvan_register_quit
 
+#include <sylvan_align.h>
+
 #include <inttypes.h>
+#include <sched.h> // for sched_yield
 #include <string.h>
 
 /**
  * Handling of custom leaves "registry"
  */
 
+/**
+ * Arena allocator for leaf payloads.
+ * Every Lace worker has its own slot with a free list and a current chunk. The table of worker
+ * slots grows when a worker without a slot appears (after Lace restarts with more workers); old
+ * tables stay valid for workers that still read them and are freed with the arena.
+ * The shared slot is used by threads that are not Lace workers and is protected by the lock.
+ * After garbage collection, chunks without live objects are returned to the system and the
+ * remaining free objects are divided evenly over the slots (see mt_arena_reclaim).
+ */
+#define MT_ARENA_CHUNK_SIZE (64*1024)
+
+typedef struct mt_arena_slot
+{
+    void *free;                 // free list of returned objects
+    char *next;                 // next unused object in the current chunk
+    char *end;                  // end of the current chunk
+    char pad[64-3*sizeof(void*)]; // avoid false sharing
+} mt_arena_slot_t;
+
+typedef struct mt_arena_chunk
+{
+    struct mt_arena_chunk *next; // linked list of allocated chunks
+    size_t nfree;               // number of free objects (only during mt_arena_reclaim)
+} mt_arena_chunk_t;             // header of 16 bytes, followed by the objects
+
+typedef struct mt_arena_table
+{
+    size_t count;               // number of worker slots
+    struct mt_arena_table *old; // the previous table
+    mt_arena_slot_t *slots[];
+} mt_arena_table_t;
+
+typedef struct mt_arena
+{
+    size_t objsize;             // size of objects (rounded up to 16 bytes)
+    _Atomic(mt_arena_table_t*) table;
+    mt_arena_chunk_t *chunks;   // linked list of allocated chunks
+    _Atomic(int) lock;          // protects the shared slot, the list of chunks and growing the table
+    mt_arena_slot_t shared;
+} mt_arena_t;
+
 typedef struct
 {
     sylvan_mt_hash_cb hash_cb;
@@ -33,6 +77,7 @@ typedef struct
     sylvan_mt_to_str_cb to_str_cb;
     sylvan_mt_write_binary_cb write_binary_cb;
     sylvan_mt_read_binary_cb read_binary_cb;
+    mt_arena_t *arena;
 } customleaf_t;
 
 static customleaf_t *cl_registry;
@@ -141,6 +186,319 @@ void sylvan_mt_set_read_binary(uint32_t type, sylvan_mt_read_binary_cb read_bina
     c->read_binary_cb = read_binary_cb;
 }
 
+/**
+ * Take the lock of the arena, with exponential backoff while it is taken, and yielding the
+ * processor when it stays taken (for example when its owner was preempted).
+ */
+static inline void
+mt_arena_lock(mt_arena_t *arena)
+{
+    unsigned int backoff = 1;
+    for (;;) {
+        int v = 0;
+        if (atomic_load_explicit(&arena->lock, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_weak(&arena->lock, &v, 1)) return;
+        if (backoff <= 1024) {
+            for (volatile unsigned int i=0; i<backoff; i++) continue;
+            backoff *= 2;
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+static inline void
+mt_arena_unlock(mt_arena_t *arena)
+{
+    atomic_store(&arena->lock, 0);
+}
+
+/**
+ * Allocate a table of <count> worker slots, with the slots of <old> and new slots for the others.
+ */
+static mt_arena_table_t*
+mt_arena_table_alloc(size_t count, mt_arena_table_t *old)
+{
+    mt_arena_table_t *t = (mt_arena_table_t*)malloc(sizeof(mt_arena_table_t) + count * sizeof(mt_arena_slot_t*));
+    if (t == NULL) {
+        fprintf(stderr, "sylvan_mt_set_arena: unable to allocate memory!\n");
+        exit(1);
+    }
+    t->count = count;
+    t->old = old;
+    size_t i = 0;
+    if (old != NULL) for (; i<old->count; i++) t->slots[i] = old->slots[i];
+    for (; i<count; i++) {
+        t->slots[i] = (mt_arena_slot_t*)alloc_aligned(sizeof(mt_arena_slot_t));
+        if (t->slots[i] == NULL) {
+            fprintf(stderr, "sylvan_mt_set_arena: unable to allocate memory!\n");
+            exit(1);
+        }
+    }
+    return t;
+}
+
+void
+sylvan_mt_set_arena(uint32_t type, size_t size)
+{
+    assert(type < cl_registry_count);
+    customleaf_t *c = cl_registry + type;
+    assert(c->arena == NULL);
+
+    mt_arena_t *arena = (mt_arena_t*)calloc(1, sizeof(mt_arena_t));
+    if (arena == NULL) {
+        fprintf(stderr, "sylvan_mt_set_arena: unable to allocate memory!\n");
+        exit(1);
+    }
+    if (size < sizeof(void*)) size = sizeof(void*);
+    arena->objsize = (size + 15) & ~(size_t)15;
+    assert(arena->objsize <= MT_ARENA_CHUNK_SIZE - sizeof(mt_arena_chunk_t));
+    atomic_init(&arena->table, mt_arena_table_alloc(lace_workers(), NULL));
+    c->arena = arena;
+}
+
+/**
+ * Give <worker> a slot, growing the table of slots.
+ */
+static mt_arena_slot_t*
+__attribute__((noinline))
+mt_arena_grow(mt_arena_t *arena, size_t worker)
+{
+    mt_arena_lock(arena);
+    mt_arena_table_t *t = atomic_load_explicit(&arena->table, memory_order_relaxed);
+    if (worker >= t->count) {
+        size_t count = lace_workers();
+        if (count <= worker) count = worker + 1;
+        t = mt_arena_table_alloc(count, t);
+        atomic_store_explicit(&arena->table, t, memory_order_release);
+    }
+    mt_arena_unlock(arena);
+    return t->slots[worker];
+}
+
+/**
+ * Obtain the slot of the current thread; the shared slot is returned locked.
+ */
+static inline mt_arena_slot_t*
+mt_arena_get_slot(mt_arena_t *arena)
+{
+    WorkerP *w = lace_get_worker();
+    if (w != NULL) {
+        mt_arena_table_t *t = atomic_load_explicit(&arena->table, memory_order_acquire);
+        if ((size_t)w->worker < t->count) return t->slots[w->worker];
+        return mt_arena_grow(arena, w->worker);
+    }
+    mt_arena_lock(arena);
+    return &arena->shared;
+}
+
+static inline void
+mt_arena_release_slot(mt_arena_t *arena, mt_arena_slot_t *slot)
+{
+    if (slot == &arena->shared) mt_arena_unlock(arena);
+}
+
+void*
+sylvan_mt_arena_alloc(uint32_t type)
+{
+    assert(type < cl_registry_count);
+    mt_arena_t *arena = cl_registry[type].arena;
+    assert(arena != NULL);
+
+    mt_arena_slot_t *slot = mt_arena_get_slot(arena);
+    void *result;
+    if (slot->free != NULL) {
+        result = slot->free;
+        slot->free = *(void**)result;
+    } else {
+        if (slot->next == slot->end) {
+            // get a new chunk, its header links the list of chunks
+            mt_arena_chunk_t *chunk = (mt_arena_chunk_t*)malloc(MT_ARENA_CHUNK_SIZE);
+            if (chunk == NULL) {
+                fprintf(stderr, "sylvan_mt_arena_alloc: unable to allocate memory!\n");
+                exit(1);
+            }
+            int shared = slot == &arena->shared;
+            if (!shared) mt_arena_lock(arena);
+            chunk->next = arena->chunks;
+            arena->chunks = chunk;
+            if (!shared) mt_arena_unlock(arena);
+            slot->next = (char*)(chunk + 1);
+            slot->end = slot->next + ((MT_ARENA_CHUNK_SIZE - sizeof(mt_arena_chunk_t)) / arena->objsize) * arena->objsize;
+        }
+        result = slot->next;
+        slot->next += arena->objsize;
+    }
+    mt_arena_release_slot(arena, slot);
+    return result;
+}
+
+void
+sylvan_mt_arena_free(uint32_t type, void *ptr)
+{
+    assert(type < cl_registry_count);
+    mt_arena_t *arena = cl_registry[type].arena;
+    assert(arena != NULL);
+
+    mt_arena_slot_t *slot = mt_arena_get_slot(arena);
+    *(void**)ptr = slot->free;
+    slot->free = ptr;
+    mt_arena_release_slot(arena, slot);
+}
+
+size_t
+sylvan_mt_arena_usage(uint32_t type)
+{
+    assert(type < cl_registry_count);
+    mt_arena_t *arena = cl_registry[type].arena;
+    assert(arena != NULL);
+
+    size_t count = 0;
+    mt_arena_lock(arena);
+    for (mt_arena_chunk_t *c = arena->chunks; c != NULL; c = c->next) count++;
+    mt_arena_unlock(arena);
+    return count * MT_ARENA_CHUNK_SIZE;
+}
+
+static int
+mt_arena_chunk_compare(const void *a, const void *b)
+{
+    const size_t x = (size_t)*(mt_arena_chunk_t* const*)a, y = (size_t)*(mt_arena_chunk_t* const*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/**
+ * Find the chunk of <ptr> in the <count> chunks sorted by address.
+ */
+static mt_arena_chunk_t*
+mt_arena_find_chunk(mt_arena_chunk_t **sorted, size_t count, const void *ptr)
+{
+    size_t lo = 0, hi = count;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if ((size_t)sorted[mid] <= (size_t)ptr) lo = mid;
+        else hi = mid;
+    }
+    return sorted[lo];
+}
+
+static inline mt_arena_slot_t*
+mt_arena_slot(mt_arena_t *arena, mt_arena_table_t *t, size_t i)
+{
+    return i < t->count ? t->slots[i] : &arena->shared;
+}
+
+/**
+ * Return the chunks without live objects to the system, and divide the other free objects
+ * evenly over the slots, as garbage collection returns objects to the free list of whichever
+ * worker destroys the leaf. Runs after garbage collection, when no Lace worker uses the arena;
+ * the caller holds the lock, for threads that are not Lace workers.
+ */
+static void
+mt_arena_reclaim(mt_arena_t *arena)
+{
+    mt_arena_table_t *t = atomic_load_explicit(&arena->table, memory_order_relaxed);
+    const size_t nslots = t->count + 1;
+
+    size_t nchunks = 0;
+    for (mt_arena_chunk_t *c = arena->chunks; c != NULL; c = c->next) nchunks++;
+    if (nchunks == 0) return;
+    mt_arena_chunk_t **sorted = (mt_arena_chunk_t**)malloc(nchunks * sizeof(mt_arena_chunk_t*));
+    if (sorted == NULL) return; // try again after the next garbage collection
+    size_t k = 0;
+    for (mt_arena_chunk_t *c = arena->chunks; c != NULL; c = c->next) {
+        c->nfree = 0;
+        sorted[k++] = c;
+    }
+    qsort(sorted, nchunks, sizeof(mt_arena_chunk_t*), mt_arena_chunk_compare);
+
+    // count the free objects of every chunk, including the unused rest of current chunks
+    for (size_t i=0; i<nslots; i++) {
+        mt_arena_slot_t *slot = mt_arena_slot(arena, t, i);
+        if (slot->next != slot->end) {
+            mt_arena_find_chunk(sorted, nchunks, slot->next)->nfree += (size_t)(slot->end - slot->next) / arena->objsize;
+        }
+        for (void *p = slot->free; p != NULL; p = *(void**)p) mt_arena_find_chunk(sorted, nchunks, p)->nfree++;
+    }
+
+    // collect the free objects of chunks that are kept
+    const size_t capacity = (MT_ARENA_CHUNK_SIZE - sizeof(mt_arena_chunk_t)) / arena->objsize;
+    void *pool = NULL;
+    size_t count = 0;
+    for (size_t i=0; i<nslots; i++) {
+        mt_arena_slot_t *slot = mt_arena_slot(arena, t, i);
+        void *p = slot->free;
+        while (p != NULL) {
+            void *next = *(void**)p;
+            if (mt_arena_find_chunk(sorted, nchunks, p)->nfree != capacity) {
+                *(void**)p = pool;
+                pool = p;
+                count++;
+            }
+            p = next;
+        }
+        slot->free = NULL;
+        if (slot->next != slot->end && mt_arena_find_chunk(sorted, nchunks, slot->next)->nfree == capacity) {
+            slot->next = slot->end = NULL;
+        }
+    }
+    free(sorted);
+
+    // free the chunks without live objects
+    mt_arena_chunk_t **pc = &arena->chunks;
+    while (*pc != NULL) {
+        mt_arena_chunk_t *c = *pc;
+        if (c->nfree == capacity) {
+            *pc = c->next;
+            free(c);
+        } else {
+            pc = &c->next;
+        }
+    }
+
+    // divide the free objects over the slots
+    for (size_t i=0; i<nslots; i++) {
+        mt_arena_slot_t *slot = mt_arena_slot(arena, t, i);
+        size_t n = count / nslots + (i < count % nslots ? 1 : 0);
+        for (; n>0; n--) {
+            void *p = pool;
+            pool = *(void**)p;
+            *(void**)p = slot->free;
+            slot->free = p;
+        }
+    }
+}
+
+VOID_TASK_0(sylvan_mt_gc_reclaim)
+{
+    for (size_t i=0; i<cl_registry_count; i++) {
+        mt_arena_t *arena = cl_registry[i].arena;
+        if (arena == NULL) continue;
+        mt_arena_lock(arena);
+        mt_arena_reclaim(arena);
+        mt_arena_unlock(arena);
+    }
+}
+
+static void
+mt_arena_destroy(mt_arena_t *arena)
+{
+    mt_arena_chunk_t *chunk = arena->chunks;
+    while (chunk != NULL) {
+        mt_arena_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    mt_arena_table_t *t = atomic_load_explicit(&arena->table, memory_order_relaxed);
+    for (size_t i=0; i<t->count; i++) free_aligned(t->slots[i], sizeof(mt_arena_slot_t));
+    while (t != NULL) {
+        mt_arena_table_t *old = t->old;
+        free(t);
+        t = old;
+    }
+    free(arena);
+}
+
 /**
  * Initialize and quit functions
  */
@@ -153,6 +511,9 @@ sylvan_mt_quit()
     if (mt_initialized == 0) return;
     mt_initialized = 0;
 
+    for (size_t i=0; i<cl_registry_count; i++) {
+        if (cl_registry[i].arena != NULL) mt_arena_destroy(cl_registry[i].arena);
+    }
     free(cl_registry);
     cl_registry = NULL;
     cl_registry_count = 0;
@@ -168,6 +529,9 @@ sylvan_init_mt()
     // Register quit handler to free structures
     sylvan_register_quit(sylvan_mt_quit);
 
+    // Return unused memory of the arenas after garbage collection
+    sylvan_gc_hook_postgc(TASK(sylvan_mt_gc_reclaim));
+
     // Tell llmsset to use our custom hooks
     llmsset_set_custom(nodes, _sylvan_hash_cb, _sylvan_equals_cb, _sylvan_create_cb, _sylvan_destroy_cb);
 
@@ -188,6 +552,17 @@ sylvan_mt_has_custom_hash(uint32_t type)
     return c->hash_cb != NULL ? 1 : 0;
 }
 
+/**
+ * Return 1 if the given <type> has a read_binary callback, or 0 otherwise.
+ */
+int
+sylvan_mt_has_read_binary(uint32_t type)
+{
+    assert(type < cl_registry_count);
+    customleaf_t *c = cl_registry + type;
+    return c->read_binary_cb != NULL ? 1 : 0;
+}
+
 /**
  * Convert a leaf (possibly complemented) to a string representation.
  * If it does not fit in <buf> of size <buflen>, returns a freshly allocated char* array.
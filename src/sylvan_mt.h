@@ -51,6 +51,9 @@ extern "C" {
  *     treat allocated objects like create (and destroy)
  *     return 0 if successful
  *
+ * Types that store a pointer to a fixed-size object can let create/destroy use an arena
+ * allocator (see sylvan_mt_set_arena) instead of malloc/free.
+ *
  * If the 64-byte value already completely describes the leaf, then the functions
  * write_binary and read_binary should be set to NULL.
  *
@@ -96,12 +99,45 @@ void sylvan_mt_set_to_str(uint32_t type, sylvan_mt_to_str_cb to_str_cb);
 void sylvan_mt_set_write_binary(uint32_t type, sylvan_mt_write_binary_cb write_binary_cb);
 void sylvan_mt_set_read_binary(uint32_t type, sylvan_mt_read_binary_cb read_binary_cb);
 
+/**
+ * Use an arena allocator for the leaf payloads of <type>, which are objects of <size> bytes.
+ * The create callback obtains objects with sylvan_mt_arena_alloc and the destroy callback
+ * returns them with sylvan_mt_arena_free. Objects are allocated from large chunks, with a
+ * separate chunk and free list for every Lace worker, so leaves created by the same worker
+ * are close in memory and returning an object during garbage collection is a pointer push.
+ * After garbage collection, chunks without live objects are returned to the system, and the
+ * other free objects are divided evenly over the workers.
+ * Call this when registering the type, before creating leaves of <type>.
+ */
+void sylvan_mt_set_arena(uint32_t type, size_t size);
+
+/**
+ * Allocate an object for a leaf payload of <type> from the arena of <type>.
+ */
+void *sylvan_mt_arena_alloc(uint32_t type);
+
+/**
+ * Return an object obtained with sylvan_mt_arena_alloc to the arena of <type>.
+ */
+void sylvan_mt_arena_free(uint32_t type, void *ptr);
+
+/**
+ * Return the number of bytes of the chunks of the arena of <type>.
+ */
+size_t sylvan_mt_arena_usage(uint32_t type);
+
 /**
  * Returns 1 if the given type implements hash, or 0 otherwise.
  * (used when inserting into the unique table)
  */
 int sylvan_mt_has_custom_hash(uint32_t type);
 
+/**
+ * Returns 1 if the given type implements read_binary, or 0 otherwise.
+ * (used when reading leaves from file)
+ */
+int sylvan_mt_has_read_binary(uint32_t type);
+
 /**
  * Get a hash for given value (calls hash callback of type).
  * If the type does not implement hash, then this is the same hash as used by the unique table.
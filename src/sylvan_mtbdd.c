@@ -22,7 +22,9 @@
 #include <string.h>
 
 #include <sylvan_refs.h>
-#include <sylvan_sl.h>
+#include <sylvan_writer.h>
+#include <sylvan_codec.h>
+#include <sylvan_serializer.h>
 #include <sha2.h>
 
 /* Primitives */
@@ -405,6 +407,7 @@ sylvan_init_mtbdd()
     sylvan_register_quit(mtbdd_quit);
     sylvan_gc_add_mark(TASK(mtbdd_gc_mark_external_refs));
     sylvan_gc_add_mark(TASK(mtbdd_gc_mark_protected));
+    sylvan_init_serializer();
 
     refs_create(&mtbdd_refs, 1024);
     if (!mtbdd_protected_created) {
@@ -563,12 +566,68 @@ mtbdd_int64(int64_t value)
     return mtbdd_makeleaf(0, *(uint64_t*)&value);
 }
 
+/**
+ * Rounding of Real leaves (see mtbdd_set_double_rounding)
+ */
+static mtbdd_round_mode double_round_mode = MTBDD_ROUND_NONE;
+static double double_round_epsilon = 0.0;
+
+double
+mtbdd_round_double(double value, mtbdd_round_mode mode, double epsilon)
+{
+    if (mode == MTBDD_ROUND_NONE || !isfinite(value) || !(epsilon > 0.0)) return value;
+
+    const double orig = value;
+    if (mode == MTBDD_ROUND_ABS) {
+        value = nearbyint(value / epsilon) * epsilon;
+    } else /* MTBDD_ROUND_REL */ {
+        // keep <bits> bits of the mantissa, such that 2^-bits <= epsilon
+        int exp;
+        frexp(epsilon, &exp);
+        int drop = 52 - (1 - exp);
+        if (drop > 52) drop = 52;
+        if (drop > 0) {
+            // round to nearest, a carry into the exponent is still correct
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(double));
+            bits += 1ULL << (drop-1);
+            bits &= ~((1ULL << drop) - 1);
+            memcpy(&value, &bits, sizeof(double));
+        }
+    }
+
+    // finite values stay finite (the quotient or a carry can overflow near DBL_MAX)
+    if (!isfinite(value)) return orig;
+
+    // normalize all 0.0 to 0.0
+    if (value == 0.0) value = 0.0;
+    return value;
+}
+
+void
+mtbdd_set_double_rounding(mtbdd_round_mode mode, double epsilon)
+{
+    double_round_mode = mode;
+    double_round_epsilon = epsilon;
+    cache_clear();
+}
+
+void
+mtbdd_get_double_rounding(mtbdd_round_mode *mode, double *epsilon)
+{
+    *mode = double_round_mode;
+    *epsilon = double_round_epsilon;
+}
+
 MTBDD
 mtbdd_double(double value)
 {
+    if (double_round_mode != MTBDD_ROUND_NONE) value = mtbdd_round_double(value, double_round_mode, double_round_epsilon);
     // normalize all 0.0 to 0.0
     if (value == 0.0) value = 0.0;
-    return mtbdd_makeleaf(1, *(uint64_t*)&value);
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(double));
+    return mtbdd_makeleaf(1, bits);
 }
 
 MTBDD
@@ -579,7 +638,7 @@ mtbdd_fraction(int64_t nom, uint64_t denom)
     nom /= c;
     denom /= c;
     if (nom > 2147483647 || nom < -2147483647 || denom > 4294967295) fprintf(stderr, "mtbdd_fraction: fraction overflow\n");
-    return mtbdd_makeleaf(2, (nom<<32)|denom);
+    return mtbdd_makeleaf(2, ((uint64_t)nom<<32)|denom);
 }
 
 /**
@@ -778,9 +837,8 @@ TASK_IMPL_3(MTBDD, mtbdd_apply, MTBDD, a, MTBDD, b, mtbdd_apply_op, op)
     }
 
     /* Recursive */
-    mtbdd_refs_spawn(SPAWN(mtbdd_apply, ahigh, bhigh, op));
-    MTBDD low = mtbdd_refs_push(CALL(mtbdd_apply, alow, blow, op));
-    MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_apply));
+    MTBDD low, high;
+    SYLVAN_FORK(mtbdd, low, high, (mtbdd_apply, alow, blow, op), (mtbdd_apply, ahigh, bhigh, op));
     mtbdd_refs_pop(1);
     result = mtbdd_makenode(v, low, high);
 
@@ -852,9 +910,8 @@ TASK_IMPL_5(MTBDD, mtbdd_applyp, MTBDD, a, MTBDD, b, size_t, p, mtbdd_applyp_op,
     }
 
     /* Recursive */
-    mtbdd_refs_spawn(SPAWN(mtbdd_applyp, ahigh, bhigh, p, op, opid));
-    MTBDD low = mtbdd_refs_push(CALL(mtbdd_applyp, alow, blow, p, op, opid));
-    MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_applyp));
+    MTBDD low, high;
+    SYLVAN_FORK(mtbdd, low, high, (mtbdd_applyp, alow, blow, p, op, opid), (mtbdd_applyp, ahigh, bhigh, p, op, opid));
     mtbdd_refs_pop(1);
     result = mtbdd_makenode(v, low, high);
 
@@ -901,9 +958,8 @@ TASK_IMPL_3(MTBDD, mtbdd_uapply, MTBDD, dd, mtbdd_uapply_op, op, size_t, param)
     MTBDD ddhigh = node_gethigh(dd, ndd);
 
     /* Recursive */
-    mtbdd_refs_spawn(SPAWN(mtbdd_uapply, ddhigh, op, param));
-    MTBDD low = mtbdd_refs_push(CALL(mtbdd_uapply, ddlow, op, param));
-    MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_uapply));
+    MTBDD low, high;
+    SYLVAN_FORK(mtbdd, low, high, (mtbdd_uapply, ddlow, op, param), (mtbdd_uapply, ddhigh, op, param));
     mtbdd_refs_pop(1);
     result = mtbdd_makenode(mtbddnode_getvariable(ndd), low, high);
 
@@ -1069,15 +1125,14 @@ TASK_IMPL_3(MTBDD, mtbdd_abstract, MTBDD, a, MTBDD, v, mtbdd_abstract_op, op)
     if (v == mtbdd_true) {
         result = a;
     } else if (var_a < var_v) {
-        mtbdd_refs_spawn(SPAWN(mtbdd_abstract, node_gethigh(a, na), v, op));
-        MTBDD low = mtbdd_refs_push(CALL(mtbdd_abstract, node_getlow(a, na), v, op));
-        MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_abstract));
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_abstract, node_getlow(a, na), v, op), (mtbdd_abstract, node_gethigh(a, na), v, op));
         mtbdd_refs_pop(1);
         result = mtbdd_makenode(var_a, low, high);
     } else /* var_a == var_v */ {
-        mtbdd_refs_spawn(SPAWN(mtbdd_abstract, node_gethigh(a, na), node_gethigh(v, nv), op));
-        MTBDD low = mtbdd_refs_push(CALL(mtbdd_abstract, node_getlow(a, na), node_gethigh(v, nv), op));
-        MTBDD high = mtbdd_refs_push(mtbdd_refs_sync(SYNC(mtbdd_abstract)));
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_abstract, node_getlow(a, na), node_gethigh(v, nv), op), (mtbdd_abstract, node_gethigh(a, na), node_gethigh(v, nv), op));
+        mtbdd_refs_push(high);
         result = WRAP(op, low, high, 0);
         mtbdd_refs_pop(2);
     }
@@ -1096,6 +1151,99 @@ TASK_IMPL_3(MTBDD, mtbdd_abstract, MTBDD, a, MTBDD, v, mtbdd_abstract_op, op)
     return result;
 }
 
+/**
+ * Add the operator <op> for variable <var> to the schedule.
+ * The operator is stored as an Integer leaf, so schedules are canonical and can be cached.
+ */
+MTBDDMAP
+mtbdd_schedule_add(MTBDDMAP schedule, uint32_t var, mtbdd_abstract_op op)
+{
+    MTBDD leaf = mtbdd_int64((int64_t)(size_t)op);
+    mtbdd_refs_push(leaf);
+    schedule = mtbdd_map_add(schedule, var, leaf);
+    mtbdd_refs_pop(1);
+    return schedule;
+}
+
+/**
+ * Add the operator <op> for each variable in the cube <vars> to the schedule.
+ */
+MTBDDMAP
+mtbdd_schedule_add_set(MTBDDMAP schedule, MTBDD vars, mtbdd_abstract_op op)
+{
+    mtbdd_refs_pushptr(&schedule);
+    while (vars != mtbdd_true) {
+        schedule = mtbdd_schedule_add(schedule, mtbdd_getvar(vars), op);
+        vars = mtbdd_gethigh(vars);
+    }
+    mtbdd_refs_popptr(1);
+    return schedule;
+}
+
+mtbdd_abstract_op
+mtbdd_schedule_op(MTBDDMAP schedule)
+{
+    return (mtbdd_abstract_op)(size_t)mtbdd_getint64(mtbdd_map_value(schedule));
+}
+
+/**
+ * Abstract the variables in <schedule> from <a>, each with its own operation
+ */
+TASK_IMPL_2(MTBDD, mtbdd_abstract_multi, MTBDD, a, MTBDDMAP, schedule)
+{
+    /* Check terminal case */
+    if (a == mtbdd_false) return mtbdd_false;
+    if (a == mtbdd_true) return mtbdd_true;
+    if (mtbdd_map_isempty(schedule)) return a;
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(MTBDD_ABSTRACT_MULTI);
+
+    /* Check cache */
+    MTBDD result;
+    if (cache_get3(CACHE_MTBDD_ABSTRACT_MULTI, a, schedule, 0, &result)) {
+        sylvan_stats_count(MTBDD_ABSTRACT_MULTI_CACHED);
+        return result;
+    }
+
+    mtbddnode_t na = MTBDD_GETNODE(a);
+    mtbddnode_t ns = MTBDD_GETNODE(schedule);
+    uint32_t var_a = mtbddnode_isleaf(na) ? 0xffffffff : mtbddnode_getvariable(na);
+    uint32_t var_s = mtbddnode_getvariable(ns);
+    mtbdd_abstract_op op = mtbdd_schedule_op(schedule);
+    MTBDDMAP next = node_getlow(schedule, ns);
+
+    /* Recursive */
+    if (var_s < var_a) {
+        /* Skipped variable, recursive then abstract result */
+        result = CALL(mtbdd_abstract_multi, a, next);
+        mtbdd_refs_push(result);
+        result = WRAP(op, result, result, 1);
+        mtbdd_refs_pop(1);
+    } else if (var_a < var_s) {
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_abstract_multi, node_getlow(a, na), schedule), (mtbdd_abstract_multi, node_gethigh(a, na), schedule));
+        mtbdd_refs_pop(1);
+        result = mtbdd_makenode(var_a, low, high);
+    } else /* var_a == var_s */ {
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_abstract_multi, node_getlow(a, na), next), (mtbdd_abstract_multi, node_gethigh(a, na), next));
+        mtbdd_refs_push(high);
+        result = WRAP(op, low, high, 0);
+        mtbdd_refs_pop(2);
+    }
+
+    /* Store in cache */
+    if (cache_put3(CACHE_MTBDD_ABSTRACT_MULTI, a, schedule, 0, result)) {
+        sylvan_stats_count(MTBDD_ABSTRACT_MULTI_CACHEDPUT);
+    }
+
+    return result;
+}
+
 /**
  * Binary operation Plus (for MTBDDs of same type)
  * Only for MTBDDs where either all leaves are Boolean, or Integer, or Double.
@@ -1488,9 +1636,8 @@ TASK_IMPL_3(MTBDD, mtbdd_ite, MTBDD, f, MTBDD, g, MTBDD, h)
     hhigh = (!lh && vh == v) ? node_gethigh(h, nh) : h;
 
     /* Recursive calls */
-    mtbdd_refs_spawn(SPAWN(mtbdd_ite, fhigh, ghigh, hhigh));
-    MTBDD low = mtbdd_refs_push(CALL(mtbdd_ite, flow, glow, hlow));
-    MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_ite));
+    MTBDD low, high;
+    SYLVAN_FORK(mtbdd, low, high, (mtbdd_ite, flow, glow, hlow), (mtbdd_ite, fhigh, ghigh, hhigh));
     mtbdd_refs_pop(1);
     result = mtbdd_makenode(v, low, high);
 
@@ -1569,7 +1716,61 @@ TASK_IMPL_2(MTBDD, mtbdd_strict_threshold_double, MTBDD, dd, double, d)
 }
 
 /**
- * Compare two Double MTBDDs, returns Boolean True if they are equal within some value epsilon
+ * Monad that rounds Real leaves to the nearest multiple of the parameter
+ */
+TASK_IMPL_2(MTBDD, mtbdd_op_round_abs, MTBDD, a, size_t, svalue)
+{
+    if (!mtbdd_isleaf(a)) return mtbdd_invalid;
+    if (a == mtbdd_false || a == mtbdd_true || mtbdd_gettype(a) != 1) return a;
+    double epsilon;
+    memcpy(&epsilon, &svalue, sizeof(double));
+    return mtbdd_double(mtbdd_round_double(mtbdd_getdouble(a), MTBDD_ROUND_ABS, epsilon));
+}
+
+/**
+ * Monad that rounds Real leaves to the relative precision given by the parameter
+ */
+TASK_IMPL_2(MTBDD, mtbdd_op_round_rel, MTBDD, a, size_t, svalue)
+{
+    if (!mtbdd_isleaf(a)) return mtbdd_invalid;
+    if (a == mtbdd_false || a == mtbdd_true || mtbdd_gettype(a) != 1) return a;
+    double epsilon;
+    memcpy(&epsilon, &svalue, sizeof(double));
+    return mtbdd_double(mtbdd_round_double(mtbdd_getdouble(a), MTBDD_ROUND_REL, epsilon));
+}
+
+TASK_IMPL_3(MTBDD, mtbdd_round, MTBDD, dd, mtbdd_round_mode, mode, double, epsilon)
+{
+    uint64_t sepsilon;
+    memcpy(&sepsilon, &epsilon, sizeof(double));
+    if (mode == MTBDD_ROUND_ABS) return mtbdd_uapply(dd, TASK(mtbdd_op_round_abs), sepsilon);
+    if (mode == MTBDD_ROUND_REL) return mtbdd_uapply(dd, TASK(mtbdd_op_round_rel), sepsilon);
+    return dd;
+}
+
+/**
+ * Get the value of an Integer, Double or Rational leaf as a double.
+ * The leaf mtbdd_true (of a BDD in the MTBDD) has the value 1.
+ */
+static double
+mtbdd_leaf_to_double(MTBDD leaf)
+{
+    if (leaf == mtbdd_true) return 1.0;
+    switch (mtbdd_gettype(leaf)) {
+    case 0:
+        return (double)mtbdd_getint64(leaf);
+    case 1:
+        return mtbdd_getdouble(leaf);
+    case 2:
+        return (double)mtbdd_getnumer(leaf) / (double)mtbdd_getdenom(leaf);
+    default:
+        assert(0); // failure
+        return 0.0;
+    }
+}
+
+/**
+ * Compare two Double (or Integer, Rational) MTBDDs, returns Boolean True if they are equal within some value epsilon
  */
 TASK_4(MTBDD, mtbdd_equal_norm_d2, MTBDD, a, MTBDD, b, size_t, svalue, int*, shortcircuit)
 {
@@ -1587,9 +1788,8 @@ TASK_4(MTBDD, mtbdd_equal_norm_d2, MTBDD, a, MTBDD, b, size_t, svalue, int*, sho
     int lb = mtbddnode_isleaf(nb);
 
     if (la && lb) {
-        // assume Double MTBDD
-        double va = mtbdd_getdouble(a);
-        double vb = mtbdd_getdouble(b);
+        double va = mtbdd_leaf_to_double(a);
+        double vb = mtbdd_leaf_to_double(b);
         va -= vb;
         if (va < 0) va = -va;
         return (va < *(double*)&svalue) ? mtbdd_true : mtbdd_false;
@@ -1649,7 +1849,7 @@ TASK_IMPL_3(MTBDD, mtbdd_equal_norm_d, MTBDD, a, MTBDD, b, double, d)
 }
 
 /**
- * Compare two Double MTBDDs, returns Boolean True if they are equal within some value epsilon
+ * Compare two Double (or Integer, Rational) MTBDDs, returns Boolean True if they are equal within some value epsilon
  * This version computes the relative difference vs the value in a.
  */
 TASK_4(MTBDD, mtbdd_equal_norm_rel_d2, MTBDD, a, MTBDD, b, size_t, svalue, int*, shortcircuit)
@@ -1668,9 +1868,8 @@ TASK_4(MTBDD, mtbdd_equal_norm_rel_d2, MTBDD, a, MTBDD, b, size_t, svalue, int*,
     int lb = mtbddnode_isleaf(nb);
 
     if (la && lb) {
-        // assume Double MTBDD
-        double va = mtbdd_getdouble(a);
-        double vb = mtbdd_getdouble(b);
+        double va = mtbdd_leaf_to_double(a);
+        double vb = mtbdd_leaf_to_double(b);
         if (va == 0) return mtbdd_false;
         va = (va - vb) / va;
         if (va < 0) va = -va;
@@ -2166,16 +2365,15 @@ TASK_IMPL_3(MTBDD, mtbdd_and_abstract_plus, MTBDD, a, MTBDD, b, MTBDD, v)
 
         if (vv == var) {
             /* Recursive, then abstract result */
-            mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract_plus, ahigh, bhigh, node_gethigh(v, nv)));
-            MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract_plus, alow, blow, node_gethigh(v, nv)));
-            MTBDD high = mtbdd_refs_push(mtbdd_refs_sync(SYNC(mtbdd_and_abstract_plus)));
+            MTBDD low, high;
+            SYLVAN_FORK(mtbdd, low, high, (mtbdd_and_abstract_plus, alow, blow, node_gethigh(v, nv)), (mtbdd_and_abstract_plus, ahigh, bhigh, node_gethigh(v, nv)));
+            mtbdd_refs_push(high);
             result = CALL(mtbdd_apply, low, high, TASK(mtbdd_op_plus));
             mtbdd_refs_pop(2);
         } else /* vv > v */ {
             /* Recursive, then create node */
-            mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract_plus, ahigh, bhigh, v));
-            MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract_plus, alow, blow, v));
-            MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_and_abstract_plus));
+            MTBDD low, high;
+            SYLVAN_FORK(mtbdd, low, high, (mtbdd_and_abstract_plus, alow, blow, v), (mtbdd_and_abstract_plus, ahigh, bhigh, v));
             mtbdd_refs_pop(1);
             result = mtbdd_makenode(var, low, high);
         }
@@ -2247,16 +2445,15 @@ TASK_IMPL_3(MTBDD, mtbdd_and_abstract_max, MTBDD, a, MTBDD, b, MTBDD, v)
 
     if (vv == var) {
         /* Recursive, then abstract result */
-        mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract_max, ahigh, bhigh, node_gethigh(v, nv)));
-        MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract_max, alow, blow, node_gethigh(v, nv)));
-        MTBDD high = mtbdd_refs_push(mtbdd_refs_sync(SYNC(mtbdd_and_abstract_max)));
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_and_abstract_max, alow, blow, node_gethigh(v, nv)), (mtbdd_and_abstract_max, ahigh, bhigh, node_gethigh(v, nv)));
+        mtbdd_refs_push(high);
         result = CALL(mtbdd_apply, low, high, TASK(mtbdd_op_max));
         mtbdd_refs_pop(2);
     } else /* vv > v */ {
         /* Recursive, then create node */
-        mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract_max, ahigh, bhigh, v));
-        MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract_max, alow, blow, v));
-        MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_and_abstract_max));
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_and_abstract_max, alow, blow, v), (mtbdd_and_abstract_max, ahigh, bhigh, v));
         mtbdd_refs_pop(1);
         result = mtbdd_makenode(var, low, high);
     }
@@ -2269,6 +2466,304 @@ TASK_IMPL_3(MTBDD, mtbdd_and_abstract_max, MTBDD, a, MTBDD, b, MTBDD, v)
     return result;
 }
 
+/**
+ * Apply <times> to <a> and <b>, and abstract variables <vars> using the operation <op>.
+ */
+TASK_IMPL_5(MTBDD, mtbdd_and_abstract_op, MTBDD, a, MTBDD, b, MTBDD, v, mtbdd_apply_op, times, mtbdd_abstract_op, op)
+{
+    if (v == mtbdd_true) return CALL(mtbdd_apply, a, b, times);
+    MTBDDMAP schedule = mtbdd_refs_push(mtbdd_schedule_add_set(mtbdd_map_empty(), v, op));
+    MTBDD result = CALL(mtbdd_and_abstract_multi, a, b, schedule, times);
+    mtbdd_refs_pop(1);
+    return result;
+}
+
+/**
+ * Apply <times> to <a> and <b>, and abstract the variables in <schedule>, each with its own operation.
+ */
+TASK_IMPL_4(MTBDD, mtbdd_and_abstract_multi, MTBDD, a, MTBDD, b, MTBDDMAP, schedule, mtbdd_apply_op, times)
+{
+    /* Check terminal case (the callback may swap its arguments, so give it copies) */
+    if (mtbdd_map_isempty(schedule)) return CALL(mtbdd_apply, a, b, times);
+    MTBDD ta = a, tb = b;
+    MTBDD result = WRAP(times, &ta, &tb);
+    if (result != mtbdd_invalid) {
+        mtbdd_refs_push(result);
+        result = CALL(mtbdd_abstract_multi, result, schedule);
+        mtbdd_refs_pop(1);
+        return result;
+    }
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(MTBDD_AND_ABSTRACT_MULTI);
+
+    /* Check cache */
+    if (cache_get6(CACHE_MTBDD_AND_ABSTRACT_MULTI | a, b, schedule, (size_t)times, 0, 0, &result, NULL)) {
+        sylvan_stats_count(MTBDD_AND_ABSTRACT_MULTI_CACHED);
+        return result;
+    }
+
+    /* Get top variable */
+    int la = mtbdd_isleaf(a);
+    int lb = mtbdd_isleaf(b);
+    mtbddnode_t na = la ? 0 : MTBDD_GETNODE(a);
+    mtbddnode_t nb = lb ? 0 : MTBDD_GETNODE(b);
+    uint32_t va = la ? 0xffffffff : mtbddnode_getvariable(na);
+    uint32_t vb = lb ? 0xffffffff : mtbddnode_getvariable(nb);
+    uint32_t var = va < vb ? va : vb;
+
+    mtbddnode_t ns = MTBDD_GETNODE(schedule);
+    uint32_t vs = mtbddnode_getvariable(ns);
+    mtbdd_abstract_op op = mtbdd_schedule_op(schedule);
+    MTBDDMAP next = node_getlow(schedule, ns);
+
+    if (vs < var) {
+        /* Skipped variable, recursive then abstract result */
+        result = CALL(mtbdd_and_abstract_multi, a, b, next, times);
+        mtbdd_refs_push(result);
+        result = WRAP(op, result, result, 1);
+        mtbdd_refs_pop(1);
+    } else {
+        /* Get cofactors */
+        MTBDD alow, ahigh, blow, bhigh;
+        alow  = (!la && va == var) ? node_getlow(a, na)  : a;
+        ahigh = (!la && va == var) ? node_gethigh(a, na) : a;
+        blow  = (!lb && vb == var) ? node_getlow(b, nb)  : b;
+        bhigh = (!lb && vb == var) ? node_gethigh(b, nb) : b;
+
+        if (vs == var) {
+            /* Recursive, then abstract result */
+            MTBDD low, high;
+            SYLVAN_FORK(mtbdd, low, high, (mtbdd_and_abstract_multi, alow, blow, next, times), (mtbdd_and_abstract_multi, ahigh, bhigh, next, times));
+            mtbdd_refs_push(high);
+            result = WRAP(op, low, high, 0);
+            mtbdd_refs_pop(2);
+        } else /* vs > var */ {
+            /* Recursive, then create node */
+            MTBDD low, high;
+            SYLVAN_FORK(mtbdd, low, high, (mtbdd_and_abstract_multi, alow, blow, schedule, times), (mtbdd_and_abstract_multi, ahigh, bhigh, schedule, times));
+            mtbdd_refs_pop(1);
+            result = mtbdd_makenode(var, low, high);
+        }
+    }
+
+    /* Store in cache */
+    if (cache_put6(CACHE_MTBDD_AND_ABSTRACT_MULTI | a, b, schedule, (size_t)times, 0, 0, result, 0)) {
+        sylvan_stats_count(MTBDD_AND_ABSTRACT_MULTI_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Multiply matrix <M> and vector <x>, summing over the column variables <cols>.
+ * The variables of <x> are in <rows> and are matched pairwise with the variables in <cols>.
+ */
+TASK_IMPL_6(MTBDD, mtbdd_matvec_op, MTBDD, M, MTBDD, x, MTBDD, rows, MTBDD, cols, mtbdd_apply_op, times, mtbdd_abstract_op, plus)
+{
+    /* Check terminal case (the callback may swap its arguments, so give it copies) */
+    MTBDD ta = M, tb = x;
+    MTBDD result = WRAP(times, &ta, &tb);
+    if (result != mtbdd_invalid && mtbdd_isleaf(result)) {
+        if (cols == mtbdd_true) return result;
+        mtbdd_refs_push(result);
+        result = CALL(mtbdd_abstract, result, cols, plus);
+        mtbdd_refs_pop(1);
+        return result;
+    }
+    if (cols == mtbdd_true) return CALL(mtbdd_apply, M, x, times);
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(MTBDD_MATVEC);
+
+    /* Check cache */
+    if (cache_get6(CACHE_MTBDD_MATVEC | M, x, rows, cols, (size_t)times, (size_t)plus, &result, NULL)) {
+        sylvan_stats_count(MTBDD_MATVEC_CACHED);
+        return result;
+    }
+
+    /* Get top variables */
+    int lm = mtbdd_isleaf(M);
+    int lx = mtbdd_isleaf(x);
+    mtbddnode_t nm = lm ? 0 : MTBDD_GETNODE(M);
+    mtbddnode_t nx = lx ? 0 : MTBDD_GETNODE(x);
+    uint32_t vm = lm ? 0xffffffff : mtbddnode_getvariable(nm);
+    uint32_t vx = lx ? 0xffffffff : mtbddnode_getvariable(nx);
+
+    /* Skip (row, column) pairs that neither <M> nor <x> depend on */
+    MTBDD r = rows, c = cols;
+    mtbddnode_t nr = 0, nc = 0;
+    uint32_t vr = 0xffffffff, vc = 0xffffffff;
+    int k = 0;
+    while (c != mtbdd_true) {
+        nr = MTBDD_GETNODE(r);
+        nc = MTBDD_GETNODE(c);
+        vr = mtbddnode_getvariable(nr);
+        vc = mtbddnode_getvariable(nc);
+        if (vm <= vc || vx <= vr) break;
+        r = node_gethigh(r, nr);
+        c = node_gethigh(c, nc);
+        k++;
+    }
+
+    if (c == mtbdd_true) {
+        /* Nothing left to sum */
+        result = CALL(mtbdd_apply, M, x, times);
+    } else if (vm < vc || vx < vr) {
+        /* Top variable is not summed, recursive then create node */
+        /* (a variable of <x> in <rows> is at the level of its column, even if <M> has it as well) */
+        uint32_t var = vm < vc ? vm : 0xffffffff;
+        if (vx < vr && vx < var) var = vx;
+        int bm = vm == var;
+        int bx = vx < vr && vx == var;
+        MTBDD mlow  = bm ? node_getlow(M, nm)  : M;
+        MTBDD mhigh = bm ? node_gethigh(M, nm) : M;
+        MTBDD xlow  = bx ? node_getlow(x, nx)  : x;
+        MTBDD xhigh = bx ? node_gethigh(x, nx) : x;
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_matvec_op, mlow, xlow, r, c, times, plus), (mtbdd_matvec_op, mhigh, xhigh, r, c, times, plus));
+        mtbdd_refs_pop(1);
+        result = mtbdd_makenode(var, low, high);
+    } else {
+        /* Top variable is column <vc> of <M> and/or row <vr> of <x>, recursive then sum */
+        MTBDD mlow  = vm == vc ? node_getlow(M, nm)  : M;
+        MTBDD mhigh = vm == vc ? node_gethigh(M, nm) : M;
+        MTBDD xlow  = vx == vr ? node_getlow(x, nx)  : x;
+        MTBDD xhigh = vx == vr ? node_gethigh(x, nx) : x;
+        r = node_gethigh(r, nr);
+        c = node_gethigh(c, nc);
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_matvec_op, mlow, xlow, r, c, times, plus), (mtbdd_matvec_op, mhigh, xhigh, r, c, times, plus));
+        mtbdd_refs_push(high);
+        result = WRAP(plus, low, high, 0);
+        mtbdd_refs_pop(2);
+    }
+
+    /* Account for the skipped pairs */
+    if (k) {
+        mtbdd_refs_push(result);
+        result = WRAP(plus, result, result, k);
+        mtbdd_refs_pop(1);
+    }
+
+    /* Store in cache */
+    if (cache_put6(CACHE_MTBDD_MATVEC | M, x, rows, cols, (size_t)times, (size_t)plus, result, 0)) {
+        sylvan_stats_count(MTBDD_MATVEC_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Multiply matrices <A> and <B>, summing over the variables <vars>.
+ * This is matrix-vector multiplication where the rows of <B> are the columns of <A>.
+ */
+TASK_IMPL_5(MTBDD, mtbdd_matmul_op, MTBDD, A, MTBDD, B, MTBDD, vars, mtbdd_apply_op, times, mtbdd_abstract_op, plus)
+{
+    return CALL(mtbdd_matvec_op, A, B, vars, vars, times, plus);
+}
+
+/**
+ * Compute M*x + b in one pass, see mtbdd_matvec.
+ * The offset <b> is carried along the first branch of every summation,
+ * so it is added to the product at the leaves instead of in a separate apply.
+ */
+TASK_IMPL_5(MTBDD, mtbdd_matvec_plus, MTBDD, M, MTBDD, x, MTBDD, b, MTBDD, rows, MTBDD, cols)
+{
+    /* Without offset, this is just matrix-vector multiplication */
+    if (b == mtbdd_false) return CALL(mtbdd_matvec_op, M, x, rows, cols, TASK(mtbdd_op_times), TASK(mtbdd_abstract_op_plus));
+
+    /* Check terminal case */
+    MTBDD ta = M, tb = x;
+    MTBDD result = CALL(mtbdd_op_times, &ta, &tb);
+    if (result != mtbdd_invalid && mtbdd_isleaf(result)) {
+        mtbdd_refs_push(result);
+        result = CALL(mtbdd_abstract, result, cols, TASK(mtbdd_abstract_op_plus));
+        mtbdd_refs_pop(1);
+        mtbdd_refs_push(result);
+        result = CALL(mtbdd_apply, result, b, TASK(mtbdd_op_plus));
+        mtbdd_refs_pop(1);
+        return result;
+    }
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(MTBDD_MATVEC_PLUS);
+
+    /* Check cache */
+    if (cache_get6(CACHE_MTBDD_MATVEC_PLUS | M, x, b, rows, cols, 0, &result, NULL)) {
+        sylvan_stats_count(MTBDD_MATVEC_PLUS_CACHED);
+        return result;
+    }
+
+    /* Get top variables */
+    int lm = mtbdd_isleaf(M);
+    int lx = mtbdd_isleaf(x);
+    int lb = mtbdd_isleaf(b);
+    mtbddnode_t nm = lm ? 0 : MTBDD_GETNODE(M);
+    mtbddnode_t nx = lx ? 0 : MTBDD_GETNODE(x);
+    mtbddnode_t nb = lb ? 0 : MTBDD_GETNODE(b);
+    uint32_t vm = lm ? 0xffffffff : mtbddnode_getvariable(nm);
+    uint32_t vx = lx ? 0xffffffff : mtbddnode_getvariable(nx);
+    uint32_t vb = lb ? 0xffffffff : mtbddnode_getvariable(nb);
+
+    /* Without variables left to sum over, recurse until M*x is a leaf */
+    mtbddnode_t nr = rows == mtbdd_true ? 0 : MTBDD_GETNODE(rows);
+    mtbddnode_t nc = cols == mtbdd_true ? 0 : MTBDD_GETNODE(cols);
+    uint32_t vr = rows == mtbdd_true ? 0xffffffff : mtbddnode_getvariable(nr);
+    uint32_t vc = cols == mtbdd_true ? 0xffffffff : mtbddnode_getvariable(nc);
+
+    if (vm < vc || vx < vr || vb < vc) {
+        /* Top variable is not summed, recursive then create node */
+        uint32_t var = vm < vc ? vm : 0xffffffff;
+        if (vx < vr && vx < var) var = vx;
+        if (vb < var) var = vb;
+        int bm = vm == var;
+        int bx = vx < vr && vx == var;
+        int bb = vb == var;
+        MTBDD mlow  = bm ? node_getlow(M, nm)  : M;
+        MTBDD mhigh = bm ? node_gethigh(M, nm) : M;
+        MTBDD xlow  = bx ? node_getlow(x, nx)  : x;
+        MTBDD xhigh = bx ? node_gethigh(x, nx) : x;
+        MTBDD blow  = bb ? node_getlow(b, nb)  : b;
+        MTBDD bhigh = bb ? node_gethigh(b, nb) : b;
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_matvec_plus, mlow, xlow, blow, rows, cols), (mtbdd_matvec_plus, mhigh, xhigh, bhigh, rows, cols));
+        mtbdd_refs_pop(1);
+        result = mtbdd_makenode(var, low, high);
+    } else {
+        /* Sum over the first pair, the offset only goes to the low branch (also if M and x
+           do not depend on the pair, then low and high are the same product) */
+        assert(cols != mtbdd_true);
+        MTBDD mlow  = vm == vc ? node_getlow(M, nm)  : M;
+        MTBDD mhigh = vm == vc ? node_gethigh(M, nm) : M;
+        MTBDD xlow  = vx == vr ? node_getlow(x, nx)  : x;
+        MTBDD xhigh = vx == vr ? node_gethigh(x, nx) : x;
+        MTBDD r = node_gethigh(rows, nr);
+        MTBDD c = node_gethigh(cols, nc);
+        MTBDD low, high;
+        SYLVAN_FORK(mtbdd, low, high, (mtbdd_matvec_plus, mlow, xlow, b, r, c), (mtbdd_matvec_op, mhigh, xhigh, r, c, TASK(mtbdd_op_times), TASK(mtbdd_abstract_op_plus)));
+        mtbdd_refs_push(high);
+        result = CALL(mtbdd_apply, low, high, TASK(mtbdd_op_plus));
+        mtbdd_refs_pop(2);
+    }
+
+    /* Store in cache */
+    if (cache_put6(CACHE_MTBDD_MATVEC_PLUS | M, x, b, rows, cols, 0, result, 0)) {
+        sylvan_stats_count(MTBDD_MATVEC_PLUS_CACHEDPUT);
+    }
+
+    return result;
+}
+
 /**
  * Calculate the support of a MTBDD, i.e. the cube of all variables that appear in the MTBDD nodes.
  */
@@ -2478,6 +2973,246 @@ TASK_IMPL_1(MTBDD, mtbdd_maximum, MTBDD, a)
     return result;
 }
 
+/**
+ * Compare two Integer, Double or Rational leaves, returns <0, 0 or >0.
+ */
+static int
+mtbdd_leaf_compare(MTBDD a, MTBDD b)
+{
+    if (a == b) return 0;
+    uint32_t ta = a == mtbdd_true ? 0xffffffff : mtbdd_gettype(a);
+    uint32_t tb = b == mtbdd_true ? 0xffffffff : mtbdd_gettype(b);
+    if (ta == 0 && tb == 0) {
+        int64_t va = mtbdd_getint64(a), vb = mtbdd_getint64(b);
+        return va < vb ? -1 : va > vb ? 1 : 0;
+    } else if (ta == 2 && tb == 2) {
+        int64_t va = (int64_t)mtbdd_getnumer(a) * mtbdd_getdenom(b);
+        int64_t vb = (int64_t)mtbdd_getnumer(b) * mtbdd_getdenom(a);
+        return va < vb ? -1 : va > vb ? 1 : 0;
+    } else {
+        double va = mtbdd_leaf_to_double(a), vb = mtbdd_leaf_to_double(b);
+        return va < vb ? -1 : va > vb ? 1 : 0;
+    }
+}
+
+/**
+ * Returns 1 if leaf <a> is ranked better than leaf <b> (larger if <largest>, else smaller).
+ * The leaf mtbdd_false is ranked below all other leaves.
+ */
+static inline int
+mtbdd_leaf_better(MTBDD a, MTBDD b, int largest)
+{
+    if (a == mtbdd_false) return 0;
+    if (b == mtbdd_false) return 1;
+    int c = mtbdd_leaf_compare(a, b);
+    return largest ? c > 0 : c < 0;
+}
+
+/**
+ * Get the best leaf of <dd> other than mtbdd_false, i.e., the maximum if <largest> and the minimum
+ * otherwise. Returns mtbdd_false if all paths lead to mtbdd_false.
+ * These bounds are cached per node and used to prune the searches of mtbdd_topk and mtbdd_range_count.
+ */
+TASK_2(MTBDD, mtbdd_bound, MTBDD, dd, int, largest)
+{
+    /* Check terminal case */
+    if (mtbdd_isleaf(dd)) return dd;
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(MTBDD_BOUND);
+
+    /* Check cache */
+    MTBDD result;
+    if (cache_get3(CACHE_MTBDD_BOUND, dd, largest, 0, &result)) {
+        sylvan_stats_count(MTBDD_BOUND_CACHED);
+        return result;
+    }
+
+    /* Call recursive */
+    mtbddnode_t n = MTBDD_GETNODE(dd);
+    MTBDD low, high;
+    SYLVAN_FORK_VALUE(low, high, (mtbdd_bound, node_getlow(dd, n), largest), (mtbdd_bound, node_gethigh(dd, n), largest));
+    result = mtbdd_leaf_better(high, low, largest) ? high : low;
+
+    /* Store in cache */
+    if (cache_put3(CACHE_MTBDD_BOUND, dd, largest, 0, result)) {
+        sylvan_stats_count(MTBDD_BOUND_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Get the best leaf of <dd> that is ranked strictly below the leaf <below> (or the best leaf
+ * if <below> is mtbdd_false). Returns mtbdd_false if there is no such leaf.
+ */
+TASK_3(MTBDD, mtbdd_topk_next, MTBDD, dd, MTBDD, below, int, largest)
+{
+    /* Check terminal case */
+    if (dd == mtbdd_false) return mtbdd_false;
+    if (mtbdd_isleaf(dd)) return (below == mtbdd_false || mtbdd_leaf_better(below, dd, largest)) ? dd : mtbdd_false;
+
+    /* Prune with the bounds of <dd> */
+    MTBDD best = CALL(mtbdd_bound, dd, largest);
+    if (below == mtbdd_false || mtbdd_leaf_better(below, best, largest)) return best;
+    MTBDD worst = CALL(mtbdd_bound, dd, !largest);
+    if (!mtbdd_leaf_better(below, worst, largest)) return mtbdd_false;
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(MTBDD_TOPK);
+
+    /* Check cache */
+    MTBDD result;
+    if (cache_get3(CACHE_MTBDD_TOPK, dd, below, largest, &result)) {
+        sylvan_stats_count(MTBDD_TOPK_CACHED);
+        return result;
+    }
+
+    /* Call recursive */
+    mtbddnode_t n = MTBDD_GETNODE(dd);
+    MTBDD low, high;
+    SYLVAN_FORK_VALUE(low, high, (mtbdd_topk_next, node_getlow(dd, n), below, largest), (mtbdd_topk_next, node_gethigh(dd, n), below, largest));
+    result = mtbdd_leaf_better(high, low, largest) ? high : low;
+
+    /* Store in cache */
+    if (cache_put3(CACHE_MTBDD_TOPK, dd, below, largest, result)) {
+        sylvan_stats_count(MTBDD_TOPK_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Get a cube of one path in <dd> to <leaf>, which is the best leaf ranked below <below>.
+ * Follows the low edge whenever the low cofactor contains <leaf>, using the cached results of mtbdd_topk_next.
+ */
+TASK_4(MTBDD, mtbdd_topk_path, MTBDD, dd, MTBDD, leaf, MTBDD, below, int, largest)
+{
+    if (mtbdd_isleaf(dd)) return mtbdd_true;
+
+    mtbddnode_t n = MTBDD_GETNODE(dd);
+    MTBDD low = node_getlow(dd, n);
+    MTBDD result;
+    if (CALL(mtbdd_topk_next, low, below, largest) == leaf) {
+        result = CALL(mtbdd_topk_path, low, leaf, below, largest);
+        mtbdd_refs_push(result);
+        result = mtbdd_makenode(mtbddnode_getvariable(n), result, mtbdd_false);
+    } else {
+        result = CALL(mtbdd_topk_path, node_gethigh(dd, n), leaf, below, largest);
+        mtbdd_refs_push(result);
+        result = mtbdd_makenode(mtbddnode_getvariable(n), mtbdd_false, result);
+    }
+    mtbdd_refs_pop(1);
+    return result;
+}
+
+/**
+ * Operation "paths" for mtbdd_uapply: true for the leaf <param>, false for the other leaves
+ */
+TASK_2(MTBDD, mtbdd_uop_leaf_paths, MTBDD, dd, size_t, param)
+{
+    if (mtbdd_isleaf(dd)) return dd == (MTBDD)param ? mtbdd_true : mtbdd_false;
+    return mtbdd_invalid;
+}
+
+/**
+ * Find the <k> best leaves of <dd> and optionally one or all paths to each leaf
+ */
+TASK_IMPL_6(size_t, mtbdd_topk, MTBDD, dd, size_t, k, int, largest, MTBDD*, leaves, MTBDD*, paths, int, all_paths)
+{
+    size_t count = 0;
+    MTBDD below = mtbdd_false;
+    while (count < k) {
+        MTBDD leaf = CALL(mtbdd_topk_next, dd, below, largest);
+        if (leaf == mtbdd_false) break;
+        if (paths != NULL) {
+            if (all_paths) paths[count] = mtbdd_uapply(dd, TASK(mtbdd_uop_leaf_paths), leaf);
+            else paths[count] = CALL(mtbdd_topk_path, dd, leaf, below, largest);
+            mtbdd_refs_push(paths[count]);
+        }
+        leaves[count++] = below = leaf;
+    }
+    if (paths != NULL) mtbdd_refs_pop(count);
+    return count;
+}
+
+/**
+ * Count the assignments to <vars> that <dd> maps to a leaf with a value in [lo, hi]
+ */
+TASK_IMPL_4(double, mtbdd_range_count, MTBDD, dd, MTBDD, vars, double, lo, double, hi)
+{
+    /* Trivial cases */
+    if (dd == mtbdd_false) return 0.0;
+    if (mtbdd_isleaf(dd)) {
+        double value = mtbdd_leaf_to_double(dd);
+        if (!(lo <= value && value <= hi)) return 0.0;
+        return powl(2.0L, mtbdd_set_count(vars));
+    }
+
+    /* Prune with the bounds of <dd> */
+    MTBDD min = CALL(mtbdd_bound, dd, 0);
+    MTBDD max = CALL(mtbdd_bound, dd, 1);
+    if (min == mtbdd_false || mtbdd_leaf_to_double(max) < lo || mtbdd_leaf_to_double(min) > hi) return 0.0;
+    if (lo != -HUGE_VAL || hi != HUGE_VAL) {
+        /* All leaves in range: share the count of all non-False assignments */
+        if (lo <= mtbdd_leaf_to_double(min) && mtbdd_leaf_to_double(max) <= hi) {
+            return CALL(mtbdd_range_count, dd, vars, -HUGE_VAL, HUGE_VAL);
+        }
+    }
+
+    /* Perhaps execute garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(MTBDD_RANGE_COUNT);
+
+    /* Count variables before var(dd) */
+    size_t skipped = 0;
+    mtbddnode_t n = MTBDD_GETNODE(dd);
+    uint32_t var = mtbddnode_getvariable(n);
+    mtbddnode_t set_node = MTBDD_GETNODE(vars);
+    uint32_t set_var = mtbddnode_getvariable(set_node);
+    while (var != set_var) {
+        skipped++;
+        vars = node_gethigh(vars, set_node);
+        // if this assertion fails, then vars is not the support of <dd>
+        assert(!mtbdd_set_isempty(vars));
+        set_node = MTBDD_GETNODE(vars);
+        set_var = mtbddnode_getvariable(set_node);
+    }
+
+    union {
+        double d;
+        uint64_t s;
+    } hack, hlo, hhi;
+    hlo.d = lo;
+    hhi.d = hi;
+
+    /* Consult cache */
+    if (cache_get6(CACHE_MTBDD_RANGE_COUNT | dd, vars, hlo.s, hhi.s, 0, 0, &hack.s, NULL)) {
+        sylvan_stats_count(MTBDD_RANGE_COUNT_CACHED);
+        return hack.d * powl(2.0L, skipped);
+    }
+
+    /* Call recursive */
+    MTBDD next = node_gethigh(vars, set_node);
+    double low, high;
+    SYLVAN_FORK_VALUE(low, high, (mtbdd_range_count, node_getlow(dd, n), next, lo, hi), (mtbdd_range_count, node_gethigh(dd, n), next, lo, hi));
+    hack.d = low + high;
+
+    if (cache_put6(CACHE_MTBDD_RANGE_COUNT | dd, vars, hlo.s, hhi.s, 0, 0, hack.s, 0)) {
+        sylvan_stats_count(MTBDD_RANGE_COUNT_CACHEDPUT);
+    }
+
+    return hack.d * powl(2.0L, skipped);
+}
+
 /**
  * Calculate the number of satisfying variable assignments according to <variables>.
  */
@@ -3189,98 +3924,130 @@ VOID_TASK_IMPL_4(mtbdd_visit_par, MTBDD, dd, mtbdd_visit_pre_cb, pre_cb, mtbdd_v
 }
 
 /**
- * Writing MTBDD files using a skiplist as a backend
+ * Writing MTBDD files using a sylvan_writer as a backend
  */
 
-TASK_2(int, mtbdd_writer_add_visitor_pre, MTBDD, dd, sylvan_skiplist_t, sl)
+static uint32_t
+mtbdd_writer_var(uint64_t index)
+{
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    return mtbddnode_isleaf(n) ? 0xffffffff : mtbddnode_getvariable(n);
+}
+
+static void
+mtbdd_writer_node(sylvan_writer_t w, uint64_t index, uint64_t *dst)
 {
-    if (mtbdd_isleaf(dd)) return 0;
-    return sylvan_skiplist_get(sl, MTBDD_STRIPMARK(dd)) == 0 ? 1 : 0;
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    MTBDD low = sylvan_writer_get(w, mtbddnode_getlow(n));
+    MTBDD high = mtbddnode_gethigh(n);
+    high = MTBDD_TRANSFERMARK(high, sylvan_writer_get(w, MTBDD_STRIPMARK(high)));
+    mtbddnode_makenode((mtbddnode_t)dst, mtbddnode_getvariable(n), low, high);
 }
 
-VOID_TASK_2(mtbdd_writer_add_visitor_post, MTBDD, dd, sylvan_skiplist_t, sl)
+static void
+mtbdd_writer_codec_get(void *ctx, uint64_t number, sylvan_codec_node_t *node)
 {
-    if (dd == mtbdd_true || dd == mtbdd_false) return;
-    sylvan_skiplist_assign_next(sl, MTBDD_STRIPMARK(dd));
+    sylvan_writer_t w = (sylvan_writer_t)ctx;
+    mtbddnode_t n = MTBDD_GETNODE(sylvan_writer_getr(w, number));
+    MTBDD high = mtbddnode_gethigh(n);
+    node->key = mtbddnode_getvariable(n);
+    node->child[0] = sylvan_writer_get(w, mtbddnode_getlow(n));
+    node->child[1] = MTBDD_TRANSFERMARK(high, sylvan_writer_get(w, MTBDD_STRIPMARK(high)));
 }
 
-sylvan_skiplist_t
+VOID_TASK_2(mtbdd_writer_add_rec, sylvan_writer_t, w, MTBDD, dd)
+{
+    if (MTBDD_STRIPMARK(dd) == mtbdd_false) return;
+    if (!sylvan_writer_mark(w, MTBDD_STRIPMARK(dd))) return;
+
+    mtbddnode_t n = MTBDD_GETNODE(dd);
+    if (mtbddnode_isleaf(n)) return;
+
+    SYLVAN_FORK_VOID((mtbdd_writer_add_rec, w, mtbddnode_gethigh(n)), (mtbdd_writer_add_rec, w, mtbddnode_getlow(n)));
+}
+
+sylvan_writer_t
 mtbdd_writer_start()
 {
-    size_t sl_size = nodes->table_size > 0x7fffffff ? 0x7fffffff : nodes->table_size;
-    return sylvan_skiplist_alloc(sl_size);
+    return sylvan_writer_alloc(mtbdd_writer_var);
 }
 
-VOID_TASK_IMPL_2(mtbdd_writer_add, sylvan_skiplist_t, sl, MTBDD, dd)
+VOID_TASK_IMPL_2(mtbdd_writer_add, sylvan_writer_t, w, MTBDD, dd)
 {
-    mtbdd_visit_seq(dd, (mtbdd_visit_pre_cb)TASK(mtbdd_writer_add_visitor_pre), (mtbdd_visit_post_cb)TASK(mtbdd_writer_add_visitor_post), (void*)sl);
+    CALL(mtbdd_writer_add_rec, w, dd);
 }
 
 void
-mtbdd_writer_writebinary(FILE *out, sylvan_skiplist_t sl)
+mtbdd_writer_writebinary(FILE *out, sylvan_writer_t w)
 {
-    size_t nodecount = sylvan_skiplist_count(sl);
-    fwrite(&nodecount, sizeof(size_t), 1, out);
-    for (size_t i=1; i<=nodecount; i++) {
-        MTBDD dd = sylvan_skiplist_getr(sl, i);
+    sylvan_writer_number(w);
 
-        mtbddnode_t n = MTBDD_GETNODE(dd);
-        if (mtbddnode_isleaf(n)) {
-            /* write leaf */
-            fwrite(n, sizeof(struct mtbddnode), 1, out);
-            uint32_t type = mtbddnode_gettype(n);
-            uint64_t value = mtbddnode_getvalue(n);
-            sylvan_mt_write_binary(type, value, out);
-        } else {
-            struct mtbddnode node;
-            MTBDD low = sylvan_skiplist_get(sl, mtbddnode_getlow(n));
-            MTBDD high = mtbddnode_gethigh(n);
-            high = MTBDD_TRANSFERMARK(high, sylvan_skiplist_get(sl, MTBDD_STRIPMARK(high)));
-            mtbddnode_makenode(&node, mtbddnode_getvariable(n), low, high);
-            fwrite(&node, sizeof(struct mtbddnode), 1, out);
-        }
+    size_t nodecount = sylvan_writer_count(w);
+    size_t leafcount = sylvan_writer_leafcount(w);
+    const int compact = sylvan_codec_write_header(out) == 0;
+    if (compact) {
+        sylvan_codec_write_varint(out, nodecount);
+        sylvan_codec_write_varint(out, leafcount);
+    } else {
+        fwrite(&nodecount, sizeof(size_t), 1, out);
+    }
+
+    /* the leaves have the lowest numbers; write them one by one, with their custom data */
+    for (size_t i=1; i<=leafcount; i++) {
+        mtbddnode_t n = MTBDD_GETNODE(sylvan_writer_getr(w, i));
+        fwrite(n, sizeof(struct mtbddnode), 1, out);
+        uint32_t type = mtbddnode_gettype(n);
+        uint64_t value = mtbddnode_getvalue(n);
+        sylvan_mt_write_binary(type, value, out);
     }
+
+    /* then all internal nodes, converted in parallel */
+    if (compact) sylvan_codec_write_nodes(out, leafcount+1, nodecount-leafcount, 1, mtbdd_writer_codec_get, w);
+    else sylvan_writer_write_nodes(w, out, leafcount+1, mtbdd_writer_node);
 }
 
 uint64_t
-mtbdd_writer_get(sylvan_skiplist_t sl, MTBDD dd)
+mtbdd_writer_get(sylvan_writer_t w, MTBDD dd)
 {
-    return MTBDD_TRANSFERMARK(dd, sylvan_skiplist_get(sl, MTBDD_STRIPMARK(dd)));
+    sylvan_writer_number(w);
+    return MTBDD_TRANSFERMARK(dd, sylvan_writer_get(w, MTBDD_STRIPMARK(dd)));
 }
 
 void
-mtbdd_writer_end(sylvan_skiplist_t sl)
+mtbdd_writer_end(sylvan_writer_t w)
 {
-    sylvan_skiplist_free(sl);
+    sylvan_writer_free(w);
 }
 
 VOID_TASK_IMPL_3(mtbdd_writer_tobinary, FILE *, out, MTBDD *, dds, int, count)
 {
-    sylvan_skiplist_t sl = mtbdd_writer_start();
+    sylvan_writer_t w = mtbdd_writer_start();
 
     for (int i=0; i<count; i++) {
-        CALL(mtbdd_writer_add, sl, dds[i]);
+        CALL(mtbdd_writer_add, w, dds[i]);
     }
 
-    mtbdd_writer_writebinary(out, sl);
+    mtbdd_writer_writebinary(out, w);
 
     fwrite(&count, sizeof(int), 1, out);
     
     for (int i=0; i<count; i++) {
-        uint64_t v = mtbdd_writer_get(sl, dds[i]);
+        uint64_t v = mtbdd_writer_get(w, dds[i]);
         fwrite(&v, sizeof(uint64_t), 1, out);
     }
 
-    mtbdd_writer_end(sl);
+    mtbdd_writer_end(w);
 }
 
 void
-mtbdd_writer_writetext(FILE *out, sylvan_skiplist_t sl)
+mtbdd_writer_writetext(FILE *out, sylvan_writer_t w)
 {
+    sylvan_writer_number(w);
+
     fprintf(out, "[\n");
-    size_t nodecount = sylvan_skiplist_count(sl);
+    size_t nodecount = sylvan_writer_count(w);
     for (size_t i=1; i<=nodecount; i++) {
-        MTBDD dd = sylvan_skiplist_getr(sl, i);
+        MTBDD dd = sylvan_writer_getr(w, i);
 
         mtbddnode_t n = MTBDD_GETNODE(dd);
         if (mtbddnode_isleaf(n)) {
@@ -3289,9 +4056,9 @@ mtbdd_writer_writetext(FILE *out, sylvan_skiplist_t sl)
             mtbdd_fprint_leaf(out, MTBDD_STRIPMARK(dd));
             fprintf(out, "\"),\n");
         } else {
-            MTBDD low = sylvan_skiplist_get(sl, mtbddnode_getlow(n));
+            MTBDD low = sylvan_writer_get(w, mtbddnode_getlow(n));
             MTBDD high = mtbddnode_gethigh(n);
-            high = MTBDD_TRANSFERMARK(high, sylvan_skiplist_get(sl, MTBDD_STRIPMARK(high)));
+            high = MTBDD_TRANSFERMARK(high, sylvan_writer_get(w, MTBDD_STRIPMARK(high)));
             fprintf(out, "  node(%zu,%u,%zu,%s%zu),\n", i, mtbddnode_getvariable(n), (size_t)low, MTBDD_HASMARK(high)?"~":"", (size_t)MTBDD_STRIPMARK(high));
         }
     }
@@ -3301,63 +4068,158 @@ mtbdd_writer_writetext(FILE *out, sylvan_skiplist_t sl)
 
 VOID_TASK_IMPL_3(mtbdd_writer_totext, FILE *, out, MTBDD *, dds, int, count)
 {
-    sylvan_skiplist_t sl = mtbdd_writer_start();
+    sylvan_writer_t w = mtbdd_writer_start();
 
     for (int i=0; i<count; i++) {
-        CALL(mtbdd_writer_add, sl, dds[i]);
+        CALL(mtbdd_writer_add, w, dds[i]);
     }
 
-    mtbdd_writer_writetext(out, sl);
+    mtbdd_writer_writetext(out, w);
 
     fprintf(out, ",[");
     
     for (int i=0; i<count; i++) {
-        uint64_t v = mtbdd_writer_get(sl, dds[i]);
+        uint64_t v = mtbdd_writer_get(w, dds[i]);
         fprintf(out, "%s%zu,", MTBDD_HASMARK(v)?"~":"", (size_t)MTBDD_STRIPMARK(v));
     }
 
     fprintf(out, "]\n");
 
-    mtbdd_writer_end(sl);
+    mtbdd_writer_end(w);
 }
 
 /**
  * Reading a file earlier written with mtbdd_writer_writebinary
  * Returns an array with the conversion from stored identifier to MTBDD
  * This array is allocated with malloc and must be freed afterwards.
- * This method does not support custom leaves.
+ * The data of custom leaves is read with their read_binary callback.
  */
-TASK_IMPL_1(uint64_t*, mtbdd_reader_readbinary, FILE*, in)
+static int
+mtbdd_reader_children(void *ctx, const uint64_t *rec, uint64_t *children)
 {
-    size_t nodecount;
-    if (fread(&nodecount, sizeof(size_t), 1, in) != 1) {
-        return NULL;
+    mtbddnode_t n = (mtbddnode_t)rec;
+    (void)ctx;
+    if (mtbddnode_isleaf(n)) return 0;
+    children[0] = mtbddnode_getlow(n);
+    children[1] = MTBDD_STRIPMARK(mtbddnode_gethigh(n));
+    return 2;
+}
+
+static uint64_t
+mtbdd_reader_node(void *ctx, const uint64_t *rec, const uint64_t *arr)
+{
+    mtbddnode_t n = (mtbddnode_t)rec;
+    (void)ctx;
+    MTBDD low = arr[mtbddnode_getlow(n)];
+    MTBDD high = mtbddnode_gethigh(n);
+    high = MTBDD_TRANSFERMARK(high, arr[MTBDD_STRIPMARK(high)]);
+    return mtbdd_makenode(mtbddnode_getvariable(n), low, high);
+}
+
+static void
+mtbdd_reader_codec_put(void *ctx, uint64_t number, const sylvan_codec_node_t *node)
+{
+    uint64_t *recs = (uint64_t*)ctx;
+    mtbddnode_makenode((mtbddnode_t)(recs+2*number), node->key, node->child[0] & ~SYLVAN_CODEC_FLAG, node->child[1]);
+}
+
+/**
+ * Read the nodes of a compact file: the leaves with their custom data, then blocks of nodes.
+ */
+TASK_4(int, mtbdd_reader_read_compact, FILE*, in, uint64_t*, recs, uint64_t*, arr, size_t, nodecount)
+{
+    uint64_t leafcount;
+    if (sylvan_codec_read_varint(in, &leafcount) != 0 || leafcount > nodecount) return -1;
+    for (size_t i=1; i<=leafcount; i++) {
+        mtbddnode_t n = (mtbddnode_t)(recs+2*i);
+        if (fread(n, sizeof(struct mtbddnode), 1, in) != 1 || !mtbddnode_isleaf(n)) return -1;
+        uint32_t type = mtbddnode_gettype(n);
+        uint64_t value = mtbddnode_getvalue(n);
+        if (sylvan_mt_read_binary(type, &value, in) != 0) return -1;
+        arr[i] = mtbdd_makeleaf(type, value);
     }
+    return CALL(sylvan_codec_read_nodes, in, leafcount+1, nodecount-leafcount, 1, mtbdd_reader_codec_put, recs);
+}
 
-    uint64_t *arr = malloc(sizeof(uint64_t)*(nodecount+1));
-    arr[0] = 0;
-    for (size_t i=1; i<=nodecount; i++) {
-        struct mtbddnode node;
-        if (fread(&node, sizeof(struct mtbddnode), 1, in) != 1) {
-            free(arr);
-            return NULL;
+/**
+ * Read the nodes of a raw file, and create the leaves on the way. The data of custom leaves
+ * follows their node. The writer puts all leaves first, so the leading leaves are read one by
+ * one and the internal nodes after them in blocks of up to 65536 nodes, without reading ahead
+ * (files can be pipes). Older files may have custom leaves between the internal nodes; then we
+ * seek back to right after the leaf, and continue with small blocks that grow again while no
+ * such leaf is found.
+ */
+static int
+mtbdd_reader_read_raw(FILE *in, uint64_t *recs, uint64_t *arr, size_t nodecount)
+{
+    size_t i = 1;
+    while (i <= nodecount) {
+        mtbddnode_t n = (mtbddnode_t)(recs+2*i);
+        if (fread(n, sizeof(struct mtbddnode), 1, in) != 1) return -1;
+        if (!mtbddnode_isleaf(n)) {
+            i++;
+            break;
         }
-
-        if (mtbddnode_isleaf(&node)) {
-            /* serialize leaf */
-            uint32_t type = mtbddnode_gettype(&node);
-            uint64_t value = mtbddnode_getvalue(&node);
-            sylvan_mt_read_binary(type, &value, in);
+        uint32_t type = mtbddnode_gettype(n);
+        uint64_t value = mtbddnode_getvalue(n);
+        if (sylvan_mt_read_binary(type, &value, in) != 0) return -1;
+        arr[i++] = mtbdd_makeleaf(type, value);
+    }
+
+    size_t blocksize = 65536;
+    while (i <= nodecount) {
+        size_t count = nodecount - i + 1;
+        if (count > blocksize) count = blocksize;
+        if (fread(recs+2*i, sizeof(struct mtbddnode), count, in) != count) return -1;
+        const size_t end = i + count;
+        for (; i<end; i++) {
+            mtbddnode_t n = (mtbddnode_t)(recs+2*i);
+            if (!mtbddnode_isleaf(n)) continue;
+            uint32_t type = mtbddnode_gettype(n);
+            uint64_t value = mtbddnode_getvalue(n);
+            if (sylvan_mt_has_read_binary(type)) {
+                if (i+1 < end && fseek(in, -(long)(sizeof(struct mtbddnode)*(end-i-1)), SEEK_CUR) != 0) return -1;
+                if (sylvan_mt_read_binary(type, &value, in) != 0) return -1;
+                arr[i++] = mtbdd_makeleaf(type, value);
+                blocksize = 0;
+                break;
+            }
             arr[i] = mtbdd_makeleaf(type, value);
-        } else {
-            MTBDD low = arr[mtbddnode_getlow(&node)];
-            MTBDD high = mtbddnode_gethigh(&node);
-            high = MTBDD_TRANSFERMARK(high, arr[MTBDD_STRIPMARK(high)]);
-            arr[i] = mtbdd_makenode(mtbddnode_getvariable(&node), low, high);
         }
+        blocksize = blocksize == 0 ? 1 : (blocksize < 65536 ? blocksize*2 : 65536);
     }
+    return 0;
+}
+
+TASK_IMPL_1(uint64_t*, mtbdd_reader_readbinary, FILE*, in)
+{
+    uint64_t nodecount;
+    const int compact = sylvan_codec_read_header(in, &nodecount);
+    if (compact < 0) return NULL;
+    if (compact && sylvan_codec_read_varint(in, &nodecount) != 0) return NULL;
+    if (nodecount >= SIZE_MAX / (2*sizeof(uint64_t))) return NULL;
 
+    uint64_t *recs = malloc(sizeof(uint64_t)*2*(nodecount+1));
+    uint64_t *arr = malloc(sizeof(uint64_t)*(nodecount+1));
+    if (recs == NULL || arr == NULL) goto error;
+    arr[0] = 0;
+
+    if (compact) {
+        if (CALL(mtbdd_reader_read_compact, in, recs, arr, nodecount) != 0) goto error;
+    } else {
+        if (mtbdd_reader_read_raw(in, recs, arr, nodecount) != 0) goto error;
+    }
+
+    /* Create the internal nodes in parallel, level by level */
+    if (CALL(sylvan_reader_make_nodes, recs, nodecount, arr, mtbdd_reader_children, mtbdd_reader_node, NULL) != 0) goto error;
+
+    free(recs);
     return arr;
+
+error:
+    free(recs);
+    free(arr);
+    return NULL;
 }
 
 /**
@@ -3413,6 +4275,119 @@ TASK_IMPL_3(int, mtbdd_reader_frombinary, FILE*, in, MTBDD*, dds, int, count)
     return 0;
 }
 
+/**
+ * Streams, with the serializers of sylvan_serializer.c
+ */
+
+static int
+mtbdd_ser_children(uint64_t index, uint64_t *children)
+{
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    if (mtbddnode_isleaf(n)) return 0;
+    children[0] = mtbddnode_getlow(n);
+    children[1] = MTBDD_STRIPMARK(mtbddnode_gethigh(n));
+    return 2;
+}
+
+/* leaves are only compared with each other, by their type and value */
+static void
+mtbdd_ser_encode(sylvan_ser_t s, uint64_t index, sylvan_codec_node_t *node)
+{
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    if (mtbddnode_isleaf(n)) {
+        node->key = mtbddnode_gettype(n);
+        node->child[0] = mtbddnode_getvalue(n);
+        node->child[1] = 0;
+    } else {
+        const MTBDD high = mtbddnode_gethigh(n);
+        node->key = mtbddnode_getvariable(n);
+        node->child[0] = sylvan_ser_get(s, mtbddnode_getlow(n));
+        node->child[1] = MTBDD_TRANSFERMARK(high, sylvan_ser_get(s, MTBDD_STRIPMARK(high)));
+    }
+}
+
+static void
+mtbdd_ser_to_record(const sylvan_codec_node_t *node, uint64_t *rec)
+{
+    mtbddnode_makenode((mtbddnode_t)rec, node->key, node->child[0] & ~SYLVAN_CODEC_FLAG, node->child[1]);
+}
+
+/* leaves are written as in files: the node, followed by its custom data */
+static void
+mtbdd_ser_write_leaf(uint64_t index, FILE *out)
+{
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    fwrite(n, sizeof(struct mtbddnode), 1, out);
+    sylvan_mt_write_binary(mtbddnode_gettype(n), mtbddnode_getvalue(n), out);
+}
+
+static int
+mtbdd_ser_read_leaf(FILE *in, uint64_t *index)
+{
+    struct mtbddnode n;
+    if (fread(&n, sizeof(struct mtbddnode), 1, in) != 1 || !mtbddnode_isleaf(&n)) return -1;
+    const uint32_t type = mtbddnode_gettype(&n);
+    uint64_t value = mtbddnode_getvalue(&n);
+    if (sylvan_mt_read_binary(type, &value, in) != 0) return -1;
+    *index = mtbdd_makeleaf(type, value);
+    return 0;
+}
+
+static const sylvan_ser_ops_t mtbdd_ser_ops = {
+    1, // 0 is mtbdd_false
+    mtbdd_ser_children,
+    mtbdd_ser_encode,
+    mtbdd_ser_to_record,
+    mtbdd_reader_children,
+    mtbdd_reader_node,
+    mtbdd_ser_write_leaf,
+    mtbdd_ser_read_leaf,
+};
+
+mtbdd_stream_t
+mtbdd_stream_alloc()
+{
+    return sylvan_ser_alloc(&mtbdd_ser_ops);
+}
+
+void
+mtbdd_stream_free(mtbdd_stream_t s)
+{
+    sylvan_ser_free(s);
+}
+
+void
+mtbdd_stream_write_begin(mtbdd_stream_t s, FILE *out)
+{
+    sylvan_ser_write_begin(s, out);
+}
+
+TASK_IMPL_3(uint64_t, mtbdd_stream_write_push, mtbdd_stream_t, s, FILE*, out, MTBDD, dd)
+{
+    const uint64_t key = MTBDD_TRANSFERMARK(dd, CALL(sylvan_ser_add, s, MTBDD_STRIPMARK(dd)));
+    CALL(sylvan_ser_write_push, s, out, key);
+    return key;
+}
+
+VOID_TASK_IMPL_2(mtbdd_stream_write_end, mtbdd_stream_t, s, FILE*, out)
+{
+    CALL(sylvan_ser_write_end, s, out);
+}
+
+int
+mtbdd_stream_read_begin(mtbdd_stream_t s, FILE *in)
+{
+    return sylvan_ser_read_begin(s, in);
+}
+
+TASK_IMPL_3(int, mtbdd_stream_read_next, mtbdd_stream_t, s, FILE*, in, MTBDD*, dd)
+{
+    uint64_t key;
+    const int res = CALL(sylvan_ser_read_next, s, in, &key);
+    if (res == 1) *dd = MTBDD_TRANSFERMARK(key, sylvan_ser_get_reversed(s, MTBDD_STRIPMARK(key)));
+    return res;
+}
+
 /**
  * Implementation of variable sets, i.e., cubes of (positive) variables.
  */
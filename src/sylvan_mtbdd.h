@@ -222,9 +222,42 @@ MTBDD mtbdd_int64(int64_t value);
 
 /**
  * Create a Real leaf with the given value.
+ * The value is rounded first if a rounding mode is set with mtbdd_set_double_rounding.
  */
 MTBDD mtbdd_double(double value);
 
+/**
+ * Rounding modes for tolerance-based merging of Real leaves.
+ * MTBDD_ROUND_NONE: keep the exact value (default).
+ * MTBDD_ROUND_ABS: round to the nearest multiple of epsilon.
+ * MTBDD_ROUND_REL: round to a relative precision of epsilon, by rounding the mantissa.
+ */
+typedef enum {
+    MTBDD_ROUND_NONE,
+    MTBDD_ROUND_ABS,
+    MTBDD_ROUND_REL,
+} mtbdd_round_mode;
+
+/**
+ * Round <value> according to <mode> and <epsilon>.
+ * Finite values stay finite: if rounding would overflow (near DBL_MAX), <value> is returned.
+ */
+double mtbdd_round_double(double value, mtbdd_round_mode mode, double epsilon);
+
+/**
+ * Set the rounding mode for all Real leaves created by mtbdd_double.
+ * Values that are equal after rounding share the same leaf, which restores sharing
+ * in MTBDDs obtained by numerical iteration.
+ * This clears the operation cache, so do not call this while operations are running.
+ * The mode is global; to round only the leaves of one MTBDD, use mtbdd_round instead.
+ */
+void mtbdd_set_double_rounding(mtbdd_round_mode mode, double epsilon);
+
+/**
+ * Obtain the current rounding mode for Real leaves.
+ */
+void mtbdd_get_double_rounding(mtbdd_round_mode *mode, double *epsilon);
+
 /**
  * Create a Fraction leaf with the given numerator and denominator.
  */
@@ -547,6 +580,28 @@ TASK_DECL_3(MTBDD, mtbdd_abstract_op_max, MTBDD, MTBDD, int);
  */
 #define mtbdd_abstract_max(dd, v) mtbdd_abstract(dd, v, TASK(mtbdd_abstract_op_max))
 
+/**
+ * A schedule for mtbdd_abstract_multi is an MTBDDMAP that maps each variable to its
+ * abstraction operator. Add <op> for variable <var> (or for each variable in the cube <vars>).
+ */
+MTBDDMAP mtbdd_schedule_add(MTBDDMAP schedule, uint32_t var, mtbdd_abstract_op op);
+MTBDDMAP mtbdd_schedule_add_set(MTBDDMAP schedule, MTBDD vars, mtbdd_abstract_op op);
+
+/**
+ * Get the operator of the first variable of a (nonempty) schedule.
+ */
+mtbdd_abstract_op mtbdd_schedule_op(MTBDDMAP schedule);
+
+/**
+ * Abstract the variables of <schedule> from <a>, each variable with its own operator.
+ * The operators are nested in the variable order: the operator of the first variable is applied
+ * last. For example, if the action variables come before the successor variables, then
+ * abstracting the actions with max and the successors with plus computes the maximum over
+ * actions of the sum over successors, in a single pass.
+ */
+TASK_DECL_2(MTBDD, mtbdd_abstract_multi, MTBDD, MTBDDMAP);
+#define mtbdd_abstract_multi(dd, schedule) RUN(mtbdd_abstract_multi, dd, schedule)
+
 /**
  * Compute IF <f> THEN <g> ELSE <h>.
  * <f> must be a Boolean MTBDD (or standard BDD).
@@ -568,6 +623,57 @@ TASK_DECL_3(MTBDD, mtbdd_and_abstract_plus, MTBDD, MTBDD, MTBDD);
 TASK_DECL_3(MTBDD, mtbdd_and_abstract_max, MTBDD, MTBDD, MTBDD);
 #define mtbdd_and_abstract_max(a, b, vars) RUN(mtbdd_and_abstract_max, a, b, vars)
 
+/**
+ * Apply <times> to <a> and <b>, and abstract variables <vars> using the operator <op>,
+ * in a single recursion. For example, with mtbdd_op_times and mtbdd_abstract_op_min.
+ */
+TASK_DECL_5(MTBDD, mtbdd_and_abstract_op, MTBDD, MTBDD, MTBDD, mtbdd_apply_op, mtbdd_abstract_op);
+#define mtbdd_and_abstract_op(a, b, vars, times, op) RUN(mtbdd_and_abstract_op, a, b, vars, times, op)
+#define mtbdd_and_abstract_min(a, b, vars) mtbdd_and_abstract_op(a, b, vars, TASK(mtbdd_op_times), TASK(mtbdd_abstract_op_min))
+
+/**
+ * Apply <times> to <a> and <b>, and abstract the variables of <schedule>, each with its own
+ * operator (see mtbdd_abstract_multi), in a single recursion.
+ */
+TASK_DECL_4(MTBDD, mtbdd_and_abstract_multi, MTBDD, MTBDD, MTBDDMAP, mtbdd_apply_op);
+#define mtbdd_and_abstract_multi(a, b, schedule, times) RUN(mtbdd_and_abstract_multi, a, b, schedule, times)
+
+/**
+ * Matrix-vector multiplication over the semiring given by <times> and <plus>.
+ * The matrix <M> is an MTBDD over the row variables and the column variables <cols>.
+ * The vector <x> is an MTBDD over the row variables <rows>; the i-th variable in <rows>
+ * is matched with the i-th variable in <cols>, so <rows> and <cols> must have equal length.
+ * Computes y(r) = plus_{c} times(M(r,c), x(c)); the result is a vector over the row variables.
+ * Recurses over both operands at the same time, so <x> never needs to be renamed.
+ * The callback <plus> is an abstraction callback (see mtbdd_abstract_op).
+ */
+TASK_DECL_6(MTBDD, mtbdd_matvec_op, MTBDD, MTBDD, MTBDD, MTBDD, mtbdd_apply_op, mtbdd_abstract_op);
+#define mtbdd_matvec_op(M, x, rows, cols, times, plus) RUN(mtbdd_matvec_op, M, x, rows, cols, times, plus)
+
+/**
+ * Matrix-matrix multiplication over the semiring given by <times> and <plus>.
+ * Computes C(r,c) = plus_{z} times(A(r,z), B(z,c)) where <vars> is the cube of variables z.
+ */
+TASK_DECL_5(MTBDD, mtbdd_matmul_op, MTBDD, MTBDD, MTBDD, mtbdd_apply_op, mtbdd_abstract_op);
+#define mtbdd_matmul_op(A, B, vars, times, plus) RUN(mtbdd_matmul_op, A, B, vars, times, plus)
+
+/**
+ * Matrix-vector multiplication for Integer, Double and Fraction MTBDDs.
+ */
+#define mtbdd_matvec(M, x, rows, cols) mtbdd_matvec_op(M, x, rows, cols, TASK(mtbdd_op_times), TASK(mtbdd_abstract_op_plus))
+
+/**
+ * Matrix-matrix multiplication for Integer, Double and Fraction MTBDDs.
+ */
+#define mtbdd_matmul(A, B, vars) mtbdd_matmul_op(A, B, vars, TASK(mtbdd_op_times), TASK(mtbdd_abstract_op_plus))
+
+/**
+ * Compute M*x + b in a single pass, for Integer, Double and Fraction MTBDDs.
+ * The matrix <M> and the vector <x> are as in mtbdd_matvec, the vector <b> is over the row variables.
+ */
+TASK_DECL_5(MTBDD, mtbdd_matvec_plus, MTBDD, MTBDD, MTBDD, MTBDD, MTBDD);
+#define mtbdd_matvec_plus(M, x, b, rows, cols) RUN(mtbdd_matvec_plus, M, x, b, rows, cols)
+
 /**
  * Monad that converts double to a Boolean MTBDD, translate terminals >= value to 1 and to 0 otherwise;
  */
@@ -590,9 +696,27 @@ TASK_DECL_2(MTBDD, mtbdd_threshold_double, MTBDD, double);
 TASK_DECL_2(MTBDD, mtbdd_strict_threshold_double, MTBDD, double);
 #define mtbdd_strict_threshold_double(dd, value) RUN(mtbdd_strict_threshold_double, dd, value)
 
+/**
+ * Monad that rounds Real leaves to the nearest multiple of the (double) parameter.
+ */
+TASK_DECL_2(MTBDD, mtbdd_op_round_abs, MTBDD, size_t);
+
+/**
+ * Monad that rounds Real leaves to the relative precision given by the (double) parameter.
+ */
+TASK_DECL_2(MTBDD, mtbdd_op_round_rel, MTBDD, size_t);
+
+/**
+ * Round all Real leaves of <dd> according to <mode> and <epsilon>, see mtbdd_round_double.
+ * Leaves that are equal after rounding are merged. Other leaves are unchanged.
+ */
+TASK_DECL_3(MTBDD, mtbdd_round, MTBDD, mtbdd_round_mode, double);
+#define mtbdd_round(dd, mode, epsilon) RUN(mtbdd_round, dd, mode, epsilon)
+
 /**
  * For two Double MTBDDs, calculate whether they are equal module some value epsilon
  * i.e. abs(a-b) < e
+ * Integer and Fraction leaves are compared by their value as a double.
  */
 TASK_DECL_3(MTBDD, mtbdd_equal_norm_d, MTBDD, MTBDD, double);
 #define mtbdd_equal_norm_d(a, b, epsilon) RUN(mtbdd_equal_norm_d, a, b, epsilon)
@@ -601,6 +725,7 @@ TASK_DECL_3(MTBDD, mtbdd_equal_norm_d, MTBDD, MTBDD, double);
  * For two Double MTBDDs, calculate whether they are equal modulo some value epsilon
  * This version computes the relative difference vs the value in a.
  * i.e. abs((a-b)/a) < e
+ * Integer and Fraction leaves are compared by their value as a double.
  */
 TASK_DECL_3(MTBDD, mtbdd_equal_norm_rel_d, MTBDD, MTBDD, double);
 #define mtbdd_equal_norm_rel_d(a, b, epsilon) RUN(mtbdd_equal_norm_rel_d, a, b, epsilon)
@@ -659,6 +784,28 @@ TASK_DECL_1(MTBDD, mtbdd_minimum, MTBDD);
 TASK_DECL_1(MTBDD, mtbdd_maximum, MTBDD);
 #define mtbdd_maximum(dd) RUN(mtbdd_maximum, dd)
 
+/**
+ * Find the <k> largest (if <largest>) or smallest distinct leaves of <dd> (for Integer, Double,
+ * Rational MTBDDs; paths to mtbdd_false are ignored, and mtbdd_true has the value 1). Writes the leaves to <leaves>, best first,
+ * and returns the number of leaves found, which is less than <k> if <dd> has fewer leaves.
+ * If <paths> is not NULL, then paths[i] is set to the BDD of all assignments that lead to leaves[i]
+ * if <all_paths> is nonzero, or to the cube of a single path to leaves[i] otherwise.
+ * Every next leaf is found by a parallel search that skips nodes using their cached minimum
+ * and maximum leaf, so <dd> is not enumerated.
+ */
+TASK_DECL_6(size_t, mtbdd_topk, MTBDD, size_t, int, MTBDD*, MTBDD*, int);
+#define mtbdd_topk(dd, k, largest, leaves, paths, all_paths) RUN(mtbdd_topk, dd, k, largest, leaves, paths, all_paths)
+
+/**
+ * Count the assignments to the variables in <vars> that <dd> maps to a leaf with a value in
+ * [<lo>, <hi>] (for Integer, Double, Rational MTBDDs; paths to mtbdd_false are not counted, and
+ * mtbdd_true has the value 1).
+ * The variables of <dd> must be in <vars>. Nodes whose cached minimum and maximum leaf are
+ * both inside or both outside the range are not searched further.
+ */
+TASK_DECL_4(double, mtbdd_range_count, MTBDD, MTBDD, double, double);
+#define mtbdd_range_count(dd, vars, lo, hi) RUN(mtbdd_range_count, dd, vars, lo, hi)
+
 /**
  * Given a MTBDD <dd> and a cube of variables <variables> expected in <dd>,
  * mtbdd_enum_first and mtbdd_enum_next enumerates the unique paths in <dd> that lead to a non-False leaf.
@@ -827,18 +974,20 @@ VOID_TASK_DECL_4(mtbdd_visit_par, MTBDD, mtbdd_visit_pre_cb, mtbdd_visit_post_cb
  * Every node that is to be written is assigned a number, starting from 1,
  * such that reading the result in the future can be done in one pass.
  *
- * We use a skiplist to store the assignment.
+ * Nodes are marked in parallel in a bitmap over the nodes table, and numbered in parallel:
+ * first the leaves, then the internal nodes by decreasing variable. Looking up the number of
+ * a node takes constant time, and the nodes are written in large blocks.
  *
  * The functions mtbdd_writer_tobinary and mtbdd_writer_totext can be used to
  * store an array of MTBDDs to binary format or text format.
  *
  * One could also do the procedure manually instead.
- * - call mtbdd_writer_start to allocate the skiplist.
- * - call mtbdd_writer_add to add a given MTBDD to the skiplist
+ * - call mtbdd_writer_start to allocate the writer.
+ * - call mtbdd_writer_add to add a given MTBDD to the writer
  * - call mtbdd_writer_writebinary to write all added nodes to a file
  * - OR:  mtbdd_writer_writetext to write all added nodes in text format
- * - call mtbdd_writer_get to obtain the MTBDD identifier as stored in the skiplist
- * - call mtbdd_writer_end to free the skiplist
+ * - call mtbdd_writer_get to obtain the MTBDD identifier as stored in the writer
+ * - call mtbdd_writer_end to free the writer
  */
 
 /**
@@ -869,36 +1018,36 @@ VOID_TASK_DECL_3(mtbdd_writer_totext, FILE *, MTBDD *, int);
 #define mtbdd_writer_totext(file, dds, count) RUN(mtbdd_writer_totext, file, dds, count)
 
 /**
- * Skeleton typedef for the skiplist
+ * Skeleton typedef for the writer
  */
-typedef struct sylvan_skiplist *sylvan_skiplist_t;
+typedef struct sylvan_writer *sylvan_writer_t;
 
 /**
- * Allocate a skiplist for writing an MTBDD.
+ * Allocate a writer for writing an MTBDD.
  */
-sylvan_skiplist_t mtbdd_writer_start(void);
+sylvan_writer_t mtbdd_writer_start(void);
 
 /**
- * Add the given MTBDD to the skiplist.
+ * Add the given MTBDD to the writer.
  */
-VOID_TASK_DECL_2(mtbdd_writer_add, sylvan_skiplist_t, MTBDD);
-#define mtbdd_writer_add(sl, dd) RUN(mtbdd_writer_add, sl, dd)
+VOID_TASK_DECL_2(mtbdd_writer_add, sylvan_writer_t, MTBDD);
+#define mtbdd_writer_add(w, dd) RUN(mtbdd_writer_add, w, dd)
 
 /**
  * Write all assigned MTBDD nodes in binary format to the file.
  */
-void mtbdd_writer_writebinary(FILE *out, sylvan_skiplist_t sl);
+void mtbdd_writer_writebinary(FILE *out, sylvan_writer_t w);
 
 /**
  * Retrieve the identifier of the given stored MTBDD.
  * This is useful if you want to be able to retrieve the stored MTBDD later.
  */
-uint64_t mtbdd_writer_get(sylvan_skiplist_t sl, MTBDD dd);
+uint64_t mtbdd_writer_get(sylvan_writer_t w, MTBDD dd);
 
 /**
- * Free the allocated skiplist.
+ * Free the allocated writer.
  */
-void mtbdd_writer_end(sylvan_skiplist_t sl);
+void mtbdd_writer_end(sylvan_writer_t w);
 
 /**
  * Reading MTBDDs from file.
@@ -924,6 +1073,7 @@ TASK_DECL_3(int, mtbdd_reader_frombinary, FILE*, MTBDD*, int);
  * Returns an array with the conversion from stored identifier to MTBDD
  * This array is allocated with malloc and must be freed afterwards.
  * Returns NULL if there was an error.
+ * The nodes are read in large blocks, and created in parallel, level by level.
  */
 
 TASK_DECL_1(uint64_t*, mtbdd_reader_readbinary, FILE*);
@@ -939,6 +1089,53 @@ MTBDD mtbdd_reader_get(uint64_t* arr, uint64_t identifier);
  */
 void mtbdd_reader_end(uint64_t *arr);
 
+/**
+ * Streams of MTBDDs, written to a pipe or socket and read without seeking, like the streams of
+ * BDD serializers (see sylvan_serializer_write_begin). A stream numbers the nodes of all pushed
+ * MTBDDs, and every push writes only the new nodes: first the new leaves with their custom data (see sylvan_mt_set_write_binary), then the
+ * other nodes in blocks, followed by the key of the MTBDD.
+ *
+ * WRITING: use mtbdd_stream_write_begin, then mtbdd_stream_write_push for every MTBDD (which
+ * flushes), then mtbdd_stream_write_end
+ * READING: use mtbdd_stream_read_begin, then mtbdd_stream_read_next until it returns 0; the nodes
+ * are created one block at a time as they arrive
+ *
+ * Numbered nodes are not garbage collected until the stream is read again or freed.
+ */
+typedef struct sylvan_ser *mtbdd_stream_t;
+
+mtbdd_stream_t mtbdd_stream_alloc(void);
+void mtbdd_stream_free(mtbdd_stream_t s);
+
+/**
+ * Start a stream. Nodes that already have a number are written with the first MTBDD.
+ */
+void mtbdd_stream_write_begin(mtbdd_stream_t s, FILE *out);
+
+/**
+ * Add a MTBDD to the stream. Returns its key.
+ */
+TASK_DECL_3(uint64_t, mtbdd_stream_write_push, mtbdd_stream_t, FILE*, MTBDD);
+#define mtbdd_stream_write_push(s, out, dd) RUN(mtbdd_stream_write_push, s, out, dd)
+
+/**
+ * End a stream.
+ */
+VOID_TASK_DECL_2(mtbdd_stream_write_end, mtbdd_stream_t, FILE*);
+#define mtbdd_stream_write_end(s, out) RUN(mtbdd_stream_write_end, s, out)
+
+/**
+ * Forget all numbers and start reading a stream. Returns 0, or -1 if it is not a stream.
+ */
+int mtbdd_stream_read_begin(mtbdd_stream_t s, FILE *in);
+
+/**
+ * Read the next MTBDD of a stream into <dd>.
+ * Returns 1, or 0 at the end of the stream, or -1 if the stream is invalid.
+ */
+TASK_DECL_3(int, mtbdd_stream_read_next, mtbdd_stream_t, FILE*, MTBDD*);
+#define mtbdd_stream_read_next(s, in, dd) RUN(mtbdd_stream_read_next, s, in, dd)
+
 /**
  * MTBDDMAP, maps uint32_t variables to MTBDDs.
  * A MTBDDMAP node has variable level, low edge going to the next MTBDDMAP, high edge to the mapped MTBDD.
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Do not include this file directly. Instead, include sylvan_int.h */
+
+#ifndef SYLVAN_REFS_INT_H
+#define SYLVAN_REFS_INT_H
+
+/**
+ * Internal references (spawn/sync, push/pop) of decision diagrams that are 64-bit values.
+ *
+ * SYLVAN_REFS_STACKS(prefix, DD, mark_rec) implements the reference stacks of one kind of
+ * decision diagrams: the functions prefix_refs_pushptr, prefix_refs_popptr, prefix_refs_push,
+ * prefix_refs_pop, prefix_refs_spawn and prefix_refs_sync (declared in the header of the
+ * module), and the Lace tasks prefix_refs_init, to call when the module is initialized, and
+ * prefix_refs_mark, to add with sylvan_gc_add_mark. During garbage collection, the referenced
+ * decision diagrams are marked with the task <mark_rec>.
+ *
+ * Every thread has its own three stacks: pointers to DD variables, DD values, and the Lace tasks
+ * (that return a DD) that were spawned. Stolen tasks that have completed are marked.
+ */
+#define SYLVAN_REFS_STACKS(prefix, DD, mark_rec) \
+typedef struct prefix##_refs_task \
+{ \
+    Task *t; \
+    void *f; \
+} *prefix##_refs_task_t; \
+\
+typedef struct prefix##_refs_internal \
+{ \
+    DD **pbegin, **pend, **pcur; \
+    DD *rbegin, *rend, *rcur; \
+    prefix##_refs_task_t sbegin, send, scur; \
+} *prefix##_refs_internal_t; \
+\
+DECLARE_THREAD_LOCAL(prefix##_refs_key, prefix##_refs_internal_t); \
+\
+VOID_TASK_2(prefix##_refs_mark_p_par, DD**, begin, size_t, count) \
+{ \
+    if (count < 32) { \
+        while (count) { \
+            CALL(mark_rec, **(begin++)); \
+            count--; \
+        } \
+    } else { \
+        SPAWN(prefix##_refs_mark_p_par, begin, count / 2); \
+        CALL(prefix##_refs_mark_p_par, begin + (count / 2), count - count / 2); \
+        SYNC(prefix##_refs_mark_p_par); \
+    } \
+} \
+\
+VOID_TASK_2(prefix##_refs_mark_r_par, DD*, begin, size_t, count) \
+{ \
+    if (count < 32) { \
+        while (count) { \
+            CALL(mark_rec, *begin++); \
+            count--; \
+        } \
+    } else { \
+        SPAWN(prefix##_refs_mark_r_par, begin, count / 2); \
+        CALL(prefix##_refs_mark_r_par, begin + (count / 2), count - count / 2); \
+        SYNC(prefix##_refs_mark_r_par); \
+    } \
+} \
+\
+VOID_TASK_2(prefix##_refs_mark_s_par, prefix##_refs_task_t, begin, size_t, count) \
+{ \
+    if (count < 32) { \
+        while (count) { \
+            Task *t = begin->t; \
+            if (!TASK_IS_STOLEN(t)) return; \
+            if (t->f == begin->f && TASK_IS_COMPLETED(t)) { \
+                CALL(mark_rec, *(DD*)TASK_RESULT(t)); \
+            } \
+            begin += 1; \
+            count -= 1; \
+        } \
+    } else { \
+        if (!TASK_IS_STOLEN(begin->t)) return; \
+        SPAWN(prefix##_refs_mark_s_par, begin, count / 2); \
+        CALL(prefix##_refs_mark_s_par, begin + (count / 2), count - count / 2); \
+        SYNC(prefix##_refs_mark_s_par); \
+    } \
+} \
+\
+VOID_TASK_0(prefix##_refs_mark_task) \
+{ \
+    LOCALIZE_THREAD_LOCAL(prefix##_refs_key, prefix##_refs_internal_t); \
+    SPAWN(prefix##_refs_mark_p_par, prefix##_refs_key->pbegin, prefix##_refs_key->pcur-prefix##_refs_key->pbegin); \
+    SPAWN(prefix##_refs_mark_r_par, prefix##_refs_key->rbegin, prefix##_refs_key->rcur-prefix##_refs_key->rbegin); \
+    CALL(prefix##_refs_mark_s_par, prefix##_refs_key->sbegin, prefix##_refs_key->scur-prefix##_refs_key->sbegin); \
+    SYNC(prefix##_refs_mark_r_par); \
+    SYNC(prefix##_refs_mark_p_par); \
+} \
+\
+VOID_TASK_0(prefix##_refs_mark) \
+{ \
+    TOGETHER(prefix##_refs_mark_task); \
+} \
+\
+VOID_TASK_0(prefix##_refs_init_task) \
+{ \
+    prefix##_refs_internal_t s = (prefix##_refs_internal_t)malloc(sizeof(struct prefix##_refs_internal)); \
+    s->pcur = s->pbegin = (DD**)malloc(sizeof(DD*) * 1024); \
+    s->pend = s->pbegin + 1024; \
+    s->rcur = s->rbegin = (DD*)malloc(sizeof(DD) * 1024); \
+    s->rend = s->rbegin + 1024; \
+    s->scur = s->sbegin = (prefix##_refs_task_t)malloc(sizeof(struct prefix##_refs_task) * 1024); \
+    s->send = s->sbegin + 1024; \
+    SET_THREAD_LOCAL(prefix##_refs_key, s); \
+} \
+\
+VOID_TASK_0(prefix##_refs_init) \
+{ \
+    INIT_THREAD_LOCAL(prefix##_refs_key); \
+    TOGETHER(prefix##_refs_init_task); \
+} \
+\
+static void __attribute__((noinline)) \
+prefix##_refs_ptrs_up(prefix##_refs_internal_t prefix##_refs_key) \
+{ \
+    size_t size = prefix##_refs_key->pend - prefix##_refs_key->pbegin; \
+    prefix##_refs_key->pbegin = (DD**)realloc(prefix##_refs_key->pbegin, sizeof(DD*) * size * 2); \
+    prefix##_refs_key->pcur = prefix##_refs_key->pbegin + size; \
+    prefix##_refs_key->pend = prefix##_refs_key->pbegin + (size * 2); \
+} \
+\
+static DD __attribute__((noinline)) \
+prefix##_refs_refs_up(prefix##_refs_internal_t prefix##_refs_key, DD res) \
+{ \
+    long size = prefix##_refs_key->rend - prefix##_refs_key->rbegin; \
+    prefix##_refs_key->rbegin = (DD*)realloc(prefix##_refs_key->rbegin, sizeof(DD) * size * 2); \
+    prefix##_refs_key->rcur = prefix##_refs_key->rbegin + size; \
+    prefix##_refs_key->rend = prefix##_refs_key->rbegin + (size * 2); \
+    return res; \
+} \
+\
+static void __attribute__((noinline)) \
+prefix##_refs_tasks_up(prefix##_refs_internal_t prefix##_refs_key) \
+{ \
+    long size = prefix##_refs_key->send - prefix##_refs_key->sbegin; \
+    prefix##_refs_key->sbegin = (prefix##_refs_task_t)realloc(prefix##_refs_key->sbegin, sizeof(struct prefix##_refs_task) * size * 2); \
+    prefix##_refs_key->scur = prefix##_refs_key->sbegin + size; \
+    prefix##_refs_key->send = prefix##_refs_key->sbegin + (size * 2); \
+} \
+\
+void \
+prefix##_refs_pushptr(DD *ptr) \
+{ \
+    LOCALIZE_THREAD_LOCAL(prefix##_refs_key, prefix##_refs_internal_t); \
+    *prefix##_refs_key->pcur++ = ptr; \
+    if (prefix##_refs_key->pcur == prefix##_refs_key->pend) prefix##_refs_ptrs_up(prefix##_refs_key); \
+} \
+\
+void \
+prefix##_refs_popptr(size_t amount) \
+{ \
+    LOCALIZE_THREAD_LOCAL(prefix##_refs_key, prefix##_refs_internal_t); \
+    prefix##_refs_key->pcur -= amount; \
+} \
+\
+DD \
+prefix##_refs_push(DD dd) \
+{ \
+    LOCALIZE_THREAD_LOCAL(prefix##_refs_key, prefix##_refs_internal_t); \
+    *(prefix##_refs_key->rcur++) = dd; \
+    if (prefix##_refs_key->rcur == prefix##_refs_key->rend) return prefix##_refs_refs_up(prefix##_refs_key, dd); \
+    else return dd; \
+} \
+\
+void \
+prefix##_refs_pop(long amount) \
+{ \
+    LOCALIZE_THREAD_LOCAL(prefix##_refs_key, prefix##_refs_internal_t); \
+    prefix##_refs_key->rcur -= amount; \
+} \
+\
+void \
+prefix##_refs_spawn(Task *t) \
+{ \
+    LOCALIZE_THREAD_LOCAL(prefix##_refs_key, prefix##_refs_internal_t); \
+    prefix##_refs_key->scur->t = t; \
+    prefix##_refs_key->scur->f = t->f; \
+    prefix##_refs_key->scur += 1; \
+    if (prefix##_refs_key->scur == prefix##_refs_key->send) prefix##_refs_tasks_up(prefix##_refs_key); \
+} \
+\
+DD \
+prefix##_refs_sync(DD result) \
+{ \
+    LOCALIZE_THREAD_LOCAL(prefix##_refs_key, prefix##_refs_internal_t); \
+    prefix##_refs_key->scur -= 1; \
+    return result; \
+}
+
+#endif
@@ -0,0 +1,772 @@
+/*
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+#include <sylvan_codec.h>
+#include <sylvan_writer.h>
+#include <sylvan_serializer.h>
+
+#include <string.h>
+
+/* Value of a bucket with a number; otherwise the value is the height, or 0 while unknown */
+#define SER_NUMBERED 0x8000000000000000ULL
+
+/* Initial number of buckets of the hash table */
+#define SER_INITIAL_SIZE 4096
+
+/* Node indexes are below 2^40; an entry of the array with higher bits is not indexed */
+#define SER_INDEX_MASK 0x000000ffffffffffULL
+
+/* Number of nodes handled sequentially by one task */
+#define SER_GRAIN 1024
+
+/* Number of records per block written to file */
+#define SER_BLOCK_NODES 65536
+
+struct sylvan_ser
+{
+    const sylvan_ser_ops_t *ops;
+    _Atomic(uint64_t) *table;   // per bucket: the index of a node (0 if empty) and its value
+    size_t table_size;          // number of buckets, a power of 2
+    _Atomic(size_t) table_count;
+    _Atomic(int) full;          // set when the table is too full to insert during sylvan_ser_add
+    uint64_t *pending;          // the new nodes of sylvan_ser_add, room for table_size
+    _Atomic(size_t) pending_count;
+    uint64_t *nodes;            // per number, the index of the node
+    size_t nodes_size;
+    uint64_t end;               // the next number
+    uint64_t done;              // the first number that is not yet in a file
+    struct sylvan_ser *prev, *next;
+};
+
+/**
+ * All allocated serializers, for garbage collection
+ */
+static pthread_mutex_t ser_lock = PTHREAD_MUTEX_INITIALIZER;
+static sylvan_ser_t ser_list = NULL;
+
+static inline size_t
+ser_limit(size_t table_size)
+{
+    return table_size / 4 * 3;
+}
+
+/**
+ * Find the bucket of <index>. If it is not in the table and <insert> is set, claim an empty
+ * bucket for it and set <insert> to 2. Returns a pointer to the value, or NULL if not found.
+ */
+static _Atomic(uint64_t)*
+ser_find(_Atomic(uint64_t) *table, size_t table_size, uint64_t index, int *insert)
+{
+    const size_t mask = table_size - 1;
+    size_t i = sylvan_fnvhash8(index, 14695981039346656037LLU) & mask;
+    for (;;) {
+        _Atomic(uint64_t) *bucket = table + 2*i;
+        uint64_t key = atomic_load_explicit(bucket, memory_order_acquire);
+        if (key == 0) {
+            if (insert == NULL || *insert == 0) return NULL;
+            if (atomic_compare_exchange_strong(bucket, &key, index)) {
+                *insert = 2;
+                return bucket + 1;
+            }
+        }
+        if (key == index) return bucket + 1;
+        i = (i + 1) & mask;
+    }
+}
+
+static void
+ser_alloc_table(sylvan_ser_t s, size_t table_size)
+{
+    s->table = calloc(2 * table_size, sizeof(uint64_t));
+    s->pending = malloc(sizeof(uint64_t) * table_size);
+    if (s->table == NULL || s->pending == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the serializer!\n", table_size*3*sizeof(uint64_t));
+        exit(1);
+    }
+    s->table_size = table_size;
+    s->table_count = 0;
+}
+
+static void
+ser_reserve_nodes(sylvan_ser_t s, size_t count)
+{
+    if (s->end + count <= s->nodes_size) return;
+    size_t size = s->nodes_size;
+    while (size < s->end + count) size *= 2;
+    s->nodes = realloc(s->nodes, sizeof(uint64_t) * size);
+    if (s->nodes == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the serializer!\n", size*sizeof(uint64_t));
+        exit(1);
+    }
+    s->nodes_size = size;
+}
+
+static void
+ser_init(sylvan_ser_t s)
+{
+    ser_alloc_table(s, SER_INITIAL_SIZE);
+    s->full = 0;
+    s->pending_count = 0;
+    s->nodes_size = SER_INITIAL_SIZE;
+    s->nodes = malloc(sizeof(uint64_t) * s->nodes_size);
+    if (s->nodes == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the serializer!\n", s->nodes_size*sizeof(uint64_t));
+        exit(1);
+    }
+    for (uint64_t i=0; i<s->ops->first; i++) s->nodes[i] = i;
+    s->end = s->ops->first;
+    s->done = s->ops->first;
+}
+
+static void
+ser_deinit(sylvan_ser_t s)
+{
+    free(s->table);
+    free(s->pending);
+    free(s->nodes);
+}
+
+sylvan_ser_t
+sylvan_ser_alloc(const sylvan_ser_ops_t *ops)
+{
+    sylvan_ser_t s = malloc(sizeof(struct sylvan_ser));
+    if (s == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the serializer!\n", sizeof(struct sylvan_ser));
+        exit(1);
+    }
+    s->ops = ops;
+    ser_init(s);
+
+    pthread_mutex_lock(&ser_lock);
+    s->prev = NULL;
+    s->next = ser_list;
+    if (ser_list != NULL) ser_list->prev = s;
+    ser_list = s;
+    pthread_mutex_unlock(&ser_lock);
+    return s;
+}
+
+void
+sylvan_ser_free(sylvan_ser_t s)
+{
+    pthread_mutex_lock(&ser_lock);
+    if (s->prev != NULL) s->prev->next = s->next;
+    else ser_list = s->next;
+    if (s->next != NULL) s->next->prev = s->prev;
+    pthread_mutex_unlock(&ser_lock);
+
+    ser_deinit(s);
+    free(s);
+}
+
+void
+sylvan_ser_reset(sylvan_ser_t s)
+{
+    ser_deinit(s);
+    ser_init(s);
+}
+
+uint64_t
+sylvan_ser_end(sylvan_ser_t s)
+{
+    return s->end;
+}
+
+uint64_t
+sylvan_ser_done(sylvan_ser_t s)
+{
+    return s->done;
+}
+
+uint64_t
+sylvan_ser_get(sylvan_ser_t s, uint64_t index)
+{
+    if (index < s->ops->first) return index;
+    _Atomic(uint64_t) *value = ser_find(s->table, s->table_size, index, NULL);
+    assert(value != NULL && (*value & SER_NUMBERED));
+    return value == NULL ? 0 : (*value & ~SER_NUMBERED);
+}
+
+uint64_t
+sylvan_ser_get_reversed(sylvan_ser_t s, uint64_t number)
+{
+    assert(number < s->end);
+    return s->nodes[number];
+}
+
+/**
+ * Move the buckets <first> ... <first>+<count>-1 of the old table to the new table.
+ */
+VOID_TASK_5(ser_rehash_par, _Atomic(uint64_t)*, old, size_t, first, size_t, count, _Atomic(uint64_t)*, table, size_t, table_size)
+{
+    if (count > SER_GRAIN) {
+        SPAWN(ser_rehash_par, old, first, count/2, table, table_size);
+        CALL(ser_rehash_par, old, first+count/2, count-count/2, table, table_size);
+        SYNC(ser_rehash_par);
+    } else {
+        for (size_t i=first; i<first+count; i++) {
+            const uint64_t key = atomic_load_explicit(old + 2*i, memory_order_relaxed);
+            if (key == 0) continue;
+            int insert = 1;
+            _Atomic(uint64_t) *value = ser_find(table, table_size, key, &insert);
+            atomic_store_explicit(value, atomic_load_explicit(old + 2*i + 1, memory_order_relaxed), memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Grow the hash table until <extra> more nodes fit.
+ */
+VOID_TASK_2(ser_grow, sylvan_ser_t, s, size_t, extra)
+{
+    size_t table_size = s->table_size;
+    while (s->table_count + extra >= ser_limit(table_size)) table_size *= 2;
+    if (table_size == s->table_size) return;
+
+    _Atomic(uint64_t) *old = s->table;
+    const size_t old_size = s->table_size;
+    uint64_t *pending = s->pending;
+    const size_t count = s->table_count;
+    ser_alloc_table(s, table_size);
+    CALL(ser_rehash_par, old, 0, old_size, s->table, table_size);
+    memcpy(s->pending, pending, sizeof(uint64_t) * s->pending_count);
+    s->table_count = count;
+    free(old);
+    free(pending);
+}
+
+/**
+ * Visit the nodes reachable from <index> that have no number yet, and compute their height.
+ * When the table is full, the visit is abandoned; the caller grows the table and visits again.
+ */
+TASK_2(uint64_t, ser_visit, sylvan_ser_t, s, uint64_t, index)
+{
+    if (index < s->ops->first) return 0;
+
+    _Atomic(uint64_t) *value = ser_find(s->table, s->table_size, index, NULL);
+    if (value == NULL) {
+        if (atomic_load_explicit(&s->full, memory_order_relaxed)) return 0;
+        if (atomic_load_explicit(&s->table_count, memory_order_relaxed) >= ser_limit(s->table_size)) {
+            atomic_store_explicit(&s->full, 1, memory_order_relaxed);
+            return 0;
+        }
+        int insert = 1;
+        value = ser_find(s->table, s->table_size, index, &insert);
+        if (insert == 2) {
+            atomic_fetch_add_explicit(&s->table_count, 1, memory_order_relaxed);
+            s->pending[atomic_fetch_add_explicit(&s->pending_count, 1, memory_order_relaxed)] = index;
+        }
+    }
+
+    const uint64_t v = atomic_load_explicit(value, memory_order_relaxed);
+    if (v & SER_NUMBERED) return 0;
+    if (v != 0) return v;
+
+    /* Another worker may be computing the same height; the result is the same */
+    uint64_t children[2], height = 1;
+    if (s->ops->children(index, children) != 0) {
+        SPAWN(ser_visit, s, children[1]);
+        height = CALL(ser_visit, s, children[0]);
+        const uint64_t height1 = SYNC(ser_visit);
+        if (height1 > height) height = height1;
+        height++;
+    }
+
+    if (!atomic_load_explicit(&s->full, memory_order_relaxed)) {
+        atomic_store_explicit(value, height, memory_order_relaxed);
+    }
+    return height;
+}
+
+typedef struct ser_entry
+{
+    sylvan_codec_node_t node;   // the node with the numbers of its children
+    uint64_t index;
+    int leaf;
+} ser_entry_t;
+
+static int
+ser_compare(const void *a, const void *b)
+{
+    const ser_entry_t *x = (const ser_entry_t*)a, *y = (const ser_entry_t*)b;
+    if (x->leaf != y->leaf) return x->leaf ? -1 : 1;
+    if (x->node.key != y->node.key) return x->node.key < y->node.key ? -1 : 1;
+    for (int i=0; i<2; i++) {
+        if (x->node.child[i] != y->node.child[i]) return x->node.child[i] < y->node.child[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Encode the nodes <order>[0] ... <order>[<count>-1] into <entries>.
+ */
+VOID_TASK_4(ser_encode_par, sylvan_ser_t, s, const uint64_t*, order, ser_entry_t*, entries, size_t, count)
+{
+    if (count > SER_GRAIN) {
+        SPAWN(ser_encode_par, s, order, entries, count/2);
+        CALL(ser_encode_par, s, order + count/2, entries + count/2, count - count/2);
+        SYNC(ser_encode_par);
+    } else {
+        for (size_t i=0; i<count; i++) {
+            uint64_t children[2];
+            s->ops->encode(s, order[i], &entries[i].node);
+            entries[i].index = order[i];
+            entries[i].leaf = s->ops->write_leaf != NULL && s->ops->children(order[i], children) == 0;
+        }
+    }
+}
+
+/**
+ * Give the nodes in <entries> the numbers <number> ... in the table and the array.
+ */
+VOID_TASK_4(ser_number_par, sylvan_ser_t, s, const ser_entry_t*, entries, uint64_t, number, size_t, count)
+{
+    if (count > SER_GRAIN) {
+        SPAWN(ser_number_par, s, entries, number, count/2);
+        CALL(ser_number_par, s, entries + count/2, number + count/2, count - count/2);
+        SYNC(ser_number_par);
+    } else {
+        for (size_t i=0; i<count; i++) {
+            _Atomic(uint64_t) *value = ser_find(s->table, s->table_size, entries[i].index, NULL);
+            atomic_store_explicit(value, (number + i) | SER_NUMBERED, memory_order_relaxed);
+            s->nodes[number + i] = entries[i].index;
+        }
+    }
+}
+
+/**
+ * Number the pending nodes by increasing height. Nodes of the same height are numbered after
+ * their children, in the order of their encoding (key, then the numbers of the children), so
+ * nodes with the same key are consecutive and the numbering does not depend on node indexes.
+ * Leaves come first.
+ */
+VOID_TASK_1(ser_number, sylvan_ser_t, s)
+{
+    const size_t count = s->pending_count;
+    if (count == 0) return;
+
+    /* Counting sort by height; heights are at most the number of new nodes */
+    uint64_t *base = calloc(count + 2, sizeof(uint64_t));
+    uint64_t *heights = malloc(sizeof(uint64_t) * count);
+    if (base == NULL || heights == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the serializer!\n", (2*count+2)*sizeof(uint64_t));
+        exit(1);
+    }
+    uint64_t maxheight = 0;
+    for (size_t i=0; i<count; i++) {
+        const uint64_t h = *ser_find(s->table, s->table_size, s->pending[i], NULL);
+        assert(h > 0 && h <= count);
+        heights[i] = h;
+        base[h]++;
+        if (h > maxheight) maxheight = h;
+    }
+    uint64_t total = 0;
+    for (uint64_t h=1; h<=maxheight+1; h++) {
+        const uint64_t c = base[h];
+        base[h] = total;
+        total += c;
+    }
+    uint64_t *order = malloc(sizeof(uint64_t) * count);
+    if (order == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the serializer!\n", count*sizeof(uint64_t));
+        exit(1);
+    }
+    for (size_t i=0; i<count; i++) order[base[heights[i]]++] = s->pending[i];
+    free(heights);
+
+    /* base[h] is now the end of height h, that is, the start of height h+1 */
+    ser_reserve_nodes(s, count);
+    ser_entry_t *entries = malloc(sizeof(ser_entry_t) * count);
+    if (entries == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the serializer!\n", count*sizeof(ser_entry_t));
+        exit(1);
+    }
+    uint64_t first = 0;
+    for (uint64_t h=1; h<=maxheight; h++) {
+        const size_t n = base[h] - first;
+        CALL(ser_encode_par, s, order + first, entries, n);
+        if (n > 1) qsort(entries, n, sizeof(ser_entry_t), ser_compare);
+        CALL(ser_number_par, s, entries, s->end + first, n);
+        first = base[h];
+    }
+    s->end += count;
+    s->pending_count = 0;
+
+    free(entries);
+    free(order);
+    free(base);
+}
+
+TASK_IMPL_2(uint64_t, sylvan_ser_add, sylvan_ser_t, s, uint64_t, index)
+{
+    if (index < s->ops->first) return index;
+    for (;;) {
+        CALL(ser_visit, s, index);
+        if (!s->full) break;
+        s->full = 0;
+        CALL(ser_grow, s, s->table_size / 2);
+    }
+    CALL(ser_number, s);
+    return sylvan_ser_get(s, index);
+}
+
+/**
+ * Writing and reading files
+ */
+
+static void
+ser_codec_get(void *ctx, uint64_t number, sylvan_codec_node_t *node)
+{
+    sylvan_ser_t s = (sylvan_ser_t)ctx;
+    s->ops->encode(s, s->nodes[number], node);
+}
+
+VOID_TASK_4(ser_fill_par, sylvan_ser_t, s, uint64_t*, buf, uint64_t, first, size_t, count)
+{
+    if (count > SER_GRAIN) {
+        SPAWN(ser_fill_par, s, buf, first, count/2);
+        CALL(ser_fill_par, s, buf + 2*(count/2), first + count/2, count - count/2);
+        SYNC(ser_fill_par);
+    } else {
+        for (size_t i=0; i<count; i++) {
+            sylvan_codec_node_t node;
+            s->ops->encode(s, s->nodes[first+i], &node);
+            s->ops->to_record(&node, buf + 2*i);
+        }
+    }
+}
+
+VOID_TASK_IMPL_2(sylvan_ser_tofile, sylvan_ser_t, s, FILE*, out)
+{
+    size_t count = s->end - s->done;
+    if (sylvan_codec_write_header(out) == 0) {
+        sylvan_codec_write_varint(out, count);
+        CALL(sylvan_codec_write_nodes, out, s->done, count, s->ops->first, ser_codec_get, s);
+    } else {
+        fwrite(&count, sizeof(size_t), 1, out);
+
+        /* Write the current block while the next block is converted */
+        uint64_t *buf[2];
+        buf[0] = malloc(sizeof(uint64_t) * 2 * SER_BLOCK_NODES);
+        buf[1] = malloc(sizeof(uint64_t) * 2 * SER_BLOCK_NODES);
+        if (buf[0] == NULL || buf[1] == NULL) {
+            fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the serializer!\n", 4*SER_BLOCK_NODES*sizeof(uint64_t));
+            exit(1);
+        }
+        uint64_t first = s->done;
+        size_t n = count < SER_BLOCK_NODES ? count : SER_BLOCK_NODES;
+        CALL(ser_fill_par, s, buf[0], first, n);
+        int cur = 0;
+        while (n > 0) {
+            const uint64_t next_first = first + n;
+            size_t next_n = s->end - next_first;
+            if (next_n > SER_BLOCK_NODES) next_n = SER_BLOCK_NODES;
+            if (next_n > 0) SPAWN(ser_fill_par, s, buf[1-cur], next_first, next_n);
+            fwrite(buf[cur], sizeof(uint64_t) * 2, n, out);
+            if (next_n > 0) SYNC(ser_fill_par);
+            first = next_first;
+            n = next_n;
+            cur = 1 - cur;
+        }
+        free(buf[0]);
+        free(buf[1]);
+    }
+    s->done = s->end;
+}
+
+typedef struct ser_read
+{
+    sylvan_ser_t s;
+    uint64_t *recs;     // records of the section, the first at recs+2
+    uint64_t first;     // number of the first node of the section
+} ser_read_t;
+
+static void
+ser_codec_put(void *ctx, uint64_t number, const sylvan_codec_node_t *node)
+{
+    ser_read_t *r = (ser_read_t*)ctx;
+    r->s->ops->to_record(node, r->recs + 2*(number - r->first + 1));
+}
+
+/* The reader numbers the nodes of the section from 1; earlier nodes are like constants */
+static int
+ser_read_children(void *ctx, const uint64_t *rec, uint64_t *children)
+{
+    ser_read_t *r = (ser_read_t*)ctx;
+    r->s->ops->record_children(r->s, rec, children);
+    for (int i=0; i<2; i++) children[i] = children[i] < r->first ? 0 : children[i] - r->first + 1;
+    return 2;
+}
+
+static uint64_t
+ser_read_make(void *ctx, const uint64_t *rec, const uint64_t *arr)
+{
+    ser_read_t *r = (ser_read_t*)ctx;
+    (void)arr; // the nodes of the section are also in r->s->nodes
+    return r->s->ops->record_make(r->s, rec, r->s->nodes);
+}
+
+VOID_TASK_3(ser_index_par, sylvan_ser_t, s, uint64_t, first, size_t, count)
+{
+    if (count > SER_GRAIN) {
+        SPAWN(ser_index_par, s, first, count/2);
+        CALL(ser_index_par, s, first + count/2, count - count/2);
+        SYNC(ser_index_par);
+    } else {
+        for (uint64_t n=first; n<first+count; n++) {
+            /* a node that is already in the table keeps its first number */
+            if (s->nodes[n] < s->ops->first || (s->nodes[n] & ~SER_INDEX_MASK)) continue;
+            int insert = 1;
+            _Atomic(uint64_t) *value = ser_find(s->table, s->table_size, s->nodes[n], &insert);
+            if (insert == 2) {
+                atomic_store_explicit(value, n | SER_NUMBERED, memory_order_relaxed);
+                atomic_fetch_add_explicit(&s->table_count, 1, memory_order_relaxed);
+            }
+        }
+    }
+}
+
+/* Create the nodes of the records <recs>, numbering them after the existing nodes */
+TASK_3(int, ser_make, sylvan_ser_t, s, uint64_t*, recs, size_t, count)
+{
+    ser_read_t r = { s, recs, s->end };
+
+    /* The new part of the array is marked during garbage collection while it is filled */
+    ser_reserve_nodes(s, count);
+    memset(s->nodes + s->end, 0, sizeof(uint64_t) * count);
+    s->end += count;
+    int res = CALL(sylvan_reader_make_nodes, recs, count, s->nodes + r.first - 1, ser_read_children, ser_read_make, &r);
+    if (res == 0) {
+        CALL(ser_grow, s, count);
+        CALL(ser_index_par, s, r.first, count);
+        s->done = s->end;
+    } else {
+        s->end = r.first;
+    }
+    return res;
+}
+
+TASK_IMPL_2(int, sylvan_ser_fromfile, sylvan_ser_t, s, FILE*, in)
+{
+    uint64_t count;
+    const int compact = sylvan_codec_read_header(in, &count);
+    if (compact < 0 || (compact && sylvan_codec_read_varint(in, &count) != 0)) return -1;
+    if (count > llmsset_get_max_size(nodes)) return -1;
+
+    ser_read_t r = { s, malloc(sizeof(uint64_t) * 2 * (count + 1)), s->end };
+    if (r.recs == NULL) return -1;
+    int res;
+    if (compact) res = CALL(sylvan_codec_read_nodes, in, r.first, count, s->ops->first, ser_codec_put, &r);
+    else res = fread(r.recs + 2, sizeof(uint64_t) * 2, count, in) == count ? 0 : -1;
+    if (res == 0) res = CALL(ser_make, s, r.recs, count);
+
+    free(r.recs);
+    return res;
+}
+
+/**
+ * Streams
+ */
+
+void
+sylvan_ser_write_begin(sylvan_ser_t s, FILE *out)
+{
+    sylvan_codec_write_stream_header(out);
+    s->done = s->ops->first;
+}
+
+/* Write the nodes that are not yet in the stream, one record per run of leaves or other nodes */
+VOID_TASK_2(ser_write_nodes, sylvan_ser_t, s, FILE*, out)
+{
+    while (s->done < s->end) {
+        uint64_t end = s->end, children[2];
+        if (s->ops->write_leaf != NULL) {
+            end = s->done;
+            while (end < s->end && s->ops->children(s->nodes[end], children) == 0) end++;
+            if (end > s->done) {
+                sylvan_codec_write_varint(out, SYLVAN_CODEC_STREAM_LEAVES);
+                sylvan_codec_write_varint(out, end - s->done);
+                for (uint64_t n=s->done; n<end; n++) s->ops->write_leaf(s->nodes[n], out);
+                s->done = end;
+                continue;
+            }
+            while (end < s->end && s->ops->children(s->nodes[end], children) != 0) end++;
+        }
+        sylvan_codec_write_varint(out, SYLVAN_CODEC_STREAM_NODES);
+        sylvan_codec_write_varint(out, end - s->done);
+        CALL(sylvan_codec_write_nodes, out, s->done, end - s->done, s->ops->first, ser_codec_get, s);
+        s->done = end;
+    }
+}
+
+VOID_TASK_IMPL_3(sylvan_ser_write_push, sylvan_ser_t, s, FILE*, out, uint64_t, key)
+{
+    CALL(ser_write_nodes, s, out);
+    sylvan_codec_write_varint(out, SYLVAN_CODEC_STREAM_ROOT);
+    sylvan_codec_write_varint(out, key);
+    fflush(out);
+}
+
+VOID_TASK_IMPL_2(sylvan_ser_write_end, sylvan_ser_t, s, FILE*, out)
+{
+    CALL(ser_write_nodes, s, out);
+    sylvan_codec_write_varint(out, SYLVAN_CODEC_STREAM_END);
+    fflush(out);
+}
+
+int
+sylvan_ser_read_begin(sylvan_ser_t s, FILE *in)
+{
+    sylvan_ser_reset(s);
+    return sylvan_codec_read_stream_header(in);
+}
+
+/* One block of nodes, the number of leaves that follow, a root or the end of a stream */
+typedef struct ser_item
+{
+    uint64_t tag;
+    uint64_t value;     // the number of nodes in recs or of leaves, or the root
+    size_t remaining;   // the number of nodes of the record after this block
+    uint64_t *recs;
+} ser_item_t;
+
+/* Read the next item, where <first> is the number of its first node */
+TASK_5(int, ser_read_item, sylvan_ser_t, s, FILE*, in, uint64_t, first, size_t, remaining, ser_item_t*, item)
+{
+    while (remaining == 0) {
+        if (sylvan_codec_read_varint(in, &item->tag) != 0) return -1;
+        if (item->tag != SYLVAN_CODEC_STREAM_END && sylvan_codec_read_varint(in, &item->value) != 0) return -1;
+        if (item->tag != SYLVAN_CODEC_STREAM_NODES && item->tag != SYLVAN_CODEC_STREAM_LEAVES) return 0;
+        if (item->value > llmsset_get_max_size(nodes)) return -1;
+        if (item->tag == SYLVAN_CODEC_STREAM_LEAVES) return 0;
+        remaining = item->value;
+    }
+
+    /* blocks of a record start at multiples of SYLVAN_CODEC_BLOCK_NODES */
+    const size_t count = remaining < SYLVAN_CODEC_BLOCK_NODES ? remaining : SYLVAN_CODEC_BLOCK_NODES;
+    ser_read_t r = { s, item->recs, first };
+    item->tag = SYLVAN_CODEC_STREAM_NODES;
+    item->value = count;
+    item->remaining = remaining - count;
+    return CALL(sylvan_codec_read_nodes, in, first, count, s->ops->first, ser_codec_put, &r);
+}
+
+/* Read and create <count> leaves, numbering them after the existing nodes */
+TASK_3(int, ser_read_leaves, sylvan_ser_t, s, FILE*, in, size_t, count)
+{
+    if (s->ops->read_leaf == NULL) return -1;
+
+    /* The new part of the array is marked during garbage collection while it is filled */
+    const uint64_t first = s->end;
+    ser_reserve_nodes(s, count);
+    memset(s->nodes + first, 0, sizeof(uint64_t) * count);
+    s->end += count;
+    for (size_t i=0; i<count; i++) {
+        if (s->ops->read_leaf(in, s->nodes + first + i) != 0) {
+            s->end = first;
+            return -1;
+        }
+    }
+    CALL(ser_grow, s, count);
+    CALL(ser_index_par, s, first, count);
+    s->done = s->end;
+    return 0;
+}
+
+TASK_IMPL_3(int, sylvan_ser_read_next, sylvan_ser_t, s, FILE*, in, uint64_t*, key)
+{
+    /* Read the next block while the nodes of the current block are created */
+    ser_item_t item[2];
+    item[0].recs = malloc(sizeof(uint64_t) * 2 * (SYLVAN_CODEC_BLOCK_NODES + 1));
+    item[1].recs = malloc(sizeof(uint64_t) * 2 * (SYLVAN_CODEC_BLOCK_NODES + 1));
+    int res = item[0].recs != NULL && item[1].recs != NULL ? 0 : -1;
+    if (res == 0) res = CALL(ser_read_item, s, in, s->end, 0, &item[0]);
+    int cur = 0;
+    while (res == 0 && (item[cur].tag == SYLVAN_CODEC_STREAM_NODES || item[cur].tag == SYLVAN_CODEC_STREAM_LEAVES)) {
+        if (item[cur].tag == SYLVAN_CODEC_STREAM_LEAVES) {
+            /* leaves are read in this task, as reading them also creates them */
+            res = CALL(ser_read_leaves, s, in, item[cur].value);
+            if (res == 0) res = CALL(ser_read_item, s, in, s->end, 0, &item[cur]);
+            continue;
+        }
+        const size_t count = item[cur].value;
+        SPAWN(ser_read_item, s, in, s->end + count, item[cur].remaining, &item[1-cur]);
+        res = CALL(ser_make, s, item[cur].recs, count);
+        const int next = SYNC(ser_read_item);
+        if (res == 0) res = next;
+        cur = 1 - cur;
+    }
+    free(item[0].recs);
+    free(item[1].recs);
+
+    if (res != 0) return -1;
+    if (item[cur].tag == SYLVAN_CODEC_STREAM_END) return 0;
+    if (item[cur].tag != SYLVAN_CODEC_STREAM_ROOT) return -1;
+    if ((item[cur].value & ~SYLVAN_CODEC_FLAG) >= s->end) return -1;
+    *key = item[cur].value;
+    return 1;
+}
+
+/**
+ * Garbage collection and initialization
+ */
+
+VOID_TASK_3(ser_mark_par, sylvan_ser_t, s, uint64_t, first, size_t, count)
+{
+    if (count > SER_GRAIN) {
+        SPAWN(ser_mark_par, s, first, count/2);
+        CALL(ser_mark_par, s, first + count/2, count - count/2);
+        SYNC(ser_mark_par);
+    } else {
+        for (uint64_t n=first; n<first+count; n++) {
+            const uint64_t index = s->nodes[n] & SER_INDEX_MASK;
+            if (index >= s->ops->first) llmsset_mark(nodes, index);
+        }
+    }
+}
+
+/* Every child of a numbered node is also numbered, so the nodes are marked without recursion */
+VOID_TASK_0(ser_gc_mark)
+{
+    pthread_mutex_lock(&ser_lock);
+    for (sylvan_ser_t s = ser_list; s != NULL; s = s->next) {
+        CALL(ser_mark_par, s, s->ops->first, s->end - s->ops->first);
+    }
+    pthread_mutex_unlock(&ser_lock);
+}
+
+static int ser_initialized = 0;
+
+/* The nodes of all serializers are gone after quitting */
+static void
+ser_quit()
+{
+    ser_initialized = 0;
+    pthread_mutex_lock(&ser_lock);
+    for (sylvan_ser_t s = ser_list; s != NULL; s = s->next) sylvan_ser_reset(s);
+    pthread_mutex_unlock(&ser_lock);
+}
+
+void
+sylvan_init_serializer()
+{
+    if (ser_initialized) return;
+    ser_initialized = 1;
+
+    sylvan_register_quit(ser_quit);
+    sylvan_gc_add_mark(TASK(ser_gc_mark));
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYLVAN_SERIALIZER_H
+#define SYLVAN_SERIALIZER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Serializers of the BDD and LDD modules (sylvan_serializer_t and lddmc_serializer_t), and the
+ * streams of the MTBDD and ZDD modules (mtbdd_stream_t and zdd_stream_t).
+ *
+ * A serializer assigns numbers to nodes, starting at ops->first; smaller numbers are the
+ * constants, which are their own numbers. Nodes are found by their index in a concurrent hash
+ * table, and the node of a number in an array. Adding a decision diagram visits its new nodes
+ * in parallel, computing their height (the longest path to a node that already had a number).
+ * The new nodes are then numbered by increasing height, so children always have lower numbers
+ * than their parents, and within a height by their encoding (key, then the numbers of the
+ * children), so the numbering does not depend on the scheduling or on the node indexes.
+ *
+ * Leaves (of MTBDDs) have height 1, and are numbered before the other nodes of height 1; leaves
+ * with custom data are ordered by their value, which may depend on the allocation of that data.
+ *
+ * Numbered nodes are kept alive during garbage collection. Different serializers can be used
+ * concurrently, but one serializer must be used by one thread (or task) at a time.
+ */
+
+typedef struct sylvan_ser *sylvan_ser_t;
+
+/**
+ * Operations on the nodes of one kind of decision diagram.
+ */
+typedef struct sylvan_ser_ops
+{
+    uint64_t first;     // number of the first node, and the first index that is not a constant
+
+    /**
+     * Given the index of a node, store the indexes of its children (without marks) in <children>
+     * and return 2, or return 0 for a leaf.
+     */
+    int (*children)(uint64_t index, uint64_t *children);
+
+    /**
+     * Encode the node with the given index, with its children replaced by their numbers.
+     */
+    void (*encode)(sylvan_ser_t s, uint64_t index, sylvan_codec_node_t *node);
+
+    /**
+     * Convert an encoded node to a record (2 words) in the raw file format.
+     */
+    void (*to_record)(const sylvan_codec_node_t *node, uint64_t *rec);
+
+    /**
+     * Given a record of the raw file format, store the numbers of its children (without marks)
+     * in <children> and return 2. The context is the serializer.
+     */
+    sylvan_reader_children_cb record_children;
+
+    /**
+     * Create the node of a record, where <arr> has the node of every smaller number.
+     * The context is the serializer.
+     */
+    sylvan_reader_node_cb record_make;
+
+    /**
+     * Write the leaf with the given index to a stream, and read a leaf from a stream and store
+     * its index in <index> (returns 0, or -1 on error). NULL if there are no leaves.
+     */
+    void (*write_leaf)(uint64_t index, FILE *out);
+    int (*read_leaf)(FILE *in, uint64_t *index);
+} sylvan_ser_ops_t;
+
+sylvan_ser_t sylvan_ser_alloc(const sylvan_ser_ops_t *ops);
+
+void sylvan_ser_free(sylvan_ser_t s);
+
+/**
+ * Forget all numbers.
+ */
+void sylvan_ser_reset(sylvan_ser_t s);
+
+/**
+ * Number all nodes reachable from the node with the given index (without marks).
+ * Returns the number of the node.
+ */
+TASK_DECL_2(uint64_t, sylvan_ser_add, sylvan_ser_t, uint64_t);
+
+/**
+ * Get the number of the node with the given index, which must have a number.
+ */
+uint64_t sylvan_ser_get(sylvan_ser_t s, uint64_t index);
+
+/**
+ * Get the index of the node with the given number, which must exist.
+ */
+uint64_t sylvan_ser_get_reversed(sylvan_ser_t s, uint64_t number);
+
+/**
+ * The number of the next node, and the number of the first node that is not yet in a file.
+ */
+uint64_t sylvan_ser_end(sylvan_ser_t s);
+uint64_t sylvan_ser_done(sylvan_ser_t s);
+
+/**
+ * Write the nodes that are not yet in a file, in the current file format.
+ */
+VOID_TASK_DECL_2(sylvan_ser_tofile, sylvan_ser_t, FILE*);
+
+/**
+ * Read a section written by sylvan_ser_tofile, numbering its nodes after the existing nodes.
+ * Returns 0, or -1 if the file is invalid.
+ */
+TASK_DECL_2(int, sylvan_ser_fromfile, sylvan_ser_t, FILE*);
+
+/**
+ * Start a stream on <out>; all numbered nodes are written with the next root.
+ */
+void sylvan_ser_write_begin(sylvan_ser_t s, FILE *out);
+
+/**
+ * Write the nodes that are not yet in the stream, then the root <key> (a number with a flag).
+ */
+VOID_TASK_DECL_3(sylvan_ser_write_push, sylvan_ser_t, FILE*, uint64_t);
+
+/**
+ * Write the nodes that are not yet in the stream, then the end of the stream.
+ */
+VOID_TASK_DECL_2(sylvan_ser_write_end, sylvan_ser_t, FILE*);
+
+/**
+ * Forget all numbers and read the header of a stream from <in>. Returns 0, or -1 on error.
+ */
+int sylvan_ser_read_begin(sylvan_ser_t s, FILE *in);
+
+/**
+ * Read the stream until the next root, creating the nodes one block at a time.
+ * Returns 1 and stores the root in <key>, 0 at the end of the stream, or -1 on error.
+ */
+TASK_DECL_3(int, sylvan_ser_read_next, sylvan_ser_t, FILE*, uint64_t*);
+
+/**
+ * Register the garbage collection hook; called by the BDD and LDD modules.
+ */
+void sylvan_init_serializer(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
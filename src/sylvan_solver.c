@@ -0,0 +1,173 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <time.h>
+
+/**
+ * Obtain the current (monotonic) time in seconds
+ */
+static double
+solver_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+void
+mtbdd_solver_info_init(mtbdd_solver_info *info, MTBDD rows, MTBDD cols)
+{
+    info->rows = rows;
+    info->cols = cols;
+    info->epsilon = 1e-6;
+    info->relative = 0;
+    info->max_iterations = 0;
+    info->callback = NULL;
+    info->iterations = 0;
+    info->converged = 0;
+    info->last_time = 0;
+    info->total_time = 0;
+}
+
+MTBDD
+mtbdd_identity(MTBDD rows, MTBDD cols)
+{
+    size_t n = mtbdd_set_count(rows);
+    assert(n == mtbdd_set_count(cols));
+
+    uint32_t r[n], c[n];
+    mtbdd_set_to_array(rows, r);
+    mtbdd_set_to_array(cols, c);
+
+    MTBDD result = mtbdd_true, eq = mtbdd_false;
+    mtbdd_refs_pushptr(&result);
+    mtbdd_refs_pushptr(&eq);
+    for (size_t i=n; i>0; i--) {
+        eq = sylvan_biimp(mtbdd_ithvar(r[i-1]), mtbdd_ithvar(c[i-1]));
+        result = sylvan_and(eq, result);
+    }
+    mtbdd_refs_popptr(2);
+    return result;
+}
+
+TASK_IMPL_3(MTBDD, mtbdd_diagonal, MTBDD, A, MTBDD, rows, MTBDD, cols)
+{
+    MTBDD id = mtbdd_refs_push(mtbdd_identity(rows, cols));
+    MTBDD result = CALL(mtbdd_and_abstract_plus, A, id, cols);
+    mtbdd_refs_pop(1);
+    return result;
+}
+
+/**
+ * Unary operation that gives mtbdd_true for Double and Fraction leaves that are zero.
+ */
+TASK_2(MTBDD, mtbdd_uop_is_zero, MTBDD, a, size_t, k)
+{
+    if (a == mtbdd_false) return mtbdd_false;
+    if (!mtbdd_isleaf(a)) return mtbdd_invalid;
+
+    if (mtbdd_gettype(a) == 1) return mtbdd_getdouble(a) == 0.0 ? mtbdd_true : mtbdd_false;
+    if (mtbdd_gettype(a) == 2) return mtbdd_getnumer(a) == 0 ? mtbdd_true : mtbdd_false;
+    return mtbdd_false;
+    (void)k; // unused variable
+}
+
+/**
+ * Unary operation 1/a for nonzero Double and Fraction leaves.
+ */
+TASK_2(MTBDD, mtbdd_uop_reciprocal, MTBDD, a, size_t, k)
+{
+    if (a == mtbdd_false) return mtbdd_false;
+    if (!mtbdd_isleaf(a)) return mtbdd_invalid;
+
+    if (mtbdd_gettype(a) == 1) {
+        assert(mtbdd_getdouble(a) != 0.0);
+        return mtbdd_double(1.0 / mtbdd_getdouble(a));
+    } else if (mtbdd_gettype(a) == 2) {
+        int64_t numer = mtbdd_getnumer(a);
+        uint64_t denom = mtbdd_getdenom(a);
+        assert(numer != 0);
+        return numer < 0 ? mtbdd_fraction(-(int64_t)denom, -numer) : mtbdd_fraction(denom, numer);
+    } else {
+        assert(0); // failure
+    }
+
+    return mtbdd_invalid;
+    (void)k; // unused variable
+}
+
+TASK_IMPL_4(MTBDD, mtbdd_solve_iterate, MTBDD, A, MTBDD, b, MTBDD, x, mtbdd_solver_info*, info)
+{
+    info->iterations = 0;
+    info->converged = 0;
+    info->last_time = 0;
+    info->total_time = 0;
+
+    MTBDD next = mtbdd_false;
+    mtbdd_refs_pushptr(&A);
+    mtbdd_refs_pushptr(&b);
+    mtbdd_refs_pushptr(&x);
+    mtbdd_refs_pushptr(&next);
+
+    while (info->max_iterations == 0 || info->iterations < info->max_iterations) {
+        double t = solver_time();
+        next = CALL(mtbdd_matvec_plus, A, x, b, info->rows, info->cols);
+        MTBDD eq;
+        if (info->relative) eq = CALL(mtbdd_equal_norm_rel_d, x, next, info->epsilon);
+        else eq = CALL(mtbdd_equal_norm_d, x, next, info->epsilon);
+        x = next;
+        info->last_time = solver_time() - t;
+        info->total_time += info->last_time;
+        info->iterations++;
+        if (info->callback != NULL) WRAP(info->callback, info, x);
+        if (eq == mtbdd_true) {
+            info->converged = 1;
+            break;
+        }
+    }
+
+    mtbdd_refs_popptr(4);
+    return x;
+}
+
+TASK_IMPL_4(MTBDD, mtbdd_solve_jacobi, MTBDD, A, MTBDD, b, MTBDD, x, mtbdd_solver_info*, info)
+{
+    /**
+     * Split A into diagonal D and off-diagonal O, then iterate x := -(O/D)*x + b/D
+     */
+    MTBDD id = mtbdd_refs_push(mtbdd_identity(info->rows, info->cols));
+    MTBDD diag = mtbdd_refs_push(CALL(mtbdd_and_abstract_plus, A, id, info->cols));
+    if (CALL(mtbdd_uapply, diag, TASK(mtbdd_uop_is_zero), 0) != mtbdd_false) {
+        // a zero on the diagonal, we cannot divide by it
+        mtbdd_refs_pop(2);
+        info->iterations = 0;
+        info->converged = 0;
+        info->last_time = 0;
+        info->total_time = 0;
+        return mtbdd_invalid;
+    }
+    MTBDD dinv = mtbdd_refs_push(CALL(mtbdd_uapply, diag, TASK(mtbdd_uop_reciprocal), 0));
+    MTBDD off = mtbdd_refs_push(mtbdd_times(A, sylvan_not(id)));
+    MTBDD N = mtbdd_refs_push(mtbdd_times(off, dinv));
+    N = mtbdd_refs_push(mtbdd_negate(N));
+    MTBDD c = mtbdd_refs_push(mtbdd_times(b, dinv));
+    MTBDD result = CALL(mtbdd_solve_iterate, N, c, x, info);
+    mtbdd_refs_pop(7);
+    return result;
+}
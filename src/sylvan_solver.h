@@ -0,0 +1,111 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Iterative numerical solvers on Double MTBDDs.
+ *
+ * Matrices are MTBDDs over row and column variables, vectors are MTBDDs over the row variables.
+ * The i-th row variable is matched with the i-th column variable (see mtbdd_matvec).
+ * Every iteration is a single mtbdd_matvec_plus, i.e., the multiplication and the addition
+ * of the constant vector are done in one pass over the decision diagrams.
+ * Convergence is checked with mtbdd_equal_norm_d or mtbdd_equal_norm_rel_d, which compare the
+ * values of Fraction leaves as doubles.
+ */
+
+/* Do not include this file directly. Instead, include sylvan.h */
+
+#ifndef SYLVAN_SOLVER_H
+#define SYLVAN_SOLVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct mtbdd_solver_info mtbdd_solver_info;
+
+/**
+ * Callback after every iteration, with the solver info and the current vector.
+ */
+LACE_TYPEDEF_CB(void, mtbdd_solver_cb, mtbdd_solver_info*, MTBDD);
+
+/**
+ * Parameters and statistics of the iterative solvers.
+ * Initialize with mtbdd_solver_info_init, then set the parameters.
+ * The solver writes the statistics.
+ */
+struct mtbdd_solver_info
+{
+    /* parameters */
+    MTBDD rows;                 // cube of row variables
+    MTBDD cols;                 // cube of column variables (same length as rows)
+    double epsilon;             // tolerance
+    int relative;               // if set, use the relative difference instead of the absolute difference
+    size_t max_iterations;      // maximum number of iterations, 0 for no limit
+    mtbdd_solver_cb callback;   // called after every iteration, or NULL
+    /* statistics */
+    size_t iterations;          // number of iterations performed
+    int converged;              // whether the tolerance was reached
+    double last_time;           // time of the last iteration (in seconds)
+    double total_time;          // time of all iterations (in seconds)
+};
+
+/**
+ * Initialize <info> for row variables <rows> and column variables <cols>,
+ * with tolerance 1e-6 (absolute) and no limit on the number of iterations.
+ */
+void mtbdd_solver_info_init(mtbdd_solver_info *info, MTBDD rows, MTBDD cols);
+
+/**
+ * Iterate x := A*x + b, starting from <x>, until two consecutive vectors are equal modulo
+ * the tolerance in <info>, or until the maximum number of iterations is reached.
+ * With b = mtbdd_false, this is the power method.
+ */
+TASK_DECL_4(MTBDD, mtbdd_solve_iterate, MTBDD, MTBDD, MTBDD, mtbdd_solver_info*);
+#define mtbdd_solve_iterate(A, b, x, info) RUN(mtbdd_solve_iterate, A, b, x, info)
+
+/**
+ * Power method, iterate x := A*x starting from <x>.
+ * For the stationary distribution of a Markov chain with transition matrix P, let <A> be
+ * the transpose of P, i.e., P with the roles of the row and the column variables swapped.
+ */
+#define mtbdd_solve_power(A, x, info) mtbdd_solve_iterate(A, mtbdd_false, x, info)
+
+/**
+ * Jacobi method, solve A*x = b starting from <x>, for Double and Fraction MTBDDs.
+ * The diagonal of <A> must be nonzero for every row; returns mtbdd_invalid (without any
+ * iterations) if a diagonal entry of <A> is zero.
+ */
+TASK_DECL_4(MTBDD, mtbdd_solve_jacobi, MTBDD, MTBDD, MTBDD, mtbdd_solver_info*);
+#define mtbdd_solve_jacobi(A, b, x, info) RUN(mtbdd_solve_jacobi, A, b, x, info)
+
+/**
+ * Compute the diagonal of matrix <A>, as a vector over the row variables.
+ */
+TASK_DECL_3(MTBDD, mtbdd_diagonal, MTBDD, MTBDD, MTBDD);
+#define mtbdd_diagonal(A, rows, cols) RUN(mtbdd_diagonal, A, rows, cols)
+
+/**
+ * Compute the identity relation between the row variables <rows> and the column variables <cols>,
+ * as a Boolean MTBDD.
+ */
+MTBDD mtbdd_identity(MTBDD rows, MTBDD cols);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
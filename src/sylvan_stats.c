@@ -46,6 +46,10 @@ struct
     {1, BDD_NODES_REUSED, "MTBDD nodes reused"},
     {1, LDD_NODES_CREATED, "LDD nodes created"},
     {1, LDD_NODES_REUSED, "LDD nodes reused"},
+    {1, LDD_INDEX_CREATED, "LDD level indexes created"},
+    {1, LDD_LEARN, "LDD learn steps"},
+    {1, EVBDD_NODES_CREATED, "EVBDD nodes created"},
+    {1, EVBDD_NODES_REUSED, "EVBDD nodes reused"},
     {1, LLMSSET_LOOKUP, "Lookup iterations"},
     {4, 0, NULL}, /* trigger to report unique nodes and operation cache */
 
@@ -85,6 +89,13 @@ struct
     {2, MTBDD_MINIMUM, "MTBDD minimum"},
     {2, MTBDD_MAXIMUM, "MTBDD maximum"},
     {2, MTBDD_EVAL_COMPOSE, "MTBDD eval_compose"},
+    {2, MTBDD_MATVEC, "MTBDD matvec"},
+    {2, MTBDD_MATVEC_PLUS, "MTBDD matvec_plus"},
+    {2, MTBDD_ABSTRACT_MULTI, "MTBDD abstract_multi"},
+    {2, MTBDD_AND_ABSTRACT_MULTI, "MTBDD and_abs_multi"},
+    {2, MTBDD_BOUND, "MTBDD bound"},
+    {2, MTBDD_TOPK, "MTBDD topk"},
+    {2, MTBDD_RANGE_COUNT, "MTBDD range_count"},
 
     {2, LDD_UNION, "LDD union"},
     {2, LDD_MINUS, "LDD minus"},
@@ -96,9 +107,18 @@ struct
     {2, LDD_MATCH, "LDD match"},
     {2, LDD_SATCOUNT, "LDD satcount"},
     {2, LDD_SATCOUNTL, "LDD satcountl"},
+    {2, LDD_SATCOUNT_EXACT, "LDD satcount_exact"},
+    {2, LDD_SATCOUNT_LOG2, "LDD satcount_log2"},
     {2, LDD_ZIP, "LDD zip"},
     {2, LDD_RELPROD_UNION, "LDD relprod_union"},
+    {2, LDD_RELPROD_MINUS, "LDD relprod_minus"},
+    {2, LDD_RELPROD_MULTI, "LDD relprod_multi"},
     {2, LDD_PROJECT_MINUS, "LDD project_minus"},
+    {2, LDD_LEARN_SAT, "LDD learn saturation"},
+    {2, LDD_TO_BDD, "LDD to BDD"},
+    {2, LDD_REL_TO_BDD, "LDD relation to BDD"},
+    {2, LDD_FROM_BDD, "LDD from BDD"},
+    {2, LDD_REL_FROM_BDD, "LDD relation from BDD"},
 
     {2, ZDD_FROM_MTBDD, "ZDD from_mtbdd"},
     {2, ZDD_TO_MTBDD, "ZDD to_mtbdd"},
@@ -115,6 +135,27 @@ struct
     {2, ZDD_PROJECT, "ZDD project" },
     {2, ZDD_ISOP, "zdd isop"},
     {2, ZDD_COVER_TO_BDD, "zdd cover_to_bdd"},
+    {2, ZDD_XOR, "ZDD xor" },
+    {2, ZDD_EQUIV, "ZDD equiv" },
+    {2, ZDD_IMP, "ZDD imp" },
+    {2, ZDD_FORALL, "ZDD forall" },
+    {2, ZDD_AND_EXISTS, "ZDD and_exists" },
+    {2, ZDD_AND_PROJECT, "ZDD and_project" },
+    {2, ZDD_COMPOSE, "ZDD compose" },
+    {2, ZDD_JOIN, "ZDD join" },
+    {2, ZDD_MEET, "ZDD meet" },
+    {2, ZDD_DELTA, "ZDD delta" },
+    {2, ZDD_QUOTIENT, "ZDD quotient" },
+    {2, ZDD_NONSUP, "ZDD nonsup" },
+    {2, ZDD_NONSUB, "ZDD nonsub" },
+    {2, ZDD_MINIMAL, "ZDD minimal" },
+    {2, ZDD_MAXIMAL, "ZDD maximal" },
+
+    {2, EVBDD_APPLY, "EVBDD apply"},
+    {2, EVBDD_ABSTRACT, "EVBDD abstract"},
+    {2, EVBDD_MINMAX, "EVBDD min/max"},
+    {2, EVBDD_FROM_MTBDD, "EVBDD from_mtbdd"},
+    {2, EVBDD_TO_MTBDD, "EVBDD to_mtbdd"},
 
     {0, 0, "Garbage collection"},
     {1, SYLVAN_GC_COUNT, "GC executions"},
@@ -32,8 +32,12 @@ typedef enum {
     BDD_NODES_REUSED,
     LDD_NODES_CREATED,
     LDD_NODES_REUSED,
+    LDD_INDEX_CREATED,
+    LDD_LEARN,
     ZDD_NODES_CREATED,
     ZDD_NODES_REUSED,
+    EVBDD_NODES_CREATED,
+    EVBDD_NODES_REUSED,
 
     /* BDD operations */
     OPCOUNTER(BDD_ITE),
@@ -72,6 +76,13 @@ typedef enum {
     OPCOUNTER(MTBDD_MINIMUM),
     OPCOUNTER(MTBDD_MAXIMUM),
     OPCOUNTER(MTBDD_EVAL_COMPOSE),
+    OPCOUNTER(MTBDD_MATVEC),
+    OPCOUNTER(MTBDD_MATVEC_PLUS),
+    OPCOUNTER(MTBDD_ABSTRACT_MULTI),
+    OPCOUNTER(MTBDD_AND_ABSTRACT_MULTI),
+    OPCOUNTER(MTBDD_BOUND),
+    OPCOUNTER(MTBDD_TOPK),
+    OPCOUNTER(MTBDD_RANGE_COUNT),
 
     /* LDD operations */
     OPCOUNTER(LDD_UNION),
@@ -84,9 +95,18 @@ typedef enum {
     OPCOUNTER(LDD_MATCH),
     OPCOUNTER(LDD_SATCOUNT),
     OPCOUNTER(LDD_SATCOUNTL),
+    OPCOUNTER(LDD_SATCOUNT_EXACT),
+    OPCOUNTER(LDD_SATCOUNT_LOG2),
     OPCOUNTER(LDD_ZIP),
     OPCOUNTER(LDD_RELPROD_UNION),
+    OPCOUNTER(LDD_RELPROD_MINUS),
+    OPCOUNTER(LDD_RELPROD_MULTI),
     OPCOUNTER(LDD_PROJECT_MINUS),
+    OPCOUNTER(LDD_LEARN_SAT),
+    OPCOUNTER(LDD_TO_BDD),
+    OPCOUNTER(LDD_REL_TO_BDD),
+    OPCOUNTER(LDD_FROM_BDD),
+    OPCOUNTER(LDD_REL_FROM_BDD),
 
     /* ZDD operations */
     OPCOUNTER(ZDD_FROM_MTBDD),
@@ -104,6 +124,28 @@ typedef enum {
     OPCOUNTER(ZDD_PROJECT),
     OPCOUNTER(ZDD_ISOP),
     OPCOUNTER(ZDD_COVER_TO_BDD),
+    OPCOUNTER(ZDD_XOR),
+    OPCOUNTER(ZDD_EQUIV),
+    OPCOUNTER(ZDD_IMP),
+    OPCOUNTER(ZDD_FORALL),
+    OPCOUNTER(ZDD_AND_EXISTS),
+    OPCOUNTER(ZDD_AND_PROJECT),
+    OPCOUNTER(ZDD_COMPOSE),
+    OPCOUNTER(ZDD_JOIN),
+    OPCOUNTER(ZDD_MEET),
+    OPCOUNTER(ZDD_DELTA),
+    OPCOUNTER(ZDD_QUOTIENT),
+    OPCOUNTER(ZDD_NONSUP),
+    OPCOUNTER(ZDD_NONSUB),
+    OPCOUNTER(ZDD_MINIMAL),
+    OPCOUNTER(ZDD_MAXIMAL),
+
+    /* EVBDD operations */
+    OPCOUNTER(EVBDD_APPLY),
+    OPCOUNTER(EVBDD_ABSTRACT),
+    OPCOUNTER(EVBDD_MINMAX),
+    OPCOUNTER(EVBDD_FROM_MTBDD),
+    OPCOUNTER(EVBDD_TO_MTBDD),
 
     /* Other counters */
     SYLVAN_GC_COUNT,
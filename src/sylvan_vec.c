@@ -0,0 +1,526 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+static int vec_initialized = 0;
+static size_t vec_n = 0;
+static uint32_t vec_dtype = 0;
+static uint32_t vec_itype = 0;
+
+/**
+ * Leaf payloads are arrays of vec_n 64-bit words (doubles or int64), allocated from the arena
+ * (16-byte aligned). Equal vectors have identical words, so hash and equals work on the words.
+ * Words are copied with memcpy, so doubles are never accessed through an integer pointer, and
+ * vectors of doubles store -0.0 as 0.0, so vectors that compare equal give the same leaf.
+ */
+
+static inline double
+vec_canon_d(double v)
+{
+    return v == 0.0 ? 0.0 : v; // -0.0 becomes 0.0
+}
+
+static inline int64_t
+vec_canon_i(int64_t v)
+{
+    return v;
+}
+
+#define VEC_LEAF_FUNCTIONS(t, T) \
+static inline uint64_t \
+vec_word_##t(const void *x, size_t i) \
+{ \
+    T v; \
+    memcpy(&v, (const char*)x + i*sizeof(T), sizeof(T)); \
+    v = vec_canon_##t(v); \
+    uint64_t w; \
+    memcpy(&w, &v, sizeof(T)); \
+    return w; \
+} \
+\
+static uint64_t \
+vec_hash_##t(const uint64_t v, const uint64_t seed) \
+{ \
+    const void *x = (const void*)(size_t)v; \
+    uint64_t hash = seed; \
+    for (size_t i=0; i<vec_n; i++) hash = sylvan_tabhash16(vec_word_##t(x, i), i, hash); \
+    return hash; \
+} \
+\
+static int \
+vec_equals_##t(const uint64_t left, const uint64_t right) \
+{ \
+    const void *x = (const void*)(size_t)left, *y = (const void*)(size_t)right; \
+    for (size_t i=0; i<vec_n; i++) if (vec_word_##t(x, i) != vec_word_##t(y, i)) return 0; \
+    return 1; \
+} \
+\
+static void \
+vec_create_##t(uint64_t *val) \
+{ \
+    T *x = (T*)sylvan_mt_arena_alloc(vec_##t##type); \
+    const char *src = (const char*)(size_t)*val; \
+    for (size_t i=0; i<vec_n; i++) { \
+        memcpy(&x[i], src + i*sizeof(T), sizeof(T)); \
+        x[i] = vec_canon_##t(x[i]); \
+    } \
+    *val = (uint64_t)(size_t)x; \
+}
+
+VEC_LEAF_FUNCTIONS(d, double)
+VEC_LEAF_FUNCTIONS(i, int64_t)
+
+static void
+vec_destroy_d(uint64_t val)
+{
+    sylvan_mt_arena_free(vec_dtype, (void*)(size_t)val);
+}
+
+static void
+vec_destroy_i(uint64_t val)
+{
+    sylvan_mt_arena_free(vec_itype, (void*)(size_t)val);
+}
+
+static inline double
+vec_get_d(const uint64_t *x, size_t i)
+{
+    double d;
+    memcpy(&d, &x[i], sizeof(double));
+    return d;
+}
+
+/**
+ * Write "(x1, x2, ...)" to <buf> if it fits, otherwise to a newly allocated string.
+ */
+static char*
+vec_to_str(int is_double, uint64_t val, char *buf, size_t buflen)
+{
+    const uint64_t *x = (const uint64_t*)(size_t)val;
+    size_t required = 3; // "(", ")" and the final 0
+    for (size_t i=0; i<vec_n; i++) {
+        if (is_double) required += (size_t)snprintf(NULL, 0, "%f", vec_get_d(x, i));
+        else required += (size_t)snprintf(NULL, 0, "%" PRId64, (int64_t)x[i]);
+        if (i != 0) required += 2;
+    }
+    char *ptr = buf;
+    if (buflen < required) {
+        ptr = (char*)malloc(required);
+        if (ptr == NULL) return NULL;
+    }
+    char *p = ptr;
+    *p++ = '(';
+    for (size_t i=0; i<vec_n; i++) {
+        if (i != 0) {
+            *p++ = ',';
+            *p++ = ' ';
+        }
+        if (is_double) p += sprintf(p, "%f", vec_get_d(x, i));
+        else p += sprintf(p, "%" PRId64, (int64_t)x[i]);
+    }
+    *p++ = ')';
+    *p = 0;
+    return ptr;
+}
+
+static char*
+vec_to_str_d(int comp, uint64_t val, char *buf, size_t buflen)
+{
+    return vec_to_str(1, val, buf, buflen);
+    (void)comp;
+}
+
+static char*
+vec_to_str_i(int comp, uint64_t val, char *buf, size_t buflen)
+{
+    return vec_to_str(0, val, buf, buflen);
+    (void)comp;
+}
+
+static int
+vec_write_binary(FILE* out, uint64_t val)
+{
+    if (fwrite((void*)(size_t)val, sizeof(uint64_t), vec_n, out) != vec_n) return -1;
+    return 0;
+}
+
+/**
+ * Read a vector into a buffer of the current thread; the value is this buffer, which the reader
+ * gives to mtbdd_makeleaf (create copies it to the arena) before the thread reads the next leaf.
+ * No leaf is made here, so garbage collection during the reader's mtbdd_makeleaf cannot free
+ * the value.
+ */
+static __thread uint64_t *vec_read_buf = NULL;
+static __thread size_t vec_read_buf_size = 0;
+
+static int
+vec_read_binary(FILE* in, uint64_t *val)
+{
+    if (vec_read_buf_size < vec_n) {
+        uint64_t *buf = (uint64_t*)realloc(vec_read_buf, sizeof(uint64_t) * vec_n);
+        if (buf == NULL) {
+            fprintf(stderr, "vec_read_binary: Unable to allocate memory!\n");
+            exit(1);
+        }
+        vec_read_buf = buf;
+        vec_read_buf_size = vec_n;
+    }
+    if (fread(vec_read_buf, sizeof(uint64_t), vec_n, in) != vec_n) return -1;
+    *val = (uint64_t)(size_t)vec_read_buf;
+    return 0;
+}
+
+static void
+vec_quit()
+{
+    vec_initialized = 0;
+}
+
+void
+sylvan_init_vec(size_t width)
+{
+    sylvan_init_mtbdd();
+
+    if (vec_initialized) {
+        assert(width == vec_n);
+        return;
+    }
+    vec_initialized = 1;
+
+    assert(width >= 1);
+    vec_n = width;
+
+    sylvan_register_quit(vec_quit);
+
+    vec_dtype = sylvan_mt_create_type();
+    sylvan_mt_set_hash(vec_dtype, vec_hash_d);
+    sylvan_mt_set_equals(vec_dtype, vec_equals_d);
+    sylvan_mt_set_create(vec_dtype, vec_create_d);
+    sylvan_mt_set_destroy(vec_dtype, vec_destroy_d);
+    sylvan_mt_set_to_str(vec_dtype, vec_to_str_d);
+    sylvan_mt_set_write_binary(vec_dtype, vec_write_binary);
+    sylvan_mt_set_read_binary(vec_dtype, vec_read_binary);
+    sylvan_mt_set_arena(vec_dtype, width * sizeof(uint64_t));
+
+    vec_itype = sylvan_mt_create_type();
+    sylvan_mt_set_hash(vec_itype, vec_hash_i);
+    sylvan_mt_set_equals(vec_itype, vec_equals_i);
+    sylvan_mt_set_create(vec_itype, vec_create_i);
+    sylvan_mt_set_destroy(vec_itype, vec_destroy_i);
+    sylvan_mt_set_to_str(vec_itype, vec_to_str_i);
+    sylvan_mt_set_write_binary(vec_itype, vec_write_binary);
+    sylvan_mt_set_read_binary(vec_itype, vec_read_binary);
+    sylvan_mt_set_arena(vec_itype, width * sizeof(uint64_t));
+}
+
+size_t
+vec_width()
+{
+    return vec_n;
+}
+
+uint32_t
+vec_double_type()
+{
+    return vec_dtype;
+}
+
+uint32_t
+vec_int64_type()
+{
+    return vec_itype;
+}
+
+MTBDD
+mtbdd_vec_double(const double *values)
+{
+    return mtbdd_makeleaf(vec_dtype, (size_t)values);
+}
+
+MTBDD
+mtbdd_vec_int64(const int64_t *values)
+{
+    return mtbdd_makeleaf(vec_itype, (size_t)values);
+}
+
+const double*
+mtbdd_getvec_double(MTBDD leaf)
+{
+    assert(mtbdd_isleaf(leaf) && mtbdd_gettype(leaf) == vec_dtype);
+    return (const double*)(size_t)mtbdd_getvalue(leaf);
+}
+
+const int64_t*
+mtbdd_getvec_int64(MTBDD leaf)
+{
+    assert(mtbdd_isleaf(leaf) && mtbdd_gettype(leaf) == vec_itype);
+    return (const int64_t*)(size_t)mtbdd_getvalue(leaf);
+}
+
+/**
+ * Componentwise kernels. Every kernel is a single loop without dependencies between the
+ * iterations, on arrays that do not overlap, so the compiler vectorizes it.
+ * Integer arithmetic wraps around (computed on uint64_t).
+ */
+
+#define VEC_KERNEL(name, type, expr) \
+static inline void \
+name(type *restrict r, const type *restrict a, const type *restrict b, size_t n) \
+{ \
+    for (size_t i=0; i<n; i++) r[i] = (expr); \
+}
+
+VEC_KERNEL(vec_plus_d, double, a[i] + b[i])
+VEC_KERNEL(vec_times_d, double, a[i] * b[i])
+VEC_KERNEL(vec_min_d, double, a[i] < b[i] ? a[i] : b[i])
+VEC_KERNEL(vec_max_d, double, a[i] > b[i] ? a[i] : b[i])
+VEC_KERNEL(vec_plus_i, int64_t, (int64_t)((uint64_t)a[i] + (uint64_t)b[i]))
+VEC_KERNEL(vec_times_i, int64_t, (int64_t)((uint64_t)a[i] * (uint64_t)b[i]))
+VEC_KERNEL(vec_min_i, int64_t, a[i] < b[i] ? a[i] : b[i])
+VEC_KERNEL(vec_max_i, int64_t, a[i] > b[i] ? a[i] : b[i])
+
+static inline void
+vec_scale_d(double *restrict r, const double *restrict a, double s, size_t n)
+{
+    for (size_t i=0; i<n; i++) r[i] = a[i] * s;
+}
+
+static inline void
+vec_scale_i(int64_t *restrict r, const int64_t *restrict a, int64_t s, size_t n)
+{
+    for (size_t i=0; i<n; i++) r[i] = (int64_t)((uint64_t)a[i] * (uint64_t)s);
+}
+
+/**
+ * Apply a componentwise kernel to two vector leaves of the same type.
+ */
+#define VEC_APPLY(a, b, kernel_d, kernel_i) do { \
+    uint32_t t = mtbdd_gettype(a); \
+    assert(mtbdd_gettype(b) == t && (t == vec_dtype || t == vec_itype)); \
+    if (t == vec_dtype) { \
+        double res[vec_n]; \
+        kernel_d(res, mtbdd_getvec_double(a), mtbdd_getvec_double(b), vec_n); \
+        return mtbdd_makeleaf(t, (size_t)res); \
+    } else { \
+        int64_t res[vec_n]; \
+        kernel_i(res, mtbdd_getvec_int64(a), mtbdd_getvec_int64(b), vec_n); \
+        return mtbdd_makeleaf(t, (size_t)res); \
+    } \
+} while (0)
+
+/**
+ * Operation "plus" for two vector MTBDDs
+ */
+TASK_IMPL_2(MTBDD, vec_op_plus, MTBDD*, pa, MTBDD*, pb)
+{
+    MTBDD a = *pa, b = *pb;
+
+    /* Check for partial functions */
+    if (a == mtbdd_false) return b;
+    if (b == mtbdd_false) return a;
+
+    /* If both leaves, compute plus */
+    if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) VEC_APPLY(a, b, vec_plus_d, vec_plus_i);
+
+    /* Commutative, so swap a,b for better cache performance */
+    if (a < b) {
+        *pa = b;
+        *pb = a;
+    }
+
+    return mtbdd_invalid;
+}
+
+/**
+ * Operation "times" for two vector MTBDDs, or a vector MTBDD and a Double/Integer MTBDD
+ */
+TASK_IMPL_2(MTBDD, vec_op_times, MTBDD*, pa, MTBDD*, pb)
+{
+    MTBDD a = *pa, b = *pb;
+
+    /* Check for partial functions and for Boolean (filter) */
+    if (a == mtbdd_false || b == mtbdd_false) return mtbdd_false;
+
+    /* If one of Boolean, interpret as filter */
+    if (a == mtbdd_true) return b;
+    if (b == mtbdd_true) return a;
+
+    /* Handle multiplication of leaves */
+    if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) {
+        uint32_t ta = mtbdd_gettype(a), tb = mtbdd_gettype(b);
+        if (ta == tb) VEC_APPLY(a, b, vec_times_d, vec_times_i);
+
+        /* Scale a vector by a scalar */
+        if (ta != vec_dtype && ta != vec_itype) {
+            MTBDD t = a;
+            a = b;
+            b = t;
+            ta = tb;
+            tb = mtbdd_gettype(b);
+        }
+        if (ta == vec_dtype) {
+            assert(tb == 1);
+            double res[vec_n];
+            vec_scale_d(res, mtbdd_getvec_double(a), mtbdd_getdouble(b), vec_n);
+            return mtbdd_makeleaf(ta, (size_t)res);
+        } else {
+            assert(ta == vec_itype && tb == 0);
+            int64_t res[vec_n];
+            vec_scale_i(res, mtbdd_getvec_int64(a), mtbdd_getint64(b), vec_n);
+            return mtbdd_makeleaf(ta, (size_t)res);
+        }
+    }
+
+    /* Commutative, so swap a,b for better cache performance */
+    if (a < b) {
+        *pa = b;
+        *pb = a;
+    }
+
+    return mtbdd_invalid;
+}
+
+/**
+ * Operation "min" for two vector MTBDDs
+ */
+TASK_IMPL_2(MTBDD, vec_op_min, MTBDD*, pa, MTBDD*, pb)
+{
+    MTBDD a = *pa, b = *pb;
+
+    /* Handle partial functions */
+    if (a == mtbdd_false) return b;
+    if (b == mtbdd_false) return a;
+
+    /* Handle trivial case */
+    if (a == b) return a;
+
+    /* Compute result for leaves */
+    if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) VEC_APPLY(a, b, vec_min_d, vec_min_i);
+
+    /* For cache performance */
+    if (a < b) {
+        *pa = b;
+        *pb = a;
+    }
+
+    return mtbdd_invalid;
+}
+
+/**
+ * Operation "max" for two vector MTBDDs
+ */
+TASK_IMPL_2(MTBDD, vec_op_max, MTBDD*, pa, MTBDD*, pb)
+{
+    MTBDD a = *pa, b = *pb;
+
+    /* Handle partial functions */
+    if (a == mtbdd_false) return b;
+    if (b == mtbdd_false) return a;
+
+    /* Handle trivial case */
+    if (a == b) return a;
+
+    /* Compute result for leaves */
+    if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) VEC_APPLY(a, b, vec_max_d, vec_max_i);
+
+    /* For cache performance */
+    if (a < b) {
+        *pa = b;
+        *pb = a;
+    }
+
+    return mtbdd_invalid;
+}
+
+/**
+ * Operation "component" for one vector MTBDD
+ */
+TASK_IMPL_2(MTBDD, vec_op_component, MTBDD, dd, size_t, k)
+{
+    /* Handle partial functions */
+    if (dd == mtbdd_false) return mtbdd_false;
+
+    /* Compute result for leaf */
+    if (mtbdd_isleaf(dd)) {
+        assert(k < vec_n);
+        if (mtbdd_gettype(dd) == vec_dtype) return mtbdd_double(mtbdd_getvec_double(dd)[k]);
+        assert(mtbdd_gettype(dd) == vec_itype);
+        return mtbdd_int64(mtbdd_getvec_int64(dd)[k]);
+    }
+
+    return mtbdd_invalid;
+}
+
+/**
+ * The abstraction operators are called in either of two ways:
+ * - with k=0, then just calculate "a op b"
+ * - with k<>0, then just calculate "a := a op a", k times
+ */
+
+TASK_IMPL_3(MTBDD, vec_abstract_op_plus, MTBDD, a, MTBDD, b, int, k)
+{
+    if (k==0) {
+        return mtbdd_apply(a, b, TASK(vec_op_plus));
+    } else {
+        MTBDD res = a;
+        for (int i=0; i<k; i++) {
+            mtbdd_refs_push(res);
+            res = mtbdd_apply(res, res, TASK(vec_op_plus));
+            mtbdd_refs_pop(1);
+        }
+        return res;
+    }
+}
+
+TASK_IMPL_3(MTBDD, vec_abstract_op_times, MTBDD, a, MTBDD, b, int, k)
+{
+    if (k==0) {
+        return mtbdd_apply(a, b, TASK(vec_op_times));
+    } else {
+        MTBDD res = a;
+        for (int i=0; i<k; i++) {
+            mtbdd_refs_push(res);
+            res = mtbdd_apply(res, res, TASK(vec_op_times));
+            mtbdd_refs_pop(1);
+        }
+        return res;
+    }
+}
+
+TASK_IMPL_3(MTBDD, vec_abstract_op_min, MTBDD, a, MTBDD, b, int, k)
+{
+    if (k == 0) {
+        return mtbdd_apply(a, b, TASK(vec_op_min));
+    } else {
+        // nothing to do: min(a, a) = a
+        return a;
+    }
+}
+
+TASK_IMPL_3(MTBDD, vec_abstract_op_max, MTBDD, a, MTBDD, b, int, k)
+{
+    if (k == 0) {
+        return mtbdd_apply(a, b, TASK(vec_op_max));
+    } else {
+        // nothing to do: max(a, a) = a
+        return a;
+    }
+}
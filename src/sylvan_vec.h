@@ -0,0 +1,153 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Vector-valued MTBDD leaves.
+ *
+ * A vector leaf holds a fixed number of doubles or of 64-bit integers, for example one value
+ * per reward structure, so a single mtbdd_apply computes an operation on all components.
+ * The width is the same for all vector leaves and is set with sylvan_init_vec.
+ * The leaf operations loop over the components in straight-line loops on aligned arrays,
+ * which the compiler turns into SIMD instructions.
+ */
+
+/* Do not include this file directly. Instead, include sylvan.h */
+
+#ifndef SYLVAN_VEC_H
+#define SYLVAN_VEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Initialize vector leaves with <width> components (at least 1).
+ * Registers the leaf types for vectors of doubles and vectors of int64.
+ */
+void sylvan_init_vec(size_t width);
+
+/**
+ * Get the number of components of vector leaves.
+ */
+size_t vec_width(void);
+
+/**
+ * Get the leaf types of vectors of doubles and vectors of int64.
+ */
+uint32_t vec_double_type(void);
+uint32_t vec_int64_type(void);
+
+/**
+ * Create a vector leaf from the array <values> of vec_width() components.
+ */
+MTBDD mtbdd_vec_double(const double *values);
+MTBDD mtbdd_vec_int64(const int64_t *values);
+
+/**
+ * Get the components of a vector leaf. The array belongs to the leaf and is valid while
+ * the leaf is not garbage collected.
+ */
+const double *mtbdd_getvec_double(MTBDD leaf);
+const int64_t *mtbdd_getvec_int64(MTBDD leaf);
+
+/**
+ * Operation "plus" for two vector MTBDDs (componentwise)
+ */
+TASK_DECL_2(MTBDD, vec_op_plus, MTBDD*, MTBDD*);
+TASK_DECL_3(MTBDD, vec_abstract_op_plus, MTBDD, MTBDD, int);
+
+/**
+ * Operation "times" for two vector MTBDDs (componentwise)
+ * One of the leaves may be a Double (resp. Integer) leaf, which then scales all components
+ * of the vector of doubles (resp. int64). For example, vec_matvec computes with a Double matrix.
+ */
+TASK_DECL_2(MTBDD, vec_op_times, MTBDD*, MTBDD*);
+TASK_DECL_3(MTBDD, vec_abstract_op_times, MTBDD, MTBDD, int);
+
+/**
+ * Operation "min" for two vector MTBDDs (componentwise)
+ */
+TASK_DECL_2(MTBDD, vec_op_min, MTBDD*, MTBDD*);
+TASK_DECL_3(MTBDD, vec_abstract_op_min, MTBDD, MTBDD, int);
+
+/**
+ * Operation "max" for two vector MTBDDs (componentwise)
+ */
+TASK_DECL_2(MTBDD, vec_op_max, MTBDD*, MTBDD*);
+TASK_DECL_3(MTBDD, vec_abstract_op_max, MTBDD, MTBDD, int);
+
+/**
+ * Operation "component" for one vector MTBDD: obtain component <k> as a Double
+ * or Integer MTBDD
+ */
+TASK_DECL_2(MTBDD, vec_op_component, MTBDD, size_t);
+
+/**
+ * Compute a + b
+ */
+#define vec_plus(a, b) mtbdd_apply(a, b, TASK(vec_op_plus))
+
+/**
+ * Compute a * b
+ */
+#define vec_times(a, b) mtbdd_apply(a, b, TASK(vec_op_times))
+
+/**
+ * Compute min(a, b)
+ */
+#define vec_min(a, b) mtbdd_apply(a, b, TASK(vec_op_min))
+
+/**
+ * Compute max(a, b)
+ */
+#define vec_max(a, b) mtbdd_apply(a, b, TASK(vec_op_max))
+
+/**
+ * Obtain the MTBDD of component <k>
+ */
+#define vec_component(dd, k) mtbdd_uapply(dd, TASK(vec_op_component), k)
+
+/**
+ * Abstract the variables in <v> from <a> by taking the sum of all values
+ */
+#define vec_abstract_plus(dd, v) mtbdd_abstract(dd, v, TASK(vec_abstract_op_plus))
+
+/**
+ * Abstract the variables in <v> from <a> by taking the product of all values
+ */
+#define vec_abstract_times(dd, v) mtbdd_abstract(dd, v, TASK(vec_abstract_op_times))
+
+/**
+ * Abstract the variables in <v> from <a> by taking the minimum of all values
+ */
+#define vec_abstract_min(dd, v) mtbdd_abstract(dd, v, TASK(vec_abstract_op_min))
+
+/**
+ * Abstract the variables in <v> from <a> by taking the maximum of all values
+ */
+#define vec_abstract_max(dd, v) mtbdd_abstract(dd, v, TASK(vec_abstract_op_max))
+
+/**
+ * Multiply matrix <M> and vector <x> (see mtbdd_matvec_op)
+ */
+#define vec_matvec(M, x, rows, cols) mtbdd_matvec_op(M, x, rows, cols, TASK(vec_op_times), TASK(vec_abstract_op_plus))
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
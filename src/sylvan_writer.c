@@ -0,0 +1,544 @@
+/*
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+#include <sylvan_align.h>
+#include <sylvan_writer.h>
+
+/* Number of bitmap words (of 64 buckets each) that are numbered by one task */
+#define WRITER_CHUNK_WORDS 4096
+
+/* Number of nodes per block written to file */
+#define WRITER_BLOCK_NODES 65536
+
+/* Number of nodes converted sequentially by one task when filling a block */
+#define WRITER_FILL_GRAIN 1024
+
+/* Number of nodes created sequentially by one task when reading */
+#define READER_MAKE_GRAIN 256
+
+typedef struct writer_run
+{
+    uint64_t first;   // number of the first node in the run
+    uint32_t var;     // variable of the nodes in the run
+    uint32_t count;   // number of nodes in the run
+} writer_run_t;
+
+typedef struct writer_chunk
+{
+    uint64_t *keys;     // (var << 40 | index) of the internal nodes, sorted; then the leaves
+    size_t nodecount;   // number of internal nodes
+    size_t leafcount;   // number of leaves, stored after the internal nodes
+    writer_run_t *runs; // runs of internal nodes with the same variable
+    size_t runcount;
+    uint64_t leaf_first; // number of the first leaf
+    uint64_t rank_base;  // number of marked nodes in earlier chunks
+} writer_chunk_t;
+
+struct sylvan_writer
+{
+    _Atomic(uint64_t) *bitmap;  // one bit per bucket of the nodes table
+    size_t bitmap_words;        // number of allocated words (for the maximum table size)
+    sylvan_writer_var_cb var_cb;
+    _Atomic(int) numbered;
+    size_t words;               // number of bitmap words covered by the numbering
+    uint64_t *rank;             // per bitmap word, the number of marked nodes in earlier words
+    uint64_t *numbers;          // per marked node (by rank), its number
+    uint64_t *order;            // per number, the index of the node
+    size_t count;
+    size_t leafcount;
+    writer_chunk_t *chunks;     // only during numbering
+};
+
+sylvan_writer_t
+sylvan_writer_alloc(sylvan_writer_var_cb var_cb)
+{
+    sylvan_writer_t w = malloc(sizeof(struct sylvan_writer));
+    if (w == NULL) {
+        fprintf(stderr, "sylvan_writer_alloc: Unable to allocate memory!\n");
+        exit(1);
+    }
+    w->bitmap_words = (llmsset_get_max_size(nodes) + 63) / 64;
+    w->bitmap = alloc_aligned(sizeof(uint64_t) * w->bitmap_words);
+    if (w->bitmap == 0) {
+        fprintf(stderr, "sylvan: Unable to allocate virtual memory (%'zu bytes) for the writer!\n", w->bitmap_words*sizeof(uint64_t));
+        exit(1);
+    }
+    w->var_cb = var_cb;
+    w->numbered = 0;
+    w->words = 0;
+    w->rank = NULL;
+    w->numbers = NULL;
+    w->order = NULL;
+    w->count = 0;
+    w->leafcount = 0;
+    w->chunks = NULL;
+    return w;
+}
+
+static void
+sylvan_writer_clear_numbering(sylvan_writer_t w)
+{
+    free(w->rank);
+    free(w->numbers);
+    free(w->order);
+    w->rank = NULL;
+    w->numbers = NULL;
+    w->order = NULL;
+    w->words = 0;
+    w->count = 0;
+    w->leafcount = 0;
+}
+
+void
+sylvan_writer_free(sylvan_writer_t w)
+{
+    sylvan_writer_clear_numbering(w);
+    free_aligned(w->bitmap, sizeof(uint64_t) * w->bitmap_words);
+    free(w);
+}
+
+int
+sylvan_writer_mark(sylvan_writer_t w, uint64_t index)
+{
+    _Atomic(uint64_t) *ptr = w->bitmap + index / 64;
+    const uint64_t bit = 1ULL << (index % 64);
+    if (atomic_load_explicit(ptr, memory_order_relaxed) & bit) return 0;
+    if (atomic_fetch_or_explicit(ptr, bit, memory_order_relaxed) & bit) return 0;
+    if (atomic_load_explicit(&w->numbered, memory_order_relaxed)) atomic_store(&w->numbered, 0);
+    return 1;
+}
+
+/**
+ * Stable radix sort of the keys on the variable (the upper 24 bits)
+ */
+static void
+writer_sort(uint64_t *keys, uint64_t *tmp, size_t count, uint32_t maxvar)
+{
+    uint64_t *src = keys, *dst = tmp;
+    for (int shift=40; shift<64 && (maxvar >> (shift-40)) != 0; shift+=8) {
+        size_t pos[257] = {0};
+        for (size_t i=0; i<count; i++) pos[((src[i] >> shift) & 0xff) + 1]++;
+        for (int b=0; b<256; b++) pos[b+1] += pos[b];
+        for (size_t i=0; i<count; i++) dst[pos[(src[i] >> shift) & 0xff]++] = src[i];
+        uint64_t *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != keys) memcpy(keys, src, sizeof(uint64_t) * count);
+}
+
+/**
+ * Collect and sort the marked nodes of chunk <c>, and compute the local rank of every word.
+ */
+static void
+writer_scan_chunk(sylvan_writer_t w, size_t c)
+{
+    writer_chunk_t *chunk = w->chunks + c;
+    const size_t first = c * WRITER_CHUNK_WORDS;
+    const size_t last = first + WRITER_CHUNK_WORDS < w->words ? first + WRITER_CHUNK_WORDS : w->words;
+
+    size_t total = 0;
+    for (size_t i=first; i<last; i++) {
+        w->rank[i] = total;
+        total += __builtin_popcountll(atomic_load_explicit(w->bitmap + i, memory_order_relaxed));
+    }
+
+    chunk->keys = NULL;
+    chunk->runs = NULL;
+    chunk->nodecount = 0;
+    chunk->leafcount = 0;
+    chunk->runcount = 0;
+    if (total == 0) return;
+
+    // internal nodes from the front, leaves from the back
+    uint64_t *keys = malloc(sizeof(uint64_t) * total);
+    if (keys == NULL) {
+        fprintf(stderr, "sylvan_writer_number: Unable to allocate memory!\n");
+        exit(1);
+    }
+    size_t n = 0, l = total;
+    uint32_t minvar = 0xffffffff, maxvar = 0;
+    for (size_t i=first; i<last; i++) {
+        uint64_t bits = atomic_load_explicit(w->bitmap + i, memory_order_relaxed);
+        while (bits) {
+            const uint64_t index = i * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            const uint32_t var = w->var_cb(index);
+            if (var == 0xffffffff) {
+                keys[--l] = index;
+            } else {
+                keys[n++] = ((uint64_t)var << 40) | index;
+                if (var < minvar) minvar = var;
+                if (var > maxvar) maxvar = var;
+            }
+        }
+    }
+
+    // put the leaves in increasing order
+    for (size_t i=l, j=total-1; i<j; i++, j--) {
+        uint64_t t = keys[i];
+        keys[i] = keys[j];
+        keys[j] = t;
+    }
+
+    if (n > 1 && minvar != maxvar) {
+        uint64_t *tmp = malloc(sizeof(uint64_t) * n);
+        if (tmp == NULL) {
+            fprintf(stderr, "sylvan_writer_number: Unable to allocate memory!\n");
+            exit(1);
+        }
+        writer_sort(keys, tmp, n, maxvar);
+        free(tmp);
+    }
+
+    size_t runcount = 0;
+    for (size_t i=0; i<n; i++) {
+        if (i == 0 || (keys[i] >> 40) != (keys[i-1] >> 40)) runcount++;
+    }
+    writer_run_t *runs = malloc(sizeof(writer_run_t) * (runcount > 0 ? runcount : 1));
+    if (runs == NULL) {
+        fprintf(stderr, "sylvan_writer_number: Unable to allocate memory!\n");
+        exit(1);
+    }
+    size_t r = 0;
+    for (size_t i=0; i<n; i++) {
+        if (i == 0 || (keys[i] >> 40) != (keys[i-1] >> 40)) {
+            runs[r].var = (uint32_t)(keys[i] >> 40);
+            runs[r].count = 0;
+            r++;
+        }
+        runs[r-1].count++;
+    }
+
+    chunk->keys = keys;
+    chunk->nodecount = n;
+    chunk->leafcount = total - n;
+    chunk->runs = runs;
+    chunk->runcount = runcount;
+}
+
+static inline uint64_t
+writer_rank(sylvan_writer_t w, uint64_t index)
+{
+    const uint64_t bits = atomic_load_explicit(w->bitmap + index / 64, memory_order_relaxed);
+    return w->rank[index / 64] + __builtin_popcountll(bits & ((1ULL << (index % 64)) - 1));
+}
+
+/**
+ * Assign the numbers of the marked nodes of chunk <c>.
+ */
+static void
+writer_assign_chunk(sylvan_writer_t w, size_t c)
+{
+    writer_chunk_t *chunk = w->chunks + c;
+    const size_t first = c * WRITER_CHUNK_WORDS;
+    const size_t last = first + WRITER_CHUNK_WORDS < w->words ? first + WRITER_CHUNK_WORDS : w->words;
+
+    for (size_t i=first; i<last; i++) w->rank[i] += chunk->rank_base;
+
+    if (chunk->keys == NULL) return;
+
+    for (size_t i=0; i<chunk->leafcount; i++) {
+        const uint64_t index = chunk->keys[chunk->nodecount + i];
+        const uint64_t number = chunk->leaf_first + i;
+        w->numbers[writer_rank(w, index)] = number;
+        w->order[number] = index;
+    }
+
+    const uint64_t *key = chunk->keys;
+    for (size_t r=0; r<chunk->runcount; r++) {
+        for (uint32_t i=0; i<chunk->runs[r].count; i++) {
+            const uint64_t index = *key++ & 0x000000ffffffffff;
+            const uint64_t number = chunk->runs[r].first + i;
+            w->numbers[writer_rank(w, index)] = number;
+            w->order[number] = index;
+        }
+    }
+
+    free(chunk->keys);
+    free(chunk->runs);
+}
+
+VOID_TASK_3(writer_scan_par, sylvan_writer_t, w, size_t, first, size_t, count)
+{
+    if (count == 1) {
+        writer_scan_chunk(w, first);
+    } else {
+        SPAWN(writer_scan_par, w, first, count/2);
+        CALL(writer_scan_par, w, first+count/2, count-count/2);
+        SYNC(writer_scan_par);
+    }
+}
+
+VOID_TASK_3(writer_assign_par, sylvan_writer_t, w, size_t, first, size_t, count)
+{
+    if (count == 1) {
+        writer_assign_chunk(w, first);
+    } else {
+        SPAWN(writer_assign_par, w, first, count/2);
+        CALL(writer_assign_par, w, first+count/2, count-count/2);
+        SYNC(writer_assign_par);
+    }
+}
+
+VOID_TASK_IMPL_1(sylvan_writer_number, sylvan_writer_t, w)
+{
+    if (atomic_load(&w->numbered)) return;
+
+    sylvan_writer_clear_numbering(w);
+
+    w->words = (llmsset_get_size(nodes) + 63) / 64;
+    if (w->words > w->bitmap_words) w->words = w->bitmap_words;
+    w->rank = malloc(sizeof(uint64_t) * (w->words > 0 ? w->words : 1));
+    if (w->rank == NULL) {
+        fprintf(stderr, "sylvan_writer_number: Unable to allocate memory!\n");
+        exit(1);
+    }
+
+    const size_t chunkcount = (w->words + WRITER_CHUNK_WORDS - 1) / WRITER_CHUNK_WORDS;
+    w->chunks = malloc(sizeof(writer_chunk_t) * (chunkcount > 0 ? chunkcount : 1));
+    if (w->chunks == NULL) {
+        fprintf(stderr, "sylvan_writer_number: Unable to allocate memory!\n");
+        exit(1);
+    }
+
+    /* Collect and sort the marked nodes of every chunk in parallel */
+    if (chunkcount > 0) CALL(writer_scan_par, w, 0, chunkcount);
+
+    /* Number the leaves first, and compute how many nodes each variable has */
+    uint64_t next = 1, rank_base = 0;
+    uint32_t maxvar = 0;
+    for (size_t c=0; c<chunkcount; c++) {
+        writer_chunk_t *chunk = w->chunks + c;
+        chunk->leaf_first = next;
+        next += chunk->leafcount;
+        chunk->rank_base = rank_base;
+        rank_base += chunk->nodecount + chunk->leafcount;
+        for (size_t r=0; r<chunk->runcount; r++) {
+            if (chunk->runs[r].var > maxvar) maxvar = chunk->runs[r].var;
+        }
+    }
+    w->leafcount = next - 1;
+
+    uint64_t *base = calloc((size_t)maxvar + 1, sizeof(uint64_t));
+    if (base == NULL) {
+        fprintf(stderr, "sylvan_writer_number: Unable to allocate memory!\n");
+        exit(1);
+    }
+    for (size_t c=0; c<chunkcount; c++) {
+        writer_chunk_t *chunk = w->chunks + c;
+        for (size_t r=0; r<chunk->runcount; r++) base[chunk->runs[r].var] += chunk->runs[r].count;
+    }
+
+    /* Then the internal nodes by decreasing variable, and in each variable by increasing index */
+    for (uint64_t v=(uint64_t)maxvar+1; v-- > 0;) {
+        uint64_t count = base[v];
+        base[v] = next;
+        next += count;
+    }
+    for (size_t c=0; c<chunkcount; c++) {
+        writer_chunk_t *chunk = w->chunks + c;
+        for (size_t r=0; r<chunk->runcount; r++) {
+            chunk->runs[r].first = base[chunk->runs[r].var];
+            base[chunk->runs[r].var] += chunk->runs[r].count;
+        }
+    }
+    free(base);
+
+    w->count = next - 1;
+    w->numbers = malloc(sizeof(uint64_t) * (w->count > 0 ? w->count : 1));
+    w->order = malloc(sizeof(uint64_t) * (w->count + 1));
+    if (w->numbers == NULL || w->order == NULL) {
+        fprintf(stderr, "sylvan_writer_number: Unable to allocate memory!\n");
+        exit(1);
+    }
+    w->order[0] = 0;
+
+    /* Assign the numbers of every chunk in parallel */
+    if (chunkcount > 0) CALL(writer_assign_par, w, 0, chunkcount);
+
+    free(w->chunks);
+    w->chunks = NULL;
+    atomic_store(&w->numbered, 1);
+}
+
+size_t
+sylvan_writer_count(sylvan_writer_t w)
+{
+    return w->count;
+}
+
+size_t
+sylvan_writer_leafcount(sylvan_writer_t w)
+{
+    return w->leafcount;
+}
+
+uint64_t
+sylvan_writer_get(sylvan_writer_t w, uint64_t index)
+{
+    if (index / 64 >= w->words) return 0;
+    const uint64_t bits = atomic_load_explicit(w->bitmap + index / 64, memory_order_relaxed);
+    if ((bits & (1ULL << (index % 64))) == 0) return 0;
+    return w->numbers[writer_rank(w, index)];
+}
+
+uint64_t
+sylvan_writer_getr(sylvan_writer_t w, uint64_t number)
+{
+    return w->order[number];
+}
+
+VOID_TASK_5(writer_fill_par, sylvan_writer_t, w, sylvan_writer_node_cb, node_cb, uint64_t*, buf, uint64_t, first, size_t, count)
+{
+    if (count > WRITER_FILL_GRAIN) {
+        SPAWN(writer_fill_par, w, node_cb, buf, first, count/2);
+        CALL(writer_fill_par, w, node_cb, buf + 2*(count/2), first + count/2, count - count/2);
+        SYNC(writer_fill_par);
+    } else {
+        for (size_t i=0; i<count; i++) node_cb(w, w->order[first+i], buf + 2*i);
+    }
+}
+
+VOID_TASK_IMPL_4(sylvan_writer_write_nodes, sylvan_writer_t, w, FILE*, out, uint64_t, first, sylvan_writer_node_cb, node_cb)
+{
+    if (first > w->count) return;
+
+    uint64_t *buf[2];
+    buf[0] = malloc(sizeof(uint64_t) * 2 * WRITER_BLOCK_NODES);
+    buf[1] = malloc(sizeof(uint64_t) * 2 * WRITER_BLOCK_NODES);
+    if (buf[0] == NULL || buf[1] == NULL) {
+        fprintf(stderr, "sylvan_writer_write_nodes: Unable to allocate memory!\n");
+        exit(1);
+    }
+
+    size_t count = w->count - first + 1;
+    if (count > WRITER_BLOCK_NODES) count = WRITER_BLOCK_NODES;
+    CALL(writer_fill_par, w, node_cb, buf[0], first, count);
+
+    /* Write the current block while the next block is converted */
+    int cur = 0;
+    while (count > 0) {
+        const uint64_t next_first = first + count;
+        size_t next_count = next_first <= w->count ? w->count - next_first + 1 : 0;
+        if (next_count > WRITER_BLOCK_NODES) next_count = WRITER_BLOCK_NODES;
+        if (next_count > 0) SPAWN(writer_fill_par, w, node_cb, buf[1-cur], next_first, next_count);
+        fwrite(buf[cur], sizeof(uint64_t) * 2, count, out);
+        if (next_count > 0) SYNC(writer_fill_par);
+        first = next_first;
+        count = next_count;
+        cur = 1 - cur;
+    }
+
+    free(buf[0]);
+    free(buf[1]);
+}
+
+typedef struct reader_level
+{
+    const uint64_t *recs;
+    uint64_t *arr;
+    const uint64_t *order;      // numbers of the nodes, sorted by depth
+    sylvan_reader_node_cb node_cb;
+    void *ctx;
+} reader_level_t;
+
+VOID_TASK_3(reader_make_par, reader_level_t*, r, size_t, first, size_t, count)
+{
+    if (count > READER_MAKE_GRAIN) {
+        SPAWN(reader_make_par, r, first, count/2);
+        CALL(reader_make_par, r, first+count/2, count-count/2);
+        SYNC(reader_make_par);
+    } else {
+        for (size_t i=first; i<first+count; i++) {
+            const uint64_t n = r->order[i];
+            r->arr[n] = r->node_cb(r->ctx, r->recs + 2*n, r->arr);
+        }
+    }
+}
+
+TASK_IMPL_6(int, sylvan_reader_make_nodes, const uint64_t*, recs, size_t, count, uint64_t*, arr, sylvan_reader_children_cb, children_cb, sylvan_reader_node_cb, node_cb, void*, ctx)
+{
+    /* Compute the depth of every node, and how many internal nodes each depth has */
+    uint32_t *depth = malloc(sizeof(uint32_t) * (count + 1));
+    size_t depthcount = 64;
+    uint64_t *base = calloc(depthcount, sizeof(uint64_t));
+    if (depth == NULL || base == NULL) {
+        free(depth);
+        free(base);
+        return -1;
+    }
+    uint32_t maxdepth = 0;
+    depth[0] = 0;
+    for (size_t i=1; i<=count; i++) {
+        uint64_t children[2];
+        if (children_cb(ctx, recs + 2*i, children) == 0) {
+            depth[i] = 0;
+            continue;
+        }
+        if (children[0] >= i || children[1] >= i) {
+            free(depth);
+            free(base);
+            return -1;
+        }
+        uint32_t d = depth[children[0]] > depth[children[1]] ? depth[children[0]] : depth[children[1]];
+        depth[i] = ++d;
+        if (d >= depthcount) {
+            uint64_t *newbase = realloc(base, sizeof(uint64_t) * depthcount * 2);
+            if (newbase == NULL) {
+                free(depth);
+                free(base);
+                return -1;
+            }
+            base = newbase;
+            memset(base + depthcount, 0, sizeof(uint64_t) * depthcount);
+            depthcount *= 2;
+        }
+        base[d]++;
+        if (d > maxdepth) maxdepth = d;
+    }
+
+    /* Sort the internal nodes by depth */
+    uint64_t total = 0;
+    for (uint32_t d=1; d<=maxdepth; d++) {
+        uint64_t c = base[d];
+        base[d] = total;
+        total += c;
+    }
+    uint64_t *order = malloc(sizeof(uint64_t) * (total > 0 ? total : 1));
+    if (order == NULL) {
+        free(depth);
+        free(base);
+        return -1;
+    }
+    for (size_t i=1; i<=count; i++) {
+        if (depth[i] != 0) order[base[depth[i]]++] = i;
+    }
+    free(depth);
+
+    /* Create the nodes of each depth in parallel; base[d] is now the end of depth d */
+    reader_level_t r = { recs, arr, order, node_cb, ctx };
+    uint64_t first = 0;
+    for (uint32_t d=1; d<=maxdepth; d++) {
+        if (base[d] > first) CALL(reader_make_par, &r, first, base[d] - first);
+        first = base[d];
+    }
+
+    free(order);
+    free(base);
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYLVAN_WRITER_H
+#define SYLVAN_WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Node numbering for writing decision diagrams to file.
+ * The writer and reader are used by the serialization mechanism of MTBDDs and ZDDs.
+ *
+ * Nodes are marked in a bitmap with one bit per bucket of the nodes table, in parallel.
+ * When all nodes are marked, they are numbered starting with 1: first the leaves, then the
+ * internal nodes by decreasing variable, and by increasing index within each variable.
+ * Children thus always have a lower number than their parents, and the nodes of one variable
+ * are consecutive. Looking up the number of a node is a rank query on the bitmap.
+ */
+
+typedef struct sylvan_writer *sylvan_writer_t;
+
+/**
+ * Given the index of a node in the nodes table, return its variable, or 0xffffffff for a leaf.
+ */
+typedef uint32_t (*sylvan_writer_var_cb)(uint64_t index);
+
+/**
+ * Given the index of an internal node, write the node with its children replaced by their
+ * numbers (see sylvan_writer_get) to <dst>, which has room for 16 bytes.
+ */
+typedef void (*sylvan_writer_node_cb)(sylvan_writer_t w, uint64_t index, uint64_t *dst);
+
+sylvan_writer_t sylvan_writer_alloc(sylvan_writer_var_cb var_cb);
+
+void sylvan_writer_free(sylvan_writer_t w);
+
+/**
+ * Mark the node with the given index. Returns 1 if it was not yet marked, 0 otherwise.
+ * Thread-safe; marking a new node after numbering discards the numbering.
+ */
+int sylvan_writer_mark(sylvan_writer_t w, uint64_t index);
+
+/**
+ * Number all marked nodes. Does nothing if the nodes are already numbered.
+ */
+VOID_TASK_DECL_1(sylvan_writer_number, sylvan_writer_t);
+#define sylvan_writer_number(w) RUN(sylvan_writer_number, w)
+
+/**
+ * Number of marked nodes, and the number of leaves among them (numbered 1 ... leafcount).
+ */
+size_t sylvan_writer_count(sylvan_writer_t w);
+size_t sylvan_writer_leafcount(sylvan_writer_t w);
+
+/**
+ * Get the number of the node with the given index, or 0 if the node is not marked.
+ * The nodes must be numbered.
+ */
+uint64_t sylvan_writer_get(sylvan_writer_t w, uint64_t index);
+
+/**
+ * Get the index of the node with the given number.
+ * The nodes must be numbered.
+ */
+uint64_t sylvan_writer_getr(sylvan_writer_t w, uint64_t number);
+
+/**
+ * Write the internal nodes with numbers <first> ... count to <out>, 16 bytes each.
+ * Nodes are converted by <node_cb> in parallel into large blocks, and each block is
+ * written with a single fwrite while the next block is being converted.
+ * The nodes must be numbered.
+ */
+VOID_TASK_DECL_4(sylvan_writer_write_nodes, sylvan_writer_t, FILE*, uint64_t, sylvan_writer_node_cb);
+#define sylvan_writer_write_nodes(w, out, first, node_cb) RUN(sylvan_writer_write_nodes, w, out, first, node_cb)
+
+/**
+ * Node creation for reading decision diagrams from file.
+ *
+ * The nodes of a file are numbered 1 ... count, and children precede their parents. The nodes
+ * are grouped by their depth (the length of the longest path to a leaf), and the nodes of each
+ * depth are created in parallel, as they only depend on nodes of smaller depths.
+ */
+
+/**
+ * Given the record of a node read from file, store the numbers of its children (without
+ * marks, 0 for the constant) in <children> and return 2, or return 0 for a leaf.
+ */
+typedef int (*sylvan_reader_children_cb)(void *ctx, const uint64_t *rec, uint64_t *children);
+
+/**
+ * Given the record of an internal node read from file, and the array <arr> with the created
+ * nodes of smaller depths, create the node.
+ */
+typedef uint64_t (*sylvan_reader_node_cb)(void *ctx, const uint64_t *rec, const uint64_t *arr);
+
+/**
+ * Create the internal nodes 1 ... <count>, with records (2 words each) at <recs>+2 ... and
+ * store them in <arr>, where arr[0] and the leaves must already be set.
+ * The callbacks are given <ctx>. Returns 0, or -1 if a node has a child that does not precede it
+ * or if memory cannot be allocated.
+ */
+TASK_DECL_6(int, sylvan_reader_make_nodes, const uint64_t*, size_t, uint64_t*, sylvan_reader_children_cb, sylvan_reader_node_cb, void*);
+#define sylvan_reader_make_nodes(recs, count, arr, children_cb, node_cb, ctx) RUN(sylvan_reader_make_nodes, recs, count, arr, children_cb, node_cb, ctx)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -29,7 +29,9 @@
 // #include <sylvan.h>
 
 #include <sylvan_refs.h>
-#include <sylvan_sl.h>
+#include <sylvan_writer.h>
+#include <sylvan_codec.h>
+#include <sylvan_serializer.h>
 
 /**
  * Basic ZDD node manipulation
@@ -382,6 +384,7 @@ sylvan_init_zdd()
     sylvan_register_quit(zdd_quit);
     sylvan_gc_add_mark(TASK(zdd_gc_mark_protected));
     sylvan_gc_add_mark(TASK(zdd_refs_mark));
+    sylvan_init_serializer();
 
     if (!zdd_protected_created) {
         protect_create(&zdd_protected, 4096);
@@ -816,6 +819,138 @@ zdd_set_to_mtbdd(ZDD set)
     return mtbdd_makenode(set_var, mtbdd_false, zdd_set_to_mtbdd(zddnode_high(set, set_node)));
 }
 
+
+/**
+ * Return 1 if the map contains the key, 0 otherwise.
+ */
+int
+zdd_map_contains(ZDDMAP map, uint32_t key)
+{
+    while (!zdd_map_isempty(map)) {
+        zddnode_t n = ZDD_GETNODE(map);
+        uint32_t k = zddnode_getvariable(n);
+        if (k == key) return 1;
+        if (k > key) return 0;
+        map = zddnode_low(map, n);
+    }
+
+    return 0;
+}
+
+/**
+ * Retrieve the number of keys in the map.
+ */
+size_t
+zdd_map_count(ZDDMAP map)
+{
+    size_t r = 0;
+
+    while (!zdd_map_isempty(map)) {
+        r++;
+        map = zdd_map_next(map);
+    }
+
+    return r;
+}
+
+/**
+ * Add the pair <key,value> to the map, overwrites if key already in map.
+ */
+ZDDMAP
+zdd_map_add(ZDDMAP map, uint32_t key, ZDD value)
+{
+    if (zdd_map_isempty(map)) {
+        return zdd_makemapnode(key, zdd_map_empty(), value);
+    }
+
+    zddnode_t n = ZDD_GETNODE(map);
+    uint32_t k = zddnode_getvariable(n);
+
+    if (k < key) {
+        // add recursively and rebuild tree
+        ZDDMAP low = zdd_map_add(zddnode_low(map, n), key, value);
+        return zdd_makemapnode(k, low, zddnode_high(map, n));
+    } else if (k > key) {
+        return zdd_makemapnode(key, map, value);
+    } else {
+        // replace old
+        return zdd_makemapnode(key, zddnode_low(map, n), value);
+    }
+}
+
+/**
+ * Add all values from map2 to map1, overwrites if key already in map1.
+ */
+ZDDMAP
+zdd_map_addall(ZDDMAP map1, ZDDMAP map2)
+{
+    if (zdd_map_isempty(map1)) return map2;
+    if (zdd_map_isempty(map2)) return map1;
+
+    zddnode_t n1 = ZDD_GETNODE(map1);
+    zddnode_t n2 = ZDD_GETNODE(map2);
+    uint32_t k1 = zddnode_getvariable(n1);
+    uint32_t k2 = zddnode_getvariable(n2);
+
+    ZDDMAP result;
+    if (k1 < k2) {
+        ZDDMAP low = zdd_map_addall(zddnode_low(map1, n1), map2);
+        result = zdd_makemapnode(k1, low, zddnode_high(map1, n1));
+    } else if (k1 > k2) {
+        ZDDMAP low = zdd_map_addall(map1, zddnode_low(map2, n2));
+        result = zdd_makemapnode(k2, low, zddnode_high(map2, n2));
+    } else {
+        ZDDMAP low = zdd_map_addall(zddnode_low(map1, n1), zddnode_low(map2, n2));
+        result = zdd_makemapnode(k2, low, zddnode_high(map2, n2));
+    }
+
+    return result;
+}
+
+/**
+ * Remove the key <key> from the map and return the result
+ */
+ZDDMAP
+zdd_map_remove(ZDDMAP map, uint32_t key)
+{
+    if (zdd_map_isempty(map)) return map;
+
+    zddnode_t n = ZDD_GETNODE(map);
+    uint32_t k = zddnode_getvariable(n);
+
+    if (k < key) {
+        ZDDMAP low = zdd_map_remove(zddnode_low(map, n), key);
+        return zdd_makemapnode(k, low, zddnode_high(map, n));
+    } else if (k > key) {
+        return map;
+    } else {
+        return zddnode_low(map, n);
+    }
+}
+
+/**
+ * Remove all keys in the set <variables> from the map and return the result
+ */
+ZDDMAP
+zdd_map_removeall(ZDDMAP map, ZDD variables)
+{
+    if (zdd_map_isempty(map)) return map;
+    if (variables == zdd_true) return map;
+
+    zddnode_t n1 = ZDD_GETNODE(map);
+    zddnode_t n2 = ZDD_GETNODE(variables);
+    uint32_t k1 = zddnode_getvariable(n1);
+    uint32_t k2 = zddnode_getvariable(n2);
+
+    if (k1 < k2) {
+        ZDDMAP low = zdd_map_removeall(zddnode_low(map, n1), variables);
+        return zdd_makemapnode(k1, low, zddnode_high(map, n1));
+    } else if (k1 > k2) {
+        return zdd_map_removeall(map, zddnode_high(variables, n2));
+    } else {
+        return zdd_map_removeall(zddnode_low(map, n1), zddnode_high(variables, n2));
+    }
+}
 /**
  * Create a cube of literals of the given domain with the values given in <arr>.
  * Uses True as the leaf.
@@ -1174,10 +1309,7 @@ TASK_IMPL_2(ZDD, zdd_and, ZDD, a, ZDD, b)
             low = zdd_and(a0, b0);
             high = zdd_false;
         } else {
-            zdd_refs_spawn(SPAWN(zdd_and, a0, b0));
-            high = zdd_and(a1, b1);
-            zdd_refs_push(high);
-            low = zdd_refs_sync(SYNC(zdd_and));
+            SYLVAN_FORK(zdd, high, low, (zdd_and, a1, b1), (zdd_and, a0, b0));
             zdd_refs_pop(1);
         }
 
@@ -1280,10 +1412,8 @@ TASK_IMPL_4(ZDD, zdd_ite, ZDD, a, ZDD, b, ZDD, c, ZDD, dom)
     /**
      * Now we call recursive tasks
      */
-    zdd_refs_spawn(SPAWN(zdd_ite, a0, b0, c0, dom_next));
-    ZDD high = CALL(zdd_ite, a1, b1, c1, dom_next);
-    zdd_refs_push(high);
-    ZDD low = zdd_refs_sync(SYNC(zdd_ite));
+    ZDD high, low;
+    SYLVAN_FORK(zdd, high, low, (zdd_ite, a1, b1, c1, dom_next), (zdd_ite, a0, b0, c0, dom_next));
     zdd_refs_pop(1);
 
     /**
@@ -1355,10 +1485,8 @@ TASK_IMPL_2(ZDD, zdd_or, ZDD, a, ZDD, b)
     /**
      * Now we call recursive tasks
      */
-    zdd_refs_spawn(SPAWN(zdd_or, a0, b0));
-    ZDD high = CALL(zdd_or, a1, b1);
-    zdd_refs_push(high);
-    ZDD low = zdd_refs_sync(SYNC(zdd_or));
+    ZDD high, low;
+    SYLVAN_FORK(zdd, high, low, (zdd_or, a1, b1), (zdd_or, a0, b0));
     zdd_refs_pop(1);
 
     /**
@@ -1506,10 +1634,8 @@ TASK_IMPL_2(ZDD, zdd_diff, ZDD, a, ZDD, b)
     /**
      * Now we call recursive tasks
      */
-    zdd_refs_spawn(SPAWN(zdd_diff, a0, b0));
-    ZDD high = CALL(zdd_diff, a1, b1);
-    zdd_refs_push(high);
-    ZDD low = zdd_refs_sync(SYNC(zdd_diff));
+    ZDD high, low;
+    SYLVAN_FORK(zdd, high, low, (zdd_diff, a1, b1), (zdd_diff, a0, b0));
     zdd_refs_pop(1);
 
     /**
@@ -1528,16 +1654,25 @@ TASK_IMPL_2(ZDD, zdd_diff, ZDD, a, ZDD, b)
 }
 
 /**
- * Compute existential quantification, but stay in same domain
+ * Implementation of the XOR operator for Boolean ZDDs (symmetric difference)
  */
-TASK_IMPL_2(ZDD, zdd_exists, ZDD, dd, ZDD, vars)
+TASK_IMPL_2(ZDD, zdd_xor, ZDD, a, ZDD, b)
 {
     /**
      * Trivial cases
      */
-    if (dd == zdd_true) return vars; // <vars> now represents True for the variables in <vars>
-    if (dd == zdd_false) return dd;
-    if (vars == zdd_true) return dd;
+    if (a == zdd_false) return b;
+    if (b == zdd_false) return a;
+    if (a == b) return zdd_false;
+
+    /**
+     * Switch A and B if A > B (for cache)
+     */
+    if (ZDD_GETINDEX(a) > ZDD_GETINDEX(b)) {
+        ZDD t = a;
+        a = b;
+        b = t;
+    }
 
     /**
      * Maybe run garbage collection
@@ -1547,209 +1682,1607 @@ TASK_IMPL_2(ZDD, zdd_exists, ZDD, dd, ZDD, vars)
     /**
      * Count operation
      */
-    sylvan_stats_count(ZDD_EXISTS);
+    sylvan_stats_count(ZDD_XOR);
 
     /**
      * Check the cache
      */
     ZDD result;
-    if (cache_get3(CACHE_ZDD_EXISTS, dd, vars, 0, &result)) {
-        sylvan_stats_count(ZDD_EXISTS_CACHED);
+    if (cache_get3(CACHE_ZDD_XOR, a, b, 0, &result)) {
+        sylvan_stats_count(ZDD_XOR_CACHED);
         return result;
     }
 
     /**
-     * Obtain variables
+     * Get the vars
      */
-    const zddnode_t dd_node = ZDD_GETNODE(dd);
-    const uint32_t dd_var = zddnode_getvariable(dd_node);
-    const zddnode_t vars_node = ZDD_GETNODE(vars);
-    const uint32_t vars_var = zddnode_getvariable(vars_node);
+    const zddnode_t a_node = zdd_isleaf(a) ? NULL : ZDD_GETNODE(a);
+    const uint32_t a_var = a_node == NULL ? 0xffffffff : zddnode_getvariable(a_node);
+    const zddnode_t b_node = zdd_isleaf(b) ? NULL : ZDD_GETNODE(b);
+    const uint32_t b_var = b_node == NULL ? 0xffffffff : zddnode_getvariable(b_node);
+    uint32_t minvar = a_var < b_var ? a_var : b_var;
+    assert(minvar != 0xffffffff);
 
     /**
-     * Compute pivot variable
+     * Get the cofactors
      */
-    if (vars_var < dd_var) {
-        result = zdd_exists(dd, zddnode_high(vars, vars_node));
-        result = zdd_makenode(vars_var, result, result);
-    } else {
-        /**
-         * Get cofactors
-         */
-        const ZDD dd0 = zddnode_low(dd, dd_node);
-        const ZDD dd1 = zddnode_high(dd, dd_node);
-
-        if (vars_var == dd_var) {
-            // Quantify
-
-            /**
-             * Now we call recursive tasks
-             */
-            const ZDD vars_next = zddnode_high(vars, vars_node);
-            if (dd0 == dd1) {
-                result = CALL(zdd_exists, dd0, vars_next);
-            } else {
-                zdd_refs_spawn(SPAWN(zdd_exists, dd0, vars_next));
-                ZDD high = CALL(zdd_exists, dd1, vars_next);
-                zdd_refs_push(high);
-                ZDD low = zdd_refs_sync(SYNC(zdd_exists));
-                zdd_refs_push(low);
-                result = zdd_or(low, high);
-                zdd_refs_pop(2);
-            }
-
-            result = zdd_makenode(vars_var, result, result);
-        } else {
-            // Keep
+    const ZDD a0 = minvar < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = minvar < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = minvar < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = minvar < b_var ? zdd_false : zddnode_high(b, b_node);
 
-            /**
-             * Now we call recursive tasks
-             */
-            ZDD low, high;
-            if (dd0 == dd1) {
-                low = high = CALL(zdd_exists, dd0, vars);
-            } else {
-                zdd_refs_spawn(SPAWN(zdd_exists, dd0, vars));
-                high = CALL(zdd_exists, dd1, vars);
-                zdd_refs_push(high);
-                low = zdd_refs_sync(SYNC(zdd_exists));
-                zdd_refs_pop(1);
-            }
+    /**
+     * Now we call recursive tasks
+     */
+    ZDD high, low;
+    SYLVAN_FORK(zdd, high, low, (zdd_xor, a1, b1), (zdd_xor, a0, b0));
+    zdd_refs_pop(1);
 
-            /**
-             * Compute result node
-             */
-            result = zdd_makenode(dd_var, low, high);
-        }
-    }
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(minvar, low, high);
 
     /**
      * Cache the result
      */
-    if (cache_put3(CACHE_ZDD_EXISTS, dd, vars, 0, result)) {
-        sylvan_stats_count(ZDD_EXISTS_CACHEDPUT);
+    if (cache_put3(CACHE_ZDD_XOR, a, b, 0, result)) {
+        sylvan_stats_count(ZDD_XOR_CACHEDPUT);
     }
 
     return result;
 }
 
 /**
- * Compute existential quantification to a smaller domain
- * Remove all variables from <dd> that are not in <newdom>
+ * Implementation of the EQUIV operator for Boolean ZDDs
  */
-TASK_IMPL_2(ZDD, zdd_project, ZDD, dd, ZDD, dom)
+TASK_IMPL_3(ZDD, zdd_equiv, ZDD, a, ZDD, b, ZDD, dom)
 {
     /**
-     * Trivial cases
-     */
-    if (dd == zdd_true) return dd;
-    if (dd == zdd_false) return dd;
-    if (dom == zdd_true) return zdd_true; // assuming dd is indeed Boolean
-
-    /**
-     * Maybe run garbage collection
+     * Trivial cases (abusing the notion of dom representing True for all assignments)
      */
-    sylvan_gc_test();
+    if (a == b) return dom;
+    if (a == zdd_false) return zdd_not(b, dom);
+    if (b == zdd_false) return zdd_not(a, dom);
+    if (dom == zdd_true) return zdd_false; // a and b are different leaves
 
     /**
-     * Count operation
+     * Switch A and B if A > B (for cache)
      */
-    sylvan_stats_count(ZDD_PROJECT);
+    if (ZDD_GETINDEX(a) > ZDD_GETINDEX(b)) {
+        ZDD t = a;
+        a = b;
+        b = t;
+    }
 
     /**
-     * Obtain variables
+     * Maybe run garbage collection
      */
-    const zddnode_t dd_node = ZDD_GETNODE(dd);
-    const uint32_t dd_var = zddnode_getvariable(dd_node);
+    sylvan_gc_test();
 
     /**
-     * Move dom to dd_var
+     * Count operation
      */
-    zddnode_t dom_node = ZDD_GETNODE(dom);
-    uint32_t dom_var = zddnode_getvariable(dom_node);
-    ZDD dom_next = zddnode_high(dom, dom_node);
-    while (dom_var < dd_var) {
-        dom = dom_next;
-        if (dom == zdd_true) return zdd_true; // assuming dd is indeed Boolean
-        dom_node = ZDD_GETNODE(dom);
-        dom_var = zddnode_getvariable(dom_node);
-        dom_next = zddnode_high(dom, dom_node);
-    }
+    sylvan_stats_count(ZDD_EQUIV);
 
     /**
      * Check the cache
      */
     ZDD result;
-    if (cache_get3(CACHE_ZDD_PROJECT, dd, dom, 0, &result)) {
-        sylvan_stats_count(ZDD_PROJECT_CACHED);
+    if (cache_get3(CACHE_ZDD_EQUIV, a, b, dom, &result)) {
+        sylvan_stats_count(ZDD_EQUIV_CACHED);
         return result;
     }
 
     /**
-     * Get cofactors
+     * Get the vars
      */
-    const ZDD dd0 = zddnode_low(dd, dd_node);
-    const ZDD dd1 = zddnode_high(dd, dd_node);
+    const zddnode_t a_node = zdd_isleaf(a) ? NULL : ZDD_GETNODE(a);
+    const uint32_t a_var = a_node == NULL ? 0xffffffff : zddnode_getvariable(a_node);
+    const zddnode_t b_node = zdd_isleaf(b) ? NULL : ZDD_GETNODE(b);
+    const uint32_t b_var = b_node == NULL ? 0xffffffff : zddnode_getvariable(b_node);
+    const zddnode_t dom_node = ZDD_GETNODE(dom);
+    const uint32_t dom_var = zddnode_getvariable(dom_node);
+    const ZDD dom_next = zddnode_high(dom, dom_node);
 
-    assert(dd_var <= dom_var);
+    assert(dom_var <= a_var && dom_var <= b_var);
 
     /**
-     * Compute pivot variable
+     * Get the cofactors
      */
-    if (dd_var < dom_var) {
-        // Quantify
-
-        /**
-         * Now we call recursive tasks
-         */
-        if (dd0 == dd1) {
-            result = CALL(zdd_project, dd0, dom);
-        } else {
-            zdd_refs_spawn(SPAWN(zdd_project, dd0, dom));
-            ZDD high = CALL(zdd_project, dd1, dom);
-            zdd_refs_push(high);
-            ZDD low = zdd_refs_sync(SYNC(zdd_project));
-            zdd_refs_push(low);
-            result = zdd_or(low, high);
-            zdd_refs_pop(2);
-        }
-    } else {
-        // Keep
+    const ZDD a0 = dom_var < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = dom_var < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = dom_var < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = dom_var < b_var ? zdd_false : zddnode_high(b, b_node);
 
-        /**
-         * Now we call recursive tasks
-         */
-        ZDD low, high;
-        if (dd0 == dd1) {
-            low = high = CALL(zdd_project, dd0, dom_next);
-        } else {
-            zdd_refs_spawn(SPAWN(zdd_project, dd0, dom_next));
-            high = CALL(zdd_project, dd1, dom_next);
-            zdd_refs_push(high);
-            low = zdd_refs_sync(SYNC(zdd_project));
-            zdd_refs_pop(1);
-        }
+    /**
+     * Now we call recursive tasks
+     */
+    ZDD high, low;
+    SYLVAN_FORK(zdd, high, low, (zdd_equiv, a1, b1, dom_next), (zdd_equiv, a0, b0, dom_next));
+    zdd_refs_pop(1);
 
-        /**
-         * Compute result node
-         */
-        result = zdd_makenode(dd_var, low, high);
-    }
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(dom_var, low, high);
 
     /**
      * Cache the result
      */
-    if (cache_put3(CACHE_ZDD_PROJECT, dd, dom, 0, result)) {
-        sylvan_stats_count(ZDD_PROJECT_CACHEDPUT);
+    if (cache_put3(CACHE_ZDD_EQUIV, a, b, dom, result)) {
+        sylvan_stats_count(ZDD_EQUIV_CACHEDPUT);
     }
 
     return result;
 }
 
-ZDD zdd_enum_first(ZDD dd, ZDD dom, uint8_t *arr, zdd_enum_filter_cb filter_cb)
+/**
+ * Implementation of the IMP operator for Boolean ZDDs
+ */
+TASK_IMPL_3(ZDD, zdd_imp, ZDD, a, ZDD, b, ZDD, dom)
 {
-    if (dd == zdd_false) {
-        return zdd_false;
+    /**
+     * Trivial cases (abusing the notion of dom representing True for all assignments)
+     */
+    if (a == zdd_false || a == b || b == dom) return dom;
+    if (a == dom) return b;
+    if (b == zdd_false) return zdd_not(a, dom);
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_IMP);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_IMP, a, b, dom, &result)) {
+        sylvan_stats_count(ZDD_IMP_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = zdd_isleaf(a) ? NULL : ZDD_GETNODE(a);
+    const uint32_t a_var = a_node == NULL ? 0xffffffff : zddnode_getvariable(a_node);
+    const zddnode_t b_node = zdd_isleaf(b) ? NULL : ZDD_GETNODE(b);
+    const uint32_t b_var = b_node == NULL ? 0xffffffff : zddnode_getvariable(b_node);
+    const zddnode_t dom_node = ZDD_GETNODE(dom);
+    const uint32_t dom_var = zddnode_getvariable(dom_node);
+    const ZDD dom_next = zddnode_high(dom, dom_node);
+
+    assert(dom_var <= a_var && dom_var <= b_var);
+
+    /**
+     * Get the cofactors
+     */
+    const ZDD a0 = dom_var < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = dom_var < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = dom_var < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = dom_var < b_var ? zdd_false : zddnode_high(b, b_node);
+
+    /**
+     * Now we call recursive tasks
+     */
+    ZDD high, low;
+    SYLVAN_FORK(zdd, high, low, (zdd_imp, a1, b1, dom_next), (zdd_imp, a0, b0, dom_next));
+    zdd_refs_pop(1);
+
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(dom_var, low, high);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_IMP, a, b, dom, result)) {
+        sylvan_stats_count(ZDD_IMP_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Implementation of the INVIMP operator for Boolean ZDDs
+ */
+TASK_IMPL_3(ZDD, zdd_invimp, ZDD, a, ZDD, b, ZDD, dom)
+{
+    return CALL(zdd_imp, b, a, dom);
+}
+
+/**
+ * Returns 1 if the family <dd> contains the empty set, or 0 otherwise.
+ */
+static inline int
+zdd_has_empty(ZDD dd)
+{
+#if ZDD_COMPLEMENT_EDGES
+    // the low edges of stored nodes are never complemented, so only the mark on <dd> counts
+    return ZDD_HASMARK(dd) ? 1 : 0;
+#else
+    while (!zdd_isleaf(dd)) dd = zdd_getlow(dd);
+    return dd == zdd_true ? 1 : 0;
+#endif
+}
+
+/**
+ * Compute the join of the families <a> and <b>, i.e., all unions of a set in <a> and a set in <b>.
+ */
+TASK_IMPL_2(ZDD, zdd_join, ZDD, a, ZDD, b)
+{
+    /**
+     * Trivial cases
+     */
+    if (a == zdd_false || b == zdd_false) return zdd_false;
+    if (a == zdd_true) return b;
+    if (b == zdd_true) return a;
+
+    /**
+     * Switch A and B if A > B (for cache)
+     */
+    if (ZDD_GETINDEX(a) > ZDD_GETINDEX(b)) {
+        ZDD t = a;
+        a = b;
+        b = t;
+    }
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_JOIN);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_JOIN, a, b, 0, &result)) {
+        sylvan_stats_count(ZDD_JOIN_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = zdd_isleaf(a) ? NULL : ZDD_GETNODE(a);
+    const uint32_t a_var = a_node == NULL ? 0xffffffff : zddnode_getvariable(a_node);
+    const zddnode_t b_node = zdd_isleaf(b) ? NULL : ZDD_GETNODE(b);
+    const uint32_t b_var = b_node == NULL ? 0xffffffff : zddnode_getvariable(b_node);
+    uint32_t minvar = a_var < b_var ? a_var : b_var;
+
+    /**
+     * Get the cofactors
+     */
+    const ZDD a0 = minvar < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = minvar < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = minvar < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = minvar < b_var ? zdd_false : zddnode_high(b, b_node);
+
+    /**
+     * Now we call recursive tasks
+     * low is a0 join b0, high is the union of a1 join b1, a1 join b0 and a0 join b1
+     */
+    ZDD low, h11, h10, h01;
+    const int n0 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_join, a0, b0));
+    const int n1 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_join, a1, b0));
+    const int n2 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_join, a0, b1));
+    h11 = zdd_refs_push(CALL(zdd_join, a1, b1));
+    h01 = zdd_refs_push(SYLVAN_JOIN(zdd, n2, (zdd_join, a0, b1)));
+    h10 = zdd_refs_push(SYLVAN_JOIN(zdd, n1, (zdd_join, a1, b0)));
+    low = zdd_refs_push(SYLVAN_JOIN(zdd, n0, (zdd_join, a0, b0)));
+    ZDD high = CALL(zdd_or, h11, h10);
+    zdd_refs_push(high);
+    high = CALL(zdd_or, high, h01);
+    zdd_refs_pop(5);
+
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(minvar, low, high);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_JOIN, a, b, 0, result)) {
+        sylvan_stats_count(ZDD_JOIN_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute the meet of the families <a> and <b>, i.e., all intersections of a set in <a> and a set in <b>.
+ */
+TASK_IMPL_2(ZDD, zdd_meet, ZDD, a, ZDD, b)
+{
+    /**
+     * Trivial cases
+     */
+    if (a == zdd_false || b == zdd_false) return zdd_false;
+    if (a == zdd_true || b == zdd_true) return zdd_true;
+
+    /**
+     * Switch A and B if A > B (for cache)
+     */
+    if (ZDD_GETINDEX(a) > ZDD_GETINDEX(b)) {
+        ZDD t = a;
+        a = b;
+        b = t;
+    }
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_MEET);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_MEET, a, b, 0, &result)) {
+        sylvan_stats_count(ZDD_MEET_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = zdd_isleaf(a) ? NULL : ZDD_GETNODE(a);
+    const uint32_t a_var = a_node == NULL ? 0xffffffff : zddnode_getvariable(a_node);
+    const zddnode_t b_node = zdd_isleaf(b) ? NULL : ZDD_GETNODE(b);
+    const uint32_t b_var = b_node == NULL ? 0xffffffff : zddnode_getvariable(b_node);
+    uint32_t minvar = a_var < b_var ? a_var : b_var;
+
+    /**
+     * Get the cofactors
+     */
+    const ZDD a0 = minvar < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = minvar < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = minvar < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = minvar < b_var ? zdd_false : zddnode_high(b, b_node);
+
+    /**
+     * Now we call recursive tasks
+     * high is a1 meet b1, low is the union of a0 meet b0, a1 meet b0 and a0 meet b1
+     */
+    ZDD high, l00, l10, l01;
+    const int n0 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_meet, a1, b1));
+    const int n1 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_meet, a1, b0));
+    const int n2 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_meet, a0, b1));
+    l00 = zdd_refs_push(CALL(zdd_meet, a0, b0));
+    l01 = zdd_refs_push(SYLVAN_JOIN(zdd, n2, (zdd_meet, a0, b1)));
+    l10 = zdd_refs_push(SYLVAN_JOIN(zdd, n1, (zdd_meet, a1, b0)));
+    high = zdd_refs_push(SYLVAN_JOIN(zdd, n0, (zdd_meet, a1, b1)));
+    ZDD low = CALL(zdd_or, l00, l10);
+    zdd_refs_push(low);
+    low = CALL(zdd_or, low, l01);
+    zdd_refs_pop(5);
+
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(minvar, low, high);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_MEET, a, b, 0, result)) {
+        sylvan_stats_count(ZDD_MEET_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute the delta of the families <a> and <b>, i.e., all symmetric differences of a set in <a> and a set in <b>.
+ */
+TASK_IMPL_2(ZDD, zdd_delta, ZDD, a, ZDD, b)
+{
+    /**
+     * Trivial cases
+     */
+    if (a == zdd_false || b == zdd_false) return zdd_false;
+    if (a == zdd_true) return b;
+    if (b == zdd_true) return a;
+
+    /**
+     * Switch A and B if A > B (for cache)
+     */
+    if (ZDD_GETINDEX(a) > ZDD_GETINDEX(b)) {
+        ZDD t = a;
+        a = b;
+        b = t;
+    }
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_DELTA);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_DELTA, a, b, 0, &result)) {
+        sylvan_stats_count(ZDD_DELTA_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = zdd_isleaf(a) ? NULL : ZDD_GETNODE(a);
+    const uint32_t a_var = a_node == NULL ? 0xffffffff : zddnode_getvariable(a_node);
+    const zddnode_t b_node = zdd_isleaf(b) ? NULL : ZDD_GETNODE(b);
+    const uint32_t b_var = b_node == NULL ? 0xffffffff : zddnode_getvariable(b_node);
+    uint32_t minvar = a_var < b_var ? a_var : b_var;
+
+    /**
+     * Get the cofactors
+     */
+    const ZDD a0 = minvar < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = minvar < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = minvar < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = minvar < b_var ? zdd_false : zddnode_high(b, b_node);
+
+    /**
+     * Now we call recursive tasks
+     * low is the union of a0 delta b0 and a1 delta b1, high of a1 delta b0 and a0 delta b1
+     */
+    ZDD l00, l11, h10, h01;
+    const int n0 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_delta, a0, b0));
+    const int n1 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_delta, a1, b0));
+    const int n2 = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_delta, a0, b1));
+    l11 = zdd_refs_push(CALL(zdd_delta, a1, b1));
+    h01 = zdd_refs_push(SYLVAN_JOIN(zdd, n2, (zdd_delta, a0, b1)));
+    h10 = zdd_refs_push(SYLVAN_JOIN(zdd, n1, (zdd_delta, a1, b0)));
+    l00 = zdd_refs_push(SYLVAN_JOIN(zdd, n0, (zdd_delta, a0, b0)));
+    ZDD high = CALL(zdd_or, h10, h01);
+    zdd_refs_push(high);
+    ZDD low = CALL(zdd_or, l00, l11);
+    zdd_refs_pop(5);
+
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(minvar, low, high);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_DELTA, a, b, 0, result)) {
+        sylvan_stats_count(ZDD_DELTA_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute the quotient of the families <a> and <b>, i.e., the largest family <q>
+ * such that the join of <b> and <q> is contained in <a>, with every set in <q>
+ * disjoint from every set in <b>.
+ */
+TASK_IMPL_2(ZDD, zdd_quotient, ZDD, a, ZDD, b)
+{
+    /**
+     * Trivial cases
+     */
+    if (b == zdd_true) return a;
+    if (a == zdd_false || b == zdd_false) return zdd_false;
+    if (a == b) return zdd_true;
+    if (a == zdd_true) return zdd_false;
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_QUOTIENT);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_QUOTIENT, a, b, 0, &result)) {
+        sylvan_stats_count(ZDD_QUOTIENT_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = ZDD_GETNODE(a);
+    const uint32_t a_var = zddnode_getvariable(a_node);
+    const zddnode_t b_node = ZDD_GETNODE(b);
+    const uint32_t b_var = zddnode_getvariable(b_node);
+
+    if (a_var < b_var) {
+        /**
+         * The sets in <b> do not contain a_var: divide both cofactors of <a>
+         */
+        const ZDD a0 = zddnode_low(a, a_node);
+        const ZDD a1 = zddnode_high(a, a_node);
+
+        ZDD low, high;
+        SYLVAN_FORK(zdd, high, low, (zdd_quotient, a1, b), (zdd_quotient, a0, b));
+        zdd_refs_pop(1);
+        result = zdd_makenode(a_var, low, high);
+    } else if (a_var > b_var) {
+        /**
+         * Some sets in <b> contain b_var, but none in <a>
+         */
+        result = zdd_false;
+    } else {
+        /**
+         * The quotient is <a1>/<b1>, intersected with <a0>/<b0> unless <b0> is empty
+         */
+        const ZDD a0 = zddnode_low(a, a_node);
+        const ZDD a1 = zddnode_high(a, a_node);
+        const ZDD b0 = zddnode_low(b, b_node);
+        const ZDD b1 = zddnode_high(b, b_node);
+
+        if (b0 == zdd_false) {
+            result = CALL(zdd_quotient, a1, b1);
+        } else {
+            ZDD q0, q1;
+            const int n = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_quotient, a0, b0));
+            q1 = zdd_refs_push(CALL(zdd_quotient, a1, b1));
+            // a deferred q0 is not needed if q1 is empty
+            q0 = n == 2 && q1 == zdd_false ? zdd_false : SYLVAN_JOIN(zdd, n, (zdd_quotient, a0, b0));
+            zdd_refs_push(q0);
+            result = CALL(zdd_and, q0, q1);
+            zdd_refs_pop(2);
+        }
+    }
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_QUOTIENT, a, b, 0, result)) {
+        sylvan_stats_count(ZDD_QUOTIENT_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute the remainder of dividing the family <a> by <b>.
+ */
+TASK_IMPL_2(ZDD, zdd_remainder, ZDD, a, ZDD, b)
+{
+    ZDD q = CALL(zdd_quotient, a, b);
+    zdd_refs_push(q);
+    ZDD p = CALL(zdd_join, b, q);
+    zdd_refs_push(p);
+    ZDD result = CALL(zdd_diff, a, p);
+    zdd_refs_pop(2);
+    return result;
+}
+
+/**
+ * Compute the sets in the family <a> that are not a superset of any set in <b>.
+ */
+TASK_IMPL_2(ZDD, zdd_nonsup, ZDD, a, ZDD, b)
+{
+    /**
+     * Trivial cases
+     */
+    if (a == zdd_false) return zdd_false;
+    if (b == zdd_false) return a;
+    if (a == b) return zdd_false;
+    if (zdd_has_empty(b)) return zdd_false;
+    if (a == zdd_true) return zdd_true;
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_NONSUP);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_NONSUP, a, b, 0, &result)) {
+        sylvan_stats_count(ZDD_NONSUP_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = ZDD_GETNODE(a);
+    const uint32_t a_var = zddnode_getvariable(a_node);
+    const zddnode_t b_node = ZDD_GETNODE(b);
+    const uint32_t b_var = zddnode_getvariable(b_node);
+    uint32_t minvar = a_var < b_var ? a_var : b_var;
+
+    /**
+     * Get the cofactors
+     */
+    const ZDD a0 = minvar < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = minvar < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = minvar < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = minvar < b_var ? zdd_false : zddnode_high(b, b_node);
+
+    /**
+     * Now we call recursive tasks
+     * a set in a1 (with minvar) may contain a set of b0 (without minvar) or of b1 (with minvar)
+     */
+    ZDD low, high;
+    const int n = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_nonsup, a0, b0));
+    high = CALL(zdd_nonsup, a1, b1);
+    zdd_refs_push(high);
+    high = CALL(zdd_nonsup, high, b0);
+    zdd_refs_pop(1);
+    zdd_refs_push(high);
+    low = SYLVAN_JOIN(zdd, n, (zdd_nonsup, a0, b0));
+    zdd_refs_pop(1);
+
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(minvar, low, high);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_NONSUP, a, b, 0, result)) {
+        sylvan_stats_count(ZDD_NONSUP_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute the sets in the family <a> that are not a subset of any set in <b>.
+ */
+TASK_IMPL_2(ZDD, zdd_nonsub, ZDD, a, ZDD, b)
+{
+    /**
+     * Trivial cases
+     */
+    if (a == zdd_false) return zdd_false;
+    if (b == zdd_false) return a;
+    if (a == b) return zdd_false;
+    if (a == zdd_true) return zdd_false;
+    if (b == zdd_true) return CALL(zdd_diff, a, zdd_true);
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_NONSUB);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_NONSUB, a, b, 0, &result)) {
+        sylvan_stats_count(ZDD_NONSUB_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = ZDD_GETNODE(a);
+    const uint32_t a_var = zddnode_getvariable(a_node);
+    const zddnode_t b_node = ZDD_GETNODE(b);
+    const uint32_t b_var = zddnode_getvariable(b_node);
+    uint32_t minvar = a_var < b_var ? a_var : b_var;
+
+    /**
+     * Get the cofactors
+     */
+    const ZDD a0 = minvar < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = minvar < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = minvar < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = minvar < b_var ? zdd_false : zddnode_high(b, b_node);
+
+    /**
+     * Now we call recursive tasks
+     * a set in a0 (without minvar) may be contained in a set of b0 (without minvar) or of b1 (with minvar)
+     */
+    ZDD low, high;
+    const int n = SYLVAN_SPAWN_OR_DEFER(zdd, (zdd_nonsub, a1, b1));
+    low = CALL(zdd_nonsub, a0, b1);
+    zdd_refs_push(low);
+    low = CALL(zdd_nonsub, low, b0);
+    zdd_refs_pop(1);
+    zdd_refs_push(low);
+    high = SYLVAN_JOIN(zdd, n, (zdd_nonsub, a1, b1));
+    zdd_refs_pop(1);
+
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(minvar, low, high);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_NONSUB, a, b, 0, result)) {
+        sylvan_stats_count(ZDD_NONSUB_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute the minimal sets of the family <dd>, i.e., the sets that contain no other set of <dd>.
+ */
+TASK_IMPL_1(ZDD, zdd_minimal, ZDD, dd)
+{
+    /**
+     * Trivial cases
+     */
+    if (zdd_isleaf(dd)) return dd;
+    if (zdd_has_empty(dd)) return zdd_true;
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_MINIMAL);
+
+    /**
+     * Check the cache (shared with zdd_maximal)
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_MINMAX, dd, 0, 0, &result)) {
+        sylvan_stats_count(ZDD_MINIMAL_CACHED);
+        return result;
+    }
+
+    const zddnode_t dd_node = ZDD_GETNODE(dd);
+    const uint32_t dd_var = zddnode_getvariable(dd_node);
+    const ZDD dd0 = zddnode_low(dd, dd_node);
+    const ZDD dd1 = zddnode_high(dd, dd_node);
+
+    /**
+     * Now we call recursive tasks
+     */
+    ZDD low, high;
+    SYLVAN_FORK(zdd, high, low, (zdd_minimal, dd1), (zdd_minimal, dd0));
+    zdd_refs_push(low);
+
+    /**
+     * A minimal set with dd_var must not contain a (minimal) set without dd_var
+     */
+    high = CALL(zdd_nonsup, high, low);
+    zdd_refs_pop(2);
+
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(dd_var, low, high);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_MINMAX, dd, 0, 0, result)) {
+        sylvan_stats_count(ZDD_MINIMAL_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute the maximal sets of the family <dd>, i.e., the sets that are contained in no other set of <dd>.
+ */
+TASK_IMPL_1(ZDD, zdd_maximal, ZDD, dd)
+{
+    /**
+     * Trivial cases
+     */
+    if (zdd_isleaf(dd)) return dd;
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_MAXIMAL);
+
+    /**
+     * Check the cache (shared with zdd_minimal)
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_MINMAX, dd, 1, 0, &result)) {
+        sylvan_stats_count(ZDD_MAXIMAL_CACHED);
+        return result;
+    }
+
+    const zddnode_t dd_node = ZDD_GETNODE(dd);
+    const uint32_t dd_var = zddnode_getvariable(dd_node);
+    const ZDD dd0 = zddnode_low(dd, dd_node);
+    const ZDD dd1 = zddnode_high(dd, dd_node);
+
+    /**
+     * Now we call recursive tasks
+     */
+    ZDD low, high;
+    SYLVAN_FORK(zdd, high, low, (zdd_maximal, dd1), (zdd_maximal, dd0));
+    zdd_refs_push(low);
+
+    /**
+     * A maximal set without dd_var must not be contained in a (maximal) set with dd_var
+     */
+    low = CALL(zdd_nonsub, low, high);
+    zdd_refs_pop(2);
+
+    /**
+     * Compute result node
+     */
+    result = zdd_makenode(dd_var, low, high);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_MINMAX, dd, 1, 0, result)) {
+        sylvan_stats_count(ZDD_MAXIMAL_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute existential quantification, but stay in same domain
+ */
+TASK_IMPL_2(ZDD, zdd_exists, ZDD, dd, ZDD, vars)
+{
+    /**
+     * Trivial cases
+     */
+    if (dd == zdd_true) return vars; // <vars> now represents True for the variables in <vars>
+    if (dd == zdd_false) return dd;
+    if (vars == zdd_true) return dd;
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_EXISTS);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_EXISTS, dd, vars, 0, &result)) {
+        sylvan_stats_count(ZDD_EXISTS_CACHED);
+        return result;
+    }
+
+    /**
+     * Obtain variables
+     */
+    const zddnode_t dd_node = ZDD_GETNODE(dd);
+    const uint32_t dd_var = zddnode_getvariable(dd_node);
+    const zddnode_t vars_node = ZDD_GETNODE(vars);
+    const uint32_t vars_var = zddnode_getvariable(vars_node);
+
+    /**
+     * Compute pivot variable
+     */
+    if (vars_var < dd_var) {
+        result = zdd_exists(dd, zddnode_high(vars, vars_node));
+        result = zdd_makenode(vars_var, result, result);
+    } else {
+        /**
+         * Get cofactors
+         */
+        const ZDD dd0 = zddnode_low(dd, dd_node);
+        const ZDD dd1 = zddnode_high(dd, dd_node);
+
+        if (vars_var == dd_var) {
+            // Quantify
+
+            /**
+             * Now we call recursive tasks
+             */
+            const ZDD vars_next = zddnode_high(vars, vars_node);
+            if (dd0 == dd1) {
+                result = CALL(zdd_exists, dd0, vars_next);
+            } else {
+                zdd_refs_spawn(SPAWN(zdd_exists, dd0, vars_next));
+                ZDD high = CALL(zdd_exists, dd1, vars_next);
+                zdd_refs_push(high);
+                ZDD low = zdd_refs_sync(SYNC(zdd_exists));
+                zdd_refs_push(low);
+                result = zdd_or(low, high);
+                zdd_refs_pop(2);
+            }
+
+            result = zdd_makenode(vars_var, result, result);
+        } else {
+            // Keep
+
+            /**
+             * Now we call recursive tasks
+             */
+            ZDD low, high;
+            if (dd0 == dd1) {
+                low = high = CALL(zdd_exists, dd0, vars);
+            } else {
+                SYLVAN_FORK(zdd, high, low, (zdd_exists, dd1, vars), (zdd_exists, dd0, vars));
+                zdd_refs_pop(1);
+            }
+
+            /**
+             * Compute result node
+             */
+            result = zdd_makenode(dd_var, low, high);
+        }
+    }
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_EXISTS, dd, vars, 0, result)) {
+        sylvan_stats_count(ZDD_EXISTS_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute existential quantification to a smaller domain
+ * Remove all variables from <dd> that are not in <newdom>
+ */
+TASK_IMPL_2(ZDD, zdd_project, ZDD, dd, ZDD, dom)
+{
+    /**
+     * Trivial cases
+     */
+    if (dd == zdd_true) return dd;
+    if (dd == zdd_false) return dd;
+    if (dom == zdd_true) return zdd_true; // assuming dd is indeed Boolean
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_PROJECT);
+
+    /**
+     * Obtain variables
+     */
+    const zddnode_t dd_node = ZDD_GETNODE(dd);
+    const uint32_t dd_var = zddnode_getvariable(dd_node);
+
+    /**
+     * Move dom to dd_var
+     */
+    zddnode_t dom_node = ZDD_GETNODE(dom);
+    uint32_t dom_var = zddnode_getvariable(dom_node);
+    ZDD dom_next = zddnode_high(dom, dom_node);
+    while (dom_var < dd_var) {
+        dom = dom_next;
+        if (dom == zdd_true) return zdd_true; // assuming dd is indeed Boolean
+        dom_node = ZDD_GETNODE(dom);
+        dom_var = zddnode_getvariable(dom_node);
+        dom_next = zddnode_high(dom, dom_node);
+    }
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_PROJECT, dd, dom, 0, &result)) {
+        sylvan_stats_count(ZDD_PROJECT_CACHED);
+        return result;
+    }
+
+    /**
+     * Get cofactors
+     */
+    const ZDD dd0 = zddnode_low(dd, dd_node);
+    const ZDD dd1 = zddnode_high(dd, dd_node);
+
+    assert(dd_var <= dom_var);
+
+    /**
+     * Compute pivot variable
+     */
+    if (dd_var < dom_var) {
+        // Quantify
+
+        /**
+         * Now we call recursive tasks
+         */
+        if (dd0 == dd1) {
+            result = CALL(zdd_project, dd0, dom);
+        } else {
+            zdd_refs_spawn(SPAWN(zdd_project, dd0, dom));
+            ZDD high = CALL(zdd_project, dd1, dom);
+            zdd_refs_push(high);
+            ZDD low = zdd_refs_sync(SYNC(zdd_project));
+            zdd_refs_push(low);
+            result = zdd_or(low, high);
+            zdd_refs_pop(2);
+        }
+    } else {
+        // Keep
+
+        /**
+         * Now we call recursive tasks
+         */
+        ZDD low, high;
+        if (dd0 == dd1) {
+            low = high = CALL(zdd_project, dd0, dom_next);
+        } else {
+            zdd_refs_spawn(SPAWN(zdd_project, dd0, dom_next));
+            high = CALL(zdd_project, dd1, dom_next);
+            zdd_refs_push(high);
+            low = zdd_refs_sync(SYNC(zdd_project));
+            zdd_refs_pop(1);
+        }
+
+        /**
+         * Compute result node
+         */
+        result = zdd_makenode(dd_var, low, high);
+    }
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_PROJECT, dd, dom, 0, result)) {
+        sylvan_stats_count(ZDD_PROJECT_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute universal quantification, but stay in same domain
+ */
+TASK_IMPL_2(ZDD, zdd_forall, ZDD, dd, ZDD, vars)
+{
+    /**
+     * Trivial cases
+     */
+    if (vars == zdd_true) return dd;
+    if (dd == zdd_false) return dd;
+    if (dd == zdd_true) return zdd_false; // True only if all variables in <vars> are 0
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_FORALL);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_FORALL, dd, vars, 0, &result)) {
+        sylvan_stats_count(ZDD_FORALL_CACHED);
+        return result;
+    }
+
+    /**
+     * Obtain variables
+     */
+    const zddnode_t dd_node = ZDD_GETNODE(dd);
+    const uint32_t dd_var = zddnode_getvariable(dd_node);
+    const zddnode_t vars_node = ZDD_GETNODE(vars);
+    const uint32_t vars_var = zddnode_getvariable(vars_node);
+
+    /**
+     * Compute pivot variable
+     */
+    if (vars_var < dd_var) {
+        // <dd> is False when the variable is 1
+        result = zdd_false;
+    } else {
+        /**
+         * Get cofactors
+         */
+        const ZDD dd0 = zddnode_low(dd, dd_node);
+        const ZDD dd1 = zddnode_high(dd, dd_node);
+
+        if (vars_var == dd_var) {
+            // Quantify
+
+            /**
+             * Now we call recursive tasks
+             */
+            const ZDD vars_next = zddnode_high(vars, vars_node);
+            if (dd0 == dd1) {
+                result = CALL(zdd_forall, dd0, vars_next);
+            } else {
+                zdd_refs_spawn(SPAWN(zdd_forall, dd0, vars_next));
+                ZDD high = CALL(zdd_forall, dd1, vars_next);
+                zdd_refs_push(high);
+                ZDD low = zdd_refs_sync(SYNC(zdd_forall));
+                zdd_refs_push(low);
+                result = zdd_and(low, high);
+                zdd_refs_pop(2);
+            }
+
+            result = zdd_makenode(vars_var, result, result);
+        } else {
+            // Keep
+
+            /**
+             * Now we call recursive tasks
+             */
+            ZDD low, high;
+            if (dd0 == dd1) {
+                low = high = CALL(zdd_forall, dd0, vars);
+            } else {
+                SYLVAN_FORK(zdd, high, low, (zdd_forall, dd1, vars), (zdd_forall, dd0, vars));
+                zdd_refs_pop(1);
+            }
+
+            /**
+             * Compute result node
+             */
+            result = zdd_makenode(dd_var, low, high);
+        }
+    }
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_FORALL, dd, vars, 0, result)) {
+        sylvan_stats_count(ZDD_FORALL_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute \exists <vars>: <a> and <b>, but stay in same domain
+ */
+TASK_IMPL_3(ZDD, zdd_and_exists, ZDD, a, ZDD, b, ZDD, vars)
+{
+    /**
+     * Trivial cases
+     */
+    if (a == zdd_false || b == zdd_false) return zdd_false;
+    if (vars == zdd_true) return zdd_and(a, b);
+    if (a == b) return zdd_exists(a, vars);
+    if (a == zdd_true || b == zdd_true) {
+        ZDD result = zdd_and(a, b);
+        zdd_refs_push(result);
+        result = zdd_exists(result, vars);
+        zdd_refs_pop(1);
+        return result;
+    }
+
+    /**
+     * Switch A and B if A > B (for cache)
+     */
+    if (ZDD_GETINDEX(a) > ZDD_GETINDEX(b)) {
+        ZDD t = a;
+        a = b;
+        b = t;
+    }
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_AND_EXISTS);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_AND_EXISTS, a, b, vars, &result)) {
+        sylvan_stats_count(ZDD_AND_EXISTS_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = ZDD_GETNODE(a);
+    const uint32_t a_var = zddnode_getvariable(a_node);
+    const zddnode_t b_node = ZDD_GETNODE(b);
+    const uint32_t b_var = zddnode_getvariable(b_node);
+    const zddnode_t vars_node = ZDD_GETNODE(vars);
+    const uint32_t vars_var = zddnode_getvariable(vars_node);
+    const uint32_t minvar = a_var < b_var ? a_var : b_var;
+
+    if (vars_var < minvar) {
+        // <a> and <b> are False when the variable is 1
+        result = CALL(zdd_and_exists, a, b, zddnode_high(vars, vars_node));
+        result = zdd_makenode(vars_var, result, result);
+    } else {
+        /**
+         * Get the cofactors
+         */
+        const ZDD a0 = minvar < a_var ? a : zddnode_low(a, a_node);
+        const ZDD a1 = minvar < a_var ? zdd_false : zddnode_high(a, a_node);
+        const ZDD b0 = minvar < b_var ? b : zddnode_low(b, b_node);
+        const ZDD b1 = minvar < b_var ? zdd_false : zddnode_high(b, b_node);
+
+        if (vars_var == minvar) {
+            // Quantify
+            const ZDD vars_next = zddnode_high(vars, vars_node);
+            zdd_refs_spawn(SPAWN(zdd_and_exists, a0, b0, vars_next));
+            ZDD high = CALL(zdd_and_exists, a1, b1, vars_next);
+            zdd_refs_push(high);
+            ZDD low = zdd_refs_sync(SYNC(zdd_and_exists));
+            zdd_refs_push(low);
+            result = zdd_or(low, high);
+            zdd_refs_pop(2);
+            result = zdd_makenode(minvar, result, result);
+        } else {
+            // Keep
+            ZDD low, high;
+            SYLVAN_FORK(zdd, high, low, (zdd_and_exists, a1, b1, vars), (zdd_and_exists, a0, b0, vars));
+            zdd_refs_pop(1);
+            result = zdd_makenode(minvar, low, high);
+        }
+    }
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_AND_EXISTS, a, b, vars, result)) {
+        sylvan_stats_count(ZDD_AND_EXISTS_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute <a> and <b>, and remove all variables that are not in <dom>
+ */
+TASK_IMPL_3(ZDD, zdd_and_project, ZDD, a, ZDD, b, ZDD, dom)
+{
+    /**
+     * Trivial cases
+     */
+    if (a == zdd_false || b == zdd_false) return zdd_false;
+    if (a == b) return zdd_project(a, dom);
+    if (dom == zdd_true || a == zdd_true || b == zdd_true) {
+        ZDD result = zdd_and(a, b);
+        zdd_refs_push(result);
+        result = zdd_project(result, dom);
+        zdd_refs_pop(1);
+        return result;
+    }
+
+    /**
+     * Switch A and B if A > B (for cache)
+     */
+    if (ZDD_GETINDEX(a) > ZDD_GETINDEX(b)) {
+        ZDD t = a;
+        a = b;
+        b = t;
+    }
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_AND_PROJECT);
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t a_node = ZDD_GETNODE(a);
+    const uint32_t a_var = zddnode_getvariable(a_node);
+    const zddnode_t b_node = ZDD_GETNODE(b);
+    const uint32_t b_var = zddnode_getvariable(b_node);
+    const uint32_t minvar = a_var < b_var ? a_var : b_var;
+
+    /**
+     * Move dom to minvar
+     */
+    zddnode_t dom_node = ZDD_GETNODE(dom);
+    uint32_t dom_var = zddnode_getvariable(dom_node);
+    ZDD dom_next = zddnode_high(dom, dom_node);
+    while (dom_var < minvar) {
+        dom = dom_next;
+        if (dom == zdd_true) return zdd_and(a, b) == zdd_false ? zdd_false : zdd_true;
+        dom_node = ZDD_GETNODE(dom);
+        dom_var = zddnode_getvariable(dom_node);
+        dom_next = zddnode_high(dom, dom_node);
+    }
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_AND_PROJECT, a, b, dom, &result)) {
+        sylvan_stats_count(ZDD_AND_PROJECT_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the cofactors
+     */
+    const ZDD a0 = minvar < a_var ? a : zddnode_low(a, a_node);
+    const ZDD a1 = minvar < a_var ? zdd_false : zddnode_high(a, a_node);
+    const ZDD b0 = minvar < b_var ? b : zddnode_low(b, b_node);
+    const ZDD b1 = minvar < b_var ? zdd_false : zddnode_high(b, b_node);
+
+    if (minvar < dom_var) {
+        // Quantify
+        zdd_refs_spawn(SPAWN(zdd_and_project, a0, b0, dom));
+        ZDD high = CALL(zdd_and_project, a1, b1, dom);
+        zdd_refs_push(high);
+        ZDD low = zdd_refs_sync(SYNC(zdd_and_project));
+        zdd_refs_push(low);
+        result = zdd_or(low, high);
+        zdd_refs_pop(2);
+    } else {
+        // Keep
+        ZDD low, high;
+        SYLVAN_FORK(zdd, high, low, (zdd_and_project, a1, b1, dom_next), (zdd_and_project, a0, b0, dom_next));
+        zdd_refs_pop(1);
+        result = zdd_makenode(minvar, low, high);
+    }
+
+    /**
+     * Cache the result
+     */
+    if (cache_put3(CACHE_ZDD_AND_PROJECT, a, b, dom, result)) {
+        sylvan_stats_count(ZDD_AND_PROJECT_CACHEDPUT);
+    }
+
+    return result;
+}
+
+/**
+ * Compute (<var> and <high>) or (not <var> and <low>), for Boolean ZDDs <high> and <low> on the same domain
+ * that contains <var>; <high> and <low> must not depend on <var>.
+ */
+TASK_3(ZDD, zdd_mux, uint32_t, var, ZDD, high, ZDD, low)
+{
+    if (high == low) return high;
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Get the vars
+     */
+    const zddnode_t h_node = zdd_isleaf(high) ? NULL : ZDD_GETNODE(high);
+    const uint32_t h_var = h_node == NULL ? 0xffffffff : zddnode_getvariable(h_node);
+    const zddnode_t l_node = zdd_isleaf(low) ? NULL : ZDD_GETNODE(low);
+    const uint32_t l_var = l_node == NULL ? 0xffffffff : zddnode_getvariable(l_node);
+    uint32_t minvar = h_var < l_var ? h_var : l_var;
+
+    /**
+     * Get the cofactors
+     */
+    const ZDD h0 = minvar < h_var ? high : zddnode_low(high, h_node);
+    const ZDD h1 = minvar < h_var ? zdd_false : zddnode_high(high, h_node);
+    const ZDD l0 = minvar < l_var ? low : zddnode_low(low, l_node);
+    const ZDD l1 = minvar < l_var ? zdd_false : zddnode_high(low, l_node);
+
+    // at <var>, take the 0-cofactor of <low> and the 1-cofactor of <high>
+    if (minvar >= var) return zdd_makenode(var, var < minvar ? low : l0, var < h_var ? zdd_false : h1);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get3(CACHE_ZDD_MUX, var, high, low, &result)) return result;
+
+    /**
+     * Now we call recursive tasks
+     */
+    zdd_refs_spawn(SPAWN(zdd_mux, var, h0, l0));
+    ZDD res_high = CALL(zdd_mux, var, h1, l1);
+    zdd_refs_push(res_high);
+    ZDD res_low = zdd_refs_sync(SYNC(zdd_mux));
+    zdd_refs_pop(1);
+
+    result = zdd_makenode(minvar, res_low, res_high);
+    cache_put3(CACHE_ZDD_MUX, var, high, low, result);
+    return result;
+}
+
+/**
+ * Compose the function represented by <dd> at <dom_at>, where all variables of <dom> before <dom_at>
+ * are don't care. The result is a function on the full domain <dom>.
+ */
+TASK_4(ZDD, zdd_compose_rec, ZDD, dd, ZDDMAP, map, ZDD, dom_at, ZDD, dom)
+{
+    /**
+     * Trivial cases
+     */
+    if (dd == zdd_false) return zdd_false;
+    if (dom_at == zdd_true) return dom; // <dd> is True
+    if (map == zdd_map_empty() && dom_at == dom) return dd;
+
+    /**
+     * Maybe run garbage collection
+     */
+    sylvan_gc_test();
+
+    /**
+     * Count operation
+     */
+    sylvan_stats_count(ZDD_COMPOSE);
+
+    /**
+     * Obtain variables and skip map entries before <dom_at>
+     */
+    const zddnode_t dom_node = ZDD_GETNODE(dom_at);
+    const uint32_t dom_var = zddnode_getvariable(dom_node);
+    const ZDD dom_next = zddnode_high(dom_at, dom_node);
+    while (map != zdd_map_empty() && zdd_map_key(map) < dom_var) map = zdd_map_next(map);
+
+    /**
+     * Check the cache
+     */
+    ZDD result;
+    if (cache_get4(CACHE_ZDD_COMPOSE, dd, map, dom_at, dom, &result)) {
+        sylvan_stats_count(ZDD_COMPOSE_CACHED);
+        return result;
+    }
+
+    /**
+     * Get the cofactors
+     */
+    const zddnode_t dd_node = zdd_isleaf(dd) ? NULL : ZDD_GETNODE(dd);
+    const uint32_t dd_var = dd_node == NULL ? 0xffffffff : zddnode_getvariable(dd_node);
+    assert(dom_var <= dd_var);
+    const ZDD dd0 = dom_var < dd_var ? dd : zddnode_low(dd, dd_node);
+    const ZDD dd1 = dom_var < dd_var ? zdd_false : zddnode_high(dd, dd_node);
+
+    /**
+     * Now we call recursive tasks
+     */
+    zdd_refs_spawn(SPAWN(zdd_compose_rec, dd0, map, dom_next, dom));
+    ZDD high = CALL(zdd_compose_rec, dd1, map, dom_next, dom);
+    zdd_refs_push(high);
+    ZDD low = zdd_refs_sync(SYNC(zdd_compose_rec));
+    zdd_refs_push(low);
+
+    /**
+     * Replace the variable by its value in the map, or keep it
+     */
+    if (map != zdd_map_empty() && zdd_map_key(map) == dom_var) {
+        result = zdd_ite(zdd_map_value(map), high, low, dom);
+    } else {
+        result = CALL(zdd_mux, dom_var, high, low);
+    }
+    zdd_refs_pop(2);
+
+    /**
+     * Cache the result
+     */
+    if (cache_put4(CACHE_ZDD_COMPOSE, dd, map, dom_at, dom, result)) {
+        sylvan_stats_count(ZDD_COMPOSE_CACHEDPUT);
+    }
+
+    return result;
+}
+
+TASK_IMPL_3(ZDD, zdd_compose, ZDD, dd, ZDDMAP, map, ZDD, dom)
+{
+    return CALL(zdd_compose_rec, dd, map, dom, dom);
+}
+
+TASK_2(int, zdd_test_isvalid_rec, ZDD, dd, uint32_t, parent_var)
+{
+    // check if True/False leaf
+    if (dd == zdd_true || dd == zdd_false) return 1;
+
+    // check if index is in array
+    uint64_t index = ZDD_GETINDEX(dd);
+    assert(index > 1 && index < nodes->table_size);
+    if (index <= 1 || index >= nodes->table_size) return 0;
+
+    // check if marked
+    int marked = llmsset_is_marked(nodes, index);
+    assert(marked);
+    if (marked == 0) return 0;
+
+    // check if leaf
+    zddnode_t n = ZDD_GETNODE(dd);
+    if (zddnode_isleaf(n)) return 1; // we're fine
+
+    // check variable order
+    uint32_t var = zddnode_getvariable(n);
+    assert(parent_var == 0xffffffff || var > parent_var);
+    if (parent_var != 0xffffffff && var <= parent_var) return 0;
+
+    // check that the high edge is not False
+    ZDD high = zddnode_high(dd, n);
+    assert(high != zdd_false);
+    if (high == zdd_false) return 0;
+
+    // check cache
+    uint64_t result;
+    if (cache_get3(CACHE_ZDD_ISVALID, dd, 0, 0, &result)) {
+        return result;
+    }
+
+    // check recursively
+    SPAWN(zdd_test_isvalid_rec, zddnode_low(dd, n), var);
+    result = (uint64_t)CALL(zdd_test_isvalid_rec, high, var);
+    if (!SYNC(zdd_test_isvalid_rec)) result = 0;
+
+    // put in cache and return result
+    cache_put3(CACHE_ZDD_ISVALID, dd, 0, 0, result);
+
+    return result;
+}
+
+TASK_IMPL_1(int, zdd_test_isvalid, ZDD, dd)
+{
+    return CALL(zdd_test_isvalid_rec, dd, 0xffffffff);
+}
+
+ZDD zdd_enum_first(ZDD dd, ZDD dom, uint8_t *arr, zdd_enum_filter_cb filter_cb)
+{
+    if (dd == zdd_false) {
+        return zdd_false;
     } else if (zdd_isleaf(dd)) {
         if (filter_cb != NULL && filter_cb(dd) == 0) return zdd_false;
         while (dom != zdd_true) {
@@ -1910,97 +3443,134 @@ VOID_TASK_IMPL_4(zdd_visit_par, ZDD, dd, zdd_visit_pre_cb, pre_cb, zdd_visit_pos
 }
 
 /**
- * Writing ZDD files using a skiplist as a backend
+ * Writing ZDD files using a sylvan_writer as a backend
  */
 
-TASK_2(int, zdd_writer_add_visitor_pre, ZDD, dd, sylvan_skiplist_t, sl)
+static uint32_t
+zdd_writer_var(uint64_t index)
+{
+    zddnode_t n = ZDD_GETNODE(index);
+    return zddnode_isleaf(n) ? 0xffffffff : zddnode_getvariable(n);
+}
+
+static inline ZDD
+zdd_writer_translate(sylvan_writer_t w, ZDD dd)
+{
+    if (ZDD_GETINDEX(dd) <= 1) return dd;
+    return ZDD_SETINDEX(dd, sylvan_writer_get(w, ZDD_GETINDEX(dd)));
+}
+
+static void
+zdd_writer_node(sylvan_writer_t w, uint64_t index, uint64_t *dst)
+{
+    zddnode_t n = ZDD_GETNODE(index);
+    ZDD low = zdd_writer_translate(w, zddnode_getlow(n));
+    ZDD high = zdd_writer_translate(w, zddnode_gethigh(n));
+    zddnode_makenode((zddnode_t)dst, zddnode_getvariable(n), low, high);
+}
+
+static void
+zdd_writer_codec_get(void *ctx, uint64_t number, sylvan_codec_node_t *node)
 {
-    if (zdd_isleaf(dd)) return 0;
-    return sylvan_skiplist_get(sl, ZDD_GETINDEX(dd)) == 0 ? 1 : 0;
+    sylvan_writer_t w = (sylvan_writer_t)ctx;
+    zddnode_t n = ZDD_GETNODE(sylvan_writer_getr(w, number));
+    node->key = zddnode_getvariable(n);
+    node->child[0] = zdd_writer_translate(w, zddnode_getlow(n));
+    node->child[1] = zdd_writer_translate(w, zddnode_gethigh(n));
 }
 
-VOID_TASK_2(zdd_writer_add_visitor_post, ZDD, dd, sylvan_skiplist_t, sl)
+VOID_TASK_2(zdd_writer_add_rec, sylvan_writer_t, w, ZDD, dd)
 {
     if (ZDD_GETINDEX(dd) <= 1) return;
-    sylvan_skiplist_assign_next(sl, ZDD_GETINDEX(dd));
+    if (!sylvan_writer_mark(w, ZDD_GETINDEX(dd))) return;
+
+    zddnode_t n = ZDD_GETNODE(dd);
+    if (zddnode_isleaf(n)) return;
+
+    SYLVAN_FORK_VOID((zdd_writer_add_rec, w, zddnode_gethigh(n)), (zdd_writer_add_rec, w, zddnode_getlow(n)));
 }
 
-sylvan_skiplist_t
+sylvan_writer_t
 zdd_writer_start()
 {
-    size_t sl_size = nodes->table_size > 0x7fffffff ? 0x7fffffff : nodes->table_size;
-    return sylvan_skiplist_alloc(sl_size);
+    return sylvan_writer_alloc(zdd_writer_var);
 }
 
-VOID_TASK_IMPL_2(zdd_writer_add, sylvan_skiplist_t, sl, ZDD, dd)
+VOID_TASK_IMPL_2(zdd_writer_add, sylvan_writer_t, w, ZDD, dd)
 {
-    zdd_visit_seq(dd, (zdd_visit_pre_cb)TASK(zdd_writer_add_visitor_pre), (zdd_visit_post_cb)TASK(zdd_writer_add_visitor_post), (void*)sl);
+    CALL(zdd_writer_add_rec, w, dd);
 }
 
 void
-zdd_writer_writebinary(FILE *out, sylvan_skiplist_t sl)
+zdd_writer_writebinary(FILE *out, sylvan_writer_t w)
 {
-    size_t nodecount = sylvan_skiplist_count(sl);
-    fwrite(&nodecount, sizeof(size_t), 1, out);
-    for (size_t i=1; i<=nodecount; i++) {
-        ZDD dd = sylvan_skiplist_getr(sl, i);
+    sylvan_writer_number(w);
 
-        zddnode_t n = ZDD_GETNODE(dd);
-        struct zddnode node;
-        ZDD low = zddnode_getlow(n);
-        ZDD high = zddnode_gethigh(n);
-        if (ZDD_GETINDEX(low) > 1) low = ZDD_SETINDEX(low, sylvan_skiplist_get(sl, ZDD_GETINDEX(low)));
-        if (ZDD_GETINDEX(high) > 1) high = ZDD_SETINDEX(high, sylvan_skiplist_get(sl, ZDD_GETINDEX(high)));
-        zddnode_makenode(&node, zddnode_getvariable(n), low, high);
-        fwrite(&node, sizeof(struct zddnode), 1, out);
+    size_t nodecount = sylvan_writer_count(w);
+    size_t leafcount = sylvan_writer_leafcount(w);
+    const int compact = sylvan_codec_write_header(out) == 0;
+    if (compact) {
+        sylvan_codec_write_varint(out, nodecount);
+        sylvan_codec_write_varint(out, leafcount);
+    } else {
+        fwrite(&nodecount, sizeof(size_t), 1, out);
+    }
+
+    /* leaves (not supported by the reader) are written as they are */
+    for (size_t i=1; i<=leafcount; i++) {
+        fwrite(ZDD_GETNODE(sylvan_writer_getr(w, i)), sizeof(struct zddnode), 1, out);
     }
+
+    if (compact) sylvan_codec_write_nodes(out, leafcount+1, nodecount-leafcount, 1, zdd_writer_codec_get, w);
+    else sylvan_writer_write_nodes(w, out, leafcount+1, zdd_writer_node);
 }
 
 uint64_t
-zdd_writer_get(sylvan_skiplist_t sl, ZDD dd)
+zdd_writer_get(sylvan_writer_t w, ZDD dd)
 {
-    return ZDD_SETINDEX(dd, sylvan_skiplist_get(sl, ZDD_GETINDEX(dd)));
+    sylvan_writer_number(w);
+    return zdd_writer_translate(w, dd);
 }
 
 void
-zdd_writer_end(sylvan_skiplist_t sl)
+zdd_writer_end(sylvan_writer_t w)
 {
-    sylvan_skiplist_free(sl);
+    sylvan_writer_free(w);
 }
 
 VOID_TASK_IMPL_3(zdd_writer_tobinary, FILE *, out, ZDD *, dds, int, count)
 {
-    sylvan_skiplist_t sl = zdd_writer_start();
+    sylvan_writer_t w = zdd_writer_start();
 
     for (int i=0; i<count; i++) {
-        CALL(zdd_writer_add, sl, dds[i]);
+        CALL(zdd_writer_add, w, dds[i]);
     }
 
-    zdd_writer_writebinary(out, sl);
+    zdd_writer_writebinary(out, w);
 
     fwrite(&count, sizeof(int), 1, out);
 
     for (int i=0; i<count; i++) {
-        uint64_t v = zdd_writer_get(sl, dds[i]);
+        uint64_t v = zdd_writer_get(w, dds[i]);
         fwrite(&v, sizeof(uint64_t), 1, out);
     }
 
-    zdd_writer_end(sl);
+    zdd_writer_end(w);
 }
 
 void
-zdd_writer_writetext(FILE *out, sylvan_skiplist_t sl)
+zdd_writer_writetext(FILE *out, sylvan_writer_t w)
 {
+    sylvan_writer_number(w);
+
     fprintf(out, "[\n");
-    size_t nodecount = sylvan_skiplist_count(sl);
+    size_t nodecount = sylvan_writer_count(w);
     for (size_t i=1; i<=nodecount; i++) {
-        ZDD dd = sylvan_skiplist_getr(sl, i);
+        ZDD dd = sylvan_writer_getr(w, i);
 
         zddnode_t n = ZDD_GETNODE(dd);
-        ZDD low = zddnode_getlow(n);
-        ZDD high = zddnode_gethigh(n);
-        if (ZDD_GETINDEX(low) > 1) low = ZDD_SETINDEX(low, sylvan_skiplist_get(sl, ZDD_GETINDEX(low)));
-        if (ZDD_GETINDEX(high) > 1) high = ZDD_SETINDEX(high, sylvan_skiplist_get(sl, ZDD_GETINDEX(high)));
+        ZDD low = zdd_writer_translate(w, zddnode_getlow(n));
+        ZDD high = zdd_writer_translate(w, zddnode_gethigh(n));
         fprintf(out, "  node(%zu,%u,low(%zu),%shigh(%zu)),\n", i, zddnode_getvariable(n), (size_t)ZDD_GETINDEX(low), ZDD_HASMARK(high)?"~":"", (size_t)ZDD_GETINDEX(high));
     }
 
@@ -2009,24 +3579,58 @@ zdd_writer_writetext(FILE *out, sylvan_skiplist_t sl)
 
 VOID_TASK_IMPL_3(zdd_writer_totext, FILE *, out, ZDD *, dds, int, count)
 {
-    sylvan_skiplist_t sl = zdd_writer_start();
+    sylvan_writer_t w = zdd_writer_start();
 
     for (int i=0; i<count; i++) {
-        CALL(zdd_writer_add, sl, dds[i]);
+        CALL(zdd_writer_add, w, dds[i]);
     }
 
-    zdd_writer_writetext(out, sl);
+    zdd_writer_writetext(out, w);
 
     fprintf(out, ",[");
 
     for (int i=0; i<count; i++) {
-        uint64_t v = zdd_writer_get(sl, dds[i]);
+        uint64_t v = zdd_writer_get(w, dds[i]);
         fprintf(out, "%s%zu,", ZDD_HASMARK(v)?"~":"", (size_t)ZDD_STRIPMARK(v));
     }
 
     fprintf(out, "]\n");
 
-    zdd_writer_end(sl);
+    zdd_writer_end(w);
+}
+
+static int
+zdd_reader_children(void *ctx, const uint64_t *rec, uint64_t *children)
+{
+    zddnode_t n = (zddnode_t)rec;
+    (void)ctx;
+    if (zddnode_isleaf(n)) {
+        /* leaves are not supported; report the node as invalid */
+        children[0] = children[1] = UINT64_MAX;
+        return 2;
+    }
+    children[0] = ZDD_GETINDEX(zddnode_getlow(n));
+    children[1] = ZDD_GETINDEX(zddnode_gethigh(n));
+    return 2;
+}
+
+static uint64_t
+zdd_reader_node(void *ctx, const uint64_t *rec, const uint64_t *arr)
+{
+    zddnode_t n = (zddnode_t)rec;
+    (void)ctx;
+    ZDD low = zddnode_getlow(n);
+    ZDD high = zddnode_gethigh(n);
+    if (ZDD_GETINDEX(low) > 0) low = ZDD_SETINDEX(low, arr[ZDD_GETINDEX(low)]);
+    if (ZDD_GETINDEX(high) > 0) high = ZDD_SETINDEX(high, arr[ZDD_GETINDEX(high)]);
+    return zdd_makenode(zddnode_getvariable(n), low, high);
+}
+
+static void
+zdd_reader_codec_put(void *ctx, uint64_t number, const sylvan_codec_node_t *node)
+{
+    uint64_t *recs = (uint64_t*)ctx;
+    zddnode_makenode((zddnode_t)(recs+2*number), node->key, node->child[0], node->child[1]);
 }
 
 /**
@@ -2037,25 +3641,45 @@ VOID_TASK_IMPL_3(zdd_writer_totext, FILE *, out, ZDD *, dds, int, count)
  */
 TASK_IMPL_1(uint64_t*, zdd_reader_readbinary, FILE*, in)
 {
-    size_t nodecount;
-    if (fread(&nodecount, sizeof(size_t), 1, in) != 1) {
-        return NULL;
-    }
+    uint64_t nodecount, leafcount;
+    const int compact = sylvan_codec_read_header(in, &nodecount);
+    if (compact < 0) return NULL;
+    if (compact && sylvan_codec_read_varint(in, &nodecount) != 0) return NULL;
+    if (compact && (sylvan_codec_read_varint(in, &leafcount) != 0 || leafcount > nodecount)) return NULL;
+    if (!compact) leafcount = nodecount;
+    if (nodecount >= SIZE_MAX / (2*sizeof(uint64_t))) return NULL;
 
+    uint64_t *recs = malloc(sizeof(uint64_t)*2*(nodecount+1));
     uint64_t *arr = malloc(sizeof(uint64_t)*(nodecount+1));
+    if (recs == NULL || arr == NULL) {
+        free(recs);
+        free(arr);
+        return NULL;
+    }
     arr[0] = 0;
-    for (size_t i=1; i<=nodecount; i++) {
-        struct zddnode node;
-        if (fread(&node, sizeof(struct zddnode), 1, in) != 1) {
-            free(arr);
-            return NULL;
-        }
 
-        ZDD low = zddnode_getlow(&node);
-        ZDD high = zddnode_gethigh(&node);
-        if (ZDD_GETINDEX(low) > 0) low = ZDD_SETINDEX(low, arr[ZDD_GETINDEX(low)]);
-        if (ZDD_GETINDEX(high) > 0) high = ZDD_SETINDEX(high, arr[ZDD_GETINDEX(high)]);
-        arr[i] = zdd_makenode(zddnode_getvariable(&node), low, high);
+    /* Read the raw nodes in blocks of up to 65536 nodes (in a compact file, only the leaves) */
+    int res = 0;
+    for (size_t i=1; i<=leafcount && res == 0; i+=65536) {
+        size_t count = leafcount - i + 1;
+        if (count > 65536) count = 65536;
+        if (fread(recs+2*i, sizeof(struct zddnode), count, in) != count) res = -1;
+    }
+    if (res == 0 && compact) {
+        res = CALL(sylvan_codec_read_nodes, in, leafcount+1, nodecount-leafcount, 1, zdd_reader_codec_put, recs);
+    }
+    if (res != 0) {
+        free(recs);
+        free(arr);
+        return NULL;
+    }
+
+    /* Create the nodes in parallel, level by level */
+    res = CALL(sylvan_reader_make_nodes, recs, nodecount, arr, zdd_reader_children, zdd_reader_node, NULL);
+    free(recs);
+    if (res != 0) {
+        free(arr);
+        return NULL;
     }
 
     return arr;
@@ -2114,6 +3738,112 @@ TASK_IMPL_3(int, zdd_reader_frombinary, FILE*, in, ZDD*, dds, int, count)
     return 0;
 }
 
+/**
+ * Streams, with the serializers of sylvan_serializer.c
+ */
+
+static int
+zdd_ser_children(uint64_t index, uint64_t *children)
+{
+    zddnode_t n = ZDD_GETNODE(index);
+    if (zddnode_isleaf(n)) return 0;
+    children[0] = ZDD_GETINDEX(zddnode_getlow(n));
+    children[1] = ZDD_GETINDEX(zddnode_gethigh(n));
+    return 2;
+}
+
+static void
+zdd_ser_encode(sylvan_ser_t s, uint64_t index, sylvan_codec_node_t *node)
+{
+    zddnode_t n = ZDD_GETNODE(index);
+    if (zddnode_isleaf(n)) {
+        node->key = zddnode_gettype(n);
+        node->child[0] = zddnode_getvalue(n);
+        node->child[1] = 0;
+    } else {
+        const ZDD low = zddnode_getlow(n), high = zddnode_gethigh(n);
+        node->key = zddnode_getvariable(n);
+        node->child[0] = ZDD_SETINDEX(low, sylvan_ser_get(s, ZDD_GETINDEX(low)));
+        node->child[1] = ZDD_SETINDEX(high, sylvan_ser_get(s, ZDD_GETINDEX(high)));
+    }
+}
+
+static void
+zdd_ser_to_record(const sylvan_codec_node_t *node, uint64_t *rec)
+{
+    zddnode_makenode((zddnode_t)rec, node->key, node->child[0], node->child[1]);
+}
+
+static void
+zdd_ser_write_leaf(uint64_t index, FILE *out)
+{
+    fwrite(ZDD_GETNODE(index), sizeof(struct zddnode), 1, out);
+}
+
+static int
+zdd_ser_read_leaf(FILE *in, uint64_t *index)
+{
+    struct zddnode n;
+    if (fread(&n, sizeof(struct zddnode), 1, in) != 1 || !zddnode_isleaf(&n)) return -1;
+    *index = zdd_makeleaf(zddnode_gettype(&n), zddnode_getvalue(&n));
+    return 0;
+}
+
+static const sylvan_ser_ops_t zdd_ser_ops = {
+    2, // 0 and 1 are constants (zdd_false, and zdd_true without complement edges)
+    zdd_ser_children,
+    zdd_ser_encode,
+    zdd_ser_to_record,
+    zdd_reader_children,
+    zdd_reader_node,
+    zdd_ser_write_leaf,
+    zdd_ser_read_leaf,
+};
+
+zdd_stream_t
+zdd_stream_alloc()
+{
+    return sylvan_ser_alloc(&zdd_ser_ops);
+}
+
+void
+zdd_stream_free(zdd_stream_t s)
+{
+    sylvan_ser_free(s);
+}
+
+void
+zdd_stream_write_begin(zdd_stream_t s, FILE *out)
+{
+    sylvan_ser_write_begin(s, out);
+}
+
+TASK_IMPL_3(uint64_t, zdd_stream_write_push, zdd_stream_t, s, FILE*, out, ZDD, dd)
+{
+    const uint64_t key = ZDD_SETINDEX(dd, CALL(sylvan_ser_add, s, ZDD_GETINDEX(dd)));
+    CALL(sylvan_ser_write_push, s, out, key);
+    return key;
+}
+
+VOID_TASK_IMPL_2(zdd_stream_write_end, zdd_stream_t, s, FILE*, out)
+{
+    CALL(sylvan_ser_write_end, s, out);
+}
+
+int
+zdd_stream_read_begin(zdd_stream_t s, FILE *in)
+{
+    return sylvan_ser_read_begin(s, in);
+}
+
+TASK_IMPL_3(int, zdd_stream_read_next, zdd_stream_t, s, FILE*, in, ZDD*, dd)
+{
+    uint64_t key;
+    const int res = CALL(sylvan_ser_read_next, s, in, &key);
+    if (res == 1) *dd = ZDD_SETINDEX(key, sylvan_ser_get_reversed(s, ZDD_GETINDEX(key)));
+    return res;
+}
+
 /**
  * ISOP algorithm based on the implementation in CuDD
  * Given lower bound L and upper bound U as BDDs, compute a cover and BDD...
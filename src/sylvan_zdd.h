@@ -300,32 +300,32 @@ TASK_DECL_2(ZDD, zdd_diff, ZDD, ZDD);
 #define zdd_diff(a, b) RUN(zdd_diff, a, b)
 
 /**
- * Compute logical XOR of <a> and <b>.
+ * Compute logical XOR of <a> and <b>. (symmetric difference)
  */
-// TASK_DECL_2(ZDD, zdd_xor, ZDD, ZDD);
-// #define zdd_xor(a, b) RUN(zdd_xor, a, b)
+TASK_DECL_2(ZDD, zdd_xor, ZDD, ZDD);
+#define zdd_xor(a, b) RUN(zdd_xor, a, b)
 
 /**
  * Compute logical EQUIV of <a> and <b>.
  * Also called bi-implication. (a <-> b)
  * This operation requires the variable domain <dom>.
  */
-// TASK_DECL_3(ZDD, zdd_equiv, ZDD, ZDD, ZDD);
-// #define zdd_equiv(a, b, dom) RUN(zdd_equiv, a, b, dom)
+TASK_DECL_3(ZDD, zdd_equiv, ZDD, ZDD, ZDD);
+#define zdd_equiv(a, b, dom) RUN(zdd_equiv, a, b, dom)
 
 /**
  * Compute logical IMP of <a> and <b>. (a -> b)
  * This operation requires the variable domain <dom>.
  */
-// TASK_DECL_3(ZDD, zdd_imp, ZDD, ZDD, ZDD);
-// #define zdd_imp(a, b, dom) RUN(zdd_imp, a, b, dom)
+TASK_DECL_3(ZDD, zdd_imp, ZDD, ZDD, ZDD);
+#define zdd_imp(a, b, dom) RUN(zdd_imp, a, b, dom)
 
 /**
- * Compute logical INVIMP of <a> and <b>. (b <- a)
+ * Compute logical INVIMP of <a> and <b>. (a <- b)
  * This operation requires the variable domain <dom>.
  */
-// TASK_DECL_3(ZDD, zdd_invimp, ZDD, ZDD, ZDD);
-// #define zdd_invimp(a, b, dom) RUN(zdd_invimp, a, b, dom)
+TASK_DECL_3(ZDD, zdd_invimp, ZDD, ZDD, ZDD);
+#define zdd_invimp(a, b, dom) RUN(zdd_invimp, a, b, dom)
 
 // add binary operators
 // zdd_diff (no domain) == a and not b
@@ -333,6 +333,69 @@ TASK_DECL_2(ZDD, zdd_diff, ZDD, ZDD);
 // zdd_nand (domain)    == not (a and b)
 // zdd_nor  (domain)    == not a and not b
 
+/**
+ * Family algebra.
+ * Read without a domain, a ZDD is a family of sets of variables: each path to True
+ * is the set of variables on its high edges. zdd_or, zdd_and and zdd_diff are union,
+ * intersection and difference of families. The operations below need no domain either.
+ */
+
+/**
+ * Compute the join of the families <a> and <b>: { f \cup g | f \in a, g \in b }.
+ */
+TASK_DECL_2(ZDD, zdd_join, ZDD, ZDD);
+#define zdd_join(a, b) RUN(zdd_join, a, b)
+
+/**
+ * Compute the meet of the families <a> and <b>: { f \cap g | f \in a, g \in b }.
+ */
+TASK_DECL_2(ZDD, zdd_meet, ZDD, ZDD);
+#define zdd_meet(a, b) RUN(zdd_meet, a, b)
+
+/**
+ * Compute the delta of the families <a> and <b>: { f \oplus g | f \in a, g \in b },
+ * where f \oplus g is the symmetric difference of the sets f and g.
+ */
+TASK_DECL_2(ZDD, zdd_delta, ZDD, ZDD);
+#define zdd_delta(a, b) RUN(zdd_delta, a, b)
+
+/**
+ * Compute the quotient <a> / <b>: all sets q such that for every g \in b,
+ * q and g are disjoint and q \cup g \in a. The quotient by the empty family is empty.
+ */
+TASK_DECL_2(ZDD, zdd_quotient, ZDD, ZDD);
+#define zdd_quotient(a, b) RUN(zdd_quotient, a, b)
+
+/**
+ * Compute the remainder <a> % <b>, i.e., <a> minus the join of <b> and <a> / <b>.
+ */
+TASK_DECL_2(ZDD, zdd_remainder, ZDD, ZDD);
+#define zdd_remainder(a, b) RUN(zdd_remainder, a, b)
+
+/**
+ * Compute the sets in <a> that are not a superset of any set in <b>.
+ */
+TASK_DECL_2(ZDD, zdd_nonsup, ZDD, ZDD);
+#define zdd_nonsup(a, b) RUN(zdd_nonsup, a, b)
+
+/**
+ * Compute the sets in <a> that are not a subset of any set in <b>.
+ */
+TASK_DECL_2(ZDD, zdd_nonsub, ZDD, ZDD);
+#define zdd_nonsub(a, b) RUN(zdd_nonsub, a, b)
+
+/**
+ * Compute the minimal sets of <dd>, i.e., the sets that have no proper subset in <dd>.
+ */
+TASK_DECL_1(ZDD, zdd_minimal, ZDD);
+#define zdd_minimal(dd) RUN(zdd_minimal, dd)
+
+/**
+ * Compute the maximal sets of <dd>, i.e., the sets that have no proper superset in <dd>.
+ */
+TASK_DECL_1(ZDD, zdd_maximal, ZDD);
+#define zdd_maximal(dd) RUN(zdd_maximal, dd)
+
 /**
  * Compute \exists <vars>: <dd>.
  * (Stays in same variable domain.)
@@ -349,30 +412,33 @@ TASK_DECL_2(ZDD, zdd_project, ZDD, ZDD);
 
 /**
  * Compute \forall <vars>: <dd>.
+ * (Stays in same variable domain.)
  */
-// TASK_DECL_2(ZDD, zdd_forall, ZDD, ZDD);
-// #define zdd_forall(dd, vars) RUN(zdd_forall, dd, vars)
+TASK_DECL_2(ZDD, zdd_forall, ZDD, ZDD);
+#define zdd_forall(dd, vars) RUN(zdd_forall, dd, vars)
 
 /**
  * Compute \exists <vars>: <a> and <b>.
  * Result is in same domain as <a> and <b>.
  */
-// TASK_DECL_3(ZDD, zdd_and_exists, ZDD, ZDD, ZDD);
-// #define zdd_and_exists(a, b, vars) RUN(zdd_and_exists, a, b, vars)
+TASK_DECL_3(ZDD, zdd_and_exists, ZDD, ZDD, ZDD);
+#define zdd_and_exists(a, b, vars) RUN(zdd_and_exists, a, b, vars)
 
 /**
- * Compute <a> and <b> and project result on <domain>
+ * Compute <a> and <b> and project result on <domain>.
+ * (Changes to the new variable domain.)
  */
-// TASK_DECL_3(ZDD, zdd_and_project, ZDD, ZDD, ZDD);
-// #define zdd_and_project(a, b, domain) RUN(zdd_and_project, a, b, domain)
+TASK_DECL_3(ZDD, zdd_and_project, ZDD, ZDD, ZDD);
+#define zdd_and_project(a, b, domain) RUN(zdd_and_project, a, b, domain)
 
 /**
- * Function composition, for each node with variable <key> which has a <key,value> pair in <map>,
- * replace the node by the result of zdd_ite(<value>, <low>, <high>).
- * Each <value> in <map> must be a Boolean ZDD.
+ * Function composition, for each variable <key> which has a <key,value> pair in <map>,
+ * replace the variable by <value>, i.e., the node by the result of zdd_ite(<value>, <high>, <low>).
+ * Each <value> in <map> must be a Boolean ZDD on the domain <dom> of <dd>, which contains all keys.
+ * Unlike BDDs, the cofactors of a ZDD node fix all variables above the node, so the domain is required.
  */
-// TASK_DECL_2(ZDD, zdd_compose, ZDD, ZDDMAP);
-// #define zdd_compose(dd, map) RUN(zdd_compose, dd, map)
+TASK_DECL_3(ZDD, zdd_compose, ZDD, ZDDMAP, ZDD);
+#define zdd_compose(dd, map, dom) RUN(zdd_compose, dd, map, dom)
 
 /**
  * For debugging.
@@ -381,8 +447,8 @@ TASK_DECL_2(ZDD, zdd_project, ZDD, ZDD);
  * In Debug mode, this will cause assertion failures instead of returning 0.
  * Returns 1 if all is fine, or 0 otherwise.
  */
-// TASK_DECL_1(int, zdd_test_isvalid, ZDD);
-// #define zdd_test_isvalid(zdd) RUN(zdd_test_isvalid, zdd)
+TASK_DECL_1(int, zdd_test_isvalid, ZDD);
+#define zdd_test_isvalid(zdd) RUN(zdd_test_isvalid, zdd)
 
 /**
  * Write a DOT representation of a ZDD
@@ -519,19 +585,21 @@ VOID_TASK_DECL_4(zdd_visit_par, ZDD, zdd_visit_pre_cb, zdd_visit_post_cb, void*)
  * Every node that is to be written is assigned a number, starting from 1,
  * such that reading the result in the future can be done in one pass.
  *
- * We use a skiplist to store the assignment.
+ * Nodes are marked in parallel in a bitmap over the nodes table, and numbered in parallel:
+ * first the leaves, then the internal nodes by decreasing variable. Looking up the number of
+ * a node takes constant time, and the nodes are written in large blocks.
  *
  * One could use the following two methods to store an array of ZDDs.
  * - call zdd_writer_tobinary to store ZDDs in binary format.
  * - call zdd_writer_totext to store ZDDs in text format.
  *
  * One could also do the procedure manually instead.
- * - call zdd_writer_start to allocate the skiplist.
- * - call zdd_writer_add to add a given ZDD to the skiplist
+ * - call zdd_writer_start to allocate the writer.
+ * - call zdd_writer_add to add a given ZDD to the writer
  * - call zdd_writer_writebinary to write all added nodes to a file
  * - OR:  zdd_writer_writetext to write all added nodes in text format
- * - call zdd_writer_get to obtain the ZDD identifier as stored in the skiplist
- * - call zdd_writer_end to free the skiplist
+ * - call zdd_writer_get to obtain the ZDD identifier as stored in the writer
+ * - call zdd_writer_end to free the writer
  */
 
 /**
@@ -560,36 +628,36 @@ VOID_TASK_DECL_3(zdd_writer_totext, FILE *, ZDD *, int);
 #define zdd_writer_totext(file, dds, count) RUN(zdd_writer_totext, file, dds, count)
 
 /**
- * Skeleton typedef for the skiplist
+ * Skeleton typedef for the writer
  */
-typedef struct sylvan_skiplist *sylvan_skiplist_t;
+typedef struct sylvan_writer *sylvan_writer_t;
 
 /**
- * Allocate a skiplist for writing an BDD.
+ * Allocate a writer for writing an BDD.
  */
-sylvan_skiplist_t zdd_writer_start(void);
+sylvan_writer_t zdd_writer_start(void);
 
 /**
- * Add the given ZDD to the skiplist.
+ * Add the given ZDD to the writer.
  */
-VOID_TASK_DECL_2(zdd_writer_add, sylvan_skiplist_t, ZDD);
-#define zdd_writer_add(sl, dd) RUN(zdd_writer_add, sl, dd)
+VOID_TASK_DECL_2(zdd_writer_add, sylvan_writer_t, ZDD);
+#define zdd_writer_add(w, dd) RUN(zdd_writer_add, w, dd)
 
 /**
  * Write all assigned ZDD nodes in binary format to the file.
  */
-void zdd_writer_writebinary(FILE *out, sylvan_skiplist_t sl);
+void zdd_writer_writebinary(FILE *out, sylvan_writer_t w);
 
 /**
  * Retrieve the identifier of the given stored ZDD.
  * This is useful if you want to be able to retrieve the stored ZDD later.
  */
-uint64_t zdd_writer_get(sylvan_skiplist_t sl, ZDD dd);
+uint64_t zdd_writer_get(sylvan_writer_t w, ZDD dd);
 
 /**
- * Free the allocated skiplist.
+ * Free the allocated writer.
  */
-void zdd_writer_end(sylvan_skiplist_t sl);
+void zdd_writer_end(sylvan_writer_t w);
 
 /**
  * Reading ZDDs from file (binary format).
@@ -630,6 +698,53 @@ ZDD zdd_reader_get(uint64_t* arr, uint64_t identifier);
  */
 void zdd_reader_end(uint64_t *arr);
 
+/**
+ * Streams of ZDDs, written to a pipe or socket and read without seeking, like the streams of
+ * BDD serializers (see sylvan_serializer_write_begin). A stream numbers the nodes of all pushed
+ * ZDDs, and every push writes only the new nodes: first the new leaves, then the
+ * other nodes in blocks, followed by the key of the ZDD.
+ *
+ * WRITING: use zdd_stream_write_begin, then zdd_stream_write_push for every ZDD (which
+ * flushes), then zdd_stream_write_end
+ * READING: use zdd_stream_read_begin, then zdd_stream_read_next until it returns 0; the nodes
+ * are created one block at a time as they arrive
+ *
+ * Numbered nodes are not garbage collected until the stream is read again or freed.
+ */
+typedef struct sylvan_ser *zdd_stream_t;
+
+zdd_stream_t zdd_stream_alloc(void);
+void zdd_stream_free(zdd_stream_t s);
+
+/**
+ * Start a stream. Nodes that already have a number are written with the first ZDD.
+ */
+void zdd_stream_write_begin(zdd_stream_t s, FILE *out);
+
+/**
+ * Add a ZDD to the stream. Returns its key.
+ */
+TASK_DECL_3(uint64_t, zdd_stream_write_push, zdd_stream_t, FILE*, ZDD);
+#define zdd_stream_write_push(s, out, dd) RUN(zdd_stream_write_push, s, out, dd)
+
+/**
+ * End a stream.
+ */
+VOID_TASK_DECL_2(zdd_stream_write_end, zdd_stream_t, FILE*);
+#define zdd_stream_write_end(s, out) RUN(zdd_stream_write_end, s, out)
+
+/**
+ * Forget all numbers and start reading a stream. Returns 0, or -1 if it is not a stream.
+ */
+int zdd_stream_read_begin(zdd_stream_t s, FILE *in);
+
+/**
+ * Read the next ZDD of a stream into <dd>.
+ * Returns 1, or 0 at the end of the stream, or -1 if the stream is invalid.
+ */
+TASK_DECL_3(int, zdd_stream_read_next, zdd_stream_t, FILE*, ZDD*);
+#define zdd_stream_read_next(s, in, dd) RUN(zdd_stream_read_next, s, in, dd)
+
 /**
  * Garbage collection
  */
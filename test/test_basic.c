@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <float.h>
 #include <string.h>
 #include <pthread.h>
 #include <unistd.h>
@@ -8,6 +9,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <inttypes.h>
+#include <math.h>
 
 #include "sylvan.h"
 #include "test_assert.h"
@@ -152,6 +154,21 @@ make_random_ldd_set(int depth, int maxvalue, int elements)
     return result;
 }
 
+static MTBDD
+make_random_mtbdd(uint32_t *vars, int n, int fraction)
+{
+    if (n == 0) {
+        int value = rng(0, 5);
+        if (value == 0) return mtbdd_false;
+        return fraction ? mtbdd_fraction(value, rng(1, 4)) : mtbdd_double(value);
+    }
+
+    MTBDD low = make_random_mtbdd(vars+1, n-1, fraction);
+    if (rng(0, 3) == 0) return low;
+    MTBDD high = make_random_mtbdd(vars+1, n-1, fraction);
+    return mtbdd_makenode(vars[0], low, high);
+}
+
 int testEqual(BDD a, BDD b)
 {
     if (a == b) return 1;
@@ -542,6 +559,1581 @@ test_ldd()
     return 0;
 }
 
+int
+test_ldd_index()
+{
+    // one wide level with the even values 0..3998, and a narrow level
+    MDD set = lddmc_false;
+    for (uint32_t v=4000; v>0; v-=2) set = lddmc_union_cube(set, (uint32_t[]){v-2, v%7}, 2);
+
+    // relation: read r and write r+1 on the wide level
+    uint32_t reads[5] = {10, 500, 1000, 3998, 3999};
+    MDD rel = lddmc_false;
+    for (int i=0; i<5; i++) rel = lddmc_union_cube(rel, (uint32_t[]){reads[i], reads[i]+1}, 2);
+    MDD meta = lddmc_cube((uint32_t[]){1, 2, (uint32_t)-1}, 3);
+    MDD expected = lddmc_false;
+    for (int i=0; i<4; i++) expected = lddmc_union_cube(expected, (uint32_t[]){reads[i]+1, (reads[i]+2)%7}, 2);
+
+    size_t thresholds[3] = {0, 1, 32};
+    for (int t=0; t<3; t++) {
+        lddmc_set_index_threshold(thresholds[t]);
+        sylvan_clear_cache();
+
+        for (uint32_t v=0; v<4002; v++) {
+            MDD down = lddmc_follow(set, v);
+            if (v % 2 == 0 && v < 4000) test_assert(down == lddmc_cube((uint32_t[]){(v+2)%7}, 1));
+            else test_assert(down == lddmc_false);
+            test_assert(lddmc_member_cube(set, (uint32_t[]){v, (v+2)%7}, 2) == (v % 2 == 0 && v < 4000));
+        }
+
+        test_assert(lddmc_relprod(set, rel, meta) == expected);
+        test_assert(lddmc_intersect(set, expected) == lddmc_false);
+
+        MDD cube = lddmc_cube((uint32_t[]){3001, 1}, 2);
+        test_assert(lddmc_union(set, cube) == lddmc_union_cube(set, (uint32_t[]){3001, 1}, 2));
+        test_assert(lddmc_satcount(lddmc_union(set, expected)) == 2004);
+    }
+
+    // a wide sparse match and relprod, the recursion on the right edges reuses the index of the
+    // level instead of indexing every suffix (which takes quadratic time and memory)
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    const size_t width = 100000;
+    uint32_t *values = (uint32_t*)malloc(sizeof(uint32_t[width]));
+    for (size_t i=0; i<width; i++) values[i] = (uint32_t)i;
+    MDD wide = lddmc_from_sorted_array(values, width, 1);
+    size_t count = 0;
+    for (size_t i=0; i<width; i+=40) values[count++] = (uint32_t)i;
+    MDD sparse = lddmc_from_sorted_array(values, count, 1);
+    for (size_t i=count; i>0; i--) {
+        values[2*i-2] = values[i-1];
+        values[2*i-1] = values[i-1] + 1;
+    }
+    MDD sparse_rel = lddmc_from_sorted_array(values, count, 2);
+    free(values);
+    MDD proj = lddmc_cube((uint32_t[]){1, (uint32_t)-1}, 2);
+    MDD rel_meta = lddmc_cube((uint32_t[]){1, 2, (uint32_t)-1}, 3);
+    double times[2];
+    for (int t=0; t<2; t++) {
+        lddmc_set_index_threshold(t == 0 ? 0 : 32);
+        sylvan_clear_cache();
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        test_assert(lddmc_match(wide, sparse, proj) == sparse);
+        test_assert(lddmc_satcount(lddmc_relprod(wide, sparse_rel, rel_meta)) == (double)count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        times[t] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    test_assert(times[1] < 4 * times[0] + 0.5);
+
+    lddmc_set_index_threshold(32);
+    return 0;
+}
+
+int
+test_ldd_last_value()
+{
+    // chains that end around the largest last value stored in the nodes
+    for (uint32_t last=1018; last<1030; last++) {
+        MDD set = lddmc_false;
+        for (uint32_t v=0; v<=last; v+=3) set = lddmc_union_cube(set, (uint32_t[]){v, v%5}, 2);
+        set = lddmc_union_cube(set, (uint32_t[]){last, 4}, 2);
+        for (uint32_t v=0; v<last+4; v++) {
+            int member = (v % 3 == 0 && v <= last) || v == last;
+            test_assert((lddmc_follow(set, v) != lddmc_false) == member);
+        }
+        MDD other = lddmc_cube((uint32_t[]){last+1, 0}, 2);
+        test_assert(lddmc_intersect(set, other) == lddmc_false);
+        test_assert(lddmc_satcount(lddmc_union(set, other)) == lddmc_satcount(set) + 1);
+
+        // a relation on the end of the chain, and a relation of copy nodes
+        MDD meta = lddmc_cube((uint32_t[]){1, 2, 0, (uint32_t)-1}, 4);
+        MDD rel = lddmc_cube((uint32_t[]){last, last+1}, 2);
+        test_assert(lddmc_relprod(set, rel, meta) == lddmc_makenode(last+1, lddmc_follow(set, last), lddmc_false));
+        MDD copy = lddmc_cube_copy((uint32_t[]){0, 0}, (int[]){1, 1}, 2);
+        test_assert(lddmc_relprod(set, copy, meta) == set);
+    }
+    return 0;
+}
+
+static int
+compare_vectors4(const void *a, const void *b)
+{
+    const uint32_t *va = (const uint32_t*)a, *vb = (const uint32_t*)b;
+    for (int i=0; i<4; i++) {
+        if (va[i] != vb[i]) return va[i] < vb[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+int
+test_ldd_sorted_array()
+{
+    static uint32_t vectors[4*500];
+    for (int count=1; count<=500; count*=7) {
+        MDD expected = lddmc_false;
+        for (int i=0; i<4*count; i++) vectors[i] = rng(0, count < 10 ? 3 : 10);
+        for (int i=0; i<count; i++) expected = lddmc_union_cube(expected, vectors+4*i, 4);
+        qsort(vectors, count, 4*sizeof(uint32_t), compare_vectors4);
+        test_assert(lddmc_from_sorted_array(vectors, count, 4) == expected);
+
+        MDD other = make_random_ldd_set(4, 10, 50);
+        test_assert(lddmc_union_sorted_array(other, vectors, count, 4) == lddmc_union(other, expected));
+    }
+
+    test_assert(lddmc_from_sorted_array(vectors, 0, 4) == lddmc_false);
+    test_assert(lddmc_from_sorted_array(vectors, 3, 0) == lddmc_true);
+    return 0;
+}
+
+/**
+ * Model for test_ldd_learn: three counters 0..3.
+ * group 0 reads/writes x0: x0 := x0+1 if x0 < 3
+ * group 1 reads/writes x1: x1 := x1+1 or x1+2 (at most 3)
+ * group 2 reads x0,x2, writes x1,x2: if x0 == 3 and x2 < 3 then x1 := 0, x2 := x2+1
+ * group 3 writes x2: x2 := 0
+ */
+static void
+learn_next(lddmc_learn_ctx_t ctx, int group, const uint32_t *src, void *context)
+{
+    uint32_t dst[2];
+    if (group == 0 && src[0] < 3) {
+        dst[0] = src[0] + 1;
+        lddmc_learn_add(ctx, dst);
+    } else if (group == 1) {
+        for (uint32_t d=1; d<=2; d++) {
+            if (src[0] + d > 3) break;
+            dst[0] = src[0] + d;
+            lddmc_learn_add(ctx, dst);
+        }
+    } else if (group == 2 && src[0] == 3 && src[1] < 3) {
+        dst[0] = 0;
+        dst[1] = src[1] + 1;
+        lddmc_learn_add(ctx, dst);
+    } else if (group == 3) {
+        dst[0] = 0;
+        lddmc_learn_add(ctx, dst);
+    }
+    (*(int*)context)++;
+}
+
+int
+test_ldd_learn()
+{
+    const int r0[1] = {0}, r1[1] = {1}, r2[2] = {0, 2}, w2[2] = {1, 2}, w3[1] = {2};
+    for (int reach=0; reach<2; reach++) {
+        int calls = 0;
+        lddmc_learner_t learner = lddmc_learner_create(3, 4, learn_next, &calls);
+        lddmc_learner_set_group(learner, 3, 0, NULL, 1, w3);
+        lddmc_learner_set_group(learner, 2, 2, r2, 2, w2);
+        lddmc_learner_set_group(learner, 1, 1, r1, 1, r1);
+        lddmc_learner_set_group(learner, 0, 1, r0, 1, r0);
+
+        uint32_t init[3] = {0, 2, 1};
+        MDD states = lddmc_cube(init, 3);
+
+        // explicit reachability
+        int seen[4][4][4];
+        memset(seen, 0, sizeof(seen));
+        seen[0][2][1] = 1;
+        for (int changed=1; changed;) {
+            changed = 0;
+            for (int a=0; a<4; a++) for (int b=0; b<4; b++) for (int c=0; c<4; c++) {
+                if (!seen[a][b][c]) continue;
+                int succ[5][3] = {{a+1, b, c}, {a, b+1, c}, {a, b+2, c}, {a, 0, c+1}, {a, b, 0}};
+                for (int k=0; k<5; k++) {
+                    if (k == 3 && a != 3) continue;
+                    int *t = succ[k];
+                    if (t[0] > 3 || t[1] > 3 || t[2] > 3 || seen[t[0]][t[1]][t[2]]) continue;
+                    seen[t[0]][t[1]][t[2]] = changed = 1;
+                }
+            }
+        }
+        MDD expected = lddmc_false;
+        for (int a=0; a<4; a++) for (int b=0; b<4; b++) for (int c=0; c<4; c++) {
+            uint32_t v[3] = {a, b, c};
+            if (seen[a][b][c]) expected = lddmc_union_cube(expected, v, 3);
+        }
+
+        if (reach) {
+            test_assert(lddmc_learn_reachable(learner, states) == expected);
+            // a second run learns nothing new
+            int before = calls;
+            test_assert(lddmc_learn_reachable(learner, states) == expected);
+            test_assert(calls == before);
+        } else {
+            // breadth-first search with lddmc_learn
+            MDD visited = states, prev = lddmc_false;
+            while (prev != visited) {
+                prev = visited;
+                for (int g=0; g<4; g++) {
+                    MDD rel = lddmc_learn(learner, g, visited);
+                    visited = lddmc_relprod_union(visited, rel, lddmc_learner_meta(learner, g), visited);
+                }
+            }
+            test_assert(visited == expected);
+        }
+
+        // every short vector is offered once (one worker), group 0 learns x0 -> x0+1 for x0 < 3
+        test_assert(lddmc_satcount(lddmc_learner_relation(learner, 0)) == 3.0);
+        test_assert(lddmc_satcount(lddmc_learner_relation(learner, 3)) == 1.0);
+        test_assert(lddmc_learner_relation(learner, 2) != lddmc_false);
+        lddmc_learner_free(learner);
+    }
+    return 0;
+}
+
+int
+test_ldd_bdd()
+{
+    // variable 0 is not in the relation, 1 is read and written, 2 only read, 3 only written
+    uint32_t meta_arr[6] = {0, 1, 2, 3, 4, (uint32_t)-1};
+    MDD meta = lddmc_cube(meta_arr, 6);
+    for (int k=0; k<10; k++) {
+        MDD states = make_random_ldd_set(4, 9, 30);
+        MDD rel = make_random_ldd_set(4, 11, 30);
+        // add a transition that copies variable 1
+        uint32_t copy_vals[4] = {rng(0, 9), 0, rng(0, 9), rng(0, 9)};
+        int copy[4] = {0, 1, 0, 0};
+        rel = lddmc_union_cube_copy(rel, copy_vals, copy, 4);
+
+        uint32_t highest[4] = {0, 0, 0, 0};
+        lddmc_highest(states, highest);
+        lddmc_rel_highest(rel, meta, highest);
+        test_assert(highest[0] <= 9 && highest[1] <= 11);
+        MDD bits = lddmc_bits_from_highest(highest, 4);
+        size_t totalbits = 0;
+        for (int i=0; i<4; i++) {
+            uint32_t b = 1;
+            while (highest[i] >> b) b++;
+            totalbits += b;
+        }
+
+        // sets
+        MTBDD bdd_states = lddmc_to_bdd(states, bits, 0);
+        test_assert(mtbdd_satcount(bdd_states, totalbits) == (double)lddmc_satcount(states));
+        test_assert(lddmc_from_bdd(bdd_states, bits, 0) == states);
+
+        // relations
+        MTBDD bdd_rel = lddmc_rel_to_bdd(rel, bits, meta, 0);
+        MTBDD vars = lddmc_meta_to_bdd_vars(meta, bits, 0);
+        MDD succ = lddmc_relprod(states, rel, meta);
+        test_assert(sylvan_relnext(bdd_states, bdd_rel, vars) == lddmc_to_bdd(succ, bits, 0));
+        MDD back = lddmc_rel_from_bdd(bdd_rel, bits, meta, 0);
+        test_assert(lddmc_relprod(states, back, meta) == succ);
+        test_assert(lddmc_rel_to_bdd(back, bits, meta, 0) == bdd_rel);
+    }
+    return 0;
+}
+
+int
+test_ldd_relprod_minus()
+{
+    // variable 0 is not in the relation, 1 is read and written, 2 only read, 3 only written
+    MDD meta = lddmc_cube((uint32_t[]){0, 1, 2, 3, 4, (uint32_t)-1}, 6);
+    // with an action label
+    MDD meta_label = lddmc_cube((uint32_t[]){3, 1, 2, 5, (uint32_t)-1}, 5);
+    for (int k=0; k<20; k++) {
+        MDD states = make_random_ldd_set(4, 6, 30);
+        MDD rel = make_random_ldd_set(4, 6, 30);
+        // copy variable 1 and the only-read variable, or copy variable 1 on both levels
+        rel = lddmc_union_cube_copy(rel, (uint32_t[]){rng(0, 6), 0, rng(0, 6), rng(0, 6)}, (int[]){0, 1, 0, 0}, 4);
+        rel = lddmc_union_cube_copy(rel, (uint32_t[]){0, 0, 0, rng(0, 6)}, (int[]){1, 1, 1, 0}, 4);
+        MDD succ = lddmc_relprod(states, rel, meta);
+        MDD avoid = lddmc_union(make_random_ldd_set(4, 6, 30), lddmc_sat_one_mdd(succ));
+        test_assert(lddmc_relprod_minus(states, rel, meta, avoid) == lddmc_minus(succ, avoid));
+        MDD most = lddmc_minus(succ, make_random_ldd_set(4, 6, 300));
+        test_assert(lddmc_relprod_minus(states, rel, meta, most) == lddmc_minus(succ, most));
+        test_assert(lddmc_relprod_minus(states, rel, meta, lddmc_false) == succ);
+        test_assert(lddmc_relprod_minus(states, rel, meta, succ) == lddmc_false);
+        test_assert(lddmc_relprod_minus(states, rel, meta, states) == lddmc_minus(succ, states));
+
+        MDD states2 = make_random_ldd_set(2, 6, 10);
+        MDD rel2 = make_random_ldd_set(4, 6, 30);
+        MDD avoid2 = make_random_ldd_set(2, 6, 10);
+        test_assert(lddmc_relprod_minus(states2, rel2, meta_label, avoid2) == lddmc_minus(lddmc_relprod(states2, rel2, meta_label), avoid2));
+    }
+    return 0;
+}
+
+int
+test_ldd_relprod_multi()
+{
+    // relations on 4 variables, starting at different levels
+    MDD metas[5] = {
+        lddmc_cube((uint32_t[]){1, 2, 1, 2, 1, 2, 1, 2, (uint32_t)-1}, 9),
+        lddmc_cube((uint32_t[]){0, 0, 1, 2, (uint32_t)-1}, 5),
+        lddmc_cube((uint32_t[]){0, 3, 4, (uint32_t)-1}, 4),
+        lddmc_cube((uint32_t[]){3, 0, 0, 1, 2, (uint32_t)-1}, 6),
+        lddmc_cube((uint32_t[]){0, 0, 0, 4, (uint32_t)-1}, 5),
+    };
+    size_t depths[5] = {8, 2, 2, 3, 1};
+    for (int k=0; k<20; k++) {
+        MDD states = make_random_ldd_set(4, 6, 30);
+        MDD rels[5], expected = lddmc_false;
+        for (size_t i=0; i<5; i++) {
+            rels[i] = make_random_ldd_set(depths[i], 6, 20);
+            expected = lddmc_union(expected, lddmc_relprod(states, rels[i], metas[i]));
+        }
+        test_assert(lddmc_relprod_multi(states, rels, metas, 5) == expected);
+        // the order of the relations does not matter, and empty relations are ignored
+        MDD rev_rels[6] = {rels[4], rels[3], lddmc_false, rels[2], rels[1], rels[0]};
+        MDD rev_metas[6] = {metas[4], metas[3], metas[0], metas[2], metas[1], metas[0]};
+        test_assert(lddmc_relprod_multi(states, rev_rels, rev_metas, 6) == expected);
+        test_assert(lddmc_relprod_multi(states, rels+1, metas+1, 1) == lddmc_relprod(states, rels[1], metas[1]));
+        test_assert(lddmc_relprod_multi(states, rels, metas, 0) == lddmc_false);
+        test_assert(lddmc_relprod_multi(lddmc_false, rels, metas, 5) == lddmc_false);
+    }
+    return 0;
+}
+
+int
+test_ldd_satcount_exact()
+{
+    for (int k=0; k<10; k++) {
+        MDD set = make_random_ldd_set(5, 8, 100);
+        uint64_t limbs[2];
+        test_assert(lddmc_satcount_exact(set, limbs, 2) == 1);
+        test_assert(limbs[0] == (uint64_t)lddmc_satcount(set) && limbs[1] == 0);
+        char *str = lddmc_satcount_exact_str(set), expected[32];
+        sprintf(expected, "%" PRIu64, limbs[0]);
+        test_assert(strcmp(str, expected) == 0);
+        free(str);
+        test_assert(fabs(lddmc_satcount_log2(set) - log2((double)limbs[0])) < 1e-9);
+    }
+
+    // 10^40 vectors of 40 variables with the values 0..9, and 2^130 vectors of 130 binary variables
+    MDD decimal = lddmc_true, binary = lddmc_true;
+    for (int i=0; i<40; i++) {
+        MDD level = lddmc_false;
+        for (uint32_t v=10; v>0; v--) level = lddmc_makenode(v-1, decimal, level);
+        decimal = level;
+    }
+    for (int i=0; i<130; i++) binary = lddmc_makenode(0, binary, lddmc_makenode(1, binary, lddmc_false));
+    lddmc_protect(&decimal);
+    lddmc_protect(&binary);
+
+    for (int gc=0; gc<2; gc++) {
+        char *str = lddmc_satcount_exact_str(decimal);
+        test_assert(strcmp(str, "10000000000000000000000000000000000000000") == 0);
+        free(str);
+        uint32_t zeros[40] = {0};
+        MDD less = lddmc_minus(decimal, lddmc_cube(zeros, 40));
+        str = lddmc_satcount_exact_str(less);
+        test_assert(strcmp(str, "9999999999999999999999999999999999999999") == 0);
+        free(str);
+        test_assert(fabs(lddmc_satcount_log2(decimal) - 40*log2(10.0)) < 1e-9);
+
+        uint64_t limbs[4];
+        test_assert(lddmc_satcount_exact(binary, limbs, 4) == 3);
+        test_assert(limbs[0] == 0 && limbs[1] == 0 && limbs[2] == 4 && limbs[3] == 0);
+        test_assert(lddmc_satcount_log2(binary) == 130.0);
+        sylvan_gc();
+    }
+
+    char *str = lddmc_satcount_exact_str(lddmc_false);
+    test_assert(strcmp(str, "0") == 0);
+    free(str);
+    test_assert(lddmc_satcount_log2(lddmc_false) == -INFINITY);
+
+    lddmc_unprotect(&decimal);
+    lddmc_unprotect(&binary);
+    return 0;
+}
+
+int
+test_matvec()
+{
+    uint32_t all[6] = {0, 1, 2, 3, 4, 5};
+    for (int fraction=0; fraction<2; fraction++) {
+        // interleaved rows/cols and rows/cols in separate blocks
+        for (int layout=0; layout<2; layout++) {
+            uint32_t rows[3], cols[3];
+            for (int i=0; i<3; i++) {
+                rows[i] = layout ? i : 2*i;
+                cols[i] = layout ? 3+i : 2*i+1;
+            }
+            MTBDD rows_set = mtbdd_set_from_array(rows, 3);
+            MTBDD cols_set = mtbdd_set_from_array(cols, 3);
+
+            MTBDD M = make_random_mtbdd(all, 6, fraction);
+            MTBDD x = make_random_mtbdd(rows, 3, fraction);
+
+            // reference: rename x to the column variables, then and_abstract_plus
+            MTBDDMAP map = mtbdd_map_empty();
+            for (int i=0; i<3; i++) map = mtbdd_map_add(map, rows[i], mtbdd_ithvar(cols[i]));
+            MTBDD xc = mtbdd_compose(x, map);
+            test_assert(mtbdd_matvec(M, x, rows_set, cols_set) == mtbdd_and_abstract_plus(M, xc, cols_set));
+        }
+
+        // matrix-matrix product, summing over the odd variables
+        uint32_t sum[3] = {1, 3, 5};
+        MTBDD sum_set = mtbdd_set_from_array(sum, 3);
+        MTBDD A = make_random_mtbdd(all, 6, fraction);
+        MTBDD B = make_random_mtbdd(all, 6, fraction);
+        test_assert(mtbdd_matmul(A, B, sum_set) == mtbdd_and_abstract_plus(A, B, sum_set));
+        test_assert(mtbdd_matmul(A, B, mtbdd_true) == mtbdd_times(A, B));
+    }
+
+    return 0;
+}
+
+int
+test_abstract_multi()
+{
+    uint32_t all[6] = {0, 1, 2, 3, 4, 5};
+    uint32_t vmax[2] = {0, 2}, vplus[2] = {3, 4}, vmin[1] = {5};
+    MTBDD max_set = mtbdd_set_from_array(vmax, 2);
+    MTBDD plus_set = mtbdd_set_from_array(vplus, 2);
+    MTBDD min_set = mtbdd_set_from_array(vmin, 1);
+
+    MTBDDMAP schedule = mtbdd_map_empty();
+    schedule = mtbdd_schedule_add_set(schedule, max_set, TASK(mtbdd_abstract_op_max));
+    schedule = mtbdd_schedule_add_set(schedule, plus_set, TASK(mtbdd_abstract_op_plus));
+    schedule = mtbdd_schedule_add(schedule, 5, TASK(mtbdd_abstract_op_min));
+    test_assert(mtbdd_map_count(schedule) == 5);
+    test_assert(mtbdd_schedule_op(schedule) == TASK(mtbdd_abstract_op_max));
+
+    for (int fraction=0; fraction<2; fraction++) {
+        MTBDD a = make_random_mtbdd(all, 6, fraction);
+        MTBDD b = make_random_mtbdd(all+2, 4, fraction);
+
+        // reference: one pass per operator, innermost (last) variables first
+        MTBDD ref = mtbdd_abstract_min(a, min_set);
+        ref = mtbdd_abstract_plus(ref, plus_set);
+        ref = mtbdd_abstract_max(ref, max_set);
+        test_assert(mtbdd_abstract_multi(a, schedule) == ref);
+        test_assert(mtbdd_abstract_multi(a, mtbdd_map_empty()) == a);
+
+        // a single operator for all variables is mtbdd_abstract
+        MTBDD all_set = mtbdd_set_from_array(all, 6);
+        MTBDDMAP plus_all = mtbdd_schedule_add_set(mtbdd_map_empty(), all_set, TASK(mtbdd_abstract_op_plus));
+        test_assert(mtbdd_abstract_multi(a, plus_all) == mtbdd_abstract_plus(a, all_set));
+
+        MTBDD ab = mtbdd_times(a, b);
+        ref = mtbdd_abstract_min(ab, min_set);
+        ref = mtbdd_abstract_plus(ref, plus_set);
+        ref = mtbdd_abstract_max(ref, max_set);
+        test_assert(mtbdd_and_abstract_multi(a, b, schedule, TASK(mtbdd_op_times)) == ref);
+
+        test_assert(mtbdd_and_abstract_min(a, b, plus_set) == mtbdd_abstract_min(ab, plus_set));
+        test_assert(mtbdd_and_abstract_op(a, b, plus_set, TASK(mtbdd_op_times), TASK(mtbdd_abstract_op_plus)) == mtbdd_and_abstract_plus(a, b, plus_set));
+        test_assert(mtbdd_and_abstract_op(a, b, max_set, TASK(mtbdd_op_plus), TASK(mtbdd_abstract_op_max)) == mtbdd_abstract_max(mtbdd_plus(a, b), max_set));
+    }
+
+    return 0;
+}
+
+/**
+ * Evaluate <dd> for the assignment given by the bits of <x> (bit i is variable i)
+ */
+static MTBDD
+eval_bits(MTBDD dd, uint64_t x)
+{
+    while (!mtbdd_isleaf(dd)) {
+        dd = (x >> mtbdd_getvar(dd)) & 1 ? mtbdd_gethigh(dd) : mtbdd_getlow(dd);
+    }
+    return dd;
+}
+
+static double
+leaf_value(MTBDD leaf)
+{
+    if (mtbdd_gettype(leaf) == 1) return mtbdd_getdouble(leaf);
+    return (double)mtbdd_getnumer(leaf) / mtbdd_getdenom(leaf);
+}
+
+int
+test_topk()
+{
+    uint32_t all[6] = {0, 1, 2, 3, 4, 5};
+    MTBDD vars = mtbdd_set_from_array(all, 6);
+    for (int fraction=0; fraction<2; fraction++) {
+        MTBDD dd = make_random_mtbdd(all, 6, fraction);
+
+        // reference: the distinct leaves, by enumerating all assignments
+        MTBDD distinct[64];
+        int n = 0;
+        for (uint64_t x=0; x<64; x++) {
+            MTBDD leaf = eval_bits(dd, x);
+            if (leaf == mtbdd_false) continue;
+            int found = 0;
+            for (int i=0; i<n; i++) if (distinct[i] == leaf) found = 1;
+            if (!found) distinct[n++] = leaf;
+        }
+
+        for (int largest=0; largest<2; largest++) {
+            MTBDD leaves[64], paths[64];
+            size_t count = mtbdd_topk(dd, 64, largest, leaves, NULL, 0);
+            test_assert(count == (size_t)n);
+            for (size_t i=1; i<count; i++) {
+                if (largest) test_assert(leaf_value(leaves[i]) < leaf_value(leaves[i-1]));
+                else test_assert(leaf_value(leaves[i]) > leaf_value(leaves[i-1]));
+            }
+
+            // all paths: exactly the assignments that lead to the leaf
+            test_assert(mtbdd_topk(dd, 2, largest, leaves, paths, 1) == (size_t)(n < 2 ? n : 2));
+            for (int i=0; i<(n < 2 ? n : 2); i++) {
+                for (uint64_t x=0; x<64; x++) {
+                    test_assert((eval_bits(paths[i], x) == mtbdd_true) == (eval_bits(dd, x) == leaves[i]));
+                }
+            }
+
+            // one path: a cube of assignments that lead to the leaf
+            test_assert(mtbdd_topk(dd, 2, largest, leaves, paths, 0) == (size_t)(n < 2 ? n : 2));
+            for (int i=0; i<(n < 2 ? n : 2); i++) {
+                test_assert(sylvan_satcount(paths[i], vars) >= 1);
+                for (uint64_t x=0; x<64; x++) {
+                    if (eval_bits(paths[i], x) == mtbdd_true) test_assert(eval_bits(dd, x) == leaves[i]);
+                }
+            }
+        }
+
+        // range counts
+        double ranges[4][2] = {{1, 3}, {2, 2}, {-10, 10}, {6, 10}};
+        for (int r=0; r<4; r++) {
+            double lo = ranges[r][0], hi = ranges[r][1];
+            double expected = 0;
+            for (uint64_t x=0; x<64; x++) {
+                MTBDD leaf = eval_bits(dd, x);
+                if (leaf == mtbdd_false) continue;
+                double v = leaf_value(leaf);
+                if (lo <= v && v <= hi) expected += 1;
+            }
+            test_assert(mtbdd_range_count(dd, vars, lo, hi) == expected);
+        }
+    }
+
+    // mtbdd_true has the value 1, in BDDs and next to other leaves
+    BDD bdd = sylvan_or(sylvan_ithvar(0), sylvan_ithvar(3));
+    MTBDD leaves[2];
+    test_assert(mtbdd_topk(bdd, 2, 1, leaves, NULL, 0) == 1 && leaves[0] == mtbdd_true);
+    test_assert(mtbdd_range_count(bdd, vars, 1, 1) == sylvan_satcount(bdd, vars));
+    test_assert(mtbdd_range_count(bdd, vars, 2, 3) == 0);
+    MTBDD dd = mtbdd_makenode(2, mtbdd_int64(5), mtbdd_true);
+    dd = mtbdd_makenode(0, mtbdd_false, dd);
+    test_assert(mtbdd_topk(dd, 2, 1, leaves, NULL, 0) == 2 && leaves[0] == mtbdd_int64(5) && leaves[1] == mtbdd_true);
+    test_assert(mtbdd_topk(dd, 2, 0, leaves, NULL, 0) == 2 && leaves[0] == mtbdd_true && leaves[1] == mtbdd_int64(5));
+    test_assert(mtbdd_range_count(dd, vars, 0, 2) == 16);
+    test_assert(mtbdd_range_count(dd, vars, 1, 5) == 32);
+
+    // overlapping ranges on the same MTBDD, with the results of the earlier ranges in the cache
+    MTBDD low = mtbdd_makenode(1, mtbdd_int64(1), mtbdd_int64(3));
+    MTBDD high = mtbdd_makenode(1, mtbdd_int64(50), mtbdd_int64(200));
+    dd = mtbdd_makenode(0, low, high);
+    test_assert(mtbdd_range_count(dd, vars, 2, 5) == 16);
+    test_assert(mtbdd_range_count(dd, vars, 2, 100) == 32);
+    test_assert(mtbdd_range_count(dd, vars, 2, 1000) == 48);
+    test_assert(mtbdd_range_count(dd, vars, 1, 100) == 48);
+
+    return 0;
+}
+
+int
+test_round()
+{
+    // rounding of single values
+    test_assert(mtbdd_round_double(0.1+1e-9, MTBDD_ROUND_ABS, 1e-6) == mtbdd_round_double(0.1, MTBDD_ROUND_ABS, 1e-6));
+    test_assert(mtbdd_round_double(1e10*(1+1e-12), MTBDD_ROUND_REL, 1e-9) == mtbdd_round_double(1e10, MTBDD_ROUND_REL, 1e-9));
+    test_assert(mtbdd_round_double(1e10, MTBDD_ROUND_REL, 1e-9) != mtbdd_round_double(1e10*(1+1e-6), MTBDD_ROUND_REL, 1e-9));
+    test_assert(mtbdd_round_double(-1e-12, MTBDD_ROUND_ABS, 1e-6) == 0.0);
+    double pi = mtbdd_round_double(3.14159, MTBDD_ROUND_REL, 1e-6);
+    test_assert(pi != 3.14159 && pi - 3.14159 <= 3.14159*1e-6 && 3.14159 - pi <= 3.14159*1e-6);
+    test_assert(mtbdd_round_double(0.1, MTBDD_ROUND_NONE, 1e-6) == 0.1);
+
+    // rounding does not overflow to infinity
+    test_assert(mtbdd_round_double(DBL_MAX, MTBDD_ROUND_ABS, 1e-6) == DBL_MAX);
+    test_assert(mtbdd_round_double(-DBL_MAX, MTBDD_ROUND_ABS, 0.75) == -DBL_MAX);
+    test_assert(mtbdd_round_double(DBL_MAX, MTBDD_ROUND_REL, 1e-3) == DBL_MAX);
+    test_assert(mtbdd_round_double(1e300, MTBDD_ROUND_ABS, 1e-300) == 1e300);
+
+    // global rounding of new leaves
+    MTBDD a = mtbdd_double(0.1);
+    MTBDD b = mtbdd_double(0.1+1e-9);
+    test_assert(a != b);
+    mtbdd_set_double_rounding(MTBDD_ROUND_ABS, 1e-6);
+    test_assert(mtbdd_double(0.1) == mtbdd_double(0.1+1e-9));
+    mtbdd_set_double_rounding(MTBDD_ROUND_REL, 1e-9);
+    test_assert(mtbdd_double(1e10) == mtbdd_double(1e10*(1+1e-12)));
+    mtbdd_round_mode mode;
+    double eps;
+    mtbdd_get_double_rounding(&mode, &eps);
+    test_assert(mode == MTBDD_ROUND_REL && eps == 1e-9);
+    mtbdd_set_double_rounding(MTBDD_ROUND_NONE, 0.0);
+    test_assert(mtbdd_double(0.1+1e-9) == b);
+
+    // rounding as a post-pass merges leaves and removes nodes
+    MTBDD dd = mtbdd_makenode(0, a, b);
+    test_assert(dd != a);
+    test_assert(mtbdd_round(dd, MTBDD_ROUND_ABS, 1e-6) == mtbdd_round(a, MTBDD_ROUND_ABS, 1e-6));
+    test_assert(mtbdd_round(dd, MTBDD_ROUND_REL, 1e-6) == mtbdd_round(a, MTBDD_ROUND_REL, 1e-6));
+    test_assert(mtbdd_round(dd, MTBDD_ROUND_NONE, 1e-6) == dd);
+    dd = mtbdd_makenode(0, mtbdd_false, mtbdd_int64(3));
+    test_assert(mtbdd_round(dd, MTBDD_ROUND_ABS, 1e-6) == dd);
+
+    return 0;
+}
+
+int
+test_solver()
+{
+    uint32_t all[4] = {0, 1, 2, 3};
+    uint32_t rows[2] = {0, 2};
+    uint32_t cols[2] = {1, 3};
+    MTBDD rows_set = mtbdd_set_from_array(rows, 2);
+    MTBDD cols_set = mtbdd_set_from_array(cols, 2);
+
+    // fused multiply-add
+    MTBDD M = make_random_mtbdd(all, 4, 0);
+    MTBDD x = make_random_mtbdd(rows, 2, 0);
+    MTBDD b = make_random_mtbdd(rows, 2, 0);
+    test_assert(mtbdd_matvec_plus(M, x, b, rows_set, cols_set) == mtbdd_plus(mtbdd_matvec(M, x, rows_set, cols_set), b));
+    MTBDD M1 = make_random_mtbdd(all+2, 2, 0);
+    test_assert(mtbdd_matvec_plus(M1, x, b, rows_set, cols_set) == mtbdd_plus(mtbdd_matvec(M1, x, rows_set, cols_set), b));
+    test_assert(mtbdd_matvec_plus(M, x, b, mtbdd_true, mtbdd_true) == mtbdd_plus(mtbdd_times(M, x), b));
+
+    mtbdd_solver_info info;
+    mtbdd_solver_info_init(&info, rows_set, cols_set);
+    info.epsilon = 1e-9;
+
+    // power method on the lazy random walk P = I/2 + 1/8, the stationary distribution is uniform
+    MTBDD id = mtbdd_identity(rows_set, cols_set);
+    MTBDD P = mtbdd_ite(id, mtbdd_double(0.625), mtbdd_double(0.125));
+    test_assert(mtbdd_diagonal(P, rows_set, cols_set) == mtbdd_double(0.625));
+    x = mtbdd_ite(sylvan_and(sylvan_nithvar(0), sylvan_nithvar(2)), mtbdd_double(1.0), mtbdd_false);
+    x = mtbdd_solve_power(P, x, &info);
+    test_assert(info.converged);
+    test_assert(info.iterations > 1);
+    test_assert(mtbdd_equal_norm_d(x, mtbdd_double(0.25), 1e-6) == mtbdd_true);
+
+    // Jacobi method on (I - P/2) x = 1, the solution is 2 everywhere
+    MTBDD A = mtbdd_ite(id, mtbdd_double(1.0 - 0.625/2), mtbdd_double(-0.125/2));
+    info.relative = 1;
+    x = mtbdd_solve_jacobi(A, mtbdd_double(1.0), mtbdd_double(0.0), &info);
+    test_assert(info.converged);
+    test_assert(mtbdd_equal_norm_d(x, mtbdd_double(2.0), 1e-6) == mtbdd_true);
+
+    // maximum number of iterations
+    info.max_iterations = 2;
+    x = mtbdd_solve_jacobi(A, mtbdd_double(1.0), mtbdd_double(0.0), &info);
+    test_assert(!info.converged);
+    test_assert(info.iterations == 2);
+
+    // a zero on the diagonal is rejected, for Double and Fraction leaves
+    info.max_iterations = 0;
+    MTBDD Z = mtbdd_ite(sylvan_and(id, sylvan_ithvar(0)), mtbdd_double(0.0), A);
+    test_assert(mtbdd_solve_jacobi(Z, mtbdd_double(1.0), mtbdd_double(0.0), &info) == mtbdd_invalid);
+    test_assert(!info.converged && info.iterations == 0);
+    MTBDD d = mtbdd_ite(sylvan_ithvar(2), mtbdd_fraction(0, 1), mtbdd_fraction(3, 4));
+    Z = mtbdd_ite(id, d, mtbdd_fraction(1, 8));
+    test_assert(mtbdd_solve_jacobi(Z, mtbdd_fraction(1, 1), mtbdd_fraction(0, 1), &info) == mtbdd_invalid);
+
+    // Jacobi method on Fraction MTBDDs: the diagonal is 2, and row (0,y) also has 1 in column (1,y),
+    // so x(1,y) = 1/2 and x(0,y) = 1/4 after three iterations
+    info.max_iterations = 10;
+    info.relative = 0;
+    BDD upper = sylvan_and(sylvan_and(sylvan_nithvar(0), sylvan_ithvar(1)), sylvan_equiv(sylvan_ithvar(2), sylvan_ithvar(3)));
+    MTBDD O = mtbdd_ite(upper, mtbdd_fraction(1, 1), mtbdd_false);
+    MTBDD F = mtbdd_ite(id, mtbdd_fraction(2, 1), O);
+    x = mtbdd_solve_jacobi(F, mtbdd_fraction(1, 1), mtbdd_fraction(0, 1), &info);
+    test_assert(info.converged);
+    test_assert(info.iterations == 3);
+    MTBDD expected = mtbdd_ite(sylvan_ithvar(0), mtbdd_fraction(1, 2), mtbdd_fraction(1, 4));
+    test_assert(x == expected);
+    info.relative = 1;
+    test_assert(mtbdd_solve_jacobi(F, mtbdd_fraction(1, 1), mtbdd_fraction(1, 1), &info) == x);
+    test_assert(info.converged);
+
+    return 0;
+}
+
+/**
+ * Custom leaf type for a pair of 64-bit values, stored in the arena of the type
+ */
+static uint32_t pair_type;
+
+static uint64_t
+pair_hash(uint64_t v, uint64_t seed)
+{
+    uint64_t *p = (uint64_t*)(size_t)v;
+    return sylvan_tabhash16(p[0], p[1], seed);
+}
+
+static int
+pair_equals(uint64_t v1, uint64_t v2)
+{
+    uint64_t *p1 = (uint64_t*)(size_t)v1;
+    uint64_t *p2 = (uint64_t*)(size_t)v2;
+    return p1[0] == p2[0] && p1[1] == p2[1];
+}
+
+static void
+pair_create(uint64_t *v)
+{
+    uint64_t *p = (uint64_t*)sylvan_mt_arena_alloc(pair_type);
+    memcpy(p, (uint64_t*)(size_t)*v, 2*sizeof(uint64_t));
+    *v = (uint64_t)(size_t)p;
+}
+
+static void
+pair_destroy(uint64_t v)
+{
+    sylvan_mt_arena_free(pair_type, (void*)(size_t)v);
+}
+
+static int
+pair_write_binary(FILE *out, uint64_t v)
+{
+    return fwrite((uint64_t*)(size_t)v, sizeof(uint64_t), 2, out) == 2 ? 0 : -1;
+}
+
+static int
+pair_read_binary(FILE *in, uint64_t *v)
+{
+    static uint64_t buf[2];
+    if (fread(buf, sizeof(uint64_t), 2, in) != 2) return -1;
+    *v = (uint64_t)(size_t)buf;
+    return 0;
+}
+
+int
+test_arena()
+{
+    // freed objects are reused
+    void *a = sylvan_mt_arena_alloc(pair_type);
+    void *b = sylvan_mt_arena_alloc(pair_type);
+    test_assert(a != b);
+    sylvan_mt_arena_free(pair_type, a);
+    test_assert(sylvan_mt_arena_alloc(pair_type) == a);
+    sylvan_mt_arena_free(pair_type, b);
+    sylvan_mt_arena_free(pair_type, a);
+
+    // leaves store a copy in the arena
+    uint64_t v1[2] = {1, 2}, v2[2] = {1, 2}, v3[2] = {3, 4};
+    MTBDD l1 = mtbdd_makeleaf(pair_type, (size_t)v1);
+    MTBDD l2 = mtbdd_makeleaf(pair_type, (size_t)v2);
+    MTBDD l3 = mtbdd_makeleaf(pair_type, (size_t)v3);
+    test_assert(l1 == l2);
+    test_assert(l1 != l3);
+    uint64_t *p = (uint64_t*)(size_t)mtbdd_getvalue(l1);
+    test_assert(p != v1 && p != v2 && p[0] == 1 && p[1] == 2);
+
+    // payloads of dead leaves are returned during garbage collection, live leaves are kept
+    mtbdd_protect(&l3);
+    for (uint64_t i=0; i<10000; i++) {
+        uint64_t v[2] = {i, i+1};
+        mtbdd_makeleaf(pair_type, (size_t)v);
+    }
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    for (uint64_t i=0; i<10000; i++) {
+        uint64_t v[2] = {i+1, i};
+        mtbdd_makeleaf(pair_type, (size_t)v);
+    }
+    p = (uint64_t*)(size_t)mtbdd_getvalue(l3);
+    test_assert(p[0] == 3 && p[1] == 4);
+    test_assert(mtbdd_makeleaf(pair_type, (size_t)v3) == l3);
+
+    // chunks without live objects are returned to the system after garbage collection
+    size_t usage = sylvan_mt_arena_usage(pair_type);
+    test_assert(usage > 2*65536);
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    test_assert(sylvan_mt_arena_usage(pair_type) == 65536);
+    p = (uint64_t*)(size_t)mtbdd_getvalue(l3);
+    test_assert(p[0] == 3 && p[1] == 4);
+    for (uint64_t i=0; i<10000; i++) {
+        uint64_t v[2] = {i, i+2};
+        p = (uint64_t*)(size_t)mtbdd_getvalue(mtbdd_makeleaf(pair_type, (size_t)v));
+        test_assert(p[0] == i && p[1] == i+2);
+    }
+    test_assert(mtbdd_makeleaf(pair_type, (size_t)v3) == l3);
+    mtbdd_unprotect(&l3);
+
+    return 0;
+}
+
+/**
+ * Build an MTBDD over variables 0, 1, 2 with the given 8 leaves (variable 0 is the most significant bit)
+ */
+static MTBDD
+vec_test_tree(MTBDD *leaves)
+{
+    MTBDD l[4], m[2];
+    for (int i=0; i<4; i++) l[i] = mtbdd_makenode(2, leaves[2*i], leaves[2*i+1]);
+    for (int i=0; i<2; i++) m[i] = mtbdd_makenode(1, l[2*i], l[2*i+1]);
+    return mtbdd_makenode(0, m[0], m[1]);
+}
+
+int
+test_vec()
+{
+    test_assert(vec_width() == 3);
+
+    // random vectors of doubles and of int64 (small integers, so double arithmetic is exact)
+    MTBDD va[8], vb[8], ia[8], ib[8];
+    for (int i=0; i<8; i++) {
+        double da[3], db[3];
+        int64_t xa[3], xb[3];
+        for (int k=0; k<3; k++) {
+            xa[k] = (int64_t)(rng(0, 16)) - 8;
+            xb[k] = (int64_t)(rng(0, 16)) - 8;
+            da[k] = (double)xa[k];
+            db[k] = (double)xb[k];
+        }
+        va[i] = mtbdd_vec_double(da);
+        vb[i] = mtbdd_vec_double(db);
+        ia[i] = mtbdd_vec_int64(xa);
+        ib[i] = mtbdd_vec_int64(xb);
+        test_assert(mtbdd_vec_double(da) == va[i]);
+        test_assert(mtbdd_getvec_double(va[i]) != da && mtbdd_getvec_double(va[i])[2] == da[2]);
+        test_assert(mtbdd_getvec_int64(ia[i])[1] == xa[1]);
+    }
+    MTBDD A = vec_test_tree(va), B = vec_test_tree(vb);
+    MTBDD IA = vec_test_tree(ia), IB = vec_test_tree(ib);
+
+    // every operation is the same operation on each component
+    uint32_t vars[] = {1, 2};
+    MTBDD cube = mtbdd_set_from_array(vars, 2);
+    for (size_t k=0; k<3; k++) {
+        MTBDD a = vec_component(A, k), b = vec_component(B, k);
+        test_assert(vec_component(vec_plus(A, B), k) == mtbdd_plus(a, b));
+        test_assert(vec_component(vec_times(A, B), k) == mtbdd_times(a, b));
+        test_assert(vec_component(vec_min(A, B), k) == mtbdd_min(a, b));
+        test_assert(vec_component(vec_max(A, B), k) == mtbdd_max(a, b));
+        test_assert(vec_component(vec_abstract_plus(A, cube), k) == mtbdd_abstract_plus(a, cube));
+        test_assert(vec_component(vec_abstract_max(A, cube), k) == mtbdd_abstract_max(a, cube));
+        test_assert(vec_component(vec_times(A, mtbdd_double(2.0)), k) == mtbdd_times(a, mtbdd_double(2.0)));
+
+        MTBDD x = vec_component(IA, k), y = vec_component(IB, k);
+        test_assert(vec_component(vec_plus(IA, IB), k) == mtbdd_plus(x, y));
+        test_assert(vec_component(vec_times(IA, IB), k) == mtbdd_times(x, y));
+        test_assert(vec_component(vec_min(IA, IB), k) == mtbdd_min(x, y));
+        test_assert(vec_component(vec_abstract_min(IA, cube), k) == mtbdd_abstract_min(x, cube));
+        test_assert(vec_component(vec_times(mtbdd_int64(3), IA), k) == mtbdd_times(mtbdd_int64(3), x));
+    }
+
+    // partial functions and Boolean filters
+    test_assert(vec_plus(A, mtbdd_false) == A);
+    test_assert(vec_times(A, mtbdd_true) == A);
+    test_assert(vec_times(A, sylvan_ithvar(0)) == mtbdd_makenode(0, mtbdd_false, mtbdd_gethigh(A)));
+
+    // text and binary representation
+    double d[3] = {1.5, -2, 0};
+    char buf[64];
+    char *str = mtbdd_leaf_to_str(mtbdd_vec_double(d), buf, 64);
+    test_assert(str == buf && strcmp(buf, "(1.500000, -2.000000, 0.000000)") == 0);
+
+    // -0.0 and 0.0 give the same leaf, also as the result of an operation
+    double z[3] = {0.0, -0.0, 1.0}, nz[3] = {-0.0, 0.0, 1.0}, m[3] = {-1.0, 1.0, 1.0};
+    test_assert(mtbdd_vec_double(z) == mtbdd_vec_double(nz));
+    test_assert(!signbit(mtbdd_getvec_double(mtbdd_vec_double(nz))[0]));
+    test_assert(vec_times(mtbdd_vec_double(z), mtbdd_vec_double(m)) == mtbdd_vec_double(z));
+
+    FILE *f = tmpfile();
+    MTBDD dds[2] = {A, IA}, read[2];
+    mtbdd_writer_tobinary(f, dds, 2);
+    rewind(f);
+    test_assert(mtbdd_reader_frombinary(f, read, 2) == 0);
+    fclose(f);
+    test_assert(read[0] == A && read[1] == IA);
+
+    // reading leaves that no longer exist, after garbage collection
+    double e[3] = {7.25, -8.5, 9};
+    MTBDD E = mtbdd_makenode(0, mtbdd_vec_double(e), mtbdd_vec_double(d));
+    f = tmpfile();
+    mtbdd_writer_tobinary(f, &E, 1);
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    rewind(f);
+    test_assert(mtbdd_reader_frombinary(f, read, 1) == 0);
+    fclose(f);
+    const double *r = mtbdd_getvec_double(mtbdd_getlow(read[0]));
+    test_assert(r[0] == 7.25 && r[1] == -8.5 && r[2] == 9);
+    test_assert(mtbdd_gethigh(read[0]) == mtbdd_vec_double(d));
+
+    return 0;
+}
+
+int
+test_writer()
+{
+    // several BDDs sharing nodes, large enough to be written in more than one block
+    uint32_t vars[48];
+    for (int i=0; i<48; i++) vars[i] = i;
+    BDDSET varset = sylvan_ref(sylvan_set_fromarray(vars, 48));
+    BDD a = sylvan_false;
+    uint8_t cube[48];
+    for (int i=0; i<2500; i++) {
+        for (int j=0; j<48; j++) cube[j] = rng(0, 2);
+        a = sylvan_ref(sylvan_union_cube(a, varset, cube));
+        sylvan_deref(a);
+    }
+    a = sylvan_ref(a);
+    BDD b = make_random(0, 18);
+    uint32_t all[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    MTBDD dds[6] = {a, b, sylvan_or(a, b), sylvan_not(a), make_random_mtbdd(all, 10, 0), make_random_mtbdd(all, 10, 1)};
+    dds[2] = sylvan_ref(dds[2]);
+
+    // every node is added once, and children are numbered before their parents
+    sylvan_writer_t w = mtbdd_writer_start();
+    for (int i=0; i<6; i++) mtbdd_writer_add(w, dds[i]);
+    for (int i=0; i<6; i++) mtbdd_writer_add(w, dds[i]);
+    for (int i=0; i<6; i++) {
+        MTBDD dd = dds[i];
+        if (mtbdd_isleaf(dd)) continue;
+        uint64_t n = mtbdd_writer_get(w, dd) & ~mtbdd_complement;
+        test_assert(n >= 1 && n <= mtbdd_nodecount_more(dds, 6));
+        test_assert((mtbdd_writer_get(w, mtbdd_getlow(dd)) & ~mtbdd_complement) < n);
+        test_assert((mtbdd_writer_get(w, mtbdd_gethigh(dd)) & ~mtbdd_complement) < n);
+    }
+    test_assert(mtbdd_writer_get(w, dds[3]) == (mtbdd_writer_get(w, a) ^ mtbdd_complement));
+    mtbdd_writer_end(w);
+
+    // round trip, and the output does not depend on the order of adding
+    FILE *f = tmpfile();
+    mtbdd_writer_tobinary(f, dds, 6);
+    long size = ftell(f);
+    rewind(f);
+    MTBDD read[6];
+    test_assert(mtbdd_reader_frombinary(f, read, 6) == 0);
+    for (int i=0; i<6; i++) test_assert(read[i] == dds[i]);
+
+    MTBDD rev[6];
+    for (int i=0; i<6; i++) rev[i] = dds[5-i];
+    FILE *g = tmpfile();
+    mtbdd_writer_tobinary(g, rev, 6);
+    test_assert(ftell(g) == size);
+    rewind(f);
+    rewind(g);
+    size_t nodecount_f, nodecount_g;
+    test_assert(fread(&nodecount_f, sizeof(size_t), 1, f) == 1);
+    test_assert(fread(&nodecount_g, sizeof(size_t), 1, g) == 1);
+    test_assert(nodecount_f == nodecount_g);
+    for (size_t i=0; i<2*nodecount_f; i++) {
+        uint64_t x, y;
+        test_assert(fread(&x, sizeof(uint64_t), 1, f) == 1);
+        test_assert(fread(&y, sizeof(uint64_t), 1, g) == 1);
+        test_assert(x == y);
+    }
+    fclose(f);
+    fclose(g);
+
+    // the compact formats also span several blocks
+    sylvan_set_file_format(SYLVAN_FILE_LZ);
+    f = tmpfile();
+    mtbdd_writer_tobinary(f, dds, 6);
+    test_assert(ftell(f) < size);
+    rewind(f);
+    test_assert(mtbdd_reader_frombinary(f, read, 6) == 0);
+    for (int i=0; i<6; i++) test_assert(read[i] == dds[i]);
+    fclose(f);
+    sylvan_set_file_format(SYLVAN_FILE_RAW);
+
+    sylvan_deref(dds[2]);
+    sylvan_deref(a);
+    sylvan_deref(b);
+    sylvan_deref(varset);
+    return 0;
+}
+
+int
+test_writer_leaves()
+{
+    // custom leaves are written with their data, and read back
+    MTBDD leaves[8];
+    for (uint64_t i=0; i<8; i++) {
+        uint64_t v[2] = {i, i*i};
+        leaves[i] = mtbdd_makeleaf(pair_type, (size_t)v);
+    }
+    MTBDD dds[2] = {vec_test_tree(leaves), mtbdd_makenode(4, leaves[3], mtbdd_double(0.5))}, read[2];
+    FILE *f = tmpfile();
+    mtbdd_writer_tobinary(f, dds, 2);
+    rewind(f);
+    test_assert(mtbdd_reader_frombinary(f, read, 2) == 0);
+    fclose(f);
+    test_assert(read[0] == dds[0] && read[1] == dds[1]);
+
+    // the reader does not seek, so files with such leaves can be read from a pipe
+    for (int k=0; k<2; k++) {
+        sylvan_set_file_format(k == 0 ? SYLVAN_FILE_RAW : SYLVAN_FILE_COMPACT);
+        int fds[2];
+        test_assert(pipe(fds) == 0);
+        FILE *out = fdopen(fds[1], "w"), *in = fdopen(fds[0], "r");
+        mtbdd_writer_tobinary(out, dds, 2);
+        fclose(out);
+        read[0] = read[1] = mtbdd_false;
+        test_assert(mtbdd_reader_frombinary(in, read, 2) == 0);
+        fclose(in);
+        test_assert(read[0] == dds[0] && read[1] == dds[1]);
+    }
+    sylvan_set_file_format(SYLVAN_FILE_RAW);
+
+    // leaves with data may also be stored between the internal nodes
+    uint64_t v1[2] = {5, 6}, v2[2] = {7, 8};
+    struct mtbddnode n[4];
+    size_t nodecount = 4;
+    f = tmpfile();
+    fwrite(&nodecount, sizeof(size_t), 1, f);
+    mtbddnode_makeleaf(n+0, pair_type, 0);
+    mtbddnode_makenode(n+1, 1, 1, mtbdd_false);
+    mtbddnode_makeleaf(n+2, pair_type, 0);
+    mtbddnode_makenode(n+3, 0, 2, 3);
+    fwrite(n+0, sizeof(struct mtbddnode), 1, f);
+    fwrite(v1, sizeof(uint64_t), 2, f);
+    fwrite(n+1, sizeof(struct mtbddnode), 1, f);
+    fwrite(n+2, sizeof(struct mtbddnode), 1, f);
+    fwrite(v2, sizeof(uint64_t), 2, f);
+    fwrite(n+3, sizeof(struct mtbddnode), 1, f);
+    rewind(f);
+    uint64_t *arr = mtbdd_reader_readbinary(f);
+    fclose(f);
+    test_assert(arr != NULL);
+    MTBDD l1 = mtbdd_makeleaf(pair_type, (size_t)v1);
+    MTBDD l2 = mtbdd_makeleaf(pair_type, (size_t)v2);
+    test_assert(mtbdd_reader_get(arr, 4) == mtbdd_makenode(0, mtbdd_makenode(1, l1, mtbdd_false), l2));
+    mtbdd_reader_end(arr);
+
+    // a node that refers to a later node is rejected
+    f = tmpfile();
+    nodecount = 2;
+    fwrite(&nodecount, sizeof(size_t), 1, f);
+    mtbddnode_makenode(n+0, 0, 2, mtbdd_false);
+    mtbddnode_makeleaf(n+1, 0, 1);
+    fwrite(n, sizeof(struct mtbddnode), 2, f);
+    rewind(f);
+    test_assert(mtbdd_reader_readbinary(f) == NULL);
+    fclose(f);
+
+    return 0;
+}
+
+int
+test_file_formats()
+{
+    int formats[3] = {SYLVAN_FILE_RAW, SYLVAN_FILE_COMPACT, SYLVAN_FILE_LZ};
+    long sizes[3];
+
+    // MTBDDs with shared nodes, complement edges and custom leaves
+    uint32_t vars[40];
+    for (int i=0; i<40; i++) vars[i] = i;
+    BDDSET varset = sylvan_ref(sylvan_set_fromarray(vars, 40));
+    BDD a = sylvan_false;
+    uint8_t cube[40];
+    for (int i=0; i<800; i++) {
+        for (int j=0; j<40; j++) cube[j] = rng(0, 4) == 0 ? 2 : rng(0, 2);
+        a = sylvan_ref(sylvan_union_cube(a, varset, cube));
+        sylvan_deref(a);
+    }
+    a = sylvan_ref(a);
+    MTBDD leaves[8];
+    for (uint64_t i=0; i<8; i++) {
+        uint64_t v[2] = {i, 100-i};
+        leaves[i] = mtbdd_makeleaf(pair_type, (size_t)v);
+    }
+    MTBDD dds[4] = {a, sylvan_not(a), make_random_mtbdd(vars, 10, 1), vec_test_tree(leaves)};
+
+    for (int k=0; k<3; k++) {
+        sylvan_set_file_format(formats[k]);
+        test_assert(sylvan_get_file_format() == formats[k]);
+        FILE *f = tmpfile();
+        mtbdd_writer_tobinary(f, dds, 4);
+        sizes[k] = ftell(f);
+        rewind(f);
+        MTBDD read[4];
+        test_assert(mtbdd_reader_frombinary(f, read, 4) == 0);
+        fclose(f);
+        for (int i=0; i<4; i++) test_assert(read[i] == dds[i]);
+    }
+    test_assert(sizes[1] < sizes[0] && sizes[2] < sizes[1]);
+
+    // BDD serialization, with sections in different formats in one file
+    FILE *f = tmpfile();
+    sylvan_serialize_reset();
+    size_t keys[3];
+    BDD b = sylvan_ref(sylvan_and(a, sylvan_ithvar(41)));
+    BDD bdds[3] = {a, b, sylvan_not(b)};
+    for (int k=0; k<3; k++) {
+        sylvan_set_file_format(formats[k]);
+        keys[k] = sylvan_serialize_add(bdds[k]);
+        sylvan_serialize_tofile(f);
+    }
+    sylvan_serialize_reset();
+    rewind(f);
+    for (int k=0; k<3; k++) sylvan_serialize_fromfile(f);
+    for (int k=0; k<3; k++) test_assert(sylvan_serialize_get_reversed(keys[k]) == bdds[k]);
+    sylvan_serialize_reset();
+    fclose(f);
+
+    // LDD serialization, with copy nodes
+    MDD set = make_random_ldd_set(6, 16, 500);
+    lddmc_refs_push(set);
+    MDD rel = lddmc_make_copynode(lddmc_cube((uint32_t[]){1, 2, 3}, 3), lddmc_cube((uint32_t[]){4, 5, 6}, 3));
+    lddmc_refs_push(rel);
+    for (int k=0; k<3; k++) {
+        sylvan_set_file_format(formats[k]);
+        f = tmpfile();
+        lddmc_serialize_reset();
+        size_t set_key = lddmc_serialize_add(set);
+        size_t rel_key = lddmc_serialize_add(rel);
+        lddmc_serialize_tofile(f);
+        sizes[k] = ftell(f);
+        lddmc_serialize_reset();
+        rewind(f);
+        lddmc_serialize_fromfile(f);
+        test_assert(lddmc_serialize_get_reversed(set_key) == set);
+        test_assert(lddmc_serialize_get_reversed(rel_key) == rel);
+        lddmc_serialize_reset();
+        fclose(f);
+    }
+    test_assert(sizes[1] < sizes[0] && sizes[2] <= sizes[1]);
+    lddmc_refs_pop(2);
+
+    sylvan_set_file_format(SYLVAN_FILE_RAW);
+    sylvan_deref(b);
+    sylvan_deref(a);
+    sylvan_deref(varset);
+    return 0;
+}
+
+/**
+ * Check that the nodes 1 ... <last> of <s> are numbered with children before parents
+ */
+static int
+test_serializer_order(sylvan_serializer_t s, size_t last)
+{
+    for (size_t i=1; i<=last; i++) {
+        BDD bdd = sylvan_serializer_get_reversed(s, i);
+        test_assert(sylvan_serializer_get(s, bdd) == i);
+        test_assert(sylvan_serializer_get(s, sylvan_not(bdd)) == (i | sylvan_complement));
+        size_t low = sylvan_serializer_get(s, sylvan_low(bdd));
+        size_t high = sylvan_serializer_get(s, sylvan_high(bdd));
+        test_assert((low & ~sylvan_complement) < i && (high & ~sylvan_complement) < i);
+    }
+    return 0;
+}
+
+int
+test_serializer()
+{
+    uint32_t vars[30];
+    for (int i=0; i<30; i++) vars[i] = i;
+    BDDSET varset = sylvan_ref(sylvan_set_fromarray(vars, 30));
+    BDD a = sylvan_false;
+    uint8_t cube[30];
+    for (int i=0; i<600; i++) {
+        for (int j=0; j<30; j++) cube[j] = rng(0, 4) == 0 ? 2 : rng(0, 2);
+        a = sylvan_ref(sylvan_union_cube(a, varset, cube));
+        sylvan_deref(a);
+    }
+    a = sylvan_ref(a);
+    BDD b = sylvan_ref(sylvan_and(sylvan_not(a), sylvan_ithvar(3)));
+    // enough nodes to grow the hash table of the serializers
+    test_assert(sylvan_nodecount(a) > 4096);
+
+    // two serializers with their own numbering
+    sylvan_serializer_t s1 = sylvan_serializer_alloc();
+    sylvan_serializer_t s2 = sylvan_serializer_alloc();
+    size_t ka = sylvan_serializer_add(s1, a);
+    test_assert(test_serializer_order(s1, ka & ~sylvan_complement) == 0);
+    size_t kb = sylvan_serializer_add(s1, b);
+    test_assert(test_serializer_order(s1, kb & ~sylvan_complement) == 0);
+    size_t kb2 = sylvan_serializer_add(s2, b);
+    size_t ka2 = sylvan_serializer_add(s2, a);
+    test_assert(sylvan_serializer_add(s1, a) == ka);
+    test_assert(test_serializer_order(s2, ka2 > kb2 ? ka2 & ~sylvan_complement : kb2 & ~sylvan_complement) == 0);
+    test_assert(sylvan_serializer_get_reversed(s2, ka2) == a && sylvan_serializer_get_reversed(s2, kb2) == b);
+
+    // the numbering does not depend on the serializer
+    sylvan_serializer_t s3 = sylvan_serializer_alloc();
+    test_assert(sylvan_serializer_add(s3, a) == ka && sylvan_serializer_add(s3, b) == kb);
+    FILE *f1 = tmpfile(), *f3 = tmpfile();
+    sylvan_serializer_tofile(s1, f1);
+    sylvan_serializer_tofile(s3, f3);
+    test_assert(ftell(f1) == ftell(f3));
+    rewind(f1);
+    rewind(f3);
+    int ch;
+    do {
+        ch = fgetc(f1);
+        test_assert(ch == fgetc(f3));
+    } while (ch != EOF);
+    sylvan_serializer_free(s3);
+    fclose(f3);
+
+    // numbered nodes survive garbage collection
+    BDD c = sylvan_xor(a, sylvan_ithvar(5));
+    size_t kc = sylvan_serializer_add(s1, c);
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    test_assert(sylvan_serializer_get_reversed(s1, kc) == c);
+    test_assert(sylvan_xor(a, sylvan_ithvar(5)) == c);
+
+    // a second section with the new nodes, read back after the first section
+    sylvan_set_file_format(SYLVAN_FILE_LZ);
+    fseek(f1, 0, SEEK_END);
+    sylvan_serializer_tofile(s1, f1);
+    sylvan_set_file_format(SYLVAN_FILE_RAW);
+    rewind(f1);
+    sylvan_serializer_t s4 = sylvan_serializer_alloc();
+    test_assert(sylvan_serializer_fromfile(s4, f1) == 0);
+    test_assert(sylvan_serializer_get_reversed(s4, ka) == a);
+    test_assert(sylvan_serializer_get_reversed(s4, kb) == b);
+    test_assert(sylvan_serializer_fromfile(s4, f1) == 0);
+    test_assert(sylvan_serializer_get_reversed(s4, kc) == c);
+    test_assert(sylvan_serializer_get(s4, c) == kc);
+    test_assert(test_serializer_order(s4, kc & ~sylvan_complement) == 0);
+
+    // a truncated file is rejected
+    long size = ftell(f1);
+    rewind(f1);
+    FILE *f5 = tmpfile();
+    for (long i=0; i<size/2; i++) fputc(fgetc(f1), f5);
+    rewind(f5);
+    sylvan_serializer_reset(s4);
+    test_assert(sylvan_serializer_fromfile(s4, f5) != 0);
+    fclose(f5);
+    fclose(f1);
+
+    sylvan_serializer_free(s4);
+    sylvan_serializer_free(s2);
+    sylvan_serializer_free(s1);
+    sylvan_deref(b);
+    sylvan_deref(a);
+    sylvan_deref(varset);
+    return 0;
+}
+
+/**
+ * Producer thread for the pipe streams: writes the bytes of <file> to the pipe <out> up to each
+ * offset in <ends>, and waits for the acknowledgement of the reader before writing the next part.
+ * Gives up and closes the pipe if the reader does not acknowledge a part within 10 seconds, so a
+ * reader that blocks on bytes beyond the current DD fails the test instead of hanging it.
+ */
+struct stream_producer
+{
+    FILE *file;
+    int out;
+    long ends[8];
+    int count;
+    int acked;
+    int timeout;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static void*
+stream_producer_run(void *arg)
+{
+    struct stream_producer *p = (struct stream_producer*)arg;
+    long pos = 0;
+    char buf[4096];
+    for (int i=0; i<p->count && !p->timeout; i++) {
+        while (pos < p->ends[i]) {
+            size_t n = p->ends[i] - pos < (long)sizeof(buf) ? (size_t)(p->ends[i] - pos) : sizeof(buf);
+            n = fread(buf, 1, n, p->file);
+            if (n == 0 || write(p->out, buf, n) != (ssize_t)n) break;
+            pos += n;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 10;
+        pthread_mutex_lock(&p->lock);
+        while (p->acked <= i && !p->timeout) {
+            if (pthread_cond_timedwait(&p->cond, &p->lock, &deadline) != 0) p->timeout = 1;
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+    close(p->out);
+    return NULL;
+}
+
+static void
+stream_producer_ack(struct stream_producer *p)
+{
+    pthread_mutex_lock(&p->lock);
+    p->acked++;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+int
+test_serializer_stream()
+{
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+
+    uint32_t vars[48];
+    for (int i=0; i<48; i++) vars[i] = i;
+    BDDSET varset = sylvan_ref(sylvan_set_fromarray(vars, 48));
+    BDD a = sylvan_false;
+    uint8_t cube[48];
+    for (int i=0; i<2500; i++) {
+        for (int j=0; j<48; j++) cube[j] = rng(0, 4) == 0 ? 2 : rng(0, 2);
+        a = sylvan_ref(sylvan_union_cube(a, varset, cube));
+        sylvan_deref(a);
+    }
+    a = sylvan_ref(a);
+    BDD b = sylvan_ref(sylvan_and(sylvan_not(a), sylvan_ithvar(7)));
+    // more nodes than one block, so the reader creates them in several steps
+    test_assert(sylvan_nodecount(a) > 65536);
+
+    // a stream with several BDDs, of which later ones share nodes with earlier ones
+    BDD bdds[4] = {a, b, sylvan_not(a), sylvan_true};
+    FILE *f = tmpfile();
+    sylvan_serializer_t s1 = sylvan_serializer_alloc();
+    sylvan_serializer_write_begin(s1, f);
+    for (int i=0; i<4; i++) {
+        size_t key = sylvan_serializer_write_push(s1, f, bdds[i]);
+        test_assert(sylvan_serializer_get(s1, bdds[i]) == key);
+    }
+    sylvan_serializer_write_end(s1, f);
+    rewind(f);
+    sylvan_serializer_t s2 = sylvan_serializer_alloc();
+    test_assert(sylvan_serializer_read_begin(s2, f) == 0);
+    for (int i=0; i<4; i++) {
+        BDD bdd;
+        test_assert(sylvan_serializer_read_next(s2, f, &bdd) == 1);
+        test_assert(bdd == bdds[i]);
+    }
+    BDD bdd;
+    test_assert(sylvan_serializer_read_next(s2, f, &bdd) == 0);
+    test_assert(sylvan_serializer_get(s2, b) == sylvan_serializer_get(s1, b));
+
+    // a truncated stream is rejected after the BDDs that it contains
+    long size = ftell(f);
+    rewind(f);
+    FILE *f2 = tmpfile();
+    for (long i=0; i<size*3/4; i++) fputc(fgetc(f), f2);
+    rewind(f2);
+    test_assert(sylvan_serializer_read_begin(s2, f2) == 0);
+    int res;
+    while ((res = sylvan_serializer_read_next(s2, f2, &bdd)) == 1) continue;
+    test_assert(res == -1);
+    fclose(f2);
+    fclose(f);
+
+    // a stream of MTBDDs with custom leaves, Double leaves and complement edges
+    MTBDD leaves[8];
+    for (uint64_t i=0; i<8; i++) {
+        uint64_t v[2] = {i, 100-i};
+        leaves[i] = i < 6 ? mtbdd_makeleaf(pair_type, (size_t)v) : mtbdd_double(0.5 * i);
+    }
+    MTBDD dds[4] = {vec_test_tree(leaves), a, sylvan_not(b), mtbdd_makenode(3, leaves[7], leaves[1])};
+    f = tmpfile();
+    mtbdd_stream_t m1 = mtbdd_stream_alloc();
+    mtbdd_stream_write_begin(m1, f);
+    for (int i=0; i<4; i++) mtbdd_stream_write_push(m1, f, dds[i]);
+    mtbdd_stream_write_end(m1, f);
+    rewind(f);
+    mtbdd_stream_t m2 = mtbdd_stream_alloc();
+    test_assert(mtbdd_stream_read_begin(m2, f) == 0);
+    for (int i=0; i<4; i++) {
+        MTBDD dd;
+        test_assert(mtbdd_stream_read_next(m2, f, &dd) == 1);
+        test_assert(dd == dds[i]);
+    }
+    MTBDD dd;
+    test_assert(mtbdd_stream_read_next(m2, f, &dd) == 0);
+    fclose(f);
+    mtbdd_stream_free(m2);
+    mtbdd_stream_free(m1);
+
+    // streams through a pipe, which cannot seek: a producer thread passes the streams on one
+    // DD at a time, and waits until the reader has returned that DD
+    sylvan_set_file_format(SYLVAN_FILE_LZ);
+    BDD c = sylvan_ref(sylvan_xor(sylvan_ithvar(1), sylvan_ithvar(4)));
+    MDD set = make_random_ldd_set(4, 8, 50);
+    lddmc_refs_push(set);
+    MDD rel = lddmc_make_copynode(lddmc_cube((uint32_t[]){1, 2}, 2), lddmc_cube((uint32_t[]){3, 4}, 2));
+    lddmc_refs_push(rel);
+    struct stream_producer p = {.file = tmpfile(), .lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+    sylvan_serializer_reset(s1);
+    sylvan_serializer_write_begin(s1, p.file);
+    sylvan_serializer_write_push(s1, p.file, c);
+    p.ends[p.count++] = ftell(p.file);
+    sylvan_serializer_write_push(s1, p.file, sylvan_not(c));
+    p.ends[p.count++] = ftell(p.file);
+    sylvan_serializer_write_end(s1, p.file);
+    fflush(p.file);
+    p.ends[p.count++] = ftell(p.file);
+    lddmc_serializer_t l1 = lddmc_serializer_alloc();
+    lddmc_serializer_write_begin(l1, p.file);
+    lddmc_serializer_write_push(l1, p.file, set);
+    p.ends[p.count++] = ftell(p.file);
+    lddmc_serializer_write_push(l1, p.file, rel);
+    p.ends[p.count++] = ftell(p.file);
+    lddmc_serializer_write_end(l1, p.file);
+    fflush(p.file);
+    p.ends[p.count++] = ftell(p.file);
+    rewind(p.file);
+
+    int fds[2];
+    test_assert(pipe(fds) == 0);
+    p.out = fds[1];
+    FILE *in = fdopen(fds[0], "r");
+    pthread_t producer;
+    test_assert(pthread_create(&producer, NULL, stream_producer_run, &p) == 0);
+    int results[6];
+    BDD bdds_in[2];
+    MDD mdds_in[3];
+    results[0] = sylvan_serializer_read_begin(s2, in) == 0 ? sylvan_serializer_read_next(s2, in, &bdds_in[0]) : -1;
+    stream_producer_ack(&p);
+    results[1] = sylvan_serializer_read_next(s2, in, &bdds_in[1]);
+    stream_producer_ack(&p);
+    results[2] = sylvan_serializer_read_next(s2, in, &bdd);
+    stream_producer_ack(&p);
+    lddmc_serializer_t l2 = lddmc_serializer_alloc();
+    results[3] = lddmc_serializer_read_begin(l2, in) == 0 ? lddmc_serializer_read_next(l2, in, &mdds_in[0]) : -1;
+    stream_producer_ack(&p);
+    results[4] = lddmc_serializer_read_next(l2, in, &mdds_in[1]);
+    stream_producer_ack(&p);
+    results[5] = lddmc_serializer_read_next(l2, in, &mdds_in[2]);
+    stream_producer_ack(&p);
+    pthread_join(producer, NULL);
+    fclose(in);
+    fclose(p.file);
+    // the producer only wrote each DD after the reader returned the previous one
+    test_assert(!p.timeout);
+    test_assert(results[0] == 1 && bdds_in[0] == c);
+    test_assert(results[1] == 1 && bdds_in[1] == sylvan_not(c));
+    test_assert(results[2] == 0);
+    test_assert(results[3] == 1 && mdds_in[0] == set);
+    test_assert(results[4] == 1 && mdds_in[1] == rel);
+    test_assert(results[5] == 0);
+    sylvan_set_file_format(SYLVAN_FILE_RAW);
+
+    lddmc_serializer_free(l2);
+    lddmc_serializer_free(l1);
+    lddmc_refs_pop(2);
+    sylvan_serializer_free(s2);
+    sylvan_serializer_free(s1);
+    sylvan_deref(c);
+    sylvan_deref(b);
+    sylvan_deref(a);
+    sylvan_deref(varset);
+    return 0;
+}
+
+/**
+ * Random MTBDD with Integer leaves in [-8, 8) over the variables <var>..5
+ */
+static MTBDD
+evbdd_test_random(uint32_t var)
+{
+    if (var == 6) return mtbdd_int64((int64_t)rng(0, 16) - 8);
+    MTBDD low = evbdd_test_random(var+1);
+    MTBDD high = evbdd_test_random(var+1);
+    return mtbdd_makenode(var, low, high);
+}
+
+int
+test_evbdd()
+{
+    // a weighted sum of variables has a linear EVBDD
+    EVBDD sum = evbdd_zero;
+    MTBDD msum = mtbdd_int64(0);
+    for (uint32_t i=0; i<8; i++) {
+        int64_t w = 1LL << i;
+        sum = evbdd_plus(sum, evbdd_makenode(i, evbdd_zero, evbdd_constant(w)));
+        msum = mtbdd_plus(msum, mtbdd_makenode(i, mtbdd_int64(0), mtbdd_int64(w)));
+    }
+    test_assert(evbdd_nodecount_one(sum) == 9);
+    test_assert(mtbdd_leafcount(msum) == 256);
+    test_assert(evbdd_to_mtbdd(sum) == msum);
+    test_assert(evbdd_from_mtbdd(msum) == sum);
+    test_assert(evbdd_minimum(sum) == 0 && evbdd_maximum(sum) == 255);
+
+    // constants and normalization
+    test_assert(evbdd_constant(0) == evbdd_zero);
+    test_assert(evbdd_isconst(evbdd_constant(-3)) && evbdd_getoffset(evbdd_constant(-3)) == -3);
+    EVBDD x = evbdd_makenode(3, evbdd_constant(5), evbdd_constant(7));
+    test_assert(evbdd_getoffset(x) == 5 && evbdd_getvar(x) == 3);
+    test_assert(evbdd_getnode(x) != evbdd_ithvar(3) && evbdd_getnode(x) == evbdd_getnode(evbdd_plus(evbdd_ithvar(3), evbdd_ithvar(3))));
+    test_assert(evbdd_getlow(x) == evbdd_constant(5) && evbdd_gethigh(x) == evbdd_constant(7));
+    test_assert(evbdd_makenode(3, evbdd_constant(5), evbdd_constant(5)) == evbdd_constant(5));
+
+    // offsets near the limits of int64_t (overflows are tested in test_evbdd_overflow)
+    EVBDD big = evbdd_makenode(3, evbdd_constant(INT64_MAX-1), evbdd_constant(INT64_MAX));
+    test_assert(evbdd_maximum(big) == INT64_MAX && evbdd_minimum(evbdd_minus(evbdd_zero, big)) == -INT64_MAX);
+    test_assert(evbdd_minimum(evbdd_addconst(evbdd_minus(evbdd_zero, big), -1)) == INT64_MIN);
+
+    // operations agree with the MTBDD operations
+    uint32_t vars[] = {1, 3, 4};
+    MTBDD cube = mtbdd_set_from_array(vars, 3);
+    MTBDD all = mtbdd_set_from_array((uint32_t[]){0, 1, 2, 3, 4, 5}, 6);
+    for (int j=0; j<10; j++) {
+        MTBDD ma = evbdd_test_random(0), mb = evbdd_test_random(0);
+        EVBDD a = evbdd_from_mtbdd(ma), b = evbdd_from_mtbdd(mb);
+        test_assert(evbdd_to_mtbdd(a) == ma);
+        test_assert(evbdd_to_mtbdd(evbdd_plus(a, b)) == mtbdd_plus(ma, mb));
+        test_assert(evbdd_to_mtbdd(evbdd_minus(a, b)) == mtbdd_minus(ma, mb));
+        test_assert(evbdd_to_mtbdd(evbdd_min(a, b)) == mtbdd_min(ma, mb));
+        test_assert(evbdd_to_mtbdd(evbdd_max(a, b)) == mtbdd_max(ma, mb));
+        test_assert(evbdd_to_mtbdd(evbdd_abstract_min(a, cube)) == mtbdd_abstract_min(ma, cube));
+        test_assert(evbdd_to_mtbdd(evbdd_abstract_max(a, cube)) == mtbdd_abstract_max(ma, cube));
+        test_assert(evbdd_minimum(a) == mtbdd_getint64(mtbdd_minimum(ma)));
+        test_assert(evbdd_maximum(b) == mtbdd_getint64(mtbdd_maximum(mb)));
+        test_assert(evbdd_plus(evbdd_addconst(a, 3), evbdd_addconst(b, -1)) == evbdd_addconst(evbdd_plus(a, b), 2));
+        uint8_t values[6];
+        for (int k=0; k<6; k++) values[k] = rng(0, 2);
+        MTBDD leaf = ma;
+        while (!mtbdd_isleaf(leaf)) leaf = values[mtbdd_getvar(leaf)] ? mtbdd_gethigh(leaf) : mtbdd_getlow(leaf);
+        test_assert(evbdd_eval(a, all, values) == mtbdd_getint64(leaf));
+    }
+
+    // protected EVBDDs survive garbage collection
+    evbdd_protect(&sum);
+    mtbdd_protect(&msum);
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    test_assert(evbdd_to_mtbdd(sum) == mtbdd_plus(msum, mtbdd_int64(0)));
+    mtbdd_unprotect(&msum);
+    evbdd_unprotect(&sum);
+
+    return 0;
+}
+
+int
+test_spawn_cutoff()
+{
+    // by default, always spawn
+    sylvan_set_spawn_cutoff(0);
+    test_assert(sylvan_get_spawn_cutoff() == SYLVAN_SPAWN_CUTOFF);
+
+    // the results do not depend on the cutoff
+    size_t cutoffs[3] = {SIZE_MAX, 1, 3};
+    for (int i=0; i<3; i++) {
+        sylvan_set_spawn_cutoff(cutoffs[i]);
+        test_assert(sylvan_get_spawn_cutoff() == cutoffs[i]);
+        for (int j=0;j<3;j++) if (test_relprod()) return 1;
+        for (int j=0;j<3;j++) if (test_operators()) return 1;
+        for (int j=0;j<3;j++) if (test_matvec()) return 1;
+        for (int j=0;j<3;j++) if (test_abstract_multi()) return 1;
+        for (int j=0;j<3;j++) if (test_topk()) return 1;
+        if (test_ldd()) return 1;
+        if (test_ldd_relprod_minus()) return 1;
+        if (test_ldd_relprod_multi()) return 1;
+        if (test_ldd_satcount_exact()) return 1;
+        if (test_ldd_index()) return 1;
+        if (test_ldd_last_value()) return 1;
+        if (test_ldd_sorted_array()) return 1;
+        if (test_ldd_learn()) return 1;
+        if (test_ldd_bdd()) return 1;
+        if (test_evbdd()) return 1;
+    }
+
+    sylvan_set_spawn_cutoff(0);
+    return 0;
+}
+
 TASK_0(int, runtests)
 {
     // we are not testing garbage collection
@@ -561,10 +2153,69 @@ TASK_0(int, runtests)
     for (int j=0;j<10;j++) if (test_operators()) return 1;
     printf("Testing disjoint and subset.\n");
     for (int j=0;j<10;j++) if (test_disjoint_subset()) return 1;
+    printf("Testing matvec and matmul.\n");
+    for (int j=0;j<10;j++) if (test_matvec()) return 1;
+    printf("Testing abstract_multi.\n");
+    if (test_abstract_multi()) return 1;
+    printf("Testing topk and range_count.\n");
+    if (test_topk()) return 1;
+    printf("Testing rounding of Real leaves.\n");
+    for (int j=0;j<10;j++) if (test_round()) return 1;
+    printf("Testing solver.\n");
+    for (int j=0;j<10;j++) if (test_solver()) return 1;
 
     printf("Testing ldd.\n");
     if (test_ldd()) return 1;
 
+    printf("Testing ldd relprod_minus.\n");
+    if (test_ldd_relprod_minus()) return 1;
+
+    printf("Testing ldd relprod_multi.\n");
+    if (test_ldd_relprod_multi()) return 1;
+
+    printf("Testing ldd exact satcount.\n");
+    if (test_ldd_satcount_exact()) return 1;
+
+    printf("Testing ldd from sorted array.\n");
+    if (test_ldd_sorted_array()) return 1;
+
+    printf("Testing ldd learning saturation.\n");
+    if (test_ldd_learn()) return 1;
+
+    printf("Testing ldd to bdd conversion.\n");
+    if (test_ldd_bdd()) return 1;
+
+    printf("Testing ldd level index.\n");
+    if (test_ldd_index()) return 1;
+
+    printf("Testing ldd last values.\n");
+    if (test_ldd_last_value()) return 1;
+
+    printf("Testing arena for custom leaves.\n");
+    if (test_arena()) return 1;
+
+    printf("Testing vector leaves.\n");
+    for (int j=0;j<10;j++) if (test_vec()) return 1;
+
+    printf("Testing writer.\n");
+    for (int j=0;j<3;j++) if (test_writer()) return 1;
+    if (test_writer_leaves()) return 1;
+
+    printf("Testing file formats.\n");
+    if (test_file_formats()) return 1;
+
+    printf("Testing serializers.\n");
+    if (test_serializer()) return 1;
+
+    printf("Testing serializer streams.\n");
+    if (test_serializer_stream()) return 1;
+
+    printf("Testing evbdd.\n");
+    if (test_evbdd()) return 1;
+
+    printf("Testing spawn cutoff.\n");
+    if (test_spawn_cutoff()) return 1;
+
     return 0;
 }
 
@@ -579,6 +2230,20 @@ int main()
     sylvan_init_bdd();
     sylvan_init_mtbdd();
     sylvan_init_ldd();
+    sylvan_init_evbdd();
+
+    // Custom leaf type with an arena for its payloads
+    pair_type = sylvan_mt_create_type();
+    sylvan_mt_set_hash(pair_type, pair_hash);
+    sylvan_mt_set_equals(pair_type, pair_equals);
+    sylvan_mt_set_create(pair_type, pair_create);
+    sylvan_mt_set_destroy(pair_type, pair_destroy);
+    sylvan_mt_set_arena(pair_type, 2*sizeof(uint64_t));
+    sylvan_mt_set_write_binary(pair_type, pair_write_binary);
+    sylvan_mt_set_read_binary(pair_type, pair_read_binary);
+
+    // Vector leaves with 3 components
+    sylvan_init_vec(3);
 
     printf("Sylvan initialization complete.\n");
 
@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sylvan.h"
+
+/**
+ * Operations on EVBDDs exit with an error when an offset overflows (see sylvan_evbdd.h).
+ * Every case must exit with "EVBDD offset overflow" on stderr; CTest checks the message.
+ */
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <plus|maximum>\n", argv[0]);
+        return 2;
+    }
+
+    // Standard Lace initialization with 1 worker
+    lace_start(1, 0);
+
+    sylvan_set_sizes(1LL<<20, 1LL<<20, 1LL<<16, 1LL<<16);
+    sylvan_init_package();
+    sylvan_init_mtbdd();
+    sylvan_init_evbdd();
+
+    if (strcmp(argv[1], "plus") == 0) {
+        // the offset of the result overflows
+        evbdd_plus(evbdd_constant(INT64_MAX), evbdd_constant(1));
+    } else if (strcmp(argv[1], "maximum") == 0) {
+        // the offsets fit, but the largest value overflows when it is computed
+        EVBDD big = evbdd_makenode(3, evbdd_constant(INT64_MAX-1), evbdd_constant(INT64_MAX));
+        evbdd_maximum(evbdd_plus(big, evbdd_constant(1)));
+    } else {
+        fprintf(stderr, "Unknown case %s\n", argv[1]);
+    }
+
+    fprintf(stderr, "No overflow detected\n");
+    sylvan_quit();
+    lace_stop();
+    return 1;
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sylvan.h"
+#include "sylvan_int.h"
+#include "sylvan_gmp.h"
+
+#include "test_assert.h"
+
+/* The largest denominator of rationals stored inline in the leaf (see sylvan_gmp.c) */
+#define INLINE_DEN_MAX 0x7fffffffL
+
+/**
+ * Create the leaf num/den from strings, via libgmp (not necessarily in lowest terms)
+ */
+static MTBDD
+leaf_str(const char *num, const char *den)
+{
+    mpq_t q;
+    mpq_init(q);
+    mpz_set_str(mpq_numref(q), num, 10);
+    mpz_set_str(mpq_denref(q), den, 10);
+    MTBDD res = mtbdd_gmp(q);
+    mpq_clear(q);
+    return res;
+}
+
+static MTBDD
+leaf_si(long num, unsigned long den)
+{
+    mpq_t q;
+    mpq_init(q);
+    mpq_set_si(q, num, den);
+    MTBDD res = mtbdd_gmp(q);
+    mpq_clear(q);
+    return res;
+}
+
+/**
+ * Check that <leaf> has the value num/den (given in lowest terms)
+ */
+static int
+has_value(MTBDD leaf, const char *num, const char *den)
+{
+    mpq_t q, r;
+    mpq_init(q);
+    mpq_init(r);
+    gmp_get_value(leaf, q);
+    mpz_set_str(mpq_numref(r), num, 10);
+    mpz_set_str(mpq_denref(r), den, 10);
+    int res = mpq_equal(q, r);
+    mpq_clear(q);
+    mpq_clear(r);
+    return res;
+}
+
+int
+test_gmp_canonical()
+{
+    // every rational has one leaf, however it is created
+    test_assert(leaf_si(2, 4) == leaf_si(1, 2));
+    test_assert(leaf_si(0, 5) == leaf_si(0, 1));
+    test_assert(leaf_si(-6, 3) == leaf_si(-2, 1));
+
+    // around the largest inline denominator
+    MTBDD a = leaf_si(1, INLINE_DEN_MAX);
+    test_assert(leaf_str("2", "4294967294") == a);
+    test_assert(has_value(a, "1", "2147483647"));
+    MTBDD b = leaf_si(1, INLINE_DEN_MAX + 1);
+    test_assert(leaf_str("3", "6442450944") == b);
+    test_assert(has_value(b, "1", "2147483648"));
+    test_assert(a != b);
+
+    // results of the inline fast paths equal the leaves made by libgmp, on both sides of the boundary
+    MTBDD x = leaf_si(1, 1L << 16), y = leaf_si(1, 1L << 15);
+    test_assert(gmp_times(x, y) == b);
+    test_assert(gmp_divide(leaf_si(1, 1), leaf_si(INLINE_DEN_MAX, 1)) == a);
+    test_assert(gmp_times(x, leaf_si(1, 1L << 14)) == leaf_si(1, 1L << 30));
+    test_assert(gmp_plus(b, b) == leaf_si(1, 1L << 30));
+    test_assert(gmp_times(b, leaf_si(2, 1)) == leaf_si(1, 1L << 30));
+    test_assert(gmp_minus(gmp_plus(a, b), b) == a);
+
+    // around the largest and smallest inline numerators
+    MTBDD max = leaf_si(INT32_MAX, 1), min = leaf_si(INT32_MIN, 1);
+    MTBDD big = leaf_str("2147483648", "1");
+    test_assert(gmp_plus(max, leaf_si(1, 1)) == big);
+    test_assert(gmp_minus(big, leaf_si(1, 1)) == max);
+    test_assert(gmp_minus(min, leaf_si(1, 1)) == leaf_str("-2147483649", "1"));
+    test_assert(gmp_plus(leaf_str("-2147483649", "1"), leaf_si(1, 1)) == min);
+    MTBDD neg = gmp_neg(min);
+    test_assert(neg == big);
+    MTBDD abs = gmp_abs(min);
+    test_assert(abs == big);
+    neg = gmp_neg(big);
+    test_assert(neg == min);
+    test_assert(leaf_si(INT32_MAX, INLINE_DEN_MAX) == leaf_si(1, 1));
+    return 0;
+}
+
+int
+test_gmp_overflow()
+{
+    MTBDD max = leaf_si(INT32_MAX, 1), min = leaf_si(INT32_MIN, 1);
+
+    // products and sums that do not fit the inline form, also with negative numerators
+    test_assert(has_value(gmp_times(min, min), "4611686018427387904", "1"));
+    test_assert(has_value(gmp_times(min, max), "-4611686016279904256", "1"));
+    test_assert(has_value(gmp_plus(min, min), "-4294967296", "1"));
+    test_assert(has_value(gmp_minus(min, max), "-4294967295", "1"));
+    test_assert(has_value(gmp_divide(min, leaf_si(-1, 1)), "2147483648", "1"));
+    test_assert(has_value(gmp_divide(leaf_si(-1, 1), min), "1", "2147483648"));
+    test_assert(has_value(gmp_divide(min, leaf_si(-3, INLINE_DEN_MAX)), "4611686016279904256", "3"));
+
+    // denominators that do not fit, and the sum of fractions with large denominators
+    MTBDD p = leaf_si(-1, INLINE_DEN_MAX), q = leaf_si(1, INLINE_DEN_MAX - 1);
+    test_assert(has_value(gmp_times(p, q), "-1", "4611686011984936962"));
+    test_assert(has_value(gmp_plus(p, q), "1", "4611686011984936962"));
+    test_assert(has_value(gmp_minus(p, q), "-4294967293", "4611686011984936962"));
+
+    // results of the slow paths that fit again are stored inline, so they equal the fast path
+    MTBDD r = gmp_times(min, min);
+    test_assert(gmp_divide(r, min) == min);
+    test_assert(gmp_minus(r, r) == leaf_si(0, 1));
+    test_assert(gmp_min(r, min) == min && gmp_max(r, min) == r);
+    return 0;
+}
+
+int
+test_gmp_file()
+{
+    // an MTBDD with inline leaves and leaves with a mpq_t, also negative ones
+    MTBDD leaves[8] = {
+        leaf_si(0, 1), leaf_si(-1, 3), leaf_si(INT32_MIN, INLINE_DEN_MAX), leaf_si(INT32_MAX, 1),
+        leaf_str("-2147483649", "1"), leaf_si(1, INLINE_DEN_MAX + 1),
+        leaf_str("-123456789012345678901234567891", "7"), leaf_str("5", "98765432109876543211"),
+    };
+    MTBDD dd = mtbdd_false;
+    for (int i=0; i<8; i++) {
+        MTBDD cube = mtbdd_makenode(2, (i & 4) ? mtbdd_false : leaves[i], (i & 4) ? leaves[i] : mtbdd_false);
+        cube = mtbdd_makenode(1, (i & 2) ? mtbdd_false : cube, (i & 2) ? cube : mtbdd_false);
+        cube = mtbdd_makenode(0, (i & 1) ? mtbdd_false : cube, (i & 1) ? cube : mtbdd_false);
+        dd = gmp_plus(dd, cube);
+    }
+    MTBDD dds[2];
+    dds[0] = dd;
+    dds[1] = gmp_neg(dd);
+    test_assert(mtbdd_leafcount(dd) == 8);
+
+    int formats[3] = {SYLVAN_FILE_RAW, SYLVAN_FILE_COMPACT, SYLVAN_FILE_LZ};
+    for (int k=0; k<3; k++) {
+        sylvan_set_file_format(formats[k]);
+        FILE *f = tmpfile();
+        mtbdd_writer_tobinary(f, dds, 2);
+        rewind(f);
+        MTBDD read[2];
+        test_assert(mtbdd_reader_frombinary(f, read, 2) == 0);
+        fclose(f);
+        test_assert(read[0] == dds[0] && read[1] == dds[1]);
+    }
+    sylvan_set_file_format(SYLVAN_FILE_RAW);
+
+    // the same leaves after garbage collection
+    mtbdd_protect(&dd);
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    test_assert(leaf_si(1, INLINE_DEN_MAX + 1) == leaves[5]);
+    test_assert(has_value(leaves[6], "-123456789012345678901234567891", "7"));
+    mtbdd_unprotect(&dd);
+    return 0;
+}
+
+TASK_0(int, runtests)
+{
+    // Testing without garbage collection
+    sylvan_gc_disable();
+
+    printf("test_gmp_canonical...\n");
+    if (test_gmp_canonical()) return 1;
+    printf("test_gmp_overflow...\n");
+    if (test_gmp_overflow()) return 1;
+    printf("test_gmp_file...\n");
+    if (test_gmp_file()) return 1;
+
+    return 0;
+}
+
+int main()
+{
+    // Standard Lace initialization with 1 worker
+    lace_start(1, 0);
+
+    // Simple Sylvan initialization, also initialize MTBDD support and GMP leaves
+    sylvan_set_sizes(1LL<<20, 1LL<<20, 1LL<<16, 1LL<<16);
+    sylvan_init_package();
+    sylvan_init_mtbdd();
+    gmp_init();
+
+    int res = RUN(runtests);
+
+    sylvan_quit();
+    lace_stop();
+
+    return res;
+}
@@ -506,6 +506,251 @@ TASK_0(int, test_zdd_exists)
     return 0;
 }
 
+/**
+ * Create a random set of <count> cubes on the domain <bdd_dom> of <nvars> variables
+ */
+static BDD
+make_random_bdd_set(BDD bdd_dom, int nvars, int count)
+{
+    BDD bdd_set = sylvan_false;
+    uint8_t arr[nvars];
+    for (int i=0; i<count; i++) {
+        for (int j=0; j<nvars; j++) arr[j] = rng(0, 3);
+        bdd_set = sylvan_union_cube(bdd_set, bdd_dom, arr);
+    }
+    return bdd_set;
+}
+
+TASK_0(int, test_zdd_binary_ops)
+{
+    /**
+     * Test zdd_xor, zdd_equiv, zdd_imp and zdd_invimp with random sets
+     */
+
+    // Create random domain of 6..12 variables
+    int nvars = rng(6, 12);
+    uint32_t dom_arr[nvars];
+    for (int i=0; i<nvars; i++) dom_arr[i] = i;
+    BDD bdd_dom = mtbdd_fromarray(dom_arr, nvars);
+    ZDD zdd_dom = zdd_set_from_array(dom_arr, nvars);
+
+    BDD bdd_a = make_random_bdd_set(bdd_dom, nvars, rng(0, 30));
+    BDD bdd_b = rng(0, 4) ? make_random_bdd_set(bdd_dom, nvars, rng(0, 30)) : sylvan_or(bdd_a, sylvan_ithvar(rng(0, nvars)));
+    ZDD zdd_a = zdd_from_mtbdd(bdd_a, bdd_dom);
+    ZDD zdd_b = zdd_from_mtbdd(bdd_b, bdd_dom);
+
+    test_assert(zdd_xor(zdd_a, zdd_b) == zdd_from_mtbdd(sylvan_xor(bdd_a, bdd_b), bdd_dom));
+    test_assert(zdd_equiv(zdd_a, zdd_b, zdd_dom) == zdd_from_mtbdd(sylvan_equiv(bdd_a, bdd_b), bdd_dom));
+    test_assert(zdd_imp(zdd_a, zdd_b, zdd_dom) == zdd_from_mtbdd(sylvan_imp(bdd_a, bdd_b), bdd_dom));
+    test_assert(zdd_invimp(zdd_a, zdd_b, zdd_dom) == zdd_from_mtbdd(sylvan_invimp(bdd_a, bdd_b), bdd_dom));
+    test_assert(zdd_xor(zdd_a, zdd_a) == zdd_false);
+    test_assert(zdd_equiv(zdd_a, zdd_a, zdd_dom) == zdd_dom);
+    test_assert(zdd_imp(zdd_false, zdd_b, zdd_dom) == zdd_dom);
+    test_assert(zdd_test_isvalid(zdd_xor(zdd_a, zdd_b)));
+    test_assert(zdd_test_isvalid(zdd_imp(zdd_a, zdd_b, zdd_dom)));
+
+    return 0;
+}
+
+TASK_0(int, test_zdd_forall)
+{
+    /**
+     * Test zdd_forall with random sets
+     */
+
+    // Create random domain of 6..12 variables, and random quantified variables
+    int nvars = rng(6, 12);
+    uint32_t dom_arr[nvars], q_arr[nvars];
+    int nq = 0;
+    for (int i=0; i<nvars; i++) {
+        dom_arr[i] = i;
+        if (rng(0, 3) == 0) q_arr[nq++] = i;
+    }
+    BDD bdd_dom = mtbdd_fromarray(dom_arr, nvars);
+    BDD bdd_qdom = mtbdd_fromarray(q_arr, nq);
+    ZDD zdd_qdom = zdd_set_from_array(q_arr, nq);
+
+    // many cubes with don't cares, so that the result is not always False
+    BDD bdd_set = make_random_bdd_set(bdd_dom, nvars, rng(10, 100));
+    ZDD zdd_set = zdd_from_mtbdd(bdd_set, bdd_dom);
+
+    test_assert(zdd_forall(zdd_set, zdd_qdom) == zdd_from_mtbdd(sylvan_forall(bdd_set, bdd_qdom), bdd_dom));
+    test_assert(zdd_forall(zdd_true, zdd_true) == zdd_true);
+
+    return 0;
+}
+
+TASK_0(int, test_zdd_and_exists)
+{
+    /**
+     * Test zdd_and_exists and zdd_and_project with random sets
+     */
+
+    // Create random domain of 6..12 variables
+    int nvars = rng(6, 12);
+    uint32_t dom_arr[nvars];
+    for (int i=0; i<nvars; i++) dom_arr[i] = i;
+    BDD bdd_dom = mtbdd_fromarray(dom_arr, nvars);
+
+    // Create random subdomain and quantified variables (qdom)
+    uint32_t subdom_arr[nvars], q_arr[nvars];
+    int nsub = 0, nq = 0;
+    for (int i=0; i<nvars; i++) {
+        if (rng(0,2)) subdom_arr[nsub++] = i;
+        else q_arr[nq++] = i;
+    }
+    BDD bdd_subdom = mtbdd_fromarray(subdom_arr, nsub);
+    ZDD zdd_subdom = zdd_set_from_array(subdom_arr, nsub);
+    BDD bdd_qdom = mtbdd_fromarray(q_arr, nq);
+    ZDD zdd_qdom = zdd_set_from_array(q_arr, nq);
+
+    BDD bdd_a = make_random_bdd_set(bdd_dom, nvars, rng(0, 50));
+    BDD bdd_b = make_random_bdd_set(bdd_dom, nvars, rng(0, 50));
+    ZDD zdd_a = zdd_from_mtbdd(bdd_a, bdd_dom);
+    ZDD zdd_b = zdd_from_mtbdd(bdd_b, bdd_dom);
+    BDD bdd_result = sylvan_and_exists(bdd_a, bdd_b, bdd_qdom);
+
+    test_assert(zdd_and_exists(zdd_a, zdd_b, zdd_qdom) == zdd_from_mtbdd(bdd_result, bdd_dom));
+    test_assert(zdd_and_project(zdd_a, zdd_b, zdd_subdom) == zdd_from_mtbdd(bdd_result, bdd_subdom));
+    test_assert(zdd_and_exists(zdd_a, zdd_a, zdd_qdom) == zdd_exists(zdd_a, zdd_qdom));
+
+    return 0;
+}
+
+TASK_0(int, test_zdd_compose)
+{
+    /**
+     * Test zdd_compose with random sets and random functions
+     */
+
+    // Create random domain of 4..10 variables
+    int nvars = rng(4, 10);
+    uint32_t dom_arr[nvars];
+    for (int i=0; i<nvars; i++) dom_arr[i] = i;
+    BDD bdd_dom = mtbdd_fromarray(dom_arr, nvars);
+    ZDD zdd_dom = zdd_set_from_array(dom_arr, nvars);
+
+    BDD bdd_set = make_random_bdd_set(bdd_dom, nvars, rng(0, 30));
+    ZDD zdd_set = zdd_from_mtbdd(bdd_set, bdd_dom);
+
+    // replace random variables by random functions, or by other variables
+    BDDMAP bdd_map = sylvan_map_empty();
+    ZDDMAP zdd_map = zdd_map_empty();
+    for (int i=0; i<nvars; i++) {
+        int r = rng(0, 3);
+        if (r == 0) continue;
+        BDD value = r == 1 ? make_random_bdd_set(bdd_dom, nvars, rng(0, 10)) : sylvan_ithvar(rng(0, nvars));
+        bdd_map = sylvan_map_add(bdd_map, i, value);
+        zdd_map = zdd_map_add(zdd_map, i, zdd_from_mtbdd(value, bdd_dom));
+    }
+
+    ZDD zdd_result = zdd_compose(zdd_set, zdd_map, zdd_dom);
+    test_assert(zdd_result == zdd_from_mtbdd(sylvan_compose(bdd_set, bdd_map), bdd_dom));
+    test_assert(zdd_test_isvalid(zdd_result));
+    test_assert(zdd_compose(zdd_set, zdd_map_empty(), zdd_dom) == zdd_set);
+
+    return 0;
+}
+
+/**
+ * Families of sets of 5 variables, as a bitmask over the 32 possible sets
+ */
+static ZDD
+make_family(uint32_t family)
+{
+    uint32_t dom_arr[5] = {0, 1, 2, 3, 4};
+    ZDD dom = zdd_set_from_array(dom_arr, 5);
+    ZDD result = zdd_false;
+    for (int s=0; s<32; s++) {
+        if ((family & (1u<<s)) == 0) continue;
+        uint8_t arr[5];
+        for (int i=0; i<5; i++) arr[i] = (s >> i) & 1;
+        result = zdd_or(result, zdd_cube(dom, arr, zdd_true));
+    }
+    return result;
+}
+
+static uint32_t
+make_random_family(void)
+{
+    switch (rng(0, 8)) {
+    case 0: return 0;
+    case 1: return 1; // only the empty set
+    case 2: return 1u << rng(0, 32);
+    default: return (uint32_t)xorshift_rand() & (uint32_t)xorshift_rand();
+    }
+}
+
+TASK_0(int, test_zdd_family_algebra)
+{
+    /**
+     * Test the family algebra operations against brute force on random families
+     */
+    uint32_t f = make_random_family();
+    uint32_t g = make_random_family();
+    if (rng(0, 3) == 0) {
+        // make <f> a multiple of <g> plus a remainder, for a nontrivial quotient
+        uint32_t q = make_random_family();
+        f = 0;
+        for (int s=0; s<32; s++) for (int t=0; t<32; t++) {
+            if ((g & (1u<<s)) && (q & (1u<<t)) && (s & t) == 0) f |= 1u << (s|t);
+        }
+        f |= make_random_family();
+    }
+
+    uint32_t join = 0, meet = 0, delta = 0, quot = 0, nonsup = 0, nonsub = 0, minimal = 0, maximal = 0;
+    for (int s=0; s<32; s++) {
+        if ((f & (1u<<s)) == 0) continue;
+        int sup = 0, sub = 0, min = 1, max = 1;
+        for (int t=0; t<32; t++) {
+            if ((g & (1u<<t)) != 0) {
+                join |= 1u << (s|t);
+                meet |= 1u << (s&t);
+                delta |= 1u << (s^t);
+                if ((t & ~s) == 0) sup = 1;
+                if ((s & ~t) == 0) sub = 1;
+            }
+            if ((f & (1u<<t)) != 0 && t != s) {
+                if ((t & ~s) == 0) min = 0;
+                if ((s & ~t) == 0) max = 0;
+            }
+        }
+        if (!sup) nonsup |= 1u << s;
+        if (!sub) nonsub |= 1u << s;
+        if (min) minimal |= 1u << s;
+        if (max) maximal |= 1u << s;
+    }
+    for (int h=0; h<32 && g != 0; h++) {
+        int ok = 1;
+        for (int t=0; t<32; t++) {
+            if ((g & (1u<<t)) == 0) continue;
+            if ((h & t) != 0 || (f & (1u<<(h|t))) == 0) ok = 0;
+        }
+        if (ok) quot |= 1u << h;
+    }
+    uint32_t rem = f;
+    for (int s=0; s<32; s++) for (int t=0; t<32; t++) {
+        if ((g & (1u<<s)) && (quot & (1u<<t))) rem &= ~(1u << (s|t));
+    }
+
+    ZDD zdd_f = make_family(f);
+    ZDD zdd_g = make_family(g);
+
+    test_assert(zdd_join(zdd_f, zdd_g) == make_family(join));
+    test_assert(zdd_meet(zdd_f, zdd_g) == make_family(meet));
+    test_assert(zdd_delta(zdd_f, zdd_g) == make_family(delta));
+    test_assert(zdd_quotient(zdd_f, zdd_g) == make_family(quot));
+    test_assert(zdd_remainder(zdd_f, zdd_g) == make_family(rem));
+    test_assert(zdd_nonsup(zdd_f, zdd_g) == make_family(nonsup));
+    test_assert(zdd_nonsub(zdd_f, zdd_g) == make_family(nonsub));
+    test_assert(zdd_minimal(zdd_f) == make_family(minimal));
+    test_assert(zdd_maximal(zdd_f) == make_family(maximal));
+    test_assert(zdd_test_isvalid(zdd_join(zdd_f, zdd_g)));
+    test_assert(zdd_test_isvalid(zdd_quotient(zdd_f, zdd_g)));
+
+    return 0;
+}
+
 // TASK_0(int, test_zdd_relnext)
 // {
 //     /**
@@ -733,12 +978,68 @@ TASK_0(int, test_zdd_read_write)
         }
     }
 
-    FILE *f = tmpfile();
-    zdd_writer_tobinary(f, zdd_set, set_count);
-    rewind(f);
-    ZDD test[set_count];
-    test_assert(zdd_reader_frombinary(f, test, set_count) == 0);
-    for (int i=0; i<set_count; i++) test_assert(test[i] == zdd_set[i]);
+    // in every file format
+    int formats[3] = {SYLVAN_FILE_RAW, SYLVAN_FILE_COMPACT, SYLVAN_FILE_LZ};
+    for (int k=0; k<3; k++) {
+        sylvan_set_file_format(formats[k]);
+        FILE *f = tmpfile();
+        zdd_writer_tobinary(f, zdd_set, set_count);
+        rewind(f);
+        ZDD test[set_count];
+        test_assert(zdd_reader_frombinary(f, test, set_count) == 0);
+        for (int i=0; i<set_count; i++) test_assert(test[i] == zdd_set[i]);
+        fclose(f);
+    }
+    sylvan_set_file_format(SYLVAN_FILE_RAW);
+
+    return 0;
+}
+
+TASK_0(int, test_zdd_stream)
+{
+    /**
+     * Test streams with random sets, of which later ones share nodes with earlier ones
+     */
+    int nvars = rng(8,12);
+    uint32_t dom_arr[nvars];
+    for (int i=0; i<nvars; i++) dom_arr[i] = i*2;
+    ZDD zdd_dom = zdd_set_from_array(dom_arr, nvars);
+
+    ZDD zdd_set[6];
+    zdd_set[0] = zdd_false;
+    int count = rng(4,100);
+    for (int i=0; i<count; i++) {
+        uint8_t arr[nvars];
+        for (int j=0; j<nvars; j++) arr[j] = rng(0, 2);
+        zdd_set[0] = zdd_union_cube(zdd_set[0], zdd_dom, arr, zdd_true);
+    }
+    zdd_set[1] = zdd_and(zdd_set[0], zdd_ithvar(dom_arr[rng(0, nvars)]));
+    zdd_set[2] = zdd_not(zdd_set[0], zdd_dom);
+    zdd_set[3] = zdd_true;
+    zdd_set[4] = zdd_false;
+    zdd_set[5] = zdd_set[1];
+
+    int formats[3] = {SYLVAN_FILE_RAW, SYLVAN_FILE_COMPACT, SYLVAN_FILE_LZ};
+    for (int k=0; k<3; k++) {
+        sylvan_set_file_format(formats[k]);
+        FILE *f = tmpfile();
+        zdd_stream_t s = zdd_stream_alloc();
+        zdd_stream_write_begin(s, f);
+        for (int i=0; i<6; i++) zdd_stream_write_push(s, f, zdd_set[i]);
+        zdd_stream_write_end(s, f);
+        rewind(f);
+        test_assert(zdd_stream_read_begin(s, f) == 0);
+        for (int i=0; i<6; i++) {
+            ZDD test;
+            test_assert(zdd_stream_read_next(s, f, &test) == 1);
+            test_assert(test == zdd_set[i]);
+        }
+        ZDD test;
+        test_assert(zdd_stream_read_next(s, f, &test) == 0);
+        zdd_stream_free(s);
+        fclose(f);
+    }
+    sylvan_set_file_format(SYLVAN_FILE_RAW);
 
     return 0;
 }
@@ -774,11 +1075,23 @@ TASK_0(int, runtests)
     for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_not)) return 1;
     printf("test_zdd_exists...\n");
     for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_exists)) return 1;
+    printf("test_zdd_binary_ops...\n");
+    for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_binary_ops)) return 1;
+    printf("test_zdd_forall...\n");
+    for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_forall)) return 1;
+    printf("test_zdd_and_exists...\n");
+    for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_and_exists)) return 1;
+    printf("test_zdd_compose...\n");
+    for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_compose)) return 1;
+    printf("test_zdd_family_algebra...\n");
+    for (int k=0; k<100*test_iterations; k++) if (CALL(test_zdd_family_algebra)) return 1;
     // for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_relnext)) return 1;
     // for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_and_dom)) return 1;
     // printf("test_zdd_read_write...\n");
     // for (int k=0; k<10; k++) if (CALL(test_zdd_read_write)) return 1;
     // for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_extend_domain)) return 1;
+    printf("test_zdd_stream...\n");
+    for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_stream)) return 1;
     printf("test_zdd_isop_basic...\n");
     if (CALL(test_zdd_isop_basic)) return 1;
     printf("test_zdd_isop_random...\n");